@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+ * Stable C ABI for CUSTOM_FEED market data plugins.
+ *
+ * A plugin is a shared library exporting UFA_FEED_PLUGIN_ENTRY, which returns a
+ * static ufa_feed_plugin descriptor. The engine loads it with dlopen() at startup,
+ * creates one instance per source and repeatedly calls poll() with a buffer it owns;
+ * the plugin fills that buffer with up to `capacity` normalized events. No engine
+ * types cross this boundary and no callbacks are made into the engine, so a plugin
+ * can be built with any compiler and decoded at native speed.
+ *
+ * This header must stay valid C.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UFA_FEED_PLUGIN_ABI_VERSION 1
+#define UFA_FEED_PLUGIN_ENTRY "ufa_feed_plugin_entry"
+#define UFA_FEED_SYMBOL_LENGTH 16
+
+/* Use on the entry point so it stays visible under -fvisibility=hidden */
+#if defined(_WIN32)
+#define UFA_FEED_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define UFA_FEED_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* Event types; values match UltraFastAnalysis::MarketDataType */
+enum {
+    UFA_FEED_EVENT_TRADE = 0,
+    UFA_FEED_EVENT_QUOTE = 1,
+    UFA_FEED_EVENT_BOOK_UPDATE = 2,
+    UFA_FEED_EVENT_TICK = 3
+};
+
+/* Normalized event written by the plugin. Prices are integers in units of
+ * 10^-price_decimals as declared in the plugin descriptor. */
+typedef struct ufa_feed_event {
+    uint64_t sequence_number;
+    uint64_t timestamp_ns;                  /* Exchange timestamp, 0 if unknown */
+    char symbol[UFA_FEED_SYMBOL_LENGTH];    /* NUL-padded */
+    uint8_t type;                           /* UFA_FEED_EVENT_* */
+    uint8_t is_bid;                         /* Side for book updates */
+    uint8_t reserved[6];
+    int64_t price;                          /* Trade/book price, or bid price for quotes */
+    uint64_t quantity;                      /* Trade/book quantity, or bid quantity for quotes */
+    int64_t ask_price;                      /* Ask price for quotes */
+    uint64_t ask_quantity;                  /* Ask quantity for quotes */
+    uint64_t trade_id;
+} ufa_feed_event;
+
+typedef struct ufa_feed_plugin {
+    uint32_t abi_version;       /* UFA_FEED_PLUGIN_ABI_VERSION the plugin was built against */
+    uint32_t event_size;        /* sizeof(ufa_feed_event) the plugin was built against */
+    const char* name;
+    int32_t price_decimals;
+
+    /* Create an instance from an opaque configuration string; NULL on failure */
+    void* (*create)(const char* config);
+    void (*destroy)(void* instance);
+
+    /* Start/stop the underlying feed; start returns 0 on success */
+    int (*start)(void* instance);
+    void (*stop)(void* instance);
+
+    /* Write up to `capacity` events into `events`, waiting at most `timeout_us` when
+     * none are available. Returns the number written, 0 on timeout, negative on error. */
+    int64_t (*poll)(void* instance, ufa_feed_event* events, size_t capacity, uint32_t timeout_us);
+
+    /* Description of the last error, or NULL */
+    const char* (*last_error)(void* instance);
+} ufa_feed_plugin;
+
+typedef const ufa_feed_plugin* (*ufa_feed_plugin_entry_fn)(void);
+
+#ifdef __cplusplus
+}
+#endif
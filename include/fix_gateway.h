@@ -0,0 +1,336 @@
+#pragma once
+
+#include "memory_accounting.h"
+#include "order.h"
+#include <boost/asio.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+constexpr char FIX_SOH = '\x01';
+
+// Parsed view of one FIX message. Field values point into the caller's receive
+// buffer, so a view is only valid until that buffer is reused.
+class FixMessageView {
+public:
+    static constexpr size_t MAX_FIELDS = 128;
+    static constexpr int INDEXED_TAGS = 128;
+
+    // Length of the complete message at the start of `data`: 0 if more bytes are
+    // needed, -1 if the data does not start with a well-formed FIX 4.4 header
+    static int64_t frame(const char* data, size_t length);
+
+    // Split a complete framed message into fields in one pass and verify its checksum
+    bool parse(const char* data, size_t length);
+
+    std::string_view get(int tag) const;
+    bool get_int(int tag, int64_t& value) const;
+    bool get_double(int tag, double& value) const;
+    char get_char(int tag) const;   // First character of the value, 0 if absent
+
+    std::string_view msg_type() const { return get(35); }
+    size_t field_count() const { return field_count_; }
+
+private:
+    struct Field {
+        int tag;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    const char* data_ = nullptr;
+    std::array<Field, MAX_FIELDS> fields_;
+    size_t field_count_ = 0;
+
+    // Field index + 1 for tags below INDEXED_TAGS, 0 when absent
+    std::array<uint8_t, INDEXED_TAGS> index_{};
+};
+
+// Builds outbound FIX messages in a reused buffer, summing the checksum as bytes
+// are appended. Constant parts of the header are rendered once as Segments with
+// their checksum contribution precomputed.
+class FixMessageWriter {
+public:
+    struct Segment {
+        std::string text;
+        uint32_t checksum = 0;
+
+        static Segment make(std::string text);
+    };
+
+    void begin(std::string_view msg_type, const Segment& header_fields, uint64_t seq_num,
+               std::string_view sending_time);
+
+    void add(int tag, std::string_view value);
+    void add(int tag, uint64_t value);
+    void add(int tag, double value);
+    void add(int tag, char value);
+
+    // Prepend BeginString and BodyLength, append CheckSum and return the full message
+    std::string_view finish();
+
+private:
+    static constexpr size_t HEADER_RESERVE = 32;  // Room for "8=FIX.4.4|9=nnnnn|"
+    std::array<char, 4096> buffer_;
+    size_t length_ = HEADER_RESERVE;
+    uint32_t checksum_ = 0;
+    bool overflow_ = false;
+
+    void append(std::string_view text);
+    void append_tag(int tag);
+};
+
+// FIX acceptor configuration
+struct FixGatewayConfig {
+    uint16_t port = 9878;
+    size_t num_threads = 1;
+    std::string sender_comp_id = "UFAENGINE";
+    int max_heartbeat_interval = 300;   // Seconds; larger HeartBtInt values are clamped
+};
+
+// Order entry callbacks shared by every FIX session; return false to reject
+struct FixOrderHandlers {
+    std::function<bool(std::shared_ptr<Order>)> submit;
+    std::function<bool(uint64_t, const std::string&)> cancel;
+    std::function<bool(uint64_t, const std::string&, uint64_t, double)> modify;
+};
+
+// Fill or state change of one order, as reported by its book
+struct FixExecution {
+    uint64_t order_id = 0;
+    uint64_t last_quantity = 0;     // 0 unless this is a fill
+    double last_price = 0.0;
+    uint64_t quantity = 0;
+    uint64_t filled_quantity = 0;
+    OrderStatus status = OrderStatus::PENDING;
+};
+
+// Open order of a FIX counterparty
+struct FixOrderReference {
+    uint64_t order_id = 0;
+    std::string symbol;
+    char side = 0;
+    uint64_t quantity = 0;
+    double price = 0.0;
+    uint64_t cum_quantity = 0;
+    double notional = 0.0;          // Sum of fill quantity times price, for AvgPx
+    std::string cancel_cl_ord_id;   // Set while a cancel waits for the book's report
+};
+
+// Orders of one counterparty (SenderCompID). The gateway keeps it across reconnects
+// and hands it to whichever session is logged on, so the client id that owns the
+// orders, and the orders themselves, outlive the connection.
+struct FixCounterpartyState {
+    using OrderMap = std::unordered_map<std::string, FixOrderReference>;
+
+    uint64_t client_id = 0;
+
+    // Open orders by ClOrdID, for cancel and replace requests, and the current
+    // ClOrdID of each by engine order id, for executions
+    OrderMap orders;
+    std::unordered_map<uint64_t, std::string> cl_ord_ids;
+    uint64_t next_order_sequence = 0;
+    uint64_t next_exec_id = 0;
+
+    // The order an execution refers to, updated with its quantities; orders.end() if unknown
+    OrderMap::iterator apply(const FixExecution& execution);
+
+    // Filled, cancelled and rejected orders can no longer be referenced
+    void finish(OrderMap::iterator order, const FixExecution& execution);
+};
+
+// One FIX 4.4 counterparty session (NewOrderSingle, OrderCancelRequest,
+// OrderCancelReplaceRequest in; ExecutionReport and OrderCancelReject out).
+// All processing happens on the session's strand.
+class FixSession : public std::enable_shared_from_this<FixSession> {
+public:
+    FixSession(boost::asio::ip::tcp::socket socket, uint64_t connection_id, const FixGatewayConfig& config,
+               std::shared_ptr<const FixOrderHandlers> handlers);
+    ~FixSession();
+
+    void start();
+    void stop();
+    bool is_connected() const { return connected_.load(); }
+
+    uint64_t get_connection_id() const { return connection_id_; }
+
+    // Invoked from the strand at Logon to take the counterparty's state; false if the
+    // SenderCompID is logged on elsewhere
+    void set_logon_callback(std::function<bool(const std::string&, const std::shared_ptr<FixSession>&,
+                                               FixCounterpartyState&)> callback) {
+        logon_callback_ = callback;
+    }
+
+    // Invoked once with the connection id, from the session's strand, after the session
+    // stops. A logged-on session hands its counterparty state back.
+    void set_disconnect_callback(std::function<void(uint64_t, const std::string&, FixCounterpartyState*)> callback) {
+        disconnect_callback_ = callback;
+    }
+
+    // Queues an execution of one of this session's orders onto its strand. Executions
+    // that arrive after the session gave its state back go to the fallback.
+    void post_execution(const FixExecution& execution);
+    void set_execution_fallback(std::function<void(uint64_t, const FixExecution&)> callback) {
+        execution_fallback_ = callback;
+    }
+
+private:
+    using OrderReference = FixOrderReference;
+
+    boost::asio::ip::tcp::socket socket_;
+    boost::asio::strand<boost::asio::any_io_executor> strand_;
+    boost::asio::steady_timer heartbeat_timer_;
+    std::atomic<bool> connected_{false};
+    const uint64_t connection_id_;
+    FixGatewayConfig config_;
+    std::shared_ptr<const FixOrderHandlers> handlers_;
+
+    // Session state
+    bool logged_on_ = false;
+    bool closing_ = false;      // Logout sent, disconnect once it is written
+    std::string target_comp_id_;
+    FixMessageWriter::Segment header_fields_;    // "49=...|56=...|"
+    uint64_t next_outbound_seq_ = 1;
+    uint64_t next_inbound_seq_ = 1;
+    std::chrono::seconds heartbeat_interval_{30};
+    std::chrono::steady_clock::time_point connected_at_;
+    std::chrono::steady_clock::time_point last_received_;
+    std::chrono::steady_clock::time_point last_sent_;
+
+    // Receive buffer; complete messages are parsed in place
+    static constexpr size_t READ_BUFFER_SIZE = 64 * 1024;
+    std::vector<char, TrackingAllocator<char, MemorySubsystem::CONNECTION_BUFFERS>> read_buffer_;
+    size_t read_begin_ = 0;
+    size_t read_end_ = 0;
+    FixMessageView message_;
+
+    // Outbound: messages are appended to outbound_ and flushed in one write
+    static constexpr size_t MAX_OUTBOUND_BYTES = 4 * 1024 * 1024;
+    FixMessageWriter writer_;
+    using OutboundBuffer = std::basic_string<char, std::char_traits<char>,
+                                             TrackingAllocator<char, MemorySubsystem::CONNECTION_BUFFERS>>;
+    OutboundBuffer outbound_;
+    OutboundBuffer writing_;
+    bool write_in_progress_ = false;
+
+    // SendingTime prefix cached per second
+    std::time_t cached_second_ = 0;
+    std::array<char, 32> sending_time_{};
+    size_t sending_time_length_ = 0;
+
+    // The counterparty's orders, held from Logon until the session stops
+    FixCounterpartyState state_;
+    bool holds_state_ = false;
+
+    std::function<bool(const std::string&, const std::shared_ptr<FixSession>&, FixCounterpartyState&)> logon_callback_;
+    std::function<void(uint64_t, const std::string&, FixCounterpartyState*)> disconnect_callback_;
+    std::function<void(uint64_t, const FixExecution&)> execution_fallback_;
+
+    // Network I/O
+    void start_read();
+    void handle_read(const boost::system::error_code& error, size_t bytes_transferred);
+    void flush();
+    void handle_write(const boost::system::error_code& error);
+    void schedule_heartbeat();
+
+    // Message handling
+    void handle_message();
+    void handle_logon();
+    void handle_new_order_single();
+    void handle_cancel_request();
+    void handle_cancel_replace_request();
+    void handle_sequence_reset();
+    void handle_execution(const FixExecution& execution);
+    void disconnect(std::string_view text);
+
+    // Outbound messages
+    std::string_view sending_time();
+    void begin_message(std::string_view msg_type);
+    void send_current();
+    void send_logon();
+    void send_heartbeat(std::string_view test_req_id);
+    void send_logout(std::string_view text);
+    void send_reject(uint64_t ref_seq_num, std::string_view ref_msg_type, std::string_view text);
+    void send_sequence_reset();
+    void send_execution_report(const OrderReference& order, std::string_view cl_ord_id,
+                               std::string_view orig_cl_ord_id, char exec_type, char ord_status,
+                               std::string_view text, uint64_t last_quantity = 0, double last_price = 0.0);
+    void send_cancel_reject(std::string_view cl_ord_id, std::string_view orig_cl_ord_id,
+                            const OrderReference* order, char response_to, std::string_view text);
+
+    uint64_t next_order_id() { return (state_.client_id << 32) | ++state_.next_order_sequence; }
+};
+
+// FIX acceptor running on its own io_context and threads alongside TCPServer
+class FixGateway {
+public:
+    // Client ids handed to FIX counterparties start here, clear of TCPServer's ids
+    static constexpr uint64_t FIX_CLIENT_ID_BASE = 1ull << 30;
+
+    explicit FixGateway(const FixGatewayConfig& config = FixGatewayConfig{});
+    ~FixGateway();
+
+    // Non-copyable, non-movable
+    FixGateway(const FixGateway&) = delete;
+    FixGateway& operator=(const FixGateway&) = delete;
+
+    bool start();
+    void stop();
+    bool is_running() const;
+
+    size_t get_session_count() const;
+
+    // Callback setters; set before start()
+    void set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback);
+    void set_order_cancel_callback(std::function<bool(uint64_t, const std::string&)> callback);
+    void set_order_modify_callback(std::function<bool(uint64_t, const std::string&, uint64_t, double)> callback);
+
+    // Execution report for orders of FIX sessions, ignored for others.
+    // Called from the matching threads (see ExecutionCallback).
+    void on_execution(const Order& order, uint64_t fill_quantity, double fill_price);
+
+private:
+    FixGatewayConfig config_;
+    boost::asio::io_context io_context_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::vector<std::thread> worker_threads_;
+    std::atomic<bool> running_{false};
+
+    std::shared_ptr<FixOrderHandlers> handlers_;
+
+    // A counterparty's state is parked here while no session is logged on for it
+    struct Counterparty {
+        std::shared_ptr<FixSession> session;
+        FixCounterpartyState state;
+    };
+
+    // Connections by connection id, and counterparties by client id and SenderCompID
+    // (guarded by sessions_mutex_)
+    std::unordered_map<uint64_t, std::shared_ptr<FixSession>> sessions_;
+    std::unordered_map<uint64_t, Counterparty> counterparties_;
+    std::unordered_map<std::string, uint64_t> client_ids_;
+    mutable std::shared_mutex sessions_mutex_;
+    uint64_t next_connection_id_ = 1;
+    uint64_t next_client_id_ = FIX_CLIENT_ID_BASE;
+
+    void start_accept();
+    bool claim_counterparty(const std::string& comp_id, const std::shared_ptr<FixSession>& session,
+                            FixCounterpartyState& state);
+    void remove_session(uint64_t connection_id, const std::string& comp_id, FixCounterpartyState* state);
+    void route_execution(uint64_t client_id, const FixExecution& execution);
+    void worker_thread_function();
+};
+
+} // namespace UltraFastAnalysis
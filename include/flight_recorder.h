@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// Flight recorder: every engine thread that registers keeps a ring of its last
+// events, written with plain stores and a TSC timestamp. When an order's
+// end-to-end latency crosses the configured threshold, the thread records a
+// TRIGGER event and keeps recording a while longer. It then copies its ring and
+// hands the copy to a writer thread, which saves it under the dump directory
+// for post-mortem analysis. The matching path never blocks on disk.
+
+enum class FlightEventType : uint8_t {
+    ORDER_IN = 1,       // order_id, value = quantity, aux = order queue depth
+    ORDER_DONE = 2,     // order_id, value = end-to-end latency ns, aux = 1 if accepted
+    TRADE = 3,          // order_id = buy order, value = quantity, aux = low 32 bits of the sell order id
+    CANCEL = 4,         // order_id, aux = 1 if found
+    BATCH = 5,          // value = orders in the batch, aux = order queue depth before it
+    TRIGGER = 6         // order_id, value = latency ns that crossed the threshold
+};
+
+const char* flight_event_type_name(FlightEventType type);
+
+// 32 bytes, two per cache line
+struct FlightEvent {
+    uint64_t tsc;
+    uint64_t order_id;
+    uint64_t value;
+    uint32_t aux;
+    FlightEventType type;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(FlightEvent) == 32, "FlightEvent must stay 32 bytes");
+
+// Dump file layout, little endian:
+//   FlightDumpHeader, then `event_count` FlightEvents, oldest first
+struct FlightDumpHeader {
+    char magic[4];                  // "UFR1"
+    uint32_t event_count;
+    uint64_t ticks_per_second;      // FlightEvent::tsc rate
+    uint64_t trigger_tsc;
+    uint64_t trigger_latency_ns;
+    uint64_t threshold_ns;
+    uint64_t wall_clock_ns;         // system_clock at the trigger, for correlating with logs
+    char thread_name[32];
+};
+
+struct FlightRecorderConfig {
+    std::string directory;                              // Dump directory, empty disables the recorder
+    size_t events_per_thread = 4096;                    // Rounded up to a power of two
+    size_t events_after_trigger = 256;                  // Recorded past the trigger before the ring is frozen
+    std::chrono::microseconds threshold{100};
+    std::chrono::milliseconds min_dump_interval{1000};  // Per thread; later spikes in the window are only counted
+    size_t max_pending_dumps = 8;                       // Queued for the writer; more are dropped
+};
+
+struct FlightRecorderStats {
+    uint64_t triggers = 0;          // Orders over the threshold
+    uint64_t dumps_written = 0;
+    uint64_t dumps_dropped = 0;     // Suppressed by the interval, the queue limit or a write error
+};
+
+class FlightRecorder;
+
+// Event ring of one thread. Only that thread records or freezes it.
+class FlightRing {
+public:
+    FlightRing(FlightRecorder* recorder, const std::string& name, size_t capacity);
+
+    void record(FlightEventType type, uint64_t order_id, uint64_t value, uint32_t aux);
+
+    // Checks an order's end-to-end latency against the threshold
+    void order_done(uint64_t order_id, uint64_t latency_ns, bool accepted);
+
+    // Freeze now if a trigger is still collecting events (thread exit)
+    void flush();
+
+private:
+    FlightRecorder* recorder_;
+    std::string name_;
+    std::vector<FlightEvent> events_;
+    uint64_t mask_;
+    uint64_t head_ = 0;                 // Events recorded so far
+    uint64_t threshold_ns_;
+    uint64_t min_dump_interval_ticks_;
+    uint64_t last_dump_tsc_ = 0;
+
+    // Pending trigger
+    size_t events_after_trigger_;
+    size_t remaining_after_trigger_ = 0;
+    bool triggered_ = false;
+    uint64_t trigger_tsc_ = 0;
+    uint64_t trigger_latency_ns_ = 0;
+    uint64_t trigger_wall_clock_ns_ = 0;
+
+    void freeze();
+};
+
+class FlightRecorder {
+public:
+    explicit FlightRecorder(const FlightRecorderConfig& config);
+    ~FlightRecorder();
+
+    // Non-copyable, non-movable
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    bool start();   // Creates the directory and the writer thread
+    void stop();    // Writes what is queued
+
+    // Give the calling thread a ring that flight_record() and FlightRing calls
+    // on this thread go to; unregister_thread() flushes it.
+    FlightRing* register_thread(const std::string& name);
+    void unregister_thread();
+
+    FlightRecorderStats get_stats() const;
+    const FlightRecorderConfig& get_config() const { return config_; }
+
+private:
+    friend class FlightRing;
+
+    struct Dump {
+        FlightDumpHeader header;
+        std::vector<FlightEvent> events;
+    };
+
+    FlightRecorderConfig config_;
+    std::atomic<bool> running_{false};
+    std::thread writer_thread_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Dump> pending_;
+    std::vector<std::unique_ptr<FlightRing>> rings_;
+    uint64_t next_dump_sequence_ = 1;
+
+    std::atomic<uint64_t> triggers_{0};
+    std::atomic<uint64_t> dumps_written_{0};
+    std::atomic<uint64_t> dumps_dropped_{0};
+
+    void submit(Dump&& dump);
+    void writer_thread_worker();
+    bool write_dump(const Dump& dump, uint64_t sequence);
+};
+
+// Ring of the calling thread, nullptr unless it registered with a running recorder
+FlightRing* current_flight_ring();
+
+// Record on the calling thread's ring; a thread-local load and nothing else when unregistered
+inline void flight_record(FlightEventType type, uint64_t order_id, uint64_t value = 0, uint32_t aux = 0) {
+    if (FlightRing* ring = current_flight_ring()) {
+        ring->record(type, order_id, value, aux);
+    }
+}
+
+} // namespace UltraFastAnalysis
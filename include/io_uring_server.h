@@ -0,0 +1,241 @@
+#pragma once
+
+#include "tcp_server.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct __kernel_timespec;
+
+namespace UltraFastAnalysis {
+
+// io_uring backend configuration
+struct IoUringConfig {
+    unsigned queue_depth = 4096;            // Submission queue entries; the completion queue is twice as deep
+    size_t max_connections = 256;           // One send buffer per connection
+    size_t send_buffer_size = 64 * 1024;
+    unsigned recv_buffer_count = 1024;      // Provided receive buffers, at most 65536
+    size_t recv_buffer_size = 4096;
+};
+
+// Counters for the io_uring event loop
+struct IoUringStats {
+    uint64_t enter_calls = 0;           // io_uring_enter syscalls
+    uint64_t wakeups = 0;               // eventfd writes by producer threads
+    uint64_t sqes_submitted = 0;
+    uint64_t completions = 0;
+    uint64_t messages_received = 0;
+    uint64_t bytes_sent = 0;
+};
+
+class IoUringServer;
+
+// Client session served by IoUringServer. Network state is owned by the server's
+// event loop thread; any thread may queue outbound messages.
+class IoUringConnection : public ProtocolSession {
+public:
+    IoUringConnection(IoUringServer& server, int fd, uint32_t slot, uint64_t connection_id,
+                      std::shared_ptr<const InstrumentRegistry> instruments);
+
+    bool is_connected() const override { return connected_.load(); }
+
+    void set_max_outbound_bytes(size_t bytes) { max_outbound_bytes_ = bytes; }
+
+    // Frame and dispatch received bytes; false on a protocol error
+    bool consume(const uint8_t* data, size_t length);
+
+protected:
+    bool enqueue(OutboundMessage&& message) override;
+    void disconnect(bool flush) override;
+
+private:
+    friend class IoUringServer;
+
+    IoUringServer& server_;
+    int fd_;
+    uint32_t slot_;
+    std::atomic<bool> connected_{true};
+    std::atomic<bool> close_after_flush_{false};
+
+    // Event loop state
+    bool recv_armed_{false};
+    bool write_inflight_{false};
+    bool closing_{false};
+    // Partial message carried between receives
+    std::vector<uint8_t, TrackingAllocator<uint8_t, MemorySubsystem::CONNECTION_BUFFERS>> input_;
+    size_t send_offset_{0};             // Progress through the send buffer
+    size_t send_length_{0};
+
+    // Outbound queue, drained into the send buffer by the event loop
+    static constexpr size_t DEFAULT_MAX_OUTBOUND_BYTES = 4 * 1024 * 1024;
+    std::mutex queue_mutex_;
+    std::deque<OutboundMessage, TrackingAllocator<OutboundMessage, MemorySubsystem::CONNECTION_BUFFERS>> pending_;
+    size_t front_offset_{0};            // Bytes of pending_.front() already copied
+    size_t queued_bytes_{0};
+    size_t max_outbound_bytes_{DEFAULT_MAX_OUTBOUND_BYTES};
+    bool write_scheduled_{false};
+};
+
+// Linux io_uring order entry server with the same surface as TCPServer.
+// One event loop thread owns the ring: multishot accept and multishot receive into
+// kernel-provided buffers, replies copied into per-connection send buffers,
+// and every submission made during a loop iteration sent with one io_uring_enter.
+class IoUringServer : public NetworkServer {
+public:
+    explicit IoUringServer(uint16_t port, const IoUringConfig& config = IoUringConfig{});
+    ~IoUringServer() override;
+
+    // Non-copyable, non-movable
+    IoUringServer(const IoUringServer&) = delete;
+    IoUringServer& operator=(const IoUringServer&) = delete;
+
+    // True if the running kernel supports every io_uring feature the event loop uses
+    static bool is_supported();
+
+    // Server lifecycle
+    bool start() override;
+    void stop() override;
+    bool is_running() const override;
+
+    // Client management
+    size_t get_client_count() const override;
+    void set_max_outbound_bytes(size_t bytes) override;
+    std::vector<uint64_t> get_client_ids() const override;
+
+    // Broadcasting
+    void broadcast_market_data(const MarketData& data) override;
+    void broadcast_order_book_update(const OrderBookSnapshot& snapshot) override;
+
+    // Callback setters
+    void set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback) override;
+    void set_order_cancel_callback(std::function<void(uint64_t, const std::string&)> callback) override;
+    void set_order_modify_callback(std::function<void(uint64_t, const std::string&, uint64_t, double)> callback) override;
+    void set_order_mass_cancel_callback(std::function<void(uint64_t, const std::string&, MassCancelSide)> callback) override;
+    void set_order_status_callback(std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> callback) override;
+
+    // Protocol configuration; set before start()
+    InstrumentRegistry& get_instrument_registry() override { return *instruments_; }
+    void set_text_protocol_enabled(bool enabled) override;
+    void set_session_config(const SessionConfig& config) override;
+    ThrottleStats get_throttle_stats() const override;
+
+    IoUringStats get_stats() const;
+
+private:
+    friend class IoUringConnection;
+
+    uint16_t port_;
+    IoUringConfig config_;
+    std::atomic<bool> running_{false};
+    std::thread loop_thread_;
+
+    // Ring memory
+    int ring_fd_{-1};
+    void* sq_ring_{nullptr};
+    void* cq_ring_{nullptr};
+    size_t sq_ring_size_{0};
+    size_t cq_ring_size_{0};
+    io_uring_sqe* sqes_{nullptr};
+    size_t sqes_size_{0};
+    unsigned* sq_head_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned sq_entries_{0};
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    io_uring_cqe* cqes_{nullptr};
+    unsigned sq_local_tail_{0};
+    unsigned to_submit_{0};
+
+    // Send buffers (one per connection slot) and provided receive buffers
+    uint8_t* send_buffers_{nullptr};
+    uint8_t* recv_buffers_{nullptr};
+    std::vector<uint16_t> recycled_buffers_;    // Consumed receive buffers to hand back
+
+    int listen_fd_{-1};
+    bool accept_retry_pending_{false};     // Re-arm accept on the next tick
+    int wake_fd_{-1};
+    uint64_t wake_value_{0};
+    std::atomic<bool> wake_pending_{false};
+
+    // Connections by slot; written only by the event loop, under clients_mutex_
+    std::vector<std::shared_ptr<IoUringConnection>> connections_;
+    std::vector<uint32_t> generations_;
+    std::vector<uint32_t> free_slots_;
+    size_t client_count_{0};
+    mutable std::shared_mutex clients_mutex_;
+    std::atomic<uint64_t> next_connection_id_{1};
+
+    // Slots with queued output, handed to the event loop
+    std::mutex ready_mutex_;
+    std::vector<uint32_t> ready_slots_;
+    std::vector<uint32_t> ready_batch_;
+
+    // Protocol configuration shared with every connection
+    std::shared_ptr<InstrumentRegistry> instruments_;
+    std::shared_ptr<SubscriptionTable> subscriptions_;
+    bool text_protocol_enabled_{true};
+    size_t max_outbound_bytes_{0};  // 0 keeps the connection default
+
+    // Session journals, and heartbeat timers keyed by slot generation and slot,
+    // driven by a periodic IORING_OP_TIMEOUT
+    std::shared_ptr<SessionStore> session_store_;
+    std::unique_ptr<TimerWheel> session_timers_;
+    std::unique_ptr<__kernel_timespec> tick_interval_;
+    std::vector<uint64_t> expired_timers_;
+
+    // Callbacks
+    std::function<bool(std::shared_ptr<Order>)> order_submit_callback_;
+    std::function<void(uint64_t, const std::string&)> order_cancel_callback_;
+    std::function<void(uint64_t, const std::string&, uint64_t, double)> order_modify_callback_;
+    std::function<void(uint64_t, const std::string&, MassCancelSide)> order_mass_cancel_callback_;
+    std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> order_status_callback_;
+
+    // Statistics
+    std::atomic<uint64_t> enter_calls_{0};
+    std::atomic<uint64_t> wakeups_{0};
+    std::atomic<uint64_t> sqes_submitted_{0};
+    std::atomic<uint64_t> completions_{0};
+    std::atomic<uint64_t> messages_received_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+
+    // Setup and teardown
+    bool setup_ring();
+    bool setup_buffers();
+    bool setup_listener();
+    void release_resources();
+
+    // Submission and completion
+    io_uring_sqe* get_sqe();
+    bool submit(bool wait);
+    void event_loop();
+    void handle_completion(const io_uring_cqe& cqe);
+    void arm_accept();
+    void arm_wake();
+    void arm_tick();
+    void handle_session_tick();
+    void arm_recv(IoUringConnection& connection);
+    void recycle_buffer(uint16_t buffer_id);
+    bool provide_recycled_buffers();
+
+    // Connections
+    void add_connection(int fd);
+    IoUringConnection* find_connection(uint32_t slot, uint32_t generation) const;
+    void drain_ready_slots();
+    void start_write(IoUringConnection& connection);
+    void submit_send(IoUringConnection& connection);
+    void close_connection(IoUringConnection& connection);
+    void release_connection_if_idle(IoUringConnection& connection);
+
+    // Called by connections from any thread
+    void schedule_write(uint32_t slot);
+};
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+class LatencyHistogram;
+
+// OS jitter detection. A sampler thread spins on the TSC, usually pinned to the
+// isolated core (or a spare sibling) of one engine role. Any gap between two
+// consecutive reads above the threshold is time the host took from it:
+// interrupts, SMIs, page faults, preemption. Gaps go into a histogram, so
+// engine latency can be compared with what the machine itself was doing.
+// Engine threads report their own scheduling and fault counts through
+// sched_register_thread() and sched_sample_thread().
+
+struct JitterSamplerSpec {
+    std::string role;       // Engine role whose core this sampler watches, e.g. "matching"
+    int cpu = -1;           // CPU to pin to, -1 leaves it unpinned
+};
+
+struct JitterConfig {
+    std::vector<JitterSamplerSpec> samplers;            // None by default; each one burns a core
+    std::chrono::nanoseconds gap_threshold{1000};       // Shorter gaps are the loop itself
+
+    bool enabled() const { return !samplers.empty(); }
+};
+
+// getrusage(RUSAGE_THREAD) of one thread, as of its last sample
+struct ThreadSchedStats {
+    std::string name;
+    uint64_t voluntary_switches = 0;
+    uint64_t involuntary_switches = 0;     // Preempted while runnable
+    uint64_t minor_faults = 0;
+    uint64_t major_faults = 0;
+};
+
+struct JitterStats {
+    std::string role;
+    int cpu = -1;
+    uint64_t sampled_ns = 0;        // Time spent sampling
+    uint64_t gaps = 0;              // Gaps above the threshold
+    uint64_t stolen_ns = 0;         // Their total length
+    uint64_t max_gap_ns = 0;
+    uint64_t p50_gap_ns = 0;
+    uint64_t p99_gap_ns = 0;
+    uint64_t p999_gap_ns = 0;
+    ThreadSchedStats sched;         // The sampler thread's own counts
+
+    double stolen_fraction() const {
+        return sampled_ns == 0 ? 0.0 : static_cast<double>(stolen_ns) / static_cast<double>(sampled_ns);
+    }
+};
+
+class JitterSampler {
+public:
+    JitterSampler(const JitterSamplerSpec& spec, std::chrono::nanoseconds gap_threshold);
+    ~JitterSampler();
+
+    // Non-copyable, non-movable
+    JitterSampler(const JitterSampler&) = delete;
+    JitterSampler& operator=(const JitterSampler&) = delete;
+
+    // Waits until the sampler thread has pinned itself; false if it could not
+    bool start();
+    void stop();
+
+    JitterStats get_stats() const;
+
+private:
+    JitterSamplerSpec spec_;
+    uint64_t threshold_ticks_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    // Written by the sampler thread only
+    std::unique_ptr<LatencyHistogram> gaps_;
+    std::atomic<uint64_t> sampled_ticks_{0};
+    std::atomic<uint64_t> stolen_ticks_{0};
+    std::atomic<uint64_t> voluntary_switches_{0};
+    std::atomic<uint64_t> involuntary_switches_{0};
+    std::atomic<uint64_t> minor_faults_{0};
+    std::atomic<uint64_t> major_faults_{0};
+
+    void sampler_thread_worker(std::promise<bool>& started);
+    void sample_rusage();
+};
+
+class JitterMonitor {
+public:
+    explicit JitterMonitor(const JitterConfig& config);
+    ~JitterMonitor();
+
+    bool start();   // False if a sampler could not start; the others keep running
+    void stop();
+
+    std::vector<JitterStats> get_stats() const;
+
+private:
+    std::vector<std::unique_ptr<JitterSampler>> samplers_;
+};
+
+// Scheduling counters of engine threads. A thread registers once, then calls
+// sched_sample_thread() from its loop; that reads getrusage at most every 100 ms
+// and otherwise costs one TSC read.
+void sched_register_thread(const std::string& name);
+void sched_sample_thread();
+void sched_unregister_thread();     // Takes a final sample; the counts stay visible
+
+std::vector<ThreadSchedStats> sched_get_thread_stats();
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "market_data_processor.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// JSON market data source for crypto-style venues (DataSourceType::CRYPTO_EXCHANGE).
+//
+// Reads from a file (data_source_url = path) or a local socket stand-in
+// (data_source_url = "unix:/path/to/socket") and parses each message on demand:
+// fields are located by scanning the raw bytes, nothing is materialized into a DOM
+// and no memory is allocated per message. Decimal price and size strings are
+// converted straight to integer ticks without going through strtod.
+//
+// Expected messages (field order is free, unknown fields are skipped):
+//   {"type":"trade","symbol":"BTC-USD","seq":1,"trade_id":7,"price":"43125.50","size":"0.015"}
+//   {"type":"quote","symbol":"BTC-USD","seq":2,"bid":"43125.00","bid_size":"1.2","ask":"43126.00","ask_size":"0.8"}
+//   {"type":"book","symbol":"BTC-USD","seq":3,"side":"bid","price":"43124.50","size":"2.5"}
+class JsonMarketDataSource : public MarketDataSource {
+public:
+    explicit JsonMarketDataSource(const MarketDataConfig& config);
+    ~JsonMarketDataSource() override;
+
+    bool connect() override;
+    void disconnect() override;
+    bool is_connected() const override;
+
+    bool start_streaming() override;
+    void stop_streaming() override;
+
+    void set_data_callback(std::function<void(const MarketData&)> callback) override;
+    void set_error_callback(std::function<void(const std::string&)> callback) override;
+
+    const MarketDataStats& get_stats() const override;
+    void reset_stats() override;
+
+    // Parse a single JSON message; returns false if it is malformed, of an unknown
+    // type, a book update without a bid/buy or ask/sell side, or has a price or
+    // size finer than the configured decimals
+    bool parse_message(std::string_view message, MarketData& out) const;
+
+    // Convert a decimal string (e.g. "43125.5") to an integer count of 10^-decimals units.
+    // Returns false on malformed input, overflow, or non-zero digits past `decimals`,
+    // which could not be represented.
+    static bool parse_decimal_to_ticks(std::string_view text, int decimals, int64_t& ticks);
+
+private:
+    MarketDataConfig config_;
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> streaming_{false};
+
+    std::thread reader_thread_;
+    std::atomic<bool> shutdown_requested_{false};
+
+    std::function<void(const MarketData&)> data_callback_;
+    std::function<void(const std::string&)> error_callback_;
+
+    int fd_{-1};
+    bool is_socket_{false};
+
+    // Read buffer, allocated once in connect()
+    std::vector<char> buffer_;
+    size_t buffer_begin_{0};
+    size_t buffer_end_{0};
+
+    double price_divisor_;
+
+    MarketDataStats stats_;
+
+    // Scratch object reused for every parsed message
+    MarketData decoded_;
+
+    // Internal methods
+    void reader_thread_worker();
+    size_t process_buffer();
+    void dispatch_message(std::string_view message);
+    void report_error(const std::string& error);
+};
+
+} // namespace UltraFastAnalysis
@@ -4,6 +4,8 @@
 #include <string>
 #include <chrono>
 #include <vector>
+#include <array>
+#include <utility>
 
 namespace UltraFastAnalysis {
 
@@ -14,6 +16,8 @@ enum class MarketDataType : uint8_t {
     TICK = 3
 };
 
+// Quantities are integer lots as the source reports them: whole units for the
+// UDP, binary and replay sources, 10^-quantity_decimals for the JSON feed.
 struct MarketData {
     uint64_t sequence_number;
     std::string symbol;
@@ -89,4 +93,18 @@ struct OrderBookSnapshot {
     }
 };
 
+// Top levels of one book, filled in place on every change without allocating
+struct BookDepth {
+    static constexpr size_t MAX_LEVELS = 10;
+    
+    std::array<std::pair<double, uint64_t>, MAX_LEVELS> bids{};   // Best first
+    std::array<std::pair<double, uint64_t>, MAX_LEVELS> asks{};
+    size_t bid_count = 0;
+    size_t ask_count = 0;
+    uint64_t update_sequence = 0;   // Book changes so far
+    uint64_t trade_count = 0;
+    double last_trade_price = 0.0;
+    uint64_t last_trade_quantity = 0;
+};
+
 } // namespace UltraFastAnalysis
@@ -2,12 +2,16 @@
 
 #include "market_data.h"
 #include "ring_buffer.h"
+#include "market_data_recorder.h"
 #include <thread>
 #include <atomic>
 #include <functional>
 #include <memory>
 #include <vector>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
 
 namespace UltraFastAnalysis {
 
@@ -16,7 +20,15 @@ enum class DataSourceType : uint8_t {
     NASDAQ_ITCH = 0,
     CRYPTO_EXCHANGE = 1,
     SIMULATED = 2,
-    CUSTOM_FEED = 3
+    CUSTOM_FEED = 3,
+    UDP_MULTICAST = 4,
+    REPLAY = 5
+};
+
+// Framing of JSON feeds (DataSourceType::CRYPTO_EXCHANGE)
+enum class JsonFraming : uint8_t {
+    NEWLINE_DELIMITED = 0,   // One JSON object per line
+    LENGTH_PREFIXED = 1      // 4-byte little-endian length followed by the object
 };
 
 // Market data processor configuration
@@ -29,13 +41,40 @@ struct MarketDataConfig {
     bool enable_compression = false;
     std::chrono::milliseconds heartbeat_interval{1000};
     std::string data_source_url;
-    uint16_t data_source_port;
+    uint16_t data_source_port = 0;
     
     // Performance tuning
     size_t ring_buffer_size = 65536;
     size_t max_message_size = 8192;
     bool enable_batching = true;
     std::chrono::microseconds max_processing_latency{50}; // 50 microseconds
+    
+    // UDP multicast feed (A/B lines); an empty group B runs a single line
+    std::string multicast_group_a = "239.1.1.1";
+    uint16_t multicast_port_a = 30001;
+    std::string multicast_group_b = "239.1.1.2";
+    uint16_t multicast_port_b = 30002;
+    std::string multicast_interface = "0.0.0.0";
+    int socket_receive_buffer_size = 16 * 1024 * 1024;
+    size_t recv_batch_size = 64;
+    std::chrono::microseconds arbitration_hold{200}; // Wait this long for the other line before declaring a gap
+    size_t arbitration_hold_packets = 1024;           // Out-of-order packets kept while waiting
+    
+    // JSON feed (data_source_url = file path or "unix:/path/to/socket")
+    JsonFraming json_framing = JsonFraming::NEWLINE_DELIMITED;
+    int price_decimals = 8;       // Prices are parsed into ticks of 10^-price_decimals
+    int quantity_decimals = 0;    // Sizes are reported in lots of 10^-quantity_decimals; 0 keeps whole
+                                  // units like the other sources, fractional sizes need more
+    size_t json_read_buffer_size = 1 << 20;
+    
+    // Feed plugin (DataSourceType::CUSTOM_FEED), see feed_plugin.h
+    std::string plugin_path;
+    std::string plugin_config;    // Passed verbatim to the plugin's create()
+    
+    // Recording and replay (DataSourceType::REPLAY, data_source_url = recording path)
+    std::string record_path;      // Record every submitted event here while running
+    double replay_speed = 1.0;    // 1.0 = recorded pace, N = N times faster, 0 = as fast as possible
+    std::chrono::microseconds replay_max_gap{0}; // Cap on replayed idle gaps, 0 preserves them all
 };
 
 // Market data statistics
@@ -167,6 +206,7 @@ public:
     bool is_running() const;
     
     // Data source management
+    void set_data_source(std::unique_ptr<MarketDataSource> source);
     bool connect_data_source();
     void disconnect_data_source();
     bool is_data_source_connected() const;
@@ -176,6 +216,12 @@ public:
     void set_data_callback(std::function<void(const MarketData&)> callback);
     void set_error_callback(std::function<void(const std::string&)> callback);
     
+    // Recording of submitted events for later replay
+    bool start_recording(const std::string& path);
+    void stop_recording();
+    bool is_recording() const;
+    const RecorderStats& get_recorder_stats() const;
+    
     // Configuration
     MarketDataConfig get_config() const;
     void update_config(const MarketDataConfig& config);
@@ -201,6 +247,9 @@ private:
     // Processing threads
     std::vector<std::thread> processing_threads_;
     
+    // Recorder fed from submit_market_data
+    std::unique_ptr<MarketDataRecorder> recorder_;
+    
     // Callbacks
     std::function<void(const MarketData&)> data_callback_;
     std::function<void(const std::string&)> error_callback_;
@@ -209,6 +258,7 @@ private:
     MarketDataStats stats_;
     
     // Internal methods
+    static std::unique_ptr<MarketDataSource> create_data_source(const MarketDataConfig& config);
     void processing_thread_worker();
     void process_market_data_batch();
     
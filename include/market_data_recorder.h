@@ -0,0 +1,115 @@
+#pragma once
+
+#include "market_data.h"
+#include "ring_buffer.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// On-disk format of market data recordings (little-endian, packed):
+// one RecordingFileHeader followed by fixed-size MarketDataRecords.
+#pragma pack(push, 1)
+struct RecordingFileHeader {
+    char magic[8];              // RECORDING_MAGIC
+    uint32_t version;           // RECORDING_VERSION
+    uint32_t record_size;       // sizeof(MarketDataRecord) the file was written with
+    uint64_t created_ns;        // Wall clock time the recording was opened
+    uint64_t reserved;
+};
+
+struct MarketDataRecord {
+    uint64_t receive_timestamp_ns;  // Monotonic time the processor received the event
+    uint64_t event_timestamp_ns;    // MarketData::timestamp
+    uint64_t sequence_number;
+    uint64_t trade_id;
+    char symbol[16];                // NUL-padded
+    uint8_t type;                   // MarketDataType
+    uint8_t is_bid;
+    uint8_t reserved[6];
+    double trade_price;
+    uint64_t trade_quantity;
+    double bid_price;
+    uint64_t bid_quantity;
+    double ask_price;
+    uint64_t ask_quantity;
+    double price;
+    uint64_t quantity;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(RecordingFileHeader) == 32, "RecordingFileHeader layout changed");
+static_assert(sizeof(MarketDataRecord) == 120, "MarketDataRecord layout changed");
+
+constexpr char RECORDING_MAGIC[8] = {'U', 'F', 'A', 'M', 'D', 'R', 'E', 'C'};
+constexpr uint32_t RECORDING_VERSION = 1;
+
+// Conversion between normalized events and records
+void encode_market_data_record(const MarketData& data, uint64_t receive_timestamp_ns, MarketDataRecord& record);
+void decode_market_data_record(const MarketDataRecord& record, MarketData& data);
+
+// Recorder statistics
+struct RecorderStats {
+    std::atomic<uint64_t> records_written{0};
+    std::atomic<uint64_t> records_dropped{0};
+    std::atomic<uint64_t> bytes_written{0};
+    std::atomic<uint64_t> write_errors{0};
+
+    void reset() {
+        records_written = 0;
+        records_dropped = 0;
+        bytes_written = 0;
+        write_errors = 0;
+    }
+};
+
+// Captures normalized market data to a binary recording.
+// record() only encodes the event into a lock-free ring; a background writer thread
+// drains the ring to disk in batches, so the hot path never blocks on I/O. Events
+// are dropped (and counted) if the writer falls a full ring behind.
+// record() must be called from a single producer thread.
+class MarketDataRecorder {
+public:
+    static constexpr size_t RING_SIZE = 65536;
+
+    MarketDataRecorder();
+    ~MarketDataRecorder();
+
+    // Non-copyable, non-movable
+    MarketDataRecorder(const MarketDataRecorder&) = delete;
+    MarketDataRecorder& operator=(const MarketDataRecorder&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool is_recording() const;
+
+    bool record(const MarketData& data);
+
+    const RecorderStats& get_stats() const;
+    std::string get_path() const;
+
+private:
+    std::unique_ptr<LockFreeRingBuffer<MarketDataRecord, RING_SIZE>> ring_;
+    std::FILE* file_{nullptr};
+    std::string path_;
+
+    std::thread writer_thread_;
+    std::atomic<bool> recording_{false};
+    std::atomic<bool> shutdown_requested_{false};
+
+    // Batch drained from the ring per write, allocated once
+    std::vector<MarketDataRecord> write_buffer_;
+
+    RecorderStats stats_;
+
+    // Internal methods
+    void writer_thread_worker();
+    size_t drain_ring();
+};
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace UltraFastAnalysis {
+
+// Subsystem-level memory accounting. Process RSS says how much memory the engine
+// holds, not which part of it grew. Containers of the major subsystems allocate
+// through TrackingAllocator, and fixed-size buffers hold a MemoryCharge, so live
+// and peak bytes are known per subsystem. Counting is a relaxed atomic add per
+// allocation; the counters of each subsystem sit on their own cache line.
+
+enum class MemorySubsystem : uint8_t {
+    ORDER_BOOKS,            // Price levels and order-by-id indexes
+    ORDERS,                 // Order objects and their shared_ptr control blocks
+    RING_BUFFERS,
+    TRADE_TAPES,            // Recent trades kept per book
+    CONNECTION_BUFFERS,     // Client read buffers and outbound queues
+    HISTOGRAMS,             // LatencyHistogram buckets
+    SESSIONS,               // Session journal indexes and market data subscriptions
+    COUNT
+};
+
+constexpr size_t MEMORY_SUBSYSTEM_COUNT = static_cast<size_t>(MemorySubsystem::COUNT);
+
+struct MemorySubsystemStats {
+    const char* name = "";
+    uint64_t live_bytes = 0;
+    uint64_t peak_bytes = 0;
+    uint64_t allocations = 0;       // Since start
+    uint64_t frees = 0;
+};
+
+const char* memory_subsystem_name(MemorySubsystem subsystem);
+
+void memory_account_allocate(MemorySubsystem subsystem, size_t bytes) noexcept;
+void memory_account_free(MemorySubsystem subsystem, size_t bytes) noexcept;
+
+std::array<MemorySubsystemStats, MEMORY_SUBSYSTEM_COUNT> get_memory_subsystem_stats();
+uint64_t get_memory_accounted_bytes();     // Live bytes over all subsystems
+
+// Peaks restart from the current live bytes
+void reset_memory_subsystem_peaks();
+
+// std::allocator that charges every allocation to one subsystem. Stateless, so
+// containers using it stay as cheap to move and swap as with std::allocator.
+template<typename T, MemorySubsystem Subsystem>
+class TrackingAllocator {
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = TrackingAllocator<U, Subsystem>;
+    };
+
+    TrackingAllocator() noexcept = default;
+
+    template<typename U>
+    TrackingAllocator(const TrackingAllocator<U, Subsystem>&) noexcept {}
+
+    T* allocate(size_t count) {
+        T* result = std::allocator<T>().allocate(count);
+        memory_account_allocate(Subsystem, count * sizeof(T));
+        return result;
+    }
+
+    void deallocate(T* pointer, size_t count) noexcept {
+        memory_account_free(Subsystem, count * sizeof(T));
+        std::allocator<T>().deallocate(pointer, count);
+    }
+
+    template<typename U>
+    bool operator==(const TrackingAllocator<U, Subsystem>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const TrackingAllocator<U, Subsystem>&) const noexcept { return false; }
+};
+
+// Bytes held outside any allocator, such as a buffer embedded in an object,
+// charged for as long as the owner lives
+class MemoryCharge {
+public:
+    explicit MemoryCharge(MemorySubsystem subsystem, size_t bytes = 0) noexcept
+        : subsystem_(subsystem), bytes_(bytes) {
+        memory_account_allocate(subsystem_, bytes_);
+    }
+
+    ~MemoryCharge() {
+        memory_account_free(subsystem_, bytes_);
+    }
+
+    // Non-copyable: each charge is released once
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+    void resize(size_t bytes) noexcept {
+        memory_account_free(subsystem_, bytes_);
+        bytes_ = bytes;
+        memory_account_allocate(subsystem_, bytes_);
+    }
+
+    size_t bytes() const { return bytes_; }
+
+private:
+    MemorySubsystem subsystem_;
+    size_t bytes_;
+};
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "order.h"
+#include "market_data.h"
+#include "order_entry_protocol.h"
+#include "order_status_table.h"
+#include "session_layer.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// Network backends for the order entry server
+enum class NetworkBackend : uint8_t {
+    ASIO = 0,       // Boost.Asio (epoll), TCPServer
+    IO_URING = 1    // Linux io_uring, IoUringServer
+};
+
+// How TCPServer spreads connections over its worker threads
+enum class IoThreadingModel : uint8_t {
+    SHARED = 0,         // One io_context run by every worker; a connection's handlers may hop threads
+    PER_THREAD = 1      // One io_context per worker; each connection stays on one worker
+};
+
+// Worker choice for accepted connections in PER_THREAD mode
+enum class ConnectionAffinity : uint8_t {
+    ROUND_ROBIN = 0,
+    CLIENT_ADDRESS = 1  // Hash of the peer address, so a client host always lands on the same worker
+};
+
+// Network server settings; a backend ignores the ones it has no use for
+struct NetworkServerConfig {
+    uint16_t port = 8080;
+    size_t num_threads = 4;
+    IoThreadingModel threading = IoThreadingModel::SHARED;
+    ConnectionAffinity affinity = ConnectionAffinity::ROUND_ROBIN;
+    bool reuse_port = false;        // PER_THREAD: one SO_REUSEPORT acceptor per worker, the kernel picks the worker
+    bool pin_threads = false;       // Pin worker i to CPU i (Linux)
+};
+
+// Order entry server interface shared by every network backend
+class NetworkServer {
+public:
+    virtual ~NetworkServer() = default;
+
+    // Server lifecycle
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+    virtual bool is_running() const = 0;
+
+    // Client management
+    virtual size_t get_client_count() const = 0;
+    virtual void set_max_outbound_bytes(size_t bytes) = 0;
+    virtual std::vector<uint64_t> get_client_ids() const = 0;
+
+    // Broadcasting
+    virtual void broadcast_market_data(const MarketData& data) = 0;
+    virtual void broadcast_order_book_update(const OrderBookSnapshot& snapshot) = 0;
+
+    // Callback setters
+    virtual void set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback) = 0;
+    virtual void set_order_cancel_callback(std::function<void(uint64_t, const std::string&)> callback) = 0;
+    virtual void set_order_modify_callback(std::function<void(uint64_t, const std::string&, uint64_t, double)> callback) = 0;
+    virtual void set_order_mass_cancel_callback(std::function<void(uint64_t, const std::string&, MassCancelSide)> callback) = 0;
+    virtual void set_order_status_callback(std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> callback) = 0;
+
+    // Protocol configuration; set before start()
+    virtual InstrumentRegistry& get_instrument_registry() = 0;
+    virtual void set_text_protocol_enabled(bool enabled) = 0;
+    virtual void set_session_config(const SessionConfig& config) = 0;
+
+    // Order entry throttling across all sessions (SessionConfig::throttle)
+    virtual ThrottleStats get_throttle_stats() const = 0;
+};
+
+// Create the server for `backend`. IO_URING falls back to ASIO when the platform
+// or kernel does not support it.
+std::unique_ptr<NetworkServer> create_network_server(NetworkBackend backend, const NetworkServerConfig& config);
+
+const char* network_backend_name(NetworkBackend backend);
+const char* io_threading_model_name(IoThreadingModel model);
+
+} // namespace UltraFastAnalysis
@@ -4,6 +4,8 @@
 #include <string>
 #include <chrono>
 #include <memory>
+#include <utility>
+#include "memory_accounting.h"
 
 namespace UltraFastAnalysis {
 
@@ -75,6 +77,14 @@ struct Order {
     }
 };
 
+// Orders the engine accepts are created here, so they and their control blocks
+// count towards MemorySubsystem::ORDERS until the last reference is gone
+template<typename... Args>
+std::shared_ptr<Order> make_order(Args&&... args) {
+    return std::allocate_shared<Order>(TrackingAllocator<Order, MemorySubsystem::ORDERS>(),
+                                       std::forward<Args>(args)...);
+}
+
 // Order comparison for priority queue (price-time priority)
 struct OrderCompare {
     bool operator()(const Order* lhs, const Order* rhs) const {
@@ -2,14 +2,33 @@
 
 #include "order.h"
 #include "market_data.h"
+#include "order_status_table.h"
+#include "memory_accounting.h"
 #include <map>
 #include <unordered_map>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <functional>
 
 namespace UltraFastAnalysis {
 
+// Fill (fill_quantity > 0), cancel or amend of an order already in a book.
+// Runs on the matching thread while the book's write lock is held.
+using ExecutionCallback = std::function<void(const Order& order, uint64_t fill_quantity, double fill_price)>;
+
+// Book depth after each add, cancel, amend or mass cancel. Runs on the matching
+// thread while the book's write lock is held.
+using DepthCallback = std::function<void(const std::string& symbol, const BookDepth& depth)>;
+
+// Orders resting at one price, in time priority
+using PriceLevel = std::vector<std::shared_ptr<Order>,
+                               TrackingAllocator<std::shared_ptr<Order>, MemorySubsystem::ORDER_BOOKS>>;
+
+template<typename Compare>
+using PriceLevelMap = std::map<double, PriceLevel, Compare,
+                               TrackingAllocator<std::pair<const double, PriceLevel>, MemorySubsystem::ORDER_BOOKS>>;
+
 class OrderBook {
 public:
     explicit OrderBook(const std::string& symbol);
@@ -23,6 +42,7 @@ public:
     bool add_order(std::shared_ptr<Order> order);
     bool cancel_order(uint64_t order_id);
     bool modify_order(uint64_t order_id, uint64_t new_quantity, double new_price);
+    size_t cancel_client_orders(uint64_t client_id, bool cancel_bids, bool cancel_asks);
     
     // Order book queries
     double get_best_bid() const;
@@ -43,6 +63,15 @@ public:
     size_t get_trade_count() const;
     double get_total_volume() const;
     
+    // Order state for status queries; readable without the book lock
+    const OrderStatusTable& get_status_table() const { return status_table_; }
+    
+    // Fills, cancels and amends of this book's orders are reported here
+    void set_execution_callback(ExecutionCallback callback);
+    
+    // Depth is only computed while a callback is set
+    void set_depth_callback(DepthCallback callback);
+    
     // Thread safety
     void lock_for_reading() const;
     void unlock_for_reading() const;
@@ -53,14 +82,22 @@ private:
     std::string symbol_;
     
     // Order storage - using maps for price-time priority
-    std::map<double, std::vector<std::shared_ptr<Order>>, std::greater<double>> bids_;
-    std::map<double, std::vector<std::shared_ptr<Order>>, std::less<double>> asks_;
+    PriceLevelMap<std::greater<double>> bids_;
+    PriceLevelMap<std::less<double>> asks_;
     
     // Fast order lookup by ID
-    std::unordered_map<uint64_t, std::shared_ptr<Order>> orders_by_id_;
+    std::unordered_map<uint64_t, std::shared_ptr<Order>, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                       TrackingAllocator<std::pair<const uint64_t, std::shared_ptr<Order>>,
+                                         MemorySubsystem::ORDER_BOOKS>> orders_by_id_;
     
     // Trade history
-    std::vector<MarketData> recent_trades_;
+    std::vector<MarketData, TrackingAllocator<MarketData, MemorySubsystem::TRADE_TAPES>> recent_trades_;
+    
+    // Written under rw_mutex_, including for orders that have left the book
+    OrderStatusTable status_table_;
+    ExecutionCallback execution_callback_;
+    DepthCallback depth_callback_;
+    BookDepth depth_;
     
     // Statistics
     size_t total_orders_;
@@ -76,6 +113,8 @@ private:
     void match_orders();
     void record_trade(const Order* buy_order, const Order* sell_order, 
                      double price, uint64_t quantity);
+    void record_execution(const Order& order, uint64_t fill_quantity = 0, double fill_price = 0.0);
+    void publish_depth();
     
     // Price level management
     void add_to_bid_level(double price, std::shared_ptr<Order> order);
@@ -109,8 +148,14 @@ public:
     
     void remove_order_book(const std::string& symbol);
     
+    // Applied to existing books and to books created later
+    void set_execution_callback(ExecutionCallback callback);
+    void set_depth_callback(DepthCallback callback);
+    
 private:
     mutable std::shared_mutex rw_mutex_;
+    ExecutionCallback execution_callback_;
+    DepthCallback depth_callback_;
     std::unordered_map<std::string, std::shared_ptr<OrderBook>> order_books_;
 };
 
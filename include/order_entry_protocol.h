@@ -0,0 +1,237 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// Binary order entry protocol.
+// Each message body follows the MessageHeader and has a fixed little-endian, packed
+// layout. Prices are integer ticks of the instrument's tick size and instruments are
+// referenced by id, so bodies are decoded in place from the read buffer.
+static_assert(std::endian::native == std::endian::little,
+              "Binary order entry messages are decoded in place and require a little-endian host");
+
+enum class MassCancelSide : uint8_t {
+    BUY = 0,
+    SELL = 1,
+    BOTH = 2
+};
+
+enum class OrderAckStatus : uint8_t {
+    ACCEPTED = 0,
+    REJECTED = 1
+};
+
+enum class OrderStatusResult : uint8_t {
+    FOUND = 0,
+    UNKNOWN_ORDER = 1,          // Not yet reached the book, never existed, or evicted
+    UNKNOWN_INSTRUMENT = 2
+};
+
+enum class LoginStatus : uint8_t {
+    ACCEPTED = 0,
+    REJECTED = 1        // Session held by another connection, or unusable session name
+};
+
+enum class OrderRejectReason : uint8_t {
+    NONE = 0,
+    UNKNOWN_INSTRUMENT = 1,
+    INVALID_QUANTITY = 2,
+    INVALID_PRICE = 3,
+    INVALID_SIDE = 4,
+    INVALID_ORDER_TYPE = 5,
+    NOT_SUPPORTED = 6,
+    UNAVAILABLE = 7,            // Engine stopped or its ingress queue is full
+    THROTTLED = 8               // Session or instrument over its order entry rate
+};
+
+#pragma pack(push, 1)
+struct NewOrderMessage {
+    uint64_t client_order_id;   // Echoed back in the OrderAckMessage
+    uint32_t instrument_id;
+    uint8_t side;               // OrderSide
+    uint8_t order_type;         // OrderType
+    uint16_t reserved;
+    int64_t price;              // Ticks
+    int64_t stop_price;         // Ticks, STOP and STOP_LIMIT only
+    uint64_t quantity;
+};
+
+struct CancelOrderMessage {
+    uint64_t order_id;
+    uint32_t instrument_id;
+    uint32_t reserved;
+};
+
+struct AmendOrderMessage {
+    uint64_t order_id;
+    uint32_t instrument_id;
+    uint32_t reserved;
+    int64_t new_price;          // Ticks
+    uint64_t new_quantity;
+};
+
+struct MassCancelMessage {
+    uint32_t instrument_id;     // 0 cancels across all instruments
+    uint8_t side;               // MassCancelSide
+    uint8_t reserved[3];
+};
+
+// Subscribe or unsubscribe (MessageType SUBSCRIBE / UNSUBSCRIBE)
+struct SubscriptionMessage {
+    uint32_t instrument_id;     // 0 applies to every instrument
+    uint8_t channels;           // SubscriptionChannel bits, see subscription_table.h
+    uint8_t reserved[3];
+};
+
+struct OrderAckMessage {
+    uint64_t client_order_id;
+    uint64_t order_id;          // Engine order id, 0 when rejected
+    uint32_t instrument_id;
+    uint8_t status;             // OrderAckStatus
+    uint8_t reject_reason;      // OrderRejectReason
+    uint16_t reserved;
+};
+
+// Fill, cancel or amend of a resting order (MessageType EXECUTION_REPORT)
+struct ExecutionReportMessage {
+    uint64_t order_id;
+    uint64_t last_quantity;     // Filled by this execution, 0 for a cancel or amend
+    int64_t last_price;         // Ticks, 0 unless last_quantity is set
+    uint64_t filled_quantity;
+    uint64_t leaves_quantity;
+    uint32_t instrument_id;
+    uint8_t status;             // OrderStatus after this execution
+    uint8_t reserved[3];
+};
+
+// Status query (MessageType ORDER_STATUS_REQUEST); answered with an OrderStatusMessage
+// of the same type, read from the order state table without entering the book
+struct OrderStatusRequestMessage {
+    uint64_t order_id;
+    uint32_t instrument_id;
+    uint32_t reserved;
+};
+
+struct OrderStatusMessage {
+    uint64_t order_id;
+    uint64_t quantity;
+    uint64_t filled_quantity;
+    double average_price;       // Price units rather than ticks; an average is rarely a whole tick
+    uint64_t update_sequence;   // Increases with every change to orders of this instrument
+    uint32_t instrument_id;
+    uint8_t result;             // OrderStatusResult
+    uint8_t status;             // OrderStatus, valid when result is FOUND
+    uint16_t reserved;
+};
+
+// Session messages. Every outbound message carries a per-session sequence number in
+// MessageHeader::sequence_number, starting again at 1 for a new session.
+
+// Reply to LOGIN
+struct LoginAckMessage {
+    uint64_t next_inbound_sequence;     // Next sequence expected from the client, 0 if not yet known
+    uint64_t last_outbound_sequence;    // Last message sent before this reply; request a resend for any gap
+    uint32_t heartbeat_interval_ms;
+    uint8_t status;                     // LoginStatus
+    uint8_t reserved[3];
+};
+
+// Resend [begin_sequence, end_sequence]; end_sequence 0 means through the latest
+struct ResendRequestMessage {
+    uint64_t begin_sequence;
+    uint64_t end_sequence;
+};
+
+// Sequence numbers from the header's sequence_number up to new_sequence are skipped.
+// Gap fills stand in for messages that are not resent, such as market data.
+struct SequenceResetMessage {
+    uint64_t new_sequence;
+    uint8_t gap_fill;
+    uint8_t reserved[7];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(NewOrderMessage) == 40, "NewOrderMessage layout changed");
+static_assert(sizeof(CancelOrderMessage) == 16, "CancelOrderMessage layout changed");
+static_assert(sizeof(AmendOrderMessage) == 32, "AmendOrderMessage layout changed");
+static_assert(sizeof(MassCancelMessage) == 8, "MassCancelMessage layout changed");
+static_assert(sizeof(OrderAckMessage) == 24, "OrderAckMessage layout changed");
+static_assert(sizeof(ExecutionReportMessage) == 48, "ExecutionReportMessage layout changed");
+static_assert(sizeof(SubscriptionMessage) == 8, "SubscriptionMessage layout changed");
+static_assert(sizeof(OrderStatusRequestMessage) == 16, "OrderStatusRequestMessage layout changed");
+static_assert(sizeof(OrderStatusMessage) == 48, "OrderStatusMessage layout changed");
+static_assert(sizeof(LoginAckMessage) == 24, "LoginAckMessage layout changed");
+static_assert(sizeof(ResendRequestMessage) == 16, "ResendRequestMessage layout changed");
+static_assert(sizeof(SequenceResetMessage) == 16, "SequenceResetMessage layout changed");
+
+// View a message body as T without copying; nullptr if the length does not match.
+// All protocol structs are packed, so the body needs no particular alignment.
+template<typename T>
+inline const T* decode_message(const uint8_t* data, size_t length) {
+    static_assert(alignof(T) == 1, "Protocol messages must be packed");
+    if (!data || length != sizeof(T)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const T*>(data);
+}
+
+// Instrument reference data for the binary protocol
+struct InstrumentInfo {
+    uint32_t instrument_id = 0;
+    std::string symbol;
+    double tick_size = 0.01;
+};
+
+// Maps instrument ids to symbols and tick sizes.
+// Populate before the server starts; lookups are lock-free reads of a dense table.
+class InstrumentRegistry {
+public:
+    bool register_instrument(uint32_t instrument_id, const std::string& symbol, double tick_size);
+
+    const InstrumentInfo* find(uint32_t instrument_id) const {
+        if (instrument_id >= instruments_.size() || instruments_[instrument_id].instrument_id == 0) {
+            return nullptr;
+        }
+        return &instruments_[instrument_id];
+    }
+
+    // Hash lookup; the string_view overload lets callers look up a symbol in place
+    const InstrumentInfo* find_by_symbol(std::string_view symbol) const;
+
+    // Registered instruments in id order
+    std::vector<const InstrumentInfo*> get_instruments() const;
+
+    size_t size() const { return count_; }
+
+    // Conversions between ticks and the engine's double prices
+    static double ticks_to_price(const InstrumentInfo& instrument, int64_t ticks) {
+        return static_cast<double>(ticks) * instrument.tick_size;
+    }
+
+    static int64_t price_to_ticks(const InstrumentInfo& instrument, double price);
+
+private:
+    struct SymbolHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view symbol) const { return std::hash<std::string_view>{}(symbol); }
+    };
+
+    std::vector<InstrumentInfo> instruments_;  // Indexed by instrument id, id 0 is unused
+    std::unordered_map<std::string, uint32_t, SymbolHash, std::equal_to<>> symbol_index_;
+    size_t count_ = 0;
+
+    static constexpr uint32_t MAX_INSTRUMENT_ID = 1u << 20;
+};
+
+// Check a new order against its instrument (nullptr if unknown); NONE when it can be submitted
+OrderRejectReason validate_new_order(const NewOrderMessage& message, const InstrumentInfo* instrument);
+
+} // namespace UltraFastAnalysis
@@ -3,8 +3,13 @@
 #include "order_book.h"
 #include "ring_buffer.h"
 #include "market_data.h"
+#include "network_server.h"
+#include "jitter_monitor.h"
+#include "market_data_processor.h"
+#include "performance_monitor.h"
 #include <thread>
 #include <atomic>
+#include <condition_variable>
 #include <vector>
 #include <memory>
 #include <functional>
@@ -13,8 +18,11 @@
 namespace UltraFastAnalysis {
 
 // Forward declarations
-class TCPServer;
-class MarketDataProcessor;
+class FixGateway;
+class ShmOrderEntryGateway;
+class ShmBookPublisher;
+class FlightRecorder;
+struct FlightRecorderStats;
 
 // Configuration for the matching engine
 struct EngineConfig {
@@ -24,10 +32,27 @@ struct EngineConfig {
     size_t max_orders_per_symbol = 100000;
     size_t max_market_data_queue_size = 1000000;
     bool enable_performance_monitoring = true;
-    std::chrono::microseconds max_latency_threshold{100}; // 100 microseconds
+    std::chrono::microseconds max_latency_threshold{100}; // 100 microseconds; orders over it trigger flight recorder dumps
     uint16_t tcp_port = 8080;
+    NetworkBackend network_backend = NetworkBackend::ASIO;  // IO_URING needs Linux 6.0+
+    IoThreadingModel network_threading = IoThreadingModel::SHARED;
+    ConnectionAffinity network_affinity = ConnectionAffinity::ROUND_ROBIN;
+    bool network_reuse_port = false;   // PER_THREAD only
+    bool pin_network_threads = false;
+    std::string session_journal_directory;              // Outbound session journals; empty keeps them in memory
+    std::chrono::seconds heartbeat_interval{30};        // Default for sessions whose LOGIN does not set one
+    ThrottleConfig order_throttle;                      // Per-session order entry rate limits, off by default
     bool verbose_logging = false;
     bool simulation_mode = false;
+    bool enable_text_protocol = true;  // Accept the legacy text order messages alongside binary
+    uint16_t fix_port = 0;             // FIX 4.4 acceptor port, 0 disables the FIX gateway
+    std::string fix_sender_comp_id = "UFAENGINE";
+    std::string shm_order_entry_name;  // Shared-memory order entry registry in /dev/shm, empty disables it
+    std::string shm_book_name;         // Shared-memory L2 book segment in /dev/shm, empty disables it
+    std::string flight_recorder_directory;  // Latency spike dumps, empty disables the flight recorder
+    size_t flight_recorder_events = 4096;   // Events kept per matching thread
+    JitterConfig jitter;                    // OS jitter samplers, run by PerformanceMonitor; none by default
+    MarketDataConfig market_data;           // Feed source and recording; simulated by default
 };
 
 // Performance metrics
@@ -80,11 +105,16 @@ public:
     void stop();
     bool is_running() const;
     
-    // Order management
+    // Order management. submit_order is safe from any gateway thread; false
+    // means the order was not queued and never reaches a book.
     bool submit_order(std::shared_ptr<Order> order);
     bool cancel_order(uint64_t order_id, const std::string& symbol);
     bool modify_order(uint64_t order_id, const std::string& symbol, 
                      uint64_t new_quantity, double new_price);
+    size_t mass_cancel(uint64_t client_id, const std::string& symbol, bool cancel_bids, bool cancel_asks);
+    
+    // Instruments addressable by the binary order entry protocol
+    bool register_instrument(uint32_t instrument_id, const std::string& symbol, double tick_size);
     
     // Market data
     bool submit_market_data(const MarketData& data);
@@ -92,10 +122,18 @@ public:
     
     // Order book access
     std::shared_ptr<OrderBook> get_order_book(const std::string& symbol) const;
+    
+    // Latest state of an order, read without locking its book
+    bool get_order_status(uint64_t order_id, const std::string& symbol, OrderStatusEntry& entry) const;
     OrderBookSnapshot get_order_book_snapshot(const std::string& symbol) const;
     
     // Performance monitoring
     const PerformanceMetrics& get_performance_metrics() const;
+    
+    // Record order latencies into this monitor's metric handles: order.submit on the
+    // gateway threads, order.match and order.end_to_end on the matching threads.
+    // Set before start(); the monitor must outlive the engine.
+    void set_performance_monitor(PerformanceMonitor* monitor);
     void reset_performance_metrics();
     
     // Configuration
@@ -106,6 +144,8 @@ public:
     size_t get_total_order_count() const;
     size_t get_total_trade_count() const;
     std::vector<std::string> get_active_symbols() const;
+    ThrottleStats get_throttle_stats() const;
+    FlightRecorderStats get_flight_recorder_stats() const;
     
 private:
     EngineConfig config_;
@@ -113,20 +153,30 @@ private:
     
     // Core components
     std::unique_ptr<OrderBookManager> order_book_manager_;
-    std::unique_ptr<TCPServer> tcp_server_;
+    std::unique_ptr<NetworkServer> network_server_;
+    std::unique_ptr<FixGateway> fix_gateway_;
+    std::unique_ptr<ShmOrderEntryGateway> shm_order_entry_;
+    std::unique_ptr<ShmBookPublisher> book_publisher_;
     std::unique_ptr<MarketDataProcessor> market_data_processor_;
+    std::unique_ptr<FlightRecorder> flight_recorder_;
     
     // Ring buffers for ultra-low-latency communication
-    std::unique_ptr<OrderRingBuffer<65536>> order_buffer_;
+    std::unique_ptr<OrderRingBuffer<65536>> order_buffer_;      // MPMC: all gateways in, all matching threads out
     std::unique_ptr<MarketDataRingBuffer<65536>> market_data_buffer_;
     
     // Threads
     std::vector<std::thread> matching_threads_;
     std::vector<std::thread> market_data_threads_;
+    std::atomic<size_t> matching_thread_index_{0};     // Names threads in monitoring output
+    std::atomic<size_t> market_data_thread_index_{0};
     
     // Performance monitoring
     PerformanceMetrics metrics_;
     std::thread metrics_thread_;
+    PerformanceMonitor* performance_monitor_{nullptr};
+    LatencyMetric submit_latency_;          // Queueing an order, gateway threads
+    LatencyMetric match_latency_;           // OrderBook::add_order, matching threads
+    LatencyMetric end_to_end_latency_;      // Gateway order creation until the book has it
     std::chrono::high_resolution_clock::time_point start_time_;
     
     // Callbacks
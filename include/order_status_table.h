@@ -0,0 +1,81 @@
+#pragma once
+
+#include "memory_accounting.h"
+#include "order.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace UltraFastAnalysis {
+
+// Point-in-time state of one order as last written by the matching path
+struct OrderStatusEntry {
+    uint64_t order_id = 0;
+    uint64_t client_id = 0;
+    uint64_t quantity = 0;
+    uint64_t filled_quantity = 0;
+    double average_price = 0.0;     // Volume-weighted fill price, 0 before the first fill
+    uint64_t update_sequence = 0;   // Table-wide write counter at the last update
+    OrderStatus status = OrderStatus::PENDING;
+};
+
+// Fixed-size order state table for one shard (one order book). Writes come from
+// whoever holds the shard's write lock; any number of readers on other threads
+// look orders up without taking that lock. Each slot is guarded by a seqlock:
+// the writer makes the slot's sequence odd, updates the fields and makes it even
+// again, and a reader retries if it saw an odd sequence or the sequence moved.
+// Writers never wait for readers.
+//
+// Orders hash to a short probe window. When the window is full the oldest
+// finished order (filled, cancelled or rejected) is evicted, then the oldest of
+// any kind, so status of long-finished orders is best effort.
+class OrderStatusTable {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 16384;
+    static constexpr size_t PROBE_LIMIT = 8;
+
+    // Capacity is rounded up to a power of two
+    explicit OrderStatusTable(size_t capacity = DEFAULT_CAPACITY);
+
+    // Non-copyable, non-movable
+    OrderStatusTable(const OrderStatusTable&) = delete;
+    OrderStatusTable& operator=(const OrderStatusTable&) = delete;
+
+    // Writer side; callers serialize. A fill folds fill_quantity at fill_price into
+    // the average price, and order must already include it in filled_quantity.
+    void record(const Order& order, uint64_t fill_quantity = 0, double fill_price = 0.0);
+
+    // Reader side, any thread; false if the order is unknown or was evicted
+    bool lookup(uint64_t order_id, OrderStatusEntry& entry) const;
+
+    size_t capacity() const { return mask_ + 1; }
+    uint64_t update_count() const { return update_count_.load(std::memory_order_relaxed); }
+
+private:
+    // One cache line per slot so readers of one order never share a line with the
+    // writer of its neighbour. Fields are atomics accessed relaxed; the sequence
+    // and fences provide the ordering.
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> sequence{0};          // Odd while a write is in progress
+        std::atomic<uint8_t> status{0};
+        std::atomic<uint64_t> order_id{0};          // 0 marks an empty slot
+        std::atomic<uint64_t> client_id{0};
+        std::atomic<uint64_t> quantity{0};
+        std::atomic<uint64_t> filled_quantity{0};
+        std::atomic<double> average_price{0.0};
+        std::atomic<uint64_t> update_sequence{0};
+    };
+    static_assert(sizeof(Slot) == 64, "Slot should fill exactly one cache line");
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    MemoryCharge slots_memory_{MemorySubsystem::ORDER_BOOKS};
+    std::atomic<uint64_t> update_count_{0};
+
+    size_t home_slot(uint64_t order_id) const;
+    Slot& find_slot_for_write(uint64_t order_id);
+    static bool read_slot(const Slot& slot, OrderStatusEntry& entry);
+    static bool is_finished(OrderStatus status);
+};
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "tsc_clock.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+namespace UltraFastAnalysis {
+
+// What happens to an order entry message once its session or instrument is over its rate
+enum class ThrottleAction : uint8_t {
+    REJECT = 0,     // Drop it; a new order is answered with OrderRejectReason::THROTTLED
+    DELAY = 1       // Stop reading until it is admitted; falls back to REJECT past max_delay
+};
+
+struct ThrottleConfig {
+    uint32_t session_rate = 0;          // Order entry messages per second per session, 0 disables
+    uint32_t session_burst = 100;       // Messages a session may send back to back
+    uint32_t instrument_rate = 0;       // Per session and instrument, 0 disables
+    uint32_t instrument_burst = 20;
+    ThrottleAction action = ThrottleAction::REJECT;
+    std::chrono::milliseconds max_delay{50};
+
+    bool enabled() const { return session_rate != 0 || instrument_rate != 0; }
+};
+
+// Totals across every session of one server; updated relaxed by the read paths
+struct ThrottleCounters {
+    std::atomic<uint64_t> admitted{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> delayed{0};           // Messages admitted after a delay
+    std::atomic<uint64_t> delay_ns{0};          // Total delay imposed
+};
+
+struct ThrottleStats {
+    uint64_t admitted = 0;
+    uint64_t rejected = 0;
+    uint64_t delayed = 0;
+    uint64_t delay_ns = 0;
+};
+
+// Token bucket in TscClock ticks. The level is the credit accumulated since
+// the last message, capped at one burst; a message costs interval_ ticks. All
+// integer arithmetic, single-threaded by design.
+class TokenBucket {
+public:
+    void configure(uint32_t rate, uint32_t burst, uint64_t ticks_per_second);
+    bool enabled() const { return interval_ != 0; }
+
+    // Ticks until one message is admitted, 0 if it can be taken now
+    uint64_t wait_ticks(uint64_t now);
+    void take() { level_ -= interval_; }
+
+private:
+    uint64_t interval_ = 0;     // Ticks per message
+    uint64_t capacity_ = 0;     // interval_ * burst
+    uint64_t level_ = 0;
+    uint64_t last_ = 0;
+};
+
+// Rate limits of one session. Only the session's read path calls acquire(), so
+// buckets need no locks; counters are shared with the server.
+class OrderThrottle {
+public:
+    void configure(const ThrottleConfig& config, ThrottleCounters* counters);
+    bool enabled() const { return enabled_; }
+    ThrottleAction action() const { return config_.action; }
+
+    // Admit one message for `instrument_id`: 0 if admitted and charged, otherwise
+    // the ticks until it would be. Each id gets a bucket on first use, so callers
+    // pass only registered instruments and map everything else to 0, whose
+    // bucket is shared by messages naming no known instrument.
+    uint64_t acquire(uint32_t instrument_id, uint64_t now);
+
+    // Outcome of a message acquire() refused
+    void record_rejected();
+    void record_delayed(uint64_t ticks);
+
+    // Longest wait DELAY may impose before rejecting, in ticks
+    uint64_t max_delay_ticks() const { return max_delay_ticks_; }
+
+private:
+    ThrottleConfig config_;
+    ThrottleCounters* counters_ = nullptr;
+    bool enabled_ = false;
+    uint64_t max_delay_ticks_ = 0;
+    uint64_t ticks_per_second_ = 0;
+    TokenBucket session_bucket_;
+    std::unordered_map<uint32_t, TokenBucket> instrument_buckets_;    // Bounded by the registry
+};
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// Hardware performance counters per engine thread (Linux perf_event_open).
+//
+// A thread calls perf_register_thread() once. That opens a counter group for
+// the thread (cycles, instructions, L1D and LLC misses, branch misses) plus a
+// context switch counter. User space only, so perf_event_paranoid <= 2 is enough.
+// PerfScope measures a region of code on the registered thread with rdpmc when
+// the kernel allows it; otherwise scopes are no-ops and only per-thread totals,
+// read with read(2) by the monitor, are available.
+
+enum class PerfEvent : uint8_t {
+    CYCLES = 0,
+    INSTRUCTIONS = 1,
+    L1D_MISSES = 2,
+    LLC_MISSES = 3,
+    BRANCH_MISSES = 4,
+    CONTEXT_SWITCHES = 5    // Software event; totals only, not in regions
+};
+
+constexpr size_t PERF_EVENT_COUNT = 6;
+constexpr size_t PERF_HARDWARE_EVENT_COUNT = 5;
+
+// Instrumented code regions
+enum class PerfRegion : uint8_t {
+    ORDER_BATCH = 0,        // OrderMatchingEngine::process_order_batch
+    MATCH = 1               // OrderBook::match_orders
+};
+
+constexpr size_t PERF_REGION_COUNT = 2;
+
+const char* perf_event_name(PerfEvent event);
+const char* perf_region_name(PerfRegion region);
+
+struct PerfCounts {
+    std::array<uint64_t, PERF_EVENT_COUNT> values{};
+    uint64_t calls = 0;     // Regions: times entered
+    uint64_t items = 0;     // Regions: work items reported (orders), calls if none
+
+    uint64_t get(PerfEvent event) const { return values[static_cast<size_t>(event)]; }
+    double ipc() const;
+    double per_item(PerfEvent event) const;
+    void add(const PerfCounts& other);
+};
+
+// Counters of one thread. open(), read_hardware() and add_region() run on that
+// thread; read_totals() and get_region() on any thread.
+class PerfThreadCounters {
+public:
+    explicit PerfThreadCounters(const std::string& name);
+    ~PerfThreadCounters();
+
+    // Non-copyable, non-movable
+    PerfThreadCounters(const PerfThreadCounters&) = delete;
+    PerfThreadCounters& operator=(const PerfThreadCounters&) = delete;
+
+    bool open();
+    void close();   // Final totals stay readable
+    bool is_open() const { return open_.load(std::memory_order_relaxed); }
+    bool uses_rdpmc() const { return rdpmc_; }
+    const std::string& get_name() const { return name_; }
+
+    // Current hardware counts by rdpmc; false if a counter is not readable in user space
+    bool read_hardware(std::array<uint64_t, PERF_HARDWARE_EVENT_COUNT>& values) const;
+
+    // Counts since open(), scaled for multiplexing
+    bool read_totals(PerfCounts& counts) const;
+
+    void add_region(PerfRegion region, const std::array<uint64_t, PERF_HARDWARE_EVENT_COUNT>& delta, uint64_t items);
+    PerfCounts get_region(PerfRegion region) const;
+
+private:
+    std::string name_;
+    std::atomic<bool> open_{false};
+    bool rdpmc_ = false;
+
+    int group_fd_ = -1;
+    int context_switch_fd_ = -1;
+    std::array<int, PERF_HARDWARE_EVENT_COUNT> fds_;
+    std::array<void*, PERF_HARDWARE_EVENT_COUNT> pages_;   // Self-monitoring pages for rdpmc
+    size_t page_size_ = 0;
+    mutable std::mutex mutex_;      // open/close against read_totals
+    PerfCounts final_totals_;       // Set by close()
+
+    // Written by the owning thread only, with plain load/store
+    struct RegionCounts {
+        std::array<std::atomic<uint64_t>, PERF_HARDWARE_EVENT_COUNT> values{};
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> items{0};
+    };
+    std::array<RegionCounts, PERF_REGION_COUNT> regions_;
+
+    bool read_totals_locked(PerfCounts& counts) const;
+};
+
+// Open counters for the calling thread and make PerfScope record to them. Returns
+// nullptr when perf events are unavailable (kernel, permissions, no PMU).
+PerfThreadCounters* perf_register_thread(const std::string& name);
+
+// Close the calling thread's counters; its totals stay in the registry
+void perf_unregister_thread();
+
+// Every thread registered so far, in registration order
+std::vector<std::shared_ptr<PerfThreadCounters>> perf_get_registered_threads();
+
+// Measures the enclosed region on a registered thread. Costs one rdpmc per
+// hardware event at each end; does nothing on unregistered threads.
+class PerfScope {
+public:
+    explicit PerfScope(PerfRegion region);
+    ~PerfScope();
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+    void add_items(uint64_t items) { items_ += items; }
+
+private:
+    PerfThreadCounters* counters_;
+    PerfRegion region_;
+    uint64_t items_ = 0;
+    std::array<uint64_t, PERF_HARDWARE_EVENT_COUNT> start_;
+};
+
+} // namespace UltraFastAnalysis
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "perf_counters.h"
+#include "jitter_monitor.h"
+#include "memory_accounting.h"
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -16,6 +19,7 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <array>
 #include <numeric>
 #include <cmath>
 #include <cstring>
@@ -40,6 +44,94 @@ enum class CounterType {
     THROUGHPUT  // Add missing types
 };
 
+// HDR-style log-linear latency histogram. Values are grouped into buckets whose
+// width doubles with each power of two, and every power of two is split into
+// enough sub-buckets to keep `significant_digits` decimal digits, so the
+// relative error is at most 10^-significant_digits from the lowest to the highest
+// trackable value. Recording is a relaxed atomic increment; any number of
+// threads may record while others read percentiles.
+class LatencyHistogram {
+public:
+    static constexpr uint64_t DEFAULT_HIGHEST_TRACKABLE_NS = 60000000000ULL; // 60 seconds
+    static constexpr int DEFAULT_SIGNIFICANT_DIGITS = 2;
+    
+    LatencyHistogram();
+    // Values are tracked in [lowest_discernible, highest_trackable]; larger values
+    // are counted as highest_trackable. significant_digits is clamped to [1, 5].
+    LatencyHistogram(uint64_t lowest_discernible, uint64_t highest_trackable, int significant_digits);
+    
+    // Non-copyable, non-movable: recorders hold references
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+    
+    void record_latency(uint64_t latency_ns);
+    void add_latency(uint64_t latency_ns); // Alias for record_latency
+    void record_latency(uint64_t latency_ns, uint64_t count);
+    
+    // Recording for a histogram only one thread writes: plain load and store
+    // instead of atomic read-modify-write. Concurrent readers remain safe.
+    void record_single_writer(uint64_t latency_ns);
+    
+    // Non-empty buckets as (highest value in the bucket, count)
+    std::vector<std::pair<uint64_t, uint64_t>> get_histogram() const;
+    uint64_t get_percentile(double percentile) const; // percentile in [0, 100]
+    
+    uint64_t get_count() const { return total_count_.load(std::memory_order_relaxed); }
+    uint64_t get_min() const;
+    uint64_t get_max() const { return max_.load(std::memory_order_relaxed); }
+    double get_mean() const;
+    
+    // Add or remove another histogram's samples. Histograms with the same range and
+    // precision combine bucket by bucket; merge() re-records other layouts at each
+    // bucket's value. subtract() takes an earlier copy of this histogram (an
+    // interval start) and fails on a layout mismatch or a count underflow.
+    void merge(const LatencyHistogram& other);
+    bool subtract(const LatencyHistogram& other);
+    bool same_layout(const LatencyHistogram& other) const;
+    
+    // Compact binary form: layout, then counts as varints with zero runs collapsed.
+    // deserialize() adopts the serialized layout; neither may run while recording.
+    std::vector<uint8_t> serialize() const;
+    bool deserialize(const uint8_t* data, size_t length);
+    
+    void reset();
+    
+    uint64_t get_lowest_discernible() const { return lowest_discernible_; }
+    uint64_t get_highest_trackable() const { return highest_trackable_; }
+    int get_significant_digits() const { return significant_digits_; }
+    
+    // Range of values counted in the same bucket as `value`
+    uint64_t lowest_equivalent(uint64_t value) const;
+    uint64_t highest_equivalent(uint64_t value) const;
+    
+private:
+    uint64_t lowest_discernible_;
+    uint64_t highest_trackable_;
+    int significant_digits_;
+    
+    // Bucket layout, as in HdrHistogram
+    uint32_t unit_magnitude_;
+    uint32_t sub_bucket_half_count_magnitude_;
+    uint64_t sub_bucket_count_;
+    uint64_t sub_bucket_half_count_;
+    uint64_t sub_bucket_mask_;
+    size_t bucket_count_;
+    size_t counts_length_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    MemoryCharge counts_memory_{MemorySubsystem::HISTOGRAMS};
+    
+    std::atomic<uint64_t> total_count_{0};
+    std::atomic<uint64_t> total_sum_{0};
+    std::atomic<uint64_t> min_{UINT64_MAX};
+    std::atomic<uint64_t> max_{0};
+    
+    void configure(uint64_t lowest_discernible, uint64_t highest_trackable, int significant_digits);
+    size_t get_bucket_index(uint64_t latency_ns) const;
+    uint64_t value_at_index(size_t index) const;
+    void update_min_max(uint64_t value);
+    void recompute_min_max();
+};
+
 // Performance counter class
 class PerformanceCounter {
 public:
@@ -57,9 +149,11 @@ public:
     uint64_t get_min() const;
     uint64_t get_max() const;
     
-    // Histogram-specific methods
-    std::vector<uint64_t> get_histogram() const;
-    double get_percentile(double percentile) const;
+    // Histogram-specific methods. record_latency() feeds the histogram of LATENCY
+    // and HISTOGRAM counters; other counters report the average as every percentile.
+    std::vector<uint64_t> get_histogram() const;    // Value at each whole percentile 1..100
+    double get_percentile(double percentile) const; // percentile in [0, 100]
+    bool has_histogram() const { return histogram_ != nullptr; }
     
     void reset();
     
@@ -77,40 +171,8 @@ private:
     std::atomic<uint64_t> min_{UINT64_MAX};
     std::atomic<uint64_t> max_{0};
     
-    // Histogram data
-    mutable std::mutex histogram_mutex_;
-    std::vector<uint64_t> histogram_;
-    static constexpr size_t HISTOGRAM_BINS = 100;
-    static constexpr uint64_t MAX_LATENCY_NS = 1000000000; // 1 second
-};
-
-// Latency histogram class
-class LatencyHistogram {
-public:
-    LatencyHistogram();
-    explicit LatencyHistogram(size_t num_buckets);
-    
-    void record_latency(uint64_t latency_ns);
-    void add_latency(uint64_t latency_ns); // Alias for record_latency
-    std::vector<std::pair<uint64_t, uint64_t>> get_histogram() const; // Fix return type
-    uint64_t get_percentile(double percentile) const; // Fix return type
-    void reset();
-    
-private:
-    mutable std::mutex mutex_;
-    std::vector<uint64_t> histogram_;
-    std::vector<uint64_t> sorted_latencies_;
-    
-    // Implementation-specific members
-    std::vector<uint64_t> buckets_;
-    std::atomic<uint64_t> total_count_{0};
-    size_t num_buckets_;
-    uint64_t bucket_size_ns_;
-    
-    size_t get_bucket_index(uint64_t latency_ns) const;
-    
-    static constexpr size_t HISTOGRAM_BINS = 100;
-    static constexpr uint64_t MAX_LATENCY_NS = 1000000000; // 1 second
+    // Distribution of recorded values, LATENCY and HISTOGRAM counters only
+    std::unique_ptr<LatencyHistogram> histogram_;
 };
 
 // Memory tracker class
@@ -150,6 +212,14 @@ private:
 };
 
 // CPU tracker class
+// CPU use of one thread of this process
+struct ThreadCpuStats {
+    int tid = 0;
+    std::string name;               // As set with set_current_thread_name()
+    uint64_t cpu_time_ns = 0;       // User and system time since the thread started
+    double utilization = 0.0;       // Percent of one core over the last update interval
+};
+
 class CPUTracker {
 public:
     CPUTracker();
@@ -163,6 +233,9 @@ public:
     double get_average_cpu_usage() const;
     double get_cpu_utilization() const;
     
+    // Every live thread as of the last update, busiest first (Linux only)
+    std::vector<ThreadCpuStats> get_thread_cpu_usage() const;
+    
     // Additional methods from implementation
     void reset();
     
@@ -183,9 +256,17 @@ private:
     std::chrono::steady_clock::time_point last_update_;
     mutable std::mutex mutex_;
     
+    // Per-thread CPU time at the previous update, by tid; guarded by mutex_
+    struct ThreadCpuState {
+        uint64_t cpu_time_ns = 0;
+        ThreadCpuStats stats;
+    };
+    std::unordered_map<int, ThreadCpuState> threads_;
+    
     void monitoring_thread_worker();
     double get_system_cpu_time() const;
     double get_process_cpu_time() const;
+    void update_thread_cpu_usage(double elapsed_seconds);
 };
 
 // Cache monitor class
@@ -198,9 +279,20 @@ public:
     void stop_monitoring();
     void update_cache_metrics();
     
-    uint64_t get_cache_misses() const;
+    // Sums over every thread registered with perf_register_thread() since the last reset
+    uint64_t get_cache_misses() const;      // Last level cache
     uint64_t get_branch_misses() const;
     uint64_t get_context_switches() const;
+    uint64_t get_cycles() const;
+    uint64_t get_instructions() const;
+    uint64_t get_l1d_misses() const;
+    double get_ipc() const;
+    
+    // Counts inside one instrumented region across threads (rdpmc only)
+    PerfCounts get_region_counts(PerfRegion region) const;
+    
+    // False when no thread could open perf events
+    bool has_perf_counters() const;
     
     // Additional methods from implementation
     bool is_monitoring() const;
@@ -214,16 +306,26 @@ private:
     std::atomic<uint64_t> cache_misses_{0};
     std::atomic<uint64_t> branch_misses_{0};
     std::atomic<uint64_t> context_switches_{0};
+    std::atomic<uint64_t> cycles_{0};
+    std::atomic<uint64_t> instructions_{0};
+    std::atomic<uint64_t> l1d_misses_{0};
+    mutable std::atomic<bool> perf_available_{false};
     
-    void monitoring_thread_worker();
-    
-    // Platform-specific cache monitoring
-    bool initialize_perf_counters();
-    void cleanup_perf_counters();
+    // Totals at the last reset(), subtracted from what the threads report
+    mutable std::mutex baseline_mutex_;
+    PerfCounts baseline_;
+    std::array<PerfCounts, PERF_REGION_COUNT> region_baseline_;
     
-    int perf_fd_cache_misses_{-1};
-    int perf_fd_branch_misses_{-1};
-    int perf_fd_context_switches_{-1};
+    void monitoring_thread_worker();
+    PerfCounts read_thread_totals() const;
+    PerfCounts read_region_totals(PerfRegion region) const;
+};
+
+// Handle of a latency metric registered with a PerformanceMonitor
+struct LatencyMetric {
+    static constexpr uint32_t INVALID = UINT32_MAX;
+    uint32_t id = INVALID;
+    bool valid() const { return id != INVALID; }
 };
 
 // Main performance monitor class
@@ -252,6 +354,25 @@ public:
     double get_average_latency(const std::string& operation) const;
     double get_percentile_latency(const std::string& operation, double percentile) const;
     
+    // Pre-registered latency metrics for hot paths. Each recording thread writes
+    // its own histogram with plain increments; the monitoring thread folds the
+    // samples added since its last pass into interval and cumulative histograms
+    // once per monitoring interval. Register at startup; at most
+    // MAX_LATENCY_METRICS, re-registering a name returns its existing handle.
+    static constexpr size_t MAX_LATENCY_METRICS = 64;
+    LatencyMetric register_latency_metric(const std::string& name);
+    LatencyMetric find_latency_metric(const std::string& name) const;
+    void record_latency(LatencyMetric metric, uint64_t latency_ns);
+    
+    // Percentiles over the last completed interval and since start (or reset)
+    double get_interval_percentile(LatencyMetric metric, double percentile) const;
+    double get_cumulative_percentile(LatencyMetric metric, double percentile) const;
+    uint64_t get_interval_count(LatencyMetric metric) const;
+    uint64_t get_cumulative_count(LatencyMetric metric) const;
+    
+    // Fold recorded samples in now; the monitoring thread does this every interval
+    void collect_latency_metrics();
+    
     // Throughput tracking
     void record_throughput(const std::string& operation, uint64_t count);
     uint64_t get_throughput(const std::string& operation) const;
@@ -259,11 +380,21 @@ public:
     // Memory and CPU tracking
     size_t get_current_memory_usage() const;
     double get_current_cpu_usage() const;
+    std::vector<ThreadCpuStats> get_thread_cpu_usage() const;
+    
+    // Live and peak bytes of each subsystem allocating through TrackingAllocator
+    std::array<MemorySubsystemStats, MEMORY_SUBSYSTEM_COUNT> get_memory_by_subsystem() const;
     
     // Cache performance
     uint64_t get_cache_misses() const;
     uint64_t get_branch_misses() const;
     
+    // OS jitter: samplers run until stop(); thread counts come from threads
+    // registered with sched_register_thread()
+    bool start_jitter_sampling(const JitterConfig& config);
+    std::vector<JitterStats> get_jitter_stats() const;
+    std::vector<ThreadSchedStats> get_thread_sched_stats() const;
+    
     // Reporting
     void generate_report(const std::string& filename = "");
     void print_summary() const;
@@ -284,20 +415,42 @@ private:
     std::unique_ptr<MemoryTracker> memory_tracker_;
     std::unique_ptr<CPUTracker> cpu_tracker_;
     std::unique_ptr<CacheMonitor> cache_monitor_;
+    std::unique_ptr<JitterMonitor> jitter_monitor_;
     
     // Counters
     std::unordered_map<std::string, std::unique_ptr<PerformanceCounter>> counters_;
     mutable std::mutex counters_mutex_;
     
-    // Latency histograms
-    std::unordered_map<std::string, std::unique_ptr<LatencyHistogram>> latency_histograms_;
-    mutable std::mutex histograms_mutex_;
+    // Registered latency metrics, guarded by metrics_mutex_
+    struct LatencyMetricState {
+        std::string name;
+        LatencyHistogram interval;
+        LatencyHistogram cumulative;
+        LatencyHistogram scratch;       // Snapshot being folded in
+    };
+    std::vector<std::unique_ptr<LatencyMetricState>> latency_metrics_;
+    std::atomic<size_t> latency_metric_count_{0};
+    mutable std::mutex metrics_mutex_;
+    
+    // Histograms of one recording thread. Only that thread creates and writes
+    // them; previous holds what the monitoring thread has already folded in.
+    struct ThreadRecorder {
+        std::thread::id thread_id;
+        std::array<std::atomic<LatencyHistogram*>, MAX_LATENCY_METRICS> histograms{};
+        std::array<std::unique_ptr<LatencyHistogram>, MAX_LATENCY_METRICS> previous;
+        ~ThreadRecorder();
+    };
+    std::vector<std::unique_ptr<ThreadRecorder>> recorders_;    // Guarded by metrics_mutex_
+    const uint64_t instance_id_;    // Keys the thread-local recorder cache
+    ThreadRecorder* get_thread_recorder();
+    const LatencyMetricState* get_metric_state(LatencyMetric metric) const;
     
     // Configuration
     std::chrono::milliseconds monitoring_interval_{1000};
     bool detailed_monitoring_enabled_;
     
     // Internal methods
+    PerformanceCounter* get_or_create_counter(const std::string& name, CounterType type);
     void monitoring_thread_worker();
     void update_system_metrics();
     void cleanup_old_data();
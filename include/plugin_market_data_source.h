@@ -0,0 +1,69 @@
+#pragma once
+
+#include "market_data_processor.h"
+#include "feed_plugin.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// Market data source backed by a dlopen'd feed plugin (DataSourceType::CUSTOM_FEED).
+// The plugin is polled in batches into a buffer owned by this source; see feed_plugin.h.
+class PluginMarketDataSource : public MarketDataSource {
+public:
+    explicit PluginMarketDataSource(const MarketDataConfig& config);
+    ~PluginMarketDataSource() override;
+
+    bool connect() override;
+    void disconnect() override;
+    bool is_connected() const override;
+
+    bool start_streaming() override;
+    void stop_streaming() override;
+
+    void set_data_callback(std::function<void(const MarketData&)> callback) override;
+    void set_error_callback(std::function<void(const std::string&)> callback) override;
+
+    const MarketDataStats& get_stats() const override;
+    void reset_stats() override;
+
+    // Name reported by the loaded plugin
+    std::string get_plugin_name() const;
+
+private:
+    MarketDataConfig config_;
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> streaming_{false};
+
+    std::thread poll_thread_;
+    std::atomic<bool> shutdown_requested_{false};
+
+    std::function<void(const MarketData&)> data_callback_;
+    std::function<void(const std::string&)> error_callback_;
+
+    // Plugin state
+    void* library_handle_{nullptr};
+    const ufa_feed_plugin* plugin_{nullptr};
+    void* instance_{nullptr};
+    double price_divisor_{1.0};
+
+    // Batch buffer handed to the plugin, allocated once in connect()
+    std::vector<ufa_feed_event> events_;
+
+    MarketDataStats stats_;
+
+    // Scratch object reused for every converted event
+    MarketData decoded_;
+
+    // Internal methods
+    bool load_plugin();
+    void unload_plugin();
+    void poll_thread_worker();
+    void dispatch_event(const ufa_feed_event& event);
+    void report_error(const std::string& error);
+};
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "market_data_processor.h"
+#include "market_data_recorder.h"
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// Replays a MarketDataRecorder file (DataSourceType::REPLAY, data_source_url = path).
+// Events are paced by their recorded receive timestamps scaled by replay_speed, or
+// emitted back to back when replay_speed is 0.
+class ReplayMarketDataSource : public MarketDataSource {
+public:
+    explicit ReplayMarketDataSource(const MarketDataConfig& config);
+    ~ReplayMarketDataSource() override;
+
+    bool connect() override;
+    void disconnect() override;
+    bool is_connected() const override;
+
+    bool start_streaming() override;
+    void stop_streaming() override;
+
+    void set_data_callback(std::function<void(const MarketData&)> callback) override;
+    void set_error_callback(std::function<void(const std::string&)> callback) override;
+
+    const MarketDataStats& get_stats() const override;
+    void reset_stats() override;
+
+    // True once every record in the file has been delivered
+    bool is_replay_complete() const;
+
+private:
+    MarketDataConfig config_;
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> streaming_{false};
+    std::atomic<bool> replay_complete_{false};
+
+    std::thread replay_thread_;
+    std::atomic<bool> shutdown_requested_{false};
+
+    std::function<void(const MarketData&)> data_callback_;
+    std::function<void(const std::string&)> error_callback_;
+
+    std::FILE* file_{nullptr};
+
+    // Batch of records read per fread, allocated once in connect()
+    std::vector<MarketDataRecord> records_;
+
+    MarketDataStats stats_;
+
+    // Scratch object reused for every replayed event
+    MarketData decoded_;
+
+    // Internal methods
+    void replay_thread_worker();
+    void wait_until(std::chrono::steady_clock::time_point deadline);
+    void report_error(const std::string& error);
+};
+
+} // namespace UltraFastAnalysis
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <array>
+#include <cstddef>
 #include <memory>
 #include "market_data.h"
 #include "order.h"
+#include "memory_accounting.h"
 
 namespace UltraFastAnalysis {
 
@@ -18,6 +21,7 @@ private:
     std::array<T, Size> buffer_;
     std::atomic<size_t> head_{0};
     std::atomic<size_t> tail_{0};
+    MemoryCharge memory_{MemorySubsystem::RING_BUFFERS, sizeof(buffer_)};
     
 public:
     LockFreeRingBuffer() = default;
@@ -80,11 +84,104 @@ public:
     }
 };
 
+// Bounded multi-producer, multi-consumer ring. Each slot carries a sequence
+// number telling whether it is free for the producer or ready for the consumer
+// at a given position; threads claim positions with a CAS and only ever wait
+// on the slot they claimed.
+template<typename T, size_t Size>
+class MpmcRingBuffer {
+    static_assert(Size > 0 && ((Size & (Size - 1)) == 0), "Size must be a power of 2");
+    
+private:
+    static constexpr size_t MASK = Size - 1;
+    
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    
+    std::array<Slot, Size> slots_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    MemoryCharge memory_{MemorySubsystem::RING_BUFFERS, sizeof(slots_)};
+    
+public:
+    MpmcRingBuffer() {
+        for (size_t i = 0; i < Size; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    // Non-copyable, non-movable
+    MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+    MpmcRingBuffer& operator=(const MpmcRingBuffer&) = delete;
+    
+    bool try_push(const T& item) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & MASK];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Buffer is full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        
+        slot->value = item;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool try_pop(T& item) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & MASK];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Buffer is empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        
+        // Moved out, so the slot does not keep the item alive until it is reused
+        item = std::move(slot->value);
+        slot->value = T();
+        slot->sequence.store(pos + Size, std::memory_order_release);
+        return true;
+    }
+    
+    // Approximate while other threads push or pop
+    size_t size() const {
+        size_t dequeue = dequeue_pos_.load(std::memory_order_acquire);
+        size_t enqueue = enqueue_pos_.load(std::memory_order_acquire);
+        return enqueue > dequeue ? std::min(enqueue - dequeue, Size) : 0;
+    }
+    
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() == Size; }
+    size_t capacity() const { return Size; }
+};
+
 // Specialized ring buffer for market data with pre-allocated memory
 template<size_t Size>
 class MarketDataRingBuffer : public LockFreeRingBuffer<MarketData, Size> {
 private:
     std::array<MarketData, Size> data_pool_;
+    MemoryCharge pool_memory_{MemorySubsystem::RING_BUFFERS, sizeof(data_pool_)};
     
 public:
     MarketDataRingBuffer() {
@@ -103,9 +200,9 @@ public:
     }
 };
 
-// Specialized ring buffer for orders
+// Order ingress: every gateway thread pushes, every matching thread pops
 template<size_t Size>
-class OrderRingBuffer : public LockFreeRingBuffer<std::shared_ptr<Order>, Size> {
+class OrderRingBuffer : public MpmcRingBuffer<std::shared_ptr<Order>, Size> {
 public:
     OrderRingBuffer() = default;
 };
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "memory_accounting.h"
+#include "order_throttle.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// Order entry session settings shared by every connection of a server
+struct SessionConfig {
+    std::string journal_directory;                              // Outbound journals; empty keeps sessions in memory only
+    std::chrono::milliseconds heartbeat_interval{30000};        // Used when LOGIN does not ask for one
+    std::chrono::milliseconds min_heartbeat_interval{1000};     // Bounds on the interval a client may ask for
+    std::chrono::milliseconds max_heartbeat_interval{300000};
+    uint32_t missed_heartbeats = 3;                             // Silent intervals before a session is dropped
+    std::chrono::milliseconds timer_tick{100};                  // Timer wheel resolution
+    ThrottleConfig throttle;                                    // Order entry rate limits per session
+};
+
+// Hashed timer wheel. Timers are opaque ids hashed into slots by expiry tick, so
+// scheduling and expiry are O(1) and one periodic tick serves every session.
+// There is no cancel: the owner ignores ids that no longer refer to a live session.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TimerWheel(std::chrono::milliseconds tick, size_t slot_count = 512);
+
+    void schedule(uint64_t id, Clock::time_point deadline);
+
+    // Append the id of every timer due by `now` to `expired`
+    void advance(Clock::time_point now, std::vector<uint64_t>& expired);
+
+    size_t size() const;
+
+private:
+    struct Timer {
+        uint64_t id;
+        uint64_t expiry_tick;
+    };
+
+    Clock::time_point origin_;
+    Clock::duration tick_;
+    std::vector<std::vector<Timer>> slots_;
+    uint64_t current_tick_{0};  // Ticks before this one have been processed
+    size_t size_{0};
+    mutable std::mutex mutex_;
+};
+
+// On-disk format of outbound session journals (little-endian, packed): one
+// JournalFileHeader followed by a JournalRecordHeader and payload per message.
+#pragma pack(push, 1)
+struct JournalFileHeader {
+    char magic[8];              // JOURNAL_MAGIC
+    uint32_t version;           // JOURNAL_VERSION
+    uint32_t reserved;
+    uint64_t created_ns;        // Wall clock time the journal was created
+};
+
+struct JournalRecordHeader {
+    uint64_t sequence;
+    uint64_t timestamp;         // MessageHeader::timestamp as sent
+    uint32_t message_type;
+    uint32_t length;            // Payload bytes that follow; 0 for messages not kept
+    uint8_t flags;              // JOURNAL_RECOVERABLE
+    uint8_t reserved[7];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(JournalFileHeader) == 24, "JournalFileHeader layout changed");
+static_assert(sizeof(JournalRecordHeader) == 32, "JournalRecordHeader layout changed");
+
+constexpr char JOURNAL_MAGIC[8] = {'U', 'F', 'A', 'S', 'J', 'R', 'N', 'L'};
+constexpr uint32_t JOURNAL_VERSION = 1;
+constexpr uint8_t JOURNAL_RECOVERABLE = 0x01;
+
+// Journaled outbound message
+struct JournalEntry {
+    uint64_t sequence = 0;
+    uint64_t timestamp = 0;
+    uint32_t message_type = 0;
+    bool recoverable = false;
+    std::string payload;
+};
+
+// Outbound messages of one logical session, numbered from 1. Recoverable messages
+// are stored with their payload and are resent verbatim; the rest keep only their
+// sequence number and are gap-filled on resend. Appends go through a stdio buffer
+// that is flushed on every timer tick and before reads. Without a file the journal
+// only tracks sequence numbers.
+class SessionJournal {
+public:
+    SessionJournal() = default;
+    ~SessionJournal();
+
+    // Non-copyable, non-movable
+    SessionJournal(const SessionJournal&) = delete;
+    SessionJournal& operator=(const SessionJournal&) = delete;
+
+    // Open or create the journal; an existing journal is indexed and a torn last record dropped
+    bool open(const std::string& path);
+    void close();
+
+    // Append message `sequence`, which must follow last_sequence(); a failed write leaves
+    // last_sequence() where it was
+    bool append(uint64_t sequence, uint32_t message_type, uint64_t timestamp, bool recoverable,
+                const void* payload, size_t length);
+    bool read(uint64_t sequence, JournalEntry& entry);
+    void flush();
+
+    uint64_t last_sequence() const;
+    uint64_t next_inbound_sequence() const { return next_inbound_sequence_; }
+    uint64_t client_id() const { return client_id_; }
+    uint64_t next_order_sequence() const { return next_order_sequence_; }
+
+private:
+    friend class SessionStore;
+
+    std::FILE* file_{nullptr};
+    // File offset of each record, indexed by sequence - 1
+    std::vector<uint64_t, TrackingAllocator<uint64_t, MemorySubsystem::SESSIONS>> offsets_;
+    uint64_t last_sequence_{0};
+    uint64_t write_offset_{0};
+    bool dirty_{false};
+    bool reading_{false};               // Last stdio operation was a read
+    mutable std::mutex mutex_;
+
+    // Owned by SessionStore; kept across reconnects, not across restarts
+    bool in_use_{false};
+    uint64_t next_inbound_sequence_{0};
+    uint64_t client_id_{0};             // Owner of the session's orders, set by the first claim
+    uint64_t next_order_sequence_{0};
+};
+
+// Session journals by session (LOGIN) name. A session can be held by one
+// connection at a time; its state survives reconnects.
+class SessionStore {
+public:
+    explicit SessionStore(const SessionConfig& config = SessionConfig{});
+
+    const SessionConfig& config() const { return config_; }
+
+    // Claim a session for a connection; nullptr if it is held by another connection,
+    // the name is not usable as a file name, or the journal cannot be opened. The first
+    // claim binds the session to client_id, which later claims get back from the journal.
+    std::shared_ptr<SessionJournal> claim(const std::string& session_name, uint64_t client_id);
+    void release(const std::shared_ptr<SessionJournal>& journal, uint64_t next_inbound_sequence,
+                 uint64_t next_order_sequence);
+
+    // Push buffered journal writes to the OS
+    void flush();
+
+    // Throttle outcomes of every session served from this store
+    ThrottleCounters& get_throttle_counters() { return throttle_counters_; }
+    ThrottleStats get_throttle_stats() const;
+
+private:
+    SessionConfig config_;
+    ThrottleCounters throttle_counters_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<SessionJournal>> journals_;
+
+    static bool is_valid_session_name(const std::string& name);
+};
+
+} // namespace UltraFastAnalysis
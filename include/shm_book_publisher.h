@@ -0,0 +1,155 @@
+#pragma once
+
+#include "market_data.h"
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UltraFastAnalysis {
+
+// Level 2 books published in shared memory for local readers.
+//
+// The engine creates one segment in /dev/shm (ShmBookConfig::name) holding a
+// fixed array of per-symbol slots. A book's matching thread rewrites its slot on
+// every change, under the seqlock scheme of OrderStatusTable: the slot sequence is
+// odd while a write is in progress and readers retry when it was odd or moved.
+// Readers map the segment read-only, so any number of them cost the engine nothing.
+
+constexpr uint64_t SHM_BOOK_MAGIC = 0x31424B4248534155ULL;   // "UASHBKB1"
+constexpr uint32_t SHM_BOOK_VERSION = 1;
+constexpr size_t SHM_BOOK_DEPTH = BookDepth::MAX_LEVELS;
+constexpr size_t SHM_BOOK_SYMBOL_LENGTH = 16;
+
+struct ShmBookHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t max_symbols;
+    uint32_t depth;
+    uint32_t engine_pid;
+    std::atomic<uint32_t> symbol_count;     // Slots [0, symbol_count) have their symbol set
+    std::atomic<uint32_t> engine_running;   // Cleared when the engine stops
+};
+
+struct ShmBookLevel {
+    std::atomic<double> price;
+    std::atomic<uint64_t> quantity;
+};
+
+// One symbol. Fields are atomics accessed relaxed; the sequence and fences
+// provide the ordering.
+struct alignas(64) ShmBookSlot {
+    std::atomic<uint64_t> sequence;         // Odd while a write is in progress
+    char symbol[SHM_BOOK_SYMBOL_LENGTH];    // Written once, before the slot is counted
+    std::atomic<uint64_t> update_sequence;  // Book changes so far
+    std::atomic<uint64_t> timestamp_ns;     // Engine steady clock at the last write
+    std::atomic<uint64_t> trade_count;
+    std::atomic<double> last_trade_price;
+    std::atomic<uint64_t> last_trade_quantity;
+    std::atomic<uint32_t> bid_count;
+    std::atomic<uint32_t> ask_count;
+    ShmBookLevel bids[SHM_BOOK_DEPTH];      // Best first
+    ShmBookLevel asks[SHM_BOOK_DEPTH];
+};
+static_assert(std::atomic<double>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "Shared-memory books need lock-free 64-bit atomics");
+
+// Consistent copy of one slot
+struct ShmBookView {
+    std::string symbol;
+    uint64_t update_sequence = 0;
+    uint64_t timestamp_ns = 0;
+    uint64_t trade_count = 0;
+    double last_trade_price = 0.0;
+    uint64_t last_trade_quantity = 0;
+    std::vector<std::pair<double, uint64_t>> bids;  // price, quantity
+    std::vector<std::pair<double, uint64_t>> asks;
+};
+
+struct ShmBookConfig {
+    std::string name = "/ufa_books";
+    uint32_t max_symbols = 1024;    // Symbols beyond this are not published
+};
+
+// Engine side. publish() is the OrderBookManager depth callback: each book calls
+// it under its own write lock, so every slot has a single writer.
+class ShmBookPublisher {
+public:
+    explicit ShmBookPublisher(const ShmBookConfig& config = ShmBookConfig{});
+    ~ShmBookPublisher();
+
+    // Non-copyable, non-movable
+    ShmBookPublisher(const ShmBookPublisher&) = delete;
+    ShmBookPublisher& operator=(const ShmBookPublisher&) = delete;
+
+    bool start();
+    void stop();
+    bool is_running() const;
+
+    void publish(const std::string& symbol, const BookDepth& depth);
+
+    size_t get_symbol_count() const;
+
+private:
+    ShmBookConfig config_;
+    void* segment_ = nullptr;
+    size_t segment_size_ = 0;
+    std::atomic<bool> running_{false};
+
+    // Slot of each published symbol; the unique lock is only taken for a new symbol
+    std::unordered_map<std::string, ShmBookSlot*> slots_by_symbol_;
+    mutable std::shared_mutex slots_mutex_;
+    bool overflow_reported_ = false;
+
+    ShmBookHeader* header() const { return static_cast<ShmBookHeader*>(segment_); }
+    ShmBookSlot* slot(size_t index) const;
+    ShmBookSlot* find_or_add_slot(const std::string& symbol);
+};
+
+// Reader side, for risk, UI and analytics processes. Maps the segment read-only.
+class ShmBookReader {
+public:
+    ShmBookReader() = default;
+    ~ShmBookReader();
+
+    // Non-copyable, non-movable
+    ShmBookReader(const ShmBookReader&) = delete;
+    ShmBookReader& operator=(const ShmBookReader&) = delete;
+
+    bool open(const std::string& name = ShmBookConfig{}.name);
+    void close();
+    bool is_open() const { return segment_ != nullptr; }
+
+    // False once the engine has stopped; the last published books stay readable
+    bool engine_running() const;
+
+    std::vector<std::string> get_symbols() const;
+
+    // False if the symbol has not been published, or no consistent copy could be
+    // taken because the engine stopped or died in the middle of a write
+    bool read(const std::string& symbol, ShmBookView& view) const;
+
+    // Cheap change check: the slot's update sequence, 0 if unknown
+    uint64_t get_update_sequence(const std::string& symbol) const;
+
+private:
+    void* segment_ = nullptr;
+    size_t segment_size_ = 0;
+
+    // Symbols are never moved once published, so lookups are cached
+    mutable std::unordered_map<std::string, const ShmBookSlot*> slots_by_symbol_;
+    mutable uint32_t known_symbols_ = 0;
+
+    const ShmBookHeader* header() const { return static_cast<const ShmBookHeader*>(segment_); }
+    // Seqlock retries before a read gives up, and how often they check the engine
+    static constexpr uint32_t READ_ATTEMPTS = 100000;
+    static constexpr uint32_t LIVENESS_CHECK_INTERVAL = 1024;
+
+    const ShmBookSlot* find_slot(const std::string& symbol) const;
+    bool read_slot(const ShmBookSlot& slot, ShmBookView& view) const;
+    bool engine_alive() const;
+};
+
+} // namespace UltraFastAnalysis
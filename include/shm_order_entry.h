@@ -0,0 +1,247 @@
+#pragma once
+
+#include "order.h"
+#include "order_entry_protocol.h"
+#include "order_status_table.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace UltraFastAnalysis {
+
+// Shared-memory order entry for strategies on the same host.
+//
+// The engine creates a registry segment in /dev/shm (ShmOrderEntryConfig::name).
+// A client claims a free registry slot, writes its name and pid and marks the slot
+// REQUESTED. The engine's poll thread then creates the client's own segment
+// (<name>.<slot>) holding two single-producer single-consumer rings of 64-byte
+// messages, one for requests and one for responses, and marks the slot ACTIVE.
+// From then on neither side makes a system call: bodies are the binary order entry
+// structs of order_entry_protocol.h, tagged with a MessageType.
+
+enum class MessageType : uint32_t;  // tcp_server.h
+
+constexpr uint64_t SHM_ORDER_ENTRY_MAGIC = 0x31454F4D48534155ULL;   // "UASHMOE1"
+constexpr uint32_t SHM_ORDER_ENTRY_VERSION = 1;
+
+enum class ShmSlotState : uint32_t {
+    FREE = 0,
+    CLAIMED = 1,        // Client is filling in the slot
+    REQUESTED = 2,      // Waiting for the engine to create the client segment
+    ACTIVE = 3,
+    REJECTED = 4,       // Engine could not create the segment; the client frees the slot
+    CLOSING = 5         // Client is done; the engine removes the segment and frees the slot
+};
+
+// One ring entry, exactly one cache line
+struct ShmMessage {
+    uint16_t message_type;      // MessageType
+    uint16_t length;            // Body bytes in use
+    uint32_t reserved;
+    uint64_t timestamp;         // Sender's steady clock, nanoseconds
+    uint8_t body[48];
+};
+static_assert(sizeof(ShmMessage) == 64, "ShmMessage should fill exactly one cache line");
+
+// Ring positions count messages since creation and never wrap
+struct ShmRingIndices {
+    alignas(64) std::atomic<uint64_t> write_index{0};   // Written by the producer
+    alignas(64) std::atomic<uint64_t> read_index{0};    // Written by the consumer
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared-memory rings need lock-free 64-bit atomics");
+
+struct ShmRegistryHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t max_clients;
+    uint32_t ring_capacity;
+    uint32_t engine_pid;
+    std::atomic<uint32_t> engine_running;   // Cleared when the engine stops
+};
+
+struct alignas(64) ShmRegistrySlot {
+    std::atomic<uint32_t> state;    // ShmSlotState
+    uint32_t client_pid;
+    uint64_t client_id;             // Set by the engine before ACTIVE
+    char client_name[48];
+};
+static_assert(sizeof(ShmRegistrySlot) == 64, "ShmRegistrySlot should fill exactly one cache line");
+
+struct ShmClientHeader {
+    uint64_t magic;
+    uint64_t client_id;
+    uint32_t ring_capacity;
+    uint32_t reserved;
+};
+
+// Process-local view of one ring inside a mapped segment. Each side caches the
+// other side's index and only rereads it when the ring looks full or empty.
+class ShmRing {
+public:
+    ShmRing() = default;
+    ShmRing(void* base, uint32_t capacity);
+
+    // Bytes a ring of this capacity occupies, a multiple of the cache line size
+    static size_t bytes(uint32_t capacity);
+
+    // Producer side
+    bool try_push(const ShmMessage& message);
+
+    // Consumer side
+    bool try_pop(ShmMessage& message);
+
+private:
+    ShmRingIndices* indices_ = nullptr;
+    ShmMessage* slots_ = nullptr;
+    uint64_t mask_ = 0;
+    uint64_t write_index_ = 0;      // Own position for the producer, last seen for the consumer
+    uint64_t read_index_ = 0;       // Own position for the consumer, last seen for the producer
+};
+
+struct ShmOrderEntryConfig {
+    std::string name = "/ufa_order_entry";      // Registry segment; client segments are <name>.<slot>
+    uint32_t max_clients = 16;
+    uint32_t ring_capacity = 4096;              // Messages per direction, rounded up to a power of two
+    std::chrono::microseconds idle_sleep{20};   // Back-off once the poll thread finds nothing; 0 busy-polls
+};
+
+// Engine side: owns the registry, creates and removes client segments and runs
+// the poll thread that feeds requests to the engine
+class ShmOrderEntryGateway {
+public:
+    // Client ids handed to shared-memory clients start here, clear of TCP and FIX ids
+    static constexpr uint64_t SHM_CLIENT_ID_BASE = 1ull << 31;
+
+    explicit ShmOrderEntryGateway(const ShmOrderEntryConfig& config, const InstrumentRegistry& instruments);
+    ~ShmOrderEntryGateway();
+
+    // Non-copyable, non-movable
+    ShmOrderEntryGateway(const ShmOrderEntryGateway&) = delete;
+    ShmOrderEntryGateway& operator=(const ShmOrderEntryGateway&) = delete;
+
+    bool start();
+    void stop();
+    bool is_running() const;
+
+    size_t get_client_count() const;
+
+    // Callback setters; set before start()
+    void set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback);
+    void set_order_cancel_callback(std::function<bool(uint64_t, const std::string&)> callback);
+    void set_order_modify_callback(std::function<bool(uint64_t, const std::string&, uint64_t, double)> callback);
+    void set_order_mass_cancel_callback(std::function<size_t(uint64_t, const std::string&, MassCancelSide)> callback);
+    void set_order_status_callback(std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> callback);
+
+    // Execution report for orders of shared-memory clients, ignored for others.
+    // Called from the matching threads (see ExecutionCallback).
+    void on_execution(const Order& order, uint64_t fill_quantity, double fill_price);
+
+private:
+    struct Client {
+        std::mutex response_mutex;      // Serializes the poll thread and matching threads as producers
+        void* segment = nullptr;
+        size_t segment_size = 0;
+        ShmRing requests;
+        ShmRing responses;
+        uint64_t client_id = 0;         // 0 while the slot has no segment
+        uint32_t pid = 0;
+        uint64_t generation = 0;
+        uint64_t next_order_sequence = 0;
+        uint64_t dropped_responses = 0;
+        std::string name;
+    };
+
+    ShmOrderEntryConfig config_;
+    const InstrumentRegistry& instruments_;
+    std::unordered_map<std::string, const InstrumentInfo*> instruments_by_symbol_;
+
+    void* registry_ = nullptr;
+    size_t registry_size_ = 0;
+    std::unique_ptr<Client[]> clients_;
+    std::atomic<size_t> client_count_{0};
+
+    std::thread poll_thread_;
+    std::atomic<bool> running_{false};
+
+    std::function<bool(std::shared_ptr<Order>)> order_submit_callback_;
+    std::function<bool(uint64_t, const std::string&)> order_cancel_callback_;
+    std::function<bool(uint64_t, const std::string&, uint64_t, double)> order_modify_callback_;
+    std::function<size_t(uint64_t, const std::string&, MassCancelSide)> order_mass_cancel_callback_;
+    std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> order_status_callback_;
+
+    static constexpr size_t IDLE_SPINS = 4096;      // Empty polls before backing off
+    static constexpr auto LIVENESS_CHECK_INTERVAL = std::chrono::seconds(1);
+
+    ShmRegistrySlot* registry_slot(size_t slot) const;
+    std::string segment_name(size_t slot) const;
+
+    void poll_thread_function();
+    void scan_registry(bool check_liveness);
+    bool open_client(size_t slot);
+    void close_client(size_t slot);
+    size_t poll_client(Client& client);
+
+    void handle_request(Client& client, const ShmMessage& message);
+    void handle_new_order(Client& client, const NewOrderMessage& message);
+    void handle_cancel_order(Client& client, const CancelOrderMessage& message);
+    void handle_amend_order(Client& client, const AmendOrderMessage& message);
+    void handle_mass_cancel(Client& client, const MassCancelMessage& message);
+    void handle_order_status_request(Client& client, const OrderStatusRequestMessage& message);
+
+    // Caller holds client.response_mutex
+    bool send_response(Client& client, MessageType type, const void* body, size_t length);
+};
+
+// Client side, for strategies linking the engine library. Not thread-safe: one
+// thread sends and polls.
+class ShmOrderEntryClient {
+public:
+    ShmOrderEntryClient() = default;
+    ~ShmOrderEntryClient();
+
+    // Non-copyable, non-movable
+    ShmOrderEntryClient(const ShmOrderEntryClient&) = delete;
+    ShmOrderEntryClient& operator=(const ShmOrderEntryClient&) = delete;
+
+    // Register with the engine publishing `name` and map this client's rings
+    bool connect(const std::string& name, const std::string& client_name,
+                 std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+    void disconnect();
+    bool is_connected() const { return segment_ != nullptr; }
+
+    uint64_t client_id() const { return client_id_; }
+
+    // False when the request ring is full or the body does not fit
+    bool send(MessageType type, const void* body, size_t length);
+
+    template<typename T>
+    bool send(MessageType type, const T& body) {
+        return send(type, &body, sizeof(T));
+    }
+
+    // Next response or execution report, false if none is waiting
+    bool poll(ShmMessage& message);
+
+    // False once the engine has stopped; the rings are then abandoned
+    bool engine_running() const;
+
+private:
+    void* registry_ = nullptr;
+    size_t registry_size_ = 0;
+    void* segment_ = nullptr;
+    size_t segment_size_ = 0;
+    size_t slot_ = 0;
+    uint64_t client_id_ = 0;
+    ShmRing requests_;
+    ShmRing responses_;
+
+    void unmap();
+};
+
+} // namespace UltraFastAnalysis
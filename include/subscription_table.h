@@ -0,0 +1,129 @@
+#pragma once
+
+#include "market_data.h"
+#include "memory_accounting.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace UltraFastAnalysis {
+
+// Upper bound on concurrently subscribed sessions; each session owns one bit slot
+constexpr size_t MAX_SUBSCRIBER_SESSIONS = 1024;
+
+// Subscription channels, one bit each. Market data channels match MarketDataType.
+enum SubscriptionChannel : uint8_t {
+    CHANNEL_TRADE = 1 << static_cast<uint8_t>(MarketDataType::TRADE),
+    CHANNEL_QUOTE = 1 << static_cast<uint8_t>(MarketDataType::QUOTE),
+    CHANNEL_BOOK_UPDATE = 1 << static_cast<uint8_t>(MarketDataType::ORDER_BOOK_UPDATE),
+    CHANNEL_TICK = 1 << static_cast<uint8_t>(MarketDataType::TICK),
+    CHANNEL_BOOK_SNAPSHOT = 1 << 4,
+    CHANNEL_ALL = 0x1F
+};
+
+constexpr size_t SUBSCRIPTION_CHANNEL_COUNT = 5;
+
+// Fixed-size set of session slots. Bits are flipped atomically so subscription
+// changes never block the publisher.
+class SessionBitset {
+public:
+    static constexpr size_t WORDS = MAX_SUBSCRIBER_SESSIONS / 64;
+
+    void set(uint32_t slot) {
+        words_[slot / 64].fetch_or(uint64_t{1} << (slot % 64), std::memory_order_relaxed);
+    }
+
+    void clear(uint32_t slot) {
+        words_[slot / 64].fetch_and(~(uint64_t{1} << (slot % 64)), std::memory_order_relaxed);
+    }
+
+    uint64_t word(size_t index) const {
+        return words_[index].load(std::memory_order_relaxed);
+    }
+
+    bool empty() const {
+        for (const auto& word : words_) {
+            if (word.load(std::memory_order_relaxed) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, WORDS> words_{};
+};
+
+// Per-instrument, per-channel subscriber bitsets. The symbol "*" subscribes to every
+// instrument. Publishers call for_each_subscriber, which visits only the set bits.
+class SubscriptionTable {
+public:
+    static constexpr const char* WILDCARD = "*";
+
+    // Instruments with at least one subscriber; further symbols are refused
+    static constexpr size_t MAX_INSTRUMENTS = 65536;
+
+    // False if the symbol would exceed MAX_INSTRUMENTS
+    bool subscribe(uint32_t slot, const std::string& symbol, uint8_t channels);
+    void unsubscribe(uint32_t slot, const std::string& symbol, uint8_t channels);
+
+    // Clear a session from every instrument before its slot is reused
+    void remove_session(uint32_t slot);
+
+    // Visit the slots subscribed to `channel` (one SubscriptionChannel bit) for `symbol`
+    template<typename F>
+    void for_each_subscriber(const std::string& symbol, uint8_t channel, F&& visit) const {
+        size_t index = static_cast<size_t>(std::countr_zero(channel));
+        if (index >= SUBSCRIPTION_CHANNEL_COUNT) {
+            return;
+        }
+
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = instruments_.find(symbol);
+        const SessionBitset* instrument = (it != instruments_.end()) ? &it->second->channels[index] : nullptr;
+        const SessionBitset& wildcard = wildcard_.channels[index];
+
+        for (size_t w = 0; w < SessionBitset::WORDS; ++w) {
+            uint64_t bits = wildcard.word(w) | (instrument ? instrument->word(w) : 0);
+            while (bits) {
+                visit(static_cast<uint32_t>(w * 64 + std::countr_zero(bits)));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    struct InstrumentSubscribers {
+        std::array<SessionBitset, SUBSCRIPTION_CHANNEL_COUNT> channels;
+        MemoryCharge memory{MemorySubsystem::SESSIONS, sizeof(channels)};
+
+        bool empty() const {
+            for (const auto& channel : channels) {
+                if (!channel.empty()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // Entries are created on first subscribe and erased once their last subscriber
+    // leaves. Bits are only set under a shared lock and entries only erased under the
+    // exclusive lock, so an entry found under a shared lock stays valid while it is held.
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<InstrumentSubscribers>, std::hash<std::string>,
+                       std::equal_to<std::string>,
+                       TrackingAllocator<std::pair<const std::string, std::unique_ptr<InstrumentSubscribers>>,
+                                         MemorySubsystem::SESSIONS>> instruments_;
+    InstrumentSubscribers wildcard_;
+
+    void erase_if_empty(const std::string& symbol);
+};
+
+} // namespace UltraFastAnalysis
@@ -2,12 +2,22 @@
 
 #include "order.h"
 #include "market_data.h"
+#include "order_entry_protocol.h"
+#include "subscription_table.h"
+#include "network_server.h"
+#include "session_layer.h"
+#include "memory_accounting.h"
 #include <boost/asio.hpp>
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <thread>
 #include <atomic>
 #include <functional>
 #include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
 
 namespace UltraFastAnalysis {
 
@@ -21,9 +31,26 @@ enum class MessageType : uint32_t {
     ORDER_STATUS_REQUEST = 6,
     HEARTBEAT = 7,
     LOGIN = 8,
-    LOGOUT = 9
+    LOGOUT = 9,
+    RESEND_REQUEST = 10,
+    SEQUENCE_RESET = 11,
+    
+    // Binary order entry, see order_entry_protocol.h
+    BINARY_NEW_ORDER = 16,
+    BINARY_CANCEL_ORDER = 17,
+    BINARY_AMEND_ORDER = 18,
+    MASS_CANCEL = 19,
+    ORDER_ACK = 20,
+    SUBSCRIBE = 21,
+    UNSUBSCRIBE = 22,
+    EXECUTION_REPORT = 23       // Shared-memory order entry only, see shm_order_entry.h
 };
 
+// Set in message_type on messages sent again in answer to a RESEND_REQUEST, like
+// FIX's PossDupFlag, so clients can tell a replay from a new message. Inbound
+// messages may carry it too; the server masks it off.
+constexpr uint32_t MESSAGE_FLAG_POSS_DUP = 0x80000000u;
+
 // Message header for all TCP messages
 struct MessageHeader {
     uint32_t message_type;
@@ -34,126 +61,366 @@ struct MessageHeader {
     MessageHeader() : message_type(0), message_length(0), sequence_number(0), timestamp(0) {}
 };
 
-// Client connection class
-class ClientConnection : public std::enable_shared_from_this<ClientConnection> {
+// Message waiting in a connection's outbound queue. Large payloads are shared
+// immutable buffers; small fixed-layout bodies are stored inline.
+struct OutboundMessage {
+    static constexpr size_t INLINE_PAYLOAD_SIZE = 64;
+    
+    MessageHeader header;
+    std::shared_ptr<const std::string> payload;
+    std::array<uint8_t, INLINE_PAYLOAD_SIZE> inline_payload;
+    
+    size_t wire_size() const { return sizeof(MessageHeader) + header.message_length; }
+};
+
+// Shared payload charged to MemorySubsystem::CONNECTION_BUFFERS, control block and
+// string buffer alike, for as long as any queue holds it
+std::shared_ptr<const std::string> make_outbound_payload(std::string data);
+
+// Transport-independent half of a client session: decodes inbound messages, invokes
+// the order callbacks and encodes replies. Transports feed received bytes to
+// dispatch_messages() and deliver whatever is passed to enqueue().
+//
+// The session layer numbers every outbound message and journals it (SessionStore),
+// checks inbound sequence numbers and asks the client to resend on a gap, answers
+// RESEND_REQUEST from the journal, and runs heartbeats from the server's timer wheel.
+// Inbound sequence number 0 means unsequenced and is never checked.
+class ProtocolSession {
 public:
-    explicit ClientConnection(boost::asio::ip::tcp::socket socket);
-    ~ClientConnection();
+    ProtocolSession(uint64_t connection_id, std::shared_ptr<const InstrumentRegistry> instruments);
+    virtual ~ProtocolSession() = default;
     
-    void start();
-    void stop();
-    bool is_connected() const;
+    virtual bool is_connected() const = 0;
     
     // Message handling
     void send_order_confirmation(const Order& order);
     void send_trade_confirmation(const Order& order, uint64_t fill_quantity, double fill_price);
     void send_order_book_snapshot(const OrderBookSnapshot& snapshot);
     void send_market_data(const MarketData& data);
+    void send_order_ack(const OrderAckMessage& ack);
+    
+    // Queue a pre-encoded payload; broadcasts share one buffer across connections
+    void send_encoded(const MessageHeader& header, const std::shared_ptr<const std::string>& payload);
+    static std::shared_ptr<const std::string> encode_market_data(const MarketData& data);
+    static std::shared_ptr<const std::string> encode_order_book_snapshot(const OrderBookSnapshot& snapshot);
+    static MessageHeader make_header(MessageType type, size_t length);
+    
+    // Legacy text order messages; binary messages are always accepted
+    void set_text_protocol_enabled(bool enabled) { text_protocol_enabled_ = enabled; }
+    
+    // Logged-in sessions are claimed from this store, which also holds the throttle settings
+    void set_session_store(std::shared_ptr<SessionStore> store);
     
-    // Getters
+    // Heartbeat and timeout check, called from the server's timer wheel. Returns when
+    // to check again, or nullopt once the session is closed.
+    std::optional<std::chrono::steady_clock::time_point> on_session_timer(std::chrono::steady_clock::time_point now);
+    
+    // Market data subscriptions are recorded under this session's slot
+    void set_subscriptions(std::shared_ptr<SubscriptionTable> subscriptions, uint32_t session_slot) {
+        subscriptions_ = std::move(subscriptions);
+        session_slot_ = session_slot;
+    }
+    uint32_t get_session_slot() const { return session_slot_; }
+    
+    // Getters. The connection id is fixed at accept; the client id owns the session's
+    // orders and is rebound at login to the id the session was first given.
+    uint64_t get_connection_id() const { return connection_id_; }
     uint64_t get_client_id() const { return client_id_; }
     const std::string& get_client_name() const { return client_name_; }
     
+    // Largest message (header and body) a client may send
+    static constexpr size_t MAX_MESSAGE_SIZE = 8192;
+    
+    void set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback) {
+        order_submit_callback_ = callback;
+    }
+    
+    void set_order_cancel_callback(std::function<void(uint64_t, const std::string&)> callback) {
+        order_cancel_callback_ = callback;
+    }
+    
+    void set_order_modify_callback(std::function<void(uint64_t, const std::string&, uint64_t, double)> callback) {
+        order_modify_callback_ = callback;
+    }
+    
+    // Mass cancel: client id, symbol (empty for all instruments), side
+    void set_order_mass_cancel_callback(std::function<void(uint64_t, const std::string&, MassCancelSide)> callback) {
+        order_mass_cancel_callback_ = callback;
+    }
+    
+    // Order status lookup by order id and symbol; must not block on the matching path
+    void set_order_status_callback(std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> callback) {
+        order_status_callback_ = callback;
+    }
+    
+protected:
+    const uint64_t connection_id_;
+    uint64_t client_id_;            // Written at login under sequence_mutex_
+    std::string client_name_;       // Written at login under sequence_mutex_
+    
+    // Hand a message to the transport; false if the session is closed or over its limit
+    virtual bool enqueue(OutboundMessage&& message) = 0;
+    
+    // Close the connection, after writing everything queued if flush is set; any thread
+    virtual void disconnect(bool flush) = 0;
+    
+    // Release the logged-in session so a new connection can claim it; transports call
+    // this once the connection is closed
+    void end_session();
+    
+    // Dispatch every complete message in [data, data + length). Returns the bytes
+    // consumed; the rest is a partial message to retry once more bytes arrive.
+    // ok is cleared on a framing error, after which the session should close.
+    size_t dispatch_messages(const uint8_t* data, size_t length, bool& ok);
+    uint64_t get_messages_dispatched() const { return messages_dispatched_; }
+    
+    // Transports that can stop reading return true, letting a DELAY throttle hold
+    // messages back. After dispatch_messages() stops on a throttled message this is
+    // how long to wait before dispatching the remaining bytes again; zero otherwise.
+    virtual bool supports_read_pause() const { return false; }
+    std::chrono::nanoseconds get_throttle_delay() const { return throttle_delay_; }
+    
+    // Dispatch one complete inbound message
+    void handle_message(const MessageHeader& header, const uint8_t* data, size_t length);
+    
 private:
-    boost::asio::ip::tcp::socket socket_;
-    std::atomic<bool> connected_{false};
-    uint64_t client_id_;
-    std::string client_name_;
+    bool text_protocol_enabled_{true};
+    uint64_t messages_dispatched_{0};
     
-    // Message buffers
-    static constexpr size_t MAX_MESSAGE_SIZE = 8192;
-    std::array<uint8_t, MAX_MESSAGE_SIZE> read_buffer_;
-    std::array<uint8_t, MAX_MESSAGE_SIZE> write_buffer_;
+    // Order entry rate limits, checked on the read path before a message is decoded
+    OrderThrottle throttle_;
+    std::chrono::nanoseconds throttle_delay_{0};
+    uint64_t throttle_paused_at_{0};            // TscClock ticks, 0 unless a message is held back
+    bool admit_message(const MessageHeader& header, const uint8_t* data, size_t length);
+    void reject_throttled(const MessageHeader& header, const uint8_t* data, size_t length);
+    
+    // Session layer. sequence_mutex_ keeps sequence numbers, journal order and queue
+    // order identical when several threads send to the session.
+    static constexpr uint64_t MAX_RESEND_BATCH = 10000;
+    std::mutex sequence_mutex_;
+    uint64_t next_outbound_sequence_{1};
+    std::shared_ptr<SessionJournal> journal_;   // Set while logged in
+    std::shared_ptr<SessionStore> session_store_;
+    
+    // Inbound sequencing, read path only
+    uint64_t next_inbound_sequence_{0};         // 0 until the first sequenced message
+    bool awaiting_resend_{false};
+    
+    // Heartbeats; the interval is 0 until login
+    std::atomic<uint32_t> heartbeat_interval_ms_{0};
+    std::atomic<int64_t> last_sent_ns_{0};      // steady_clock
+    std::atomic<int64_t> last_received_ns_{0};
+    
+    // Order ids are the client id in the high bits and a per-session sequence; both
+    // are kept in the SessionStore across reconnects
+    uint64_t next_order_sequence_{0};
+    uint64_t next_order_id() { return (client_id_ << 32) | ++next_order_sequence_; }
+    
+    // Instrument ids used by the binary protocol
+    std::shared_ptr<const InstrumentRegistry> instruments_;
+    
+    // Subscription state shared with the server's publisher
+    std::shared_ptr<SubscriptionTable> subscriptions_;
+    uint32_t session_slot_{0};
     
     // Message parsing
-    void handle_message(const MessageHeader& header, const uint8_t* data, size_t length);
     void handle_order_submit(const uint8_t* data, size_t length);
     void handle_order_cancel(const uint8_t* data, size_t length);
     void handle_order_modify(const uint8_t* data, size_t length);
     void handle_market_data_request(const uint8_t* data, size_t length);
-    void handle_login(const uint8_t* data, size_t length);
-    
-    // Network I/O
-    void start_read();
-    void handle_read(const boost::system::error_code& error, size_t bytes_transferred);
-    void start_write();
-    void handle_write(const boost::system::error_code& error, size_t bytes_transferred);
+    void handle_login(const uint8_t* data, size_t length, uint64_t sequence);
+    void handle_logout();
+    void handle_resend_request(const uint8_t* data, size_t length);
+    void handle_sequence_reset(const uint8_t* data, size_t length);
+    bool accept_inbound_sequence(MessageType type, uint64_t sequence);
+    void handle_binary_new_order(const uint8_t* data, size_t length);
+    void handle_binary_cancel_order(const uint8_t* data, size_t length);
+    void handle_binary_amend_order(const uint8_t* data, size_t length);
+    void handle_mass_cancel(const uint8_t* data, size_t length);
+    void handle_order_status_request(const uint8_t* data, size_t length);
+    void handle_subscription(const uint8_t* data, size_t length, bool subscribe);
+    void update_subscription(const std::string& symbol, uint8_t channels, bool subscribe);
+    void reject_order(const NewOrderMessage& message, OrderRejectReason reason);
     
     // Message serialization
     template<typename T>
     void serialize_message(MessageType type, const T& data);
+    void enqueue_message(MessageType type, std::shared_ptr<const std::string> payload);
+    void send_empty(MessageType type);
+    
+    // Number, journal and queue one outbound message
+    bool send_message(OutboundMessage&& message);
+    void send_gap_fill(uint64_t begin_sequence, uint64_t new_sequence);
     
     // Callbacks
-    std::function<void(std::shared_ptr<Order>)> order_submit_callback_;
+    std::function<bool(std::shared_ptr<Order>)> order_submit_callback_;
     std::function<void(uint64_t, const std::string&)> order_cancel_callback_;
     std::function<void(uint64_t, const std::string&, uint64_t, double)> order_modify_callback_;
-    
+    std::function<void(uint64_t, const std::string&, MassCancelSide)> order_mass_cancel_callback_;
+    std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> order_status_callback_;
+};
+
+// Client connection served by Boost.Asio
+class ClientConnection : public ProtocolSession, public std::enable_shared_from_this<ClientConnection> {
 public:
-    void set_order_submit_callback(std::function<void(std::shared_ptr<Order>)> callback) {
-        order_submit_callback_ = callback;
-    }
+    ClientConnection(boost::asio::ip::tcp::socket socket, uint64_t connection_id,
+                     std::shared_ptr<const InstrumentRegistry> instruments);
+    ~ClientConnection();
     
-    void set_order_cancel_callback(std::function<void(uint64_t, const std::string&)> callback) {
-        order_cancel_callback_ = callback;
-    }
+    void start();
+    void stop();
+    bool is_connected() const override;
+    bool supports_read_pause() const override { return true; }
     
-    void set_order_modify_callback(std::function<void(uint64_t, const std::string&, uint64_t, double)> callback) {
-        order_modify_callback_ = callback;
-    }
+    // Outbound bytes a client may have queued before it is disconnected as a slow consumer
+    void set_max_outbound_bytes(size_t bytes) { max_outbound_bytes_ = bytes; }
+    size_t get_outbound_queue_bytes() const;
+    
+    // Invoked once with the connection id, from the connection's strand, after the connection stops
+    void set_disconnect_callback(std::function<void(uint64_t)> callback) { disconnect_callback_ = callback; }
+    
+protected:
+    bool enqueue(OutboundMessage&& message) override;
+    void disconnect(bool flush) override;
+    
+private:
+    boost::asio::ip::tcp::socket socket_;
+    boost::asio::strand<boost::asio::any_io_executor> strand_;
+    std::atomic<bool> connected_{false};
+    
+    // Inbound bytes; [read_start_, read_end_) is received but not yet dispatched.
+    // Each read fills all free space, so a burst of messages costs one read.
+    static constexpr size_t READ_BUFFER_SIZE = 64 * 1024;
+    std::array<uint8_t, READ_BUFFER_SIZE> read_buffer_;
+    MemoryCharge read_buffer_memory_{MemorySubsystem::CONNECTION_BUFFERS, READ_BUFFER_SIZE};
+    size_t read_start_{0};
+    size_t read_end_{0};
+    
+    // Holds reads while a throttled message waits; the socket buffer fills and TCP
+    // flow control slows the client down
+    boost::asio::steady_timer throttle_timer_;
+    
+    // Outbound queue: producers append to pending_ under queue_mutex_, the single
+    // writer swaps it into writing_ and sends the whole batch with one gather write
+    static constexpr size_t DEFAULT_MAX_OUTBOUND_BYTES = 4 * 1024 * 1024;
+    static constexpr size_t MAX_WRITE_BATCH = 256;
+    mutable std::mutex queue_mutex_;
+    using OutboundQueue = std::vector<OutboundMessage,
+                                      TrackingAllocator<OutboundMessage, MemorySubsystem::CONNECTION_BUFFERS>>;
+    OutboundQueue pending_;
+    OutboundQueue writing_;
+    std::vector<boost::asio::const_buffer,
+                TrackingAllocator<boost::asio::const_buffer, MemorySubsystem::CONNECTION_BUFFERS>> write_buffers_;
+    size_t queued_bytes_{0};
+    size_t max_outbound_bytes_{DEFAULT_MAX_OUTBOUND_BYTES};
+    bool write_in_progress_{false};
+    std::atomic<bool> close_after_flush_{false};
+    
+    std::function<void(uint64_t)> disconnect_callback_;
+    
+    // Network I/O
+    void start_read();
+    void handle_read(const boost::system::error_code& error, size_t bytes_transferred);
+    void dispatch_received();
+    void start_write();
+    void handle_write(const boost::system::error_code& error, size_t bytes_transferred);
 };
 
-// Main TCP server class
-class TCPServer {
+// Main TCP server class (Boost.Asio backend)
+// Asio order entry server. Workers either share one io_context, or each runs its
+// own io_context and serves the connections assigned to it end to end.
+class TCPServer : public NetworkServer {
 public:
     explicit TCPServer(uint16_t port, size_t num_threads = 4);
-    ~TCPServer();
+    explicit TCPServer(const NetworkServerConfig& config);
+    ~TCPServer() override;
     
     // Non-copyable, non-movable
     TCPServer(const TCPServer&) = delete;
     TCPServer& operator=(const TCPServer&) = delete;
     
     // Server lifecycle
-    bool start();
-    void stop();
-    bool is_running() const;
+    bool start() override;
+    void stop() override;
+    bool is_running() const override;
     
     // Client management
-    size_t get_client_count() const;
-    std::vector<uint64_t> get_client_ids() const;
+    size_t get_client_count() const override;
+    void set_max_outbound_bytes(size_t bytes) override;
+    std::vector<uint64_t> get_client_ids() const override;
     
     // Broadcasting
-    void broadcast_market_data(const MarketData& data);
-    void broadcast_order_book_update(const OrderBookSnapshot& snapshot);
+    void broadcast_market_data(const MarketData& data) override;
+    void broadcast_order_book_update(const OrderBookSnapshot& snapshot) override;
     
     // Callback setters
-    void set_order_submit_callback(std::function<void(std::shared_ptr<Order>)> callback);
-    void set_order_cancel_callback(std::function<void(uint64_t, const std::string&)> callback);
-    void set_order_modify_callback(std::function<void(uint64_t, const std::string&, uint64_t, double)> callback);
+    void set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback) override;
+    void set_order_cancel_callback(std::function<void(uint64_t, const std::string&)> callback) override;
+    void set_order_modify_callback(std::function<void(uint64_t, const std::string&, uint64_t, double)> callback) override;
+    void set_order_mass_cancel_callback(std::function<void(uint64_t, const std::string&, MassCancelSide)> callback) override;
+    void set_order_status_callback(std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> callback) override;
+    
+    // Protocol configuration; set before start()
+    InstrumentRegistry& get_instrument_registry() override { return *instruments_; }
+    void set_text_protocol_enabled(bool enabled) override;
+    void set_session_config(const SessionConfig& config) override;
+    ThrottleStats get_throttle_stats() const override;
     
 private:
-    boost::asio::io_context io_context_;
-    boost::asio::ip::tcp::acceptor acceptor_;
+    using WorkGuard = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+    
+    NetworkServerConfig config_;
+    
+    // SHARED: one context run by every worker. PER_THREAD: context i is run by worker i.
+    std::vector<std::unique_ptr<boost::asio::io_context>> io_contexts_;
+    std::vector<WorkGuard> work_guards_;
+    
+    // One acceptor, or with reuse_port one per worker on that worker's io_context
+    std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> acceptors_;
+    std::atomic<size_t> next_worker_{0};
+    
     std::vector<std::thread> worker_threads_;
     std::atomic<bool> running_{false};
-    size_t num_threads_;
     
-    // Client management
+    // Client management, keyed by connection id
     std::unordered_map<uint64_t, std::shared_ptr<ClientConnection>> clients_;
     mutable std::shared_mutex clients_mutex_;
-    std::atomic<uint64_t> next_client_id_{1};
+    std::atomic<uint64_t> next_connection_id_{1};
+    
+    // Protocol configuration shared with every connection
+    std::shared_ptr<InstrumentRegistry> instruments_;
+    bool text_protocol_enabled_{true};
+    
+    // Session journals, and heartbeat timers keyed by connection id on one periodic tick
+    std::shared_ptr<SessionStore> session_store_;
+    std::unique_ptr<TimerWheel> session_timers_;
+    std::unique_ptr<boost::asio::steady_timer> session_tick_;
+    std::vector<uint64_t> expired_timers_;
+    
+    // Subscriptions and the connection owning each session slot (guarded by clients_mutex_)
+    std::shared_ptr<SubscriptionTable> subscriptions_;
+    std::vector<std::shared_ptr<ClientConnection>> sessions_by_slot_;
+    std::vector<uint32_t> free_session_slots_;
+    size_t max_outbound_bytes_{0};  // 0 keeps the connection default
     
     // Callbacks
-    std::function<void(std::shared_ptr<Order>)> order_submit_callback_;
+    std::function<bool(std::shared_ptr<Order>)> order_submit_callback_;
     std::function<void(uint64_t, const std::string&)> order_cancel_callback_;
     std::function<void(uint64_t, const std::string&, uint64_t, double)> order_modify_callback_;
+    std::function<void(uint64_t, const std::string&, MassCancelSide)> order_mass_cancel_callback_;
+    std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> order_status_callback_;
     
     // Internal methods
-    void start_accept();
+    void open_acceptors();
+    void start_accept(size_t acceptor_index);
     void handle_accept(const boost::system::error_code& error, boost::asio::ip::tcp::socket socket);
-    void remove_client(uint64_t client_id);
+    size_t select_worker(const boost::asio::ip::tcp::socket& socket);
+    void remove_client(uint64_t connection_id);
+    void schedule_session_tick();
+    void handle_session_tick();
     
     // Worker thread function
-    void worker_thread_function();
+    void worker_thread_function(size_t worker_index);
 };
 
 } // namespace UltraFastAnalysis
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace UltraFastAnalysis {
+
+// Name the calling thread, as shown by top -H, perf, gdb and CPUTracker's
+// per-thread usage. Linux keeps 15 characters; longer names are cut.
+inline void set_current_thread_name(const std::string& name) {
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#else
+    (void)name;
+#endif
+}
+
+} // namespace UltraFastAnalysis
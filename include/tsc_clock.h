@@ -0,0 +1,21 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace UltraFastAnalysis {
+
+// Cycle counter for timestamps taken on hot paths (throttling, the flight recorder,
+// jitter sampling). On x86-64 this is the TSC (invariant on every CPU the engine
+// targets); elsewhere it falls back to steady_clock nanoseconds.
+class TscClock {
+public:
+    static uint64_t now();
+
+    // Calibrated once against steady_clock on first use
+    static uint64_t ticks_per_second();
+
+    static std::chrono::nanoseconds to_duration(uint64_t ticks);
+};
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "market_data_processor.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct mmsghdr;
+struct iovec;
+
+namespace UltraFastAnalysis {
+
+// Wire format for the UDP multicast feed (little-endian, packed)
+#pragma pack(push, 1)
+struct FeedPacketHeader {
+    uint64_t sequence_number;   // Sequence number of the first message in the packet
+    uint16_t message_count;     // Number of FeedMessage records following the header
+    uint16_t packet_length;     // Total packet length including this header
+    uint32_t reserved;
+};
+
+struct FeedMessage {
+    uint8_t type;               // MarketDataType
+    uint8_t is_bid;             // Side for ORDER_BOOK_UPDATE
+    uint8_t reserved[6];
+    char symbol[16];            // NUL-padded
+    uint64_t timestamp_ns;      // Exchange timestamp
+    uint64_t trade_id;
+    int64_t price;              // Trade / book price, or bid price for quotes
+    uint64_t quantity;          // Trade / book quantity, or bid quantity for quotes
+    int64_t ask_price;          // Ask price for quotes
+    uint64_t ask_quantity;      // Ask quantity for quotes
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FeedPacketHeader) == 16, "FeedPacketHeader layout changed");
+static_assert(sizeof(FeedMessage) == 72, "FeedMessage layout changed");
+
+// Prices on the wire are integers in units of 1/FEED_PRICE_MULTIPLIER
+constexpr int64_t FEED_PRICE_MULTIPLIER = 10000;
+constexpr size_t MAX_FEED_PACKET_SIZE = 1472; // Fits a standard Ethernet MTU
+
+// Arbitration statistics for the A/B lines
+struct FeedArbitrationStats {
+    std::atomic<uint64_t> packets_line_a{0};
+    std::atomic<uint64_t> packets_line_b{0};
+    std::atomic<uint64_t> packets_accepted{0};
+    std::atomic<uint64_t> packets_duplicate{0};
+    std::atomic<uint64_t> packets_malformed{0};
+    std::atomic<uint64_t> packets_held{0};      // Arrived ahead of a missing range and waited for it
+    std::atomic<uint64_t> sequence_gaps{0};
+    std::atomic<uint64_t> messages_lost{0};
+    std::atomic<uint64_t> recv_batches{0};
+
+    void reset() {
+        packets_line_a = 0;
+        packets_line_b = 0;
+        packets_accepted = 0;
+        packets_duplicate = 0;
+        packets_malformed = 0;
+        packets_held = 0;
+        sequence_gaps = 0;
+        messages_lost = 0;
+        recv_batches = 0;
+    }
+};
+
+// UDP multicast market data source with A/B line arbitration.
+// Both lines are drained with recvmmsg into pre-allocated buffers; the first copy of
+// each sequence number wins and the packet is handed to the decoder in place. A
+// packet that arrives past a missing range is copied aside for up to
+// arbitration_hold, since the other line is usually only a little behind; the
+// range is reported lost only if neither line fills it in that time.
+class UdpMulticastDataSource : public MarketDataSource {
+public:
+    // Decoder invoked for every arbitrated packet. The pointer refers to the receive
+    // buffer and is only valid for the duration of the call.
+    using PacketDecoder = std::function<void(const uint8_t* data, size_t length)>;
+
+    explicit UdpMulticastDataSource(const MarketDataConfig& config);
+    ~UdpMulticastDataSource() override;
+
+    bool connect() override;
+    void disconnect() override;
+    bool is_connected() const override;
+
+    bool start_streaming() override;
+    void stop_streaming() override;
+
+    void set_data_callback(std::function<void(const MarketData&)> callback) override;
+    void set_error_callback(std::function<void(const std::string&)> callback) override;
+
+    const MarketDataStats& get_stats() const override;
+    void reset_stats() override;
+
+    // Replace the built-in FeedMessage decoder (e.g. for a venue-specific format)
+    void set_packet_decoder(PacketDecoder decoder);
+
+    const FeedArbitrationStats& get_arbitration_stats() const;
+    uint64_t get_next_expected_sequence() const;
+
+private:
+    static constexpr size_t NUM_LINES = 2;
+
+    MarketDataConfig config_;
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> streaming_{false};
+
+    std::thread receive_thread_;
+    std::atomic<bool> shutdown_requested_{false};
+
+    std::function<void(const MarketData&)> data_callback_;
+    std::function<void(const std::string&)> error_callback_;
+    PacketDecoder packet_decoder_;
+
+    std::array<int, NUM_LINES> sockets_{{-1, -1}};
+
+    // recvmmsg batch state, allocated once in connect()
+    size_t batch_size_;
+    std::vector<uint8_t> packet_storage_;
+    std::vector<iovec> iovecs_;
+    std::vector<mmsghdr> messages_;
+    
+    // Packets received from both lines in the current drain cycle
+    struct PendingPacket {
+        uint8_t* data;
+        size_t length;
+        uint64_t sequence_number;
+    };
+    std::vector<PendingPacket> pending_;
+
+    // Arbitration state (owned by the receive thread)
+    std::atomic<uint64_t> next_expected_sequence_{0};
+    bool sequence_initialized_{false};
+
+    // Packets waiting for a missing range, in sequence order, copied into
+    // fixed slots allocated in connect()
+    struct HeldPacket {
+        uint64_t sequence_number;
+        size_t length;
+        uint64_t held_at_ns;
+        uint32_t slot;
+    };
+    uint64_t hold_ns_;
+    std::vector<HeldPacket> held_;
+    std::vector<uint8_t> held_storage_;
+    std::vector<uint32_t> free_held_slots_;
+
+    MarketDataStats stats_;
+    FeedArbitrationStats arbitration_stats_;
+
+    // Scratch object reused by the default decoder
+    MarketData decoded_;
+
+    // Internal methods
+    int open_line_socket(const std::string& group, uint16_t port);
+    void close_sockets();
+    void receive_thread_worker();
+    void drain_line(size_t line);
+    void arbitrate_packet(uint8_t* data, size_t length, uint64_t now_ns);
+    bool hold_packet(const uint8_t* data, size_t length, uint64_t sequence_number, uint64_t now_ns);
+    void release_held_packets(uint64_t now_ns, bool force);
+    void deliver_packet(uint8_t* data, size_t length);
+    void decode_packet(const uint8_t* data, size_t length);
+    void report_error(const std::string& error);
+};
+
+} // namespace UltraFastAnalysis
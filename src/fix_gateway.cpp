@@ -0,0 +1,1180 @@
+#include "fix_gateway.h"
+#include "thread_name.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <charconv>
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+constexpr std::string_view BEGIN_STRING = "8=FIX.4.4\x01";
+
+constexpr uint32_t checksum_of(std::string_view text) {
+    uint32_t sum = 0;
+    for (char c : text) {
+        sum += static_cast<uint8_t>(c);
+    }
+    return sum;
+}
+
+// Checksum contribution of "8=FIX.4.4|9=", the constant start of every message
+constexpr uint32_t BEGIN_STRING_CHECKSUM = checksum_of("8=FIX.4.4\x01" "9=");
+
+} // namespace
+
+// FixMessageView implementation
+int64_t FixMessageView::frame(const char* data, size_t length) {
+    // Every message starts "8=FIX.4.4|9=<BodyLength>|"
+    size_t prefix = std::min(length, BEGIN_STRING.size());
+    if (std::memcmp(data, BEGIN_STRING.data(), prefix) != 0) {
+        return -1;
+    }
+    if (length < BEGIN_STRING.size() + 2) {
+        return 0;
+    }
+    if (data[BEGIN_STRING.size()] != '9' || data[BEGIN_STRING.size() + 1] != '=') {
+        return -1;
+    }
+
+    size_t pos = BEGIN_STRING.size() + 2;
+    size_t body_length = 0;
+    size_t digits = 0;
+    for (;; ++pos, ++digits) {
+        if (pos == length) {
+            return 0;
+        }
+        char c = data[pos];
+        if (c == FIX_SOH) {
+            break;
+        }
+        if (c < '0' || c > '9' || digits == 6) {
+            return -1;
+        }
+        body_length = body_length * 10 + static_cast<size_t>(c - '0');
+    }
+    if (digits == 0) {
+        return -1;
+    }
+
+    // Body, then the fixed-width trailer "10=nnn|"
+    size_t body_end = pos + 1 + body_length;
+    size_t total = body_end + 7;
+    if (length < total) {
+        return 0;
+    }
+    if (std::memcmp(data + body_end, "10=", 3) != 0 || data[total - 1] != FIX_SOH) {
+        return -1;
+    }
+    return static_cast<int64_t>(total);
+}
+
+bool FixMessageView::parse(const char* data, size_t length) {
+    // Clear only the index entries the previous message set
+    for (size_t i = 0; i < field_count_; ++i) {
+        if (fields_[i].tag < INDEXED_TAGS) {
+            index_[fields_[i].tag] = 0;
+        }
+    }
+    data_ = data;
+    field_count_ = 0;
+
+    uint32_t checksum = 0;
+    size_t pos = 0;
+    while (pos < length) {
+        size_t field_start = pos;
+
+        int tag = 0;
+        while (pos < length && data[pos] != '=') {
+            char c = data[pos];
+            if (c < '0' || c > '9' || tag > 100000) {
+                return false;
+            }
+            tag = tag * 10 + (c - '0');
+            ++pos;
+        }
+        if (pos == length || tag == 0) {
+            return false;
+        }
+
+        size_t value_start = ++pos;
+        while (pos < length && data[pos] != FIX_SOH) {
+            ++pos;
+        }
+        if (pos == length) {
+            return false;
+        }
+
+        if (tag == 10) {
+            // The checksum covers every byte before the CheckSum field
+            int64_t expected = 0;
+            auto result = std::from_chars(data + value_start, data + pos, expected);
+            if (result.ptr != data + pos || expected != static_cast<int64_t>(checksum % 256)) {
+                return false;
+            }
+        } else {
+            for (size_t i = field_start; i <= pos; ++i) {
+                checksum += static_cast<uint8_t>(data[i]);
+            }
+        }
+
+        if (field_count_ == MAX_FIELDS) {
+            return false;
+        }
+        fields_[field_count_] = Field{tag, static_cast<uint32_t>(value_start),
+                                      static_cast<uint32_t>(pos - value_start)};
+        ++field_count_;
+        if (tag < INDEXED_TAGS && index_[tag] == 0) {
+            index_[tag] = static_cast<uint8_t>(field_count_);
+        }
+
+        ++pos;
+    }
+    return field_count_ >= 4;
+}
+
+std::string_view FixMessageView::get(int tag) const {
+    if (tag > 0 && tag < INDEXED_TAGS) {
+        uint8_t index = index_[tag];
+        if (index == 0) {
+            return {};
+        }
+        const Field& field = fields_[index - 1];
+        return std::string_view(data_ + field.offset, field.length);
+    }
+
+    for (size_t i = 0; i < field_count_; ++i) {
+        if (fields_[i].tag == tag) {
+            return std::string_view(data_ + fields_[i].offset, fields_[i].length);
+        }
+    }
+    return {};
+}
+
+bool FixMessageView::get_int(int tag, int64_t& value) const {
+    std::string_view text = get(tag);
+    if (text.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool FixMessageView::get_double(int tag, double& value) const {
+    std::string_view text = get(tag);
+    if (text.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+char FixMessageView::get_char(int tag) const {
+    std::string_view text = get(tag);
+    return text.empty() ? 0 : text[0];
+}
+
+// FixMessageWriter implementation
+FixMessageWriter::Segment FixMessageWriter::Segment::make(std::string text) {
+    Segment segment;
+    segment.checksum = checksum_of(text);
+    segment.text = std::move(text);
+    return segment;
+}
+
+void FixMessageWriter::begin(std::string_view msg_type, const Segment& header_fields, uint64_t seq_num,
+                             std::string_view sending_time) {
+    length_ = HEADER_RESERVE;
+    checksum_ = 0;
+    overflow_ = false;
+
+    add(35, msg_type);
+
+    // SenderCompID and TargetCompID are fixed for the session
+    if (length_ + header_fields.text.size() > buffer_.size() - 8) {
+        overflow_ = true;
+        return;
+    }
+    std::memcpy(buffer_.data() + length_, header_fields.text.data(), header_fields.text.size());
+    length_ += header_fields.text.size();
+    checksum_ += header_fields.checksum;
+
+    add(34, seq_num);
+    add(52, sending_time);
+}
+
+void FixMessageWriter::add(int tag, std::string_view value) {
+    append_tag(tag);
+    append(value);
+    append(std::string_view(&FIX_SOH, 1));
+}
+
+void FixMessageWriter::add(int tag, uint64_t value) {
+    char text[24];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    add(tag, std::string_view(text, result.ptr - text));
+}
+
+void FixMessageWriter::add(int tag, double value) {
+    // Shortest round-trip fixed notation; FIX prices never use exponents
+    char text[64];
+    auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed);
+    if (result.ec != std::errc()) {
+        overflow_ = true;
+        return;
+    }
+    add(tag, std::string_view(text, result.ptr - text));
+}
+
+void FixMessageWriter::add(int tag, char value) {
+    add(tag, std::string_view(&value, 1));
+}
+
+std::string_view FixMessageWriter::finish() {
+    if (overflow_) {
+        return {};
+    }
+
+    // Render "8=FIX.4.4|9=<BodyLength>|" right-aligned against the body
+    char digits[8] = {};
+    auto result = std::to_chars(digits, digits + sizeof(digits), length_ - HEADER_RESERVE);
+    if (result.ec != std::errc()) {
+        return {};
+    }
+    std::string_view body_length(digits, result.ptr - digits);
+
+    size_t prefix_length = BEGIN_STRING.size() + 2 + body_length.size() + 1;
+    size_t start = HEADER_RESERVE - prefix_length;
+    char* out = buffer_.data() + start;
+    std::memcpy(out, "8=FIX.4.4\x01" "9=", BEGIN_STRING.size() + 2);
+    std::memcpy(out + BEGIN_STRING.size() + 2, body_length.data(), body_length.size());
+    out[prefix_length - 1] = FIX_SOH;
+    uint32_t checksum = checksum_ + BEGIN_STRING_CHECKSUM + checksum_of(body_length) + static_cast<uint8_t>(FIX_SOH);
+
+    // Trailer "10=nnn|"
+    checksum %= 256;
+    char* trailer = buffer_.data() + length_;
+    trailer[0] = '1';
+    trailer[1] = '0';
+    trailer[2] = '=';
+    trailer[3] = static_cast<char>('0' + checksum / 100);
+    trailer[4] = static_cast<char>('0' + (checksum / 10) % 10);
+    trailer[5] = static_cast<char>('0' + checksum % 10);
+    trailer[6] = FIX_SOH;
+
+    return std::string_view(out, length_ + 7 - start);
+}
+
+void FixMessageWriter::append(std::string_view text) {
+    // Keep room for the 7-byte trailer
+    if (length_ + text.size() > buffer_.size() - 8) {
+        overflow_ = true;
+        return;
+    }
+    std::memcpy(buffer_.data() + length_, text.data(), text.size());
+    length_ += text.size();
+    checksum_ += checksum_of(text);
+}
+
+void FixMessageWriter::append_tag(int tag) {
+    char text[16];
+    auto result = std::to_chars(text, text + sizeof(text) - 1, tag);
+    *result.ptr++ = '=';
+    append(std::string_view(text, result.ptr - text));
+}
+
+// FixCounterpartyState implementation
+FixCounterpartyState::OrderMap::iterator FixCounterpartyState::apply(const FixExecution& execution) {
+    auto id = cl_ord_ids.find(execution.order_id);
+    if (id == cl_ord_ids.end()) {
+        return orders.end();
+    }
+    auto it = orders.find(id->second);
+    if (it == orders.end()) {
+        cl_ord_ids.erase(id);
+        return it;
+    }
+
+    FixOrderReference& order = it->second;
+    order.quantity = execution.quantity;
+    if (execution.last_quantity > 0) {
+        order.cum_quantity = execution.filled_quantity;
+        order.notional += static_cast<double>(execution.last_quantity) * execution.last_price;
+    }
+    return it;
+}
+
+void FixCounterpartyState::finish(OrderMap::iterator order, const FixExecution& execution) {
+    if (execution.status == OrderStatus::FILLED || execution.status == OrderStatus::CANCELLED ||
+        execution.status == OrderStatus::REJECTED) {
+        cl_ord_ids.erase(order->second.order_id);
+        orders.erase(order);
+    }
+}
+
+// FixSession implementation
+FixSession::FixSession(boost::asio::ip::tcp::socket socket, uint64_t connection_id, const FixGatewayConfig& config,
+                       std::shared_ptr<const FixOrderHandlers> handlers)
+    : socket_(std::move(socket)), strand_(boost::asio::make_strand(socket_.get_executor())),
+      heartbeat_timer_(strand_), connection_id_(connection_id), config_(config), handlers_(std::move(handlers)),
+      read_buffer_(READ_BUFFER_SIZE) {
+    outbound_.reserve(16 * 1024);
+    writing_.reserve(16 * 1024);
+}
+
+FixSession::~FixSession() {
+    boost::system::error_code ec;
+    socket_.close(ec);
+}
+
+void FixSession::start() {
+    if (connected_.exchange(true)) {
+        return;
+    }
+
+    boost::asio::dispatch(strand_, [this, self = shared_from_this()]() {
+        connected_at_ = std::chrono::steady_clock::now();
+        last_received_ = connected_at_;
+        last_sent_ = connected_at_;
+        start_read();
+        schedule_heartbeat();
+    });
+}
+
+void FixSession::stop() {
+    if (!connected_.exchange(false)) {
+        return;
+    }
+
+    boost::asio::post(strand_, [this, self = shared_from_this()]() {
+        heartbeat_timer_.cancel();
+        boost::system::error_code ec;
+        socket_.close(ec);
+
+        // Executions queued behind this go to the gateway's copy of the state
+        if (disconnect_callback_) {
+            disconnect_callback_(connection_id_, target_comp_id_, holds_state_ ? &state_ : nullptr);
+        }
+        holds_state_ = false;
+    });
+}
+
+void FixSession::start_read() {
+    if (!connected_.load() || closing_) {
+        return;
+    }
+
+    // Move a partial message to the front when the tail runs short
+    if (read_begin_ > 0 && read_buffer_.size() - read_end_ < 4096) {
+        std::memmove(read_buffer_.data(), read_buffer_.data() + read_begin_, read_end_ - read_begin_);
+        read_end_ -= read_begin_;
+        read_begin_ = 0;
+    }
+
+    if (read_end_ == read_buffer_.size()) {
+        std::cerr << "FIX message exceeds receive buffer, session " << connection_id_ << std::endl;
+        stop();
+        return;
+    }
+
+    socket_.async_read_some(
+        boost::asio::buffer(read_buffer_.data() + read_end_, read_buffer_.size() - read_end_),
+        boost::asio::bind_executor(strand_,
+            [this, self = shared_from_this()](const boost::system::error_code& error, size_t bytes_transferred) {
+                handle_read(error, bytes_transferred);
+            }));
+}
+
+void FixSession::handle_read(const boost::system::error_code& error, size_t bytes_transferred) {
+    if (error || !connected_.load()) {
+        stop();
+        return;
+    }
+
+    read_end_ += bytes_transferred;
+    last_received_ = std::chrono::steady_clock::now();
+
+    // Parse every complete message in place; a partial one stays for the next read
+    while (connected_.load() && !closing_ && read_begin_ < read_end_) {
+        const char* data = read_buffer_.data() + read_begin_;
+        int64_t length = FixMessageView::frame(data, read_end_ - read_begin_);
+        if (length == 0) {
+            break;
+        }
+        if (length < 0) {
+            std::cerr << "Malformed FIX message framing, session " << connection_id_ << std::endl;
+            stop();
+            return;
+        }
+
+        read_begin_ += static_cast<size_t>(length);
+        if (!message_.parse(data, static_cast<size_t>(length))) {
+            // Garbled messages (bad checksum, bad tag) are dropped without consuming a sequence number
+            std::cerr << "Dropping garbled FIX message, session " << connection_id_ << std::endl;
+            continue;
+        }
+        handle_message();
+    }
+
+    if (read_begin_ == read_end_) {
+        read_begin_ = 0;
+        read_end_ = 0;
+    }
+
+    // Responses to the whole batch go out in one write
+    flush();
+    start_read();
+}
+
+void FixSession::flush() {
+    if (write_in_progress_ || outbound_.empty() || !connected_.load()) {
+        return;
+    }
+
+    writing_.swap(outbound_);
+    outbound_.clear();
+    write_in_progress_ = true;
+    last_sent_ = std::chrono::steady_clock::now();
+
+    boost::asio::async_write(socket_, boost::asio::buffer(writing_),
+        boost::asio::bind_executor(strand_,
+            [this, self = shared_from_this()](const boost::system::error_code& error, size_t) {
+                handle_write(error);
+            }));
+}
+
+void FixSession::handle_write(const boost::system::error_code& error) {
+    write_in_progress_ = false;
+    if (error) {
+        if (error != boost::asio::error::operation_aborted) {
+            std::cerr << "FIX write error: " << error.message() << std::endl;
+        }
+        stop();
+        return;
+    }
+
+    writing_.clear();
+    if (closing_ && outbound_.empty()) {
+        stop();
+        return;
+    }
+    flush();
+}
+
+void FixSession::schedule_heartbeat() {
+    heartbeat_timer_.expires_after(std::chrono::seconds(1));
+    heartbeat_timer_.async_wait(
+        [this, self = shared_from_this()](const boost::system::error_code& error) {
+            if (error || !connected_.load()) {
+                return;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (!logged_on_) {
+                if (now - connected_at_ > heartbeat_interval_) {
+                    std::cerr << "No FIX Logon received, session " << connection_id_ << std::endl;
+                    stop();
+                    return;
+                }
+            } else if (!closing_) {
+                if (now - last_received_ > heartbeat_interval_ * 2) {
+                    std::cerr << "FIX heartbeat timeout, session " << connection_id_ << std::endl;
+                    disconnect("Heartbeat timeout");
+                } else if (now - last_sent_ >= heartbeat_interval_) {
+                    send_heartbeat({});
+                    flush();
+                }
+            }
+            schedule_heartbeat();
+        });
+}
+
+void FixSession::handle_message() {
+    std::string_view type = message_.msg_type();
+
+    // SequenceReset in reset mode ignores MsgSeqNum
+    if (type == "4" && logged_on_ && message_.get_char(123) != 'Y') {
+        handle_sequence_reset();
+        return;
+    }
+
+    int64_t seq_num = 0;
+    if (!message_.get_int(34, seq_num) || seq_num <= 0) {
+        std::cerr << "FIX message without MsgSeqNum, session " << connection_id_ << std::endl;
+        if (logged_on_) {
+            disconnect("MsgSeqNum missing");
+        } else {
+            stop();
+        }
+        return;
+    }
+
+    if (!logged_on_) {
+        if (type != "A") {
+            std::cerr << "First FIX message must be Logon, session " << connection_id_ << std::endl;
+            stop();
+            return;
+        }
+        handle_logon();
+        return;
+    }
+
+    uint64_t seq = static_cast<uint64_t>(seq_num);
+    if (seq < next_inbound_seq_) {
+        if (message_.get_char(43) == 'Y') {
+            return;  // Possible duplicate already processed
+        }
+        std::cerr << "FIX MsgSeqNum too low (" << seq << ", expected " << next_inbound_seq_
+                  << "), session " << connection_id_ << std::endl;
+        disconnect("MsgSeqNum too low");
+        return;
+    }
+    if (seq > next_inbound_seq_) {
+        // No resend support: log the gap and continue from the new sequence number
+        std::cerr << "FIX sequence gap (" << next_inbound_seq_ << " to " << seq
+                  << "), session " << connection_id_ << std::endl;
+    }
+    next_inbound_seq_ = seq + 1;
+
+    if (type.size() != 1) {
+        send_reject(seq, type, "Unsupported MsgType");
+        return;
+    }
+
+    switch (type[0]) {
+        case 'D':
+            handle_new_order_single();
+            break;
+        case 'F':
+            handle_cancel_request();
+            break;
+        case 'G':
+            handle_cancel_replace_request();
+            break;
+        case '0':
+            break;
+        case '1':
+            send_heartbeat(message_.get(112));
+            break;
+        case '2':
+            send_sequence_reset();
+            break;
+        case '3':
+            std::cerr << "FIX session reject received: " << message_.get(58) << std::endl;
+            break;
+        case '4':
+            handle_sequence_reset();
+            break;
+        case '5':
+            disconnect({});
+            break;
+        case 'A':
+            std::cerr << "Duplicate FIX Logon ignored, session " << connection_id_ << std::endl;
+            break;
+        default:
+            send_reject(seq, type, "Unsupported MsgType");
+            break;
+    }
+}
+
+void FixSession::handle_logon() {
+    std::string_view sender = message_.get(49);
+    std::string_view target = message_.get(56);
+    if (sender.empty() || target != config_.sender_comp_id) {
+        std::cerr << "FIX Logon with unexpected CompIDs, session " << connection_id_ << std::endl;
+        stop();
+        return;
+    }
+
+    // One connection per counterparty; it takes back the orders of earlier connections
+    if (!logon_callback_ || !logon_callback_(std::string(sender), shared_from_this(), state_)) {
+        std::cerr << "FIX Logon for " << sender << " refused, already logged on, session "
+                  << connection_id_ << std::endl;
+        stop();
+        return;
+    }
+    holds_state_ = true;
+
+    target_comp_id_.assign(sender);
+    header_fields_ = FixMessageWriter::Segment::make(
+        "49=" + config_.sender_comp_id + FIX_SOH + "56=" + target_comp_id_ + FIX_SOH);
+
+    int64_t heartbeat_interval = 0;
+    if (!message_.get_int(108, heartbeat_interval) || heartbeat_interval <= 0) {
+        std::cerr << "FIX Logon without a valid HeartBtInt, session " << connection_id_ << std::endl;
+        disconnect("Invalid HeartBtInt");
+        return;
+    }
+    heartbeat_interval_ = std::chrono::seconds(
+        std::min<int64_t>(heartbeat_interval, config_.max_heartbeat_interval));
+
+    if (message_.get_char(141) == 'Y') {
+        next_outbound_seq_ = 1;
+    }
+
+    int64_t seq_num = 0;
+    message_.get_int(34, seq_num);
+    next_inbound_seq_ = static_cast<uint64_t>(seq_num) + 1;
+    logged_on_ = true;
+
+    send_logon();
+    std::cout << "FIX session logged on: " << target_comp_id_ << " (ID: " << state_.client_id << ")" << std::endl;
+}
+
+void FixSession::handle_new_order_single() {
+    std::string_view cl_ord_id = message_.get(11);
+    char ord_type = message_.get_char(40);
+
+    OrderReference order;
+    order.symbol.assign(message_.get(55));
+    order.side = message_.get_char(54);
+    int64_t quantity = 0;
+    bool has_quantity = message_.get_int(38, quantity) && quantity > 0;
+    if (has_quantity) {
+        order.quantity = static_cast<uint64_t>(quantity);
+    }
+    message_.get_double(44, order.price);
+    double stop_price = 0.0;
+    message_.get_double(99, stop_price);
+
+    std::string_view reason;
+    OrderType type = OrderType::LIMIT;
+    switch (ord_type) {
+        case '1': type = OrderType::MARKET; break;
+        case '2': type = OrderType::LIMIT; break;
+        case '3': type = OrderType::STOP; break;
+        case '4': type = OrderType::STOP_LIMIT; break;
+        default: reason = "Unsupported OrdType"; break;
+    }
+
+    if (cl_ord_id.empty()) reason = "Missing ClOrdID";
+    else if (order.symbol.empty()) reason = "Missing Symbol";
+    else if (order.side != '1' && order.side != '2') reason = "Unsupported Side";
+    else if (!has_quantity) reason = "Invalid OrderQty";
+    else if ((ord_type == '2' || ord_type == '4') && order.price <= 0.0) reason = "Invalid Price";
+    else if ((ord_type == '3' || ord_type == '4') && stop_price <= 0.0) reason = "Invalid StopPx";
+    else if (state_.orders.count(std::string(cl_ord_id))) reason = "Duplicate ClOrdID";
+
+    if (!reason.empty()) {
+        send_execution_report(order, cl_ord_id, {}, '8', '8', reason);
+        return;
+    }
+
+    auto engine_order = make_order();
+    engine_order->order_id = next_order_id();
+    engine_order->client_id = state_.client_id;
+    engine_order->symbol = order.symbol;
+    engine_order->side = (order.side == '1') ? OrderSide::BUY : OrderSide::SELL;
+    engine_order->type = type;
+    engine_order->quantity = order.quantity;
+    engine_order->price = order.price;
+    engine_order->stop_price = stop_price;
+    engine_order->timestamp = std::chrono::high_resolution_clock::now();
+
+    if (!handlers_->submit || !handlers_->submit(engine_order)) {
+        send_execution_report(order, cl_ord_id, {}, '8', '8', "Order rejected by engine");
+        return;
+    }
+
+    order.order_id = engine_order->order_id;
+    auto [it, inserted] = state_.orders.emplace(std::string(cl_ord_id), std::move(order));
+    state_.cl_ord_ids[it->second.order_id] = it->first;
+    send_execution_report(it->second, cl_ord_id, {}, '0', '0', {});
+}
+
+void FixSession::handle_cancel_request() {
+    std::string_view cl_ord_id = message_.get(11);
+    std::string_view orig_cl_ord_id = message_.get(41);
+
+    auto it = state_.orders.find(std::string(orig_cl_ord_id));
+    if (cl_ord_id.empty() || it == state_.orders.end()) {
+        send_cancel_reject(cl_ord_id, orig_cl_ord_id, nullptr, '1', "Unknown order");
+        return;
+    }
+
+    if (!it->second.cancel_cl_ord_id.empty()) {
+        send_cancel_reject(cl_ord_id, orig_cl_ord_id, &it->second, '1', "Cancel pending");
+        return;
+    }
+
+    if (!handlers_->cancel || !handlers_->cancel(it->second.order_id, it->second.symbol)) {
+        send_cancel_reject(cl_ord_id, orig_cl_ord_id, &it->second, '1', "Order not open");
+        return;
+    }
+
+    // Confirmed when the book's cancel reaches this strand, behind any fill it reported before
+    it->second.cancel_cl_ord_id.assign(cl_ord_id);
+}
+
+void FixSession::handle_cancel_replace_request() {
+    std::string_view cl_ord_id = message_.get(11);
+    std::string_view orig_cl_ord_id = message_.get(41);
+
+    auto it = state_.orders.find(std::string(orig_cl_ord_id));
+    if (cl_ord_id.empty() || it == state_.orders.end()) {
+        send_cancel_reject(cl_ord_id, orig_cl_ord_id, nullptr, '2', "Unknown order");
+        return;
+    }
+
+    int64_t quantity = 0;
+    double price = 0.0;
+    if (!message_.get_int(38, quantity) || quantity <= 0 || !message_.get_double(44, price) || price <= 0.0) {
+        send_cancel_reject(cl_ord_id, orig_cl_ord_id, &it->second, '2', "Invalid OrderQty or Price");
+        return;
+    }
+
+    if (state_.orders.count(std::string(cl_ord_id))) {
+        send_cancel_reject(cl_ord_id, orig_cl_ord_id, &it->second, '2', "Duplicate ClOrdID");
+        return;
+    }
+
+    if (!it->second.cancel_cl_ord_id.empty()) {
+        send_cancel_reject(cl_ord_id, orig_cl_ord_id, &it->second, '2', "Cancel pending");
+        return;
+    }
+
+    if (!handlers_->modify ||
+        !handlers_->modify(it->second.order_id, it->second.symbol, static_cast<uint64_t>(quantity), price)) {
+        send_cancel_reject(cl_ord_id, orig_cl_ord_id, &it->second, '2', "Order not open");
+        return;
+    }
+
+    // Later requests reference the order by its new ClOrdID
+    OrderReference order = std::move(it->second);
+    state_.orders.erase(it);
+    order.quantity = static_cast<uint64_t>(quantity);
+    order.price = price;
+    auto [replaced, inserted] = state_.orders.emplace(std::string(cl_ord_id), std::move(order));
+    state_.cl_ord_ids[replaced->second.order_id] = replaced->first;
+    send_execution_report(replaced->second, cl_ord_id, orig_cl_ord_id, '5',
+                          replaced->second.cum_quantity > 0 ? '1' : '0', {});
+}
+
+void FixSession::handle_sequence_reset() {
+    int64_t new_seq_num = 0;
+    if (!message_.get_int(36, new_seq_num) || new_seq_num <= 0) {
+        return;
+    }
+    if (static_cast<uint64_t>(new_seq_num) < next_inbound_seq_) {
+        std::cerr << "FIX SequenceReset would lower MsgSeqNum, session " << connection_id_ << std::endl;
+        return;
+    }
+    next_inbound_seq_ = static_cast<uint64_t>(new_seq_num);
+}
+
+void FixSession::post_execution(const FixExecution& execution) {
+    boost::asio::post(strand_, [this, self = shared_from_this(), execution]() {
+        if (!holds_state_) {
+            if (execution_fallback_) {
+                execution_fallback_(state_.client_id, execution);
+            }
+            return;
+        }
+        handle_execution(execution);
+        if (connected_.load()) {
+            flush();
+        }
+    });
+}
+
+void FixSession::handle_execution(const FixExecution& execution) {
+    auto it = state_.apply(execution);
+    if (it == state_.orders.end()) {
+        return;
+    }
+
+    OrderReference& order = it->second;
+    if (execution.last_quantity > 0) {
+        send_execution_report(order, it->first, {}, 'F', execution.status == OrderStatus::FILLED ? '2' : '1', {},
+                              execution.last_quantity, execution.last_price);
+    } else if (execution.status == OrderStatus::CANCELLED) {
+        if (order.cancel_cl_ord_id.empty()) {
+            send_execution_report(order, it->first, {}, '4', '4', {});     // Not requested by this session
+        } else {
+            send_execution_report(order, order.cancel_cl_ord_id, it->first, '4', '4', {});
+        }
+    } else if (execution.status == OrderStatus::REJECTED) {
+        send_execution_report(order, it->first, {}, '8', '8', "Order rejected by engine");
+    }
+    state_.finish(it, execution);
+}
+
+void FixSession::disconnect(std::string_view text) {
+    send_logout(text);
+    closing_ = true;
+    flush();
+}
+
+std::string_view FixSession::sending_time() {
+    // UTCTimestamp "YYYYMMDD-HH:MM:SS.sss"; the seconds part is formatted once per second
+    auto now = std::chrono::system_clock::now();
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    std::time_t seconds = static_cast<std::time_t>(millis / 1000);
+
+    if (seconds != cached_second_) {
+        std::tm utc{};
+        gmtime_r(&seconds, &utc);
+        sending_time_length_ = std::strftime(sending_time_.data(), sending_time_.size(), "%Y%m%d-%H:%M:%S", &utc);
+        cached_second_ = seconds;
+    }
+
+    unsigned fraction = static_cast<unsigned>(millis % 1000);
+    char* out = sending_time_.data() + sending_time_length_;
+    out[0] = '.';
+    out[1] = static_cast<char>('0' + fraction / 100);
+    out[2] = static_cast<char>('0' + (fraction / 10) % 10);
+    out[3] = static_cast<char>('0' + fraction % 10);
+    return std::string_view(sending_time_.data(), sending_time_length_ + 4);
+}
+
+void FixSession::begin_message(std::string_view msg_type) {
+    writer_.begin(msg_type, header_fields_, next_outbound_seq_, sending_time());
+}
+
+void FixSession::send_current() {
+    std::string_view message = writer_.finish();
+    if (message.empty()) {
+        std::cerr << "FIX message too large to encode, session " << connection_id_ << std::endl;
+        return;
+    }
+
+    if (outbound_.size() + message.size() > MAX_OUTBOUND_BYTES) {
+        std::cerr << "FIX session " << connection_id_ << " is not draining its socket, disconnecting" << std::endl;
+        stop();
+        return;
+    }
+
+    outbound_.append(message);
+    ++next_outbound_seq_;
+}
+
+void FixSession::send_logon() {
+    begin_message("A");
+    writer_.add(98, '0');
+    writer_.add(108, static_cast<uint64_t>(heartbeat_interval_.count()));
+    send_current();
+}
+
+void FixSession::send_heartbeat(std::string_view test_req_id) {
+    begin_message("0");
+    if (!test_req_id.empty()) {
+        writer_.add(112, test_req_id);
+    }
+    send_current();
+}
+
+void FixSession::send_logout(std::string_view text) {
+    begin_message("5");
+    if (!text.empty()) {
+        writer_.add(58, text);
+    }
+    send_current();
+}
+
+void FixSession::send_reject(uint64_t ref_seq_num, std::string_view ref_msg_type, std::string_view text) {
+    begin_message("3");
+    writer_.add(45, ref_seq_num);
+    writer_.add(372, ref_msg_type);
+    writer_.add(373, static_cast<uint64_t>(11));  // Invalid MsgType
+    writer_.add(58, text);
+    send_current();
+}
+
+void FixSession::send_sequence_reset() {
+    // Nothing is journaled, so answer a ResendRequest by resetting past the gap
+    begin_message("4");
+    writer_.add(123, 'N');
+    writer_.add(36, next_outbound_seq_ + 1);
+    send_current();
+}
+
+void FixSession::send_execution_report(const OrderReference& order, std::string_view cl_ord_id,
+                                       std::string_view orig_cl_ord_id, char exec_type, char ord_status,
+                                       std::string_view text, uint64_t last_quantity, double last_price) {
+    begin_message("8");
+    if (order.order_id != 0) {
+        writer_.add(37, order.order_id);
+    } else {
+        writer_.add(37, std::string_view("NONE"));
+    }
+    writer_.add(11, cl_ord_id);
+    if (!orig_cl_ord_id.empty()) {
+        writer_.add(41, orig_cl_ord_id);
+    }
+    writer_.add(17, (state_.client_id << 32) | ++state_.next_exec_id);
+    writer_.add(150, exec_type);
+    writer_.add(39, ord_status);
+    writer_.add(55, std::string_view(order.symbol));
+    if (order.side != 0) {
+        writer_.add(54, order.side);
+    }
+    writer_.add(38, order.quantity);
+    if (order.price > 0.0) {
+        writer_.add(44, order.price);
+    }
+    if (last_quantity > 0) {
+        writer_.add(32, last_quantity);
+        writer_.add(31, last_price);
+    }
+    bool open = ord_status == '0' || ord_status == '1';
+    writer_.add(151, open && order.quantity > order.cum_quantity ? order.quantity - order.cum_quantity : uint64_t{0});
+    writer_.add(14, order.cum_quantity);
+    writer_.add(6, order.cum_quantity > 0 ? order.notional / static_cast<double>(order.cum_quantity) : 0.0);
+    writer_.add(60, sending_time());
+    if (!text.empty()) {
+        writer_.add(58, text);
+    }
+    send_current();
+}
+
+void FixSession::send_cancel_reject(std::string_view cl_ord_id, std::string_view orig_cl_ord_id,
+                                    const OrderReference* order, char response_to, std::string_view text) {
+    begin_message("9");
+    if (order) {
+        writer_.add(37, order->order_id);
+    } else {
+        writer_.add(37, std::string_view("NONE"));
+    }
+    writer_.add(11, cl_ord_id);
+    writer_.add(41, orig_cl_ord_id);
+    writer_.add(39, order ? (order->cum_quantity > 0 ? '1' : '0') : '8');
+    writer_.add(434, response_to);
+    writer_.add(102, order ? '0' : '1');  // Too late to cancel / Unknown order
+    writer_.add(58, text);
+    send_current();
+}
+
+// FixGateway implementation
+FixGateway::FixGateway(const FixGatewayConfig& config)
+    : config_(config), acceptor_(io_context_), handlers_(std::make_shared<FixOrderHandlers>()) {
+}
+
+FixGateway::~FixGateway() {
+    stop();
+}
+
+bool FixGateway::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    try {
+        boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::tcp::v4(), config_.port);
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+        acceptor_.bind(endpoint);
+        acceptor_.listen();
+
+        io_context_.restart();
+        start_accept();
+
+        for (size_t i = 0; i < std::max<size_t>(config_.num_threads, 1); ++i) {
+            worker_threads_.emplace_back(&FixGateway::worker_thread_function, this);
+        }
+
+        running_.store(true);
+        std::cout << "FIX gateway started on port " << acceptor_.local_endpoint().port()
+                  << " as " << config_.sender_comp_id << std::endl;
+        return true;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to start FIX gateway: " << e.what() << std::endl;
+        boost::system::error_code ec;
+        acceptor_.close(ec);
+        return false;
+    }
+}
+
+void FixGateway::stop() {
+    if (!running_.load()) {
+        return;
+    }
+
+    std::cout << "Stopping FIX gateway..." << std::endl;
+
+    running_.store(false);
+
+    boost::system::error_code ec;
+    acceptor_.close(ec);
+
+    std::unordered_map<uint64_t, std::shared_ptr<FixSession>> sessions;
+    {
+        std::unique_lock<std::shared_mutex> lock(sessions_mutex_);
+        sessions.swap(sessions_);
+    }
+    for (auto& [id, session] : sessions) {
+        session->stop();
+    }
+
+    io_context_.stop();
+
+    for (auto& thread : worker_threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    worker_threads_.clear();
+
+    std::cout << "FIX gateway stopped" << std::endl;
+}
+
+bool FixGateway::is_running() const {
+    return running_.load();
+}
+
+size_t FixGateway::get_session_count() const {
+    std::shared_lock<std::shared_mutex> lock(sessions_mutex_);
+    return sessions_.size();
+}
+
+void FixGateway::set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback) {
+    handlers_->submit = callback;
+}
+
+void FixGateway::set_order_cancel_callback(std::function<bool(uint64_t, const std::string&)> callback) {
+    handlers_->cancel = callback;
+}
+
+void FixGateway::set_order_modify_callback(std::function<bool(uint64_t, const std::string&, uint64_t, double)> callback) {
+    handlers_->modify = callback;
+}
+
+void FixGateway::on_execution(const Order& order, uint64_t fill_quantity, double fill_price) {
+    uint64_t client_id = order.client_id;
+    if (!running_.load(std::memory_order_relaxed) || client_id < FIX_CLIENT_ID_BASE ||
+        client_id >= 2 * FIX_CLIENT_ID_BASE) {
+        return;
+    }
+
+    // New orders and amends are acknowledged by the session when it submits them
+    bool terminal = order.status == OrderStatus::CANCELLED || order.status == OrderStatus::REJECTED;
+    if (fill_quantity == 0 && !terminal) {
+        return;
+    }
+
+    FixExecution execution;
+    execution.order_id = order.order_id;
+    execution.last_quantity = fill_quantity;
+    execution.last_price = fill_price;
+    execution.quantity = order.quantity;
+    execution.filled_quantity = order.filled_quantity;
+    execution.status = order.status;
+    route_execution(client_id, execution);
+}
+
+void FixGateway::route_execution(uint64_t client_id, const FixExecution& execution) {
+    std::shared_ptr<FixSession> session;
+    {
+        std::shared_lock<std::shared_mutex> lock(sessions_mutex_);
+        auto it = counterparties_.find(client_id);
+        if (it == counterparties_.end()) {
+            return;
+        }
+        session = it->second.session;
+    }
+    if (session) {
+        session->post_execution(execution);
+        return;
+    }
+
+    // No session is logged on: keep the parked orders current, the report itself is lost
+    std::unique_lock<std::shared_mutex> lock(sessions_mutex_);
+    auto it = counterparties_.find(client_id);
+    if (it == counterparties_.end()) {
+        return;
+    }
+    if (it->second.session) {
+        // Logged on again in between
+        it->second.session->post_execution(execution);
+        return;
+    }
+    FixCounterpartyState& state = it->second.state;
+    auto order = state.apply(execution);
+    if (order != state.orders.end()) {
+        state.finish(order, execution);
+    }
+}
+
+bool FixGateway::claim_counterparty(const std::string& comp_id, const std::shared_ptr<FixSession>& session,
+                                    FixCounterpartyState& state) {
+    std::unique_lock<std::shared_mutex> lock(sessions_mutex_);
+    auto [id, inserted] = client_ids_.emplace(comp_id, 0);
+    if (inserted) {
+        id->second = next_client_id_++;
+        counterparties_[id->second].state.client_id = id->second;
+    }
+
+    Counterparty& counterparty = counterparties_[id->second];
+    if (counterparty.session) {
+        return false;
+    }
+    counterparty.session = session;
+    state = std::move(counterparty.state);
+    counterparty.state = FixCounterpartyState{};
+    return true;
+}
+
+void FixGateway::start_accept() {
+    acceptor_.async_accept(
+        [this](const boost::system::error_code& error, boost::asio::ip::tcp::socket socket) {
+            if (!error) {
+                boost::system::error_code ec;
+                socket.set_option(boost::asio::ip::tcp::no_delay(true), ec);
+
+                std::shared_ptr<FixSession> session;
+                {
+                    std::unique_lock<std::shared_mutex> lock(sessions_mutex_);
+                    uint64_t connection_id = next_connection_id_++;
+                    session = std::make_shared<FixSession>(std::move(socket), connection_id, config_, handlers_);
+                    sessions_[connection_id] = session;
+                }
+                session->set_logon_callback([this](const std::string& comp_id, const std::shared_ptr<FixSession>& owner,
+                                                   FixCounterpartyState& state) {
+                    return claim_counterparty(comp_id, owner, state);
+                });
+                session->set_disconnect_callback([this](uint64_t id, const std::string& comp_id,
+                                                        FixCounterpartyState* state) {
+                    remove_session(id, comp_id, state);
+                });
+                session->set_execution_fallback([this](uint64_t client_id, const FixExecution& execution) {
+                    route_execution(client_id, execution);
+                });
+                session->start();
+            } else if (running_.load()) {
+                std::cerr << "FIX accept error: " << error.message() << std::endl;
+            }
+
+            if (running_.load()) {
+                start_accept();
+            }
+        });
+}
+
+void FixGateway::remove_session(uint64_t connection_id, const std::string& comp_id, FixCounterpartyState* state) {
+    std::unique_lock<std::shared_mutex> lock(sessions_mutex_);
+    sessions_.erase(connection_id);
+    if (!state) {
+        return;
+    }
+
+    // Park the counterparty's orders until it logs on again
+    auto id = client_ids_.find(comp_id);
+    if (id == client_ids_.end()) {
+        return;
+    }
+    Counterparty& counterparty = counterparties_[id->second];
+    counterparty.state = std::move(*state);
+    counterparty.session.reset();
+}
+
+void FixGateway::worker_thread_function() {
+    set_current_thread_name("fix_worker");
+    try {
+        io_context_.run();
+    } catch (const std::exception& e) {
+        std::cerr << "FIX worker thread error: " << e.what() << std::endl;
+    }
+}
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,255 @@
+#include "flight_recorder.h"
+#include "thread_name.h"
+#include "tsc_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+thread_local FlightRing* thread_ring = nullptr;
+
+size_t round_up_power_of_two(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+const char* flight_event_type_name(FlightEventType type) {
+    switch (type) {
+        case FlightEventType::ORDER_IN: return "ORDER_IN";
+        case FlightEventType::ORDER_DONE: return "ORDER_DONE";
+        case FlightEventType::TRADE: return "TRADE";
+        case FlightEventType::CANCEL: return "CANCEL";
+        case FlightEventType::BATCH: return "BATCH";
+        case FlightEventType::TRIGGER: return "TRIGGER";
+    }
+    return "UNKNOWN";
+}
+
+FlightRing* current_flight_ring() {
+    return thread_ring;
+}
+
+// FlightRing implementation
+FlightRing::FlightRing(FlightRecorder* recorder, const std::string& name, size_t capacity)
+    : recorder_(recorder), name_(name),
+      events_(round_up_power_of_two(std::max<size_t>(capacity, 16))),
+      mask_(events_.size() - 1),
+      threshold_ns_(static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(recorder->config_.threshold).count())),
+      min_dump_interval_ticks_(static_cast<uint64_t>(
+          static_cast<unsigned __int128>(TscClock::ticks_per_second()) *
+          static_cast<uint64_t>(recorder->config_.min_dump_interval.count()) / 1000)),
+      events_after_trigger_(std::min(recorder->config_.events_after_trigger, events_.size() / 2)) {
+}
+
+void FlightRing::record(FlightEventType type, uint64_t order_id, uint64_t value, uint32_t aux) {
+    FlightEvent& event = events_[head_ & mask_];
+    event.tsc = TscClock::now();
+    event.order_id = order_id;
+    event.value = value;
+    event.aux = aux;
+    event.type = type;
+    ++head_;
+
+    if (triggered_ && --remaining_after_trigger_ == 0) {
+        freeze();
+    }
+}
+
+void FlightRing::order_done(uint64_t order_id, uint64_t latency_ns, bool accepted) {
+    record(FlightEventType::ORDER_DONE, order_id, latency_ns, accepted ? 1 : 0);
+    if (latency_ns < threshold_ns_) {
+        return;
+    }
+
+    recorder_->triggers_.fetch_add(1, std::memory_order_relaxed);
+    if (triggered_) {
+        return;     // Already inside the window of an earlier spike
+    }
+    uint64_t now = TscClock::now();
+    if (last_dump_tsc_ != 0 && now - last_dump_tsc_ < min_dump_interval_ticks_) {
+        recorder_->dumps_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    trigger_tsc_ = now;
+    trigger_latency_ns_ = latency_ns;
+    trigger_wall_clock_ns_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    record(FlightEventType::TRIGGER, order_id, latency_ns, 0);
+    if (events_after_trigger_ == 0) {
+        freeze();
+    } else {
+        triggered_ = true;
+        remaining_after_trigger_ = events_after_trigger_;
+    }
+}
+
+void FlightRing::flush() {
+    if (triggered_) {
+        freeze();
+    }
+}
+
+void FlightRing::freeze() {
+    triggered_ = false;
+    last_dump_tsc_ = trigger_tsc_;
+
+    FlightRecorder::Dump dump;
+    uint64_t count = std::min<uint64_t>(head_, events_.size());
+    dump.events.reserve(count);
+    for (uint64_t i = head_ - count; i < head_; ++i) {
+        dump.events.push_back(events_[i & mask_]);
+    }
+
+    FlightDumpHeader& header = dump.header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "UFR1", 4);
+    header.event_count = static_cast<uint32_t>(count);
+    header.ticks_per_second = TscClock::ticks_per_second();
+    header.trigger_tsc = trigger_tsc_;
+    header.trigger_latency_ns = trigger_latency_ns_;
+    header.threshold_ns = threshold_ns_;
+    header.wall_clock_ns = trigger_wall_clock_ns_;
+    std::strncpy(header.thread_name, name_.c_str(), sizeof(header.thread_name) - 1);
+
+    recorder_->submit(std::move(dump));
+}
+
+// FlightRecorder implementation
+FlightRecorder::FlightRecorder(const FlightRecorderConfig& config) : config_(config) {
+}
+
+FlightRecorder::~FlightRecorder() {
+    stop();
+}
+
+bool FlightRecorder::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(config_.directory, ec);
+    if (ec) {
+        std::cerr << "Failed to create flight recorder directory " << config_.directory
+                  << ": " << ec.message() << std::endl;
+        return false;
+    }
+
+    TscClock::ticks_per_second();  // Calibrate before the first event needs it
+    running_.store(true);
+    writer_thread_ = std::thread(&FlightRecorder::writer_thread_worker, this);
+    return true;
+}
+
+void FlightRecorder::stop() {
+    if (!running_.load()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_.store(false);
+    }
+    cv_.notify_all();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+}
+
+FlightRing* FlightRecorder::register_thread(const std::string& name) {
+    if (!running_.load()) {
+        return nullptr;
+    }
+    auto ring = std::make_unique<FlightRing>(this, name, config_.events_per_thread);
+    thread_ring = ring.get();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings_.push_back(std::move(ring));
+    return thread_ring;
+}
+
+void FlightRecorder::unregister_thread() {
+    if (thread_ring) {
+        thread_ring->flush();
+        thread_ring = nullptr;
+    }
+}
+
+FlightRecorderStats FlightRecorder::get_stats() const {
+    FlightRecorderStats stats;
+    stats.triggers = triggers_.load(std::memory_order_relaxed);
+    stats.dumps_written = dumps_written_.load(std::memory_order_relaxed);
+    stats.dumps_dropped = dumps_dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FlightRecorder::submit(Dump&& dump) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.size() >= config_.max_pending_dumps) {
+            dumps_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pending_.push_back(std::move(dump));
+    }
+    cv_.notify_one();
+}
+
+void FlightRecorder::writer_thread_worker() {
+    set_current_thread_name("flight_writer");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return !pending_.empty() || !running_.load(); });
+        if (pending_.empty()) {
+            break;  // Stopped with nothing left to write
+        }
+        Dump dump = std::move(pending_.front());
+        pending_.pop_front();
+        uint64_t sequence = next_dump_sequence_++;
+
+        lock.unlock();
+        if (write_dump(dump, sequence)) {
+            dumps_written_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            dumps_dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        lock.lock();
+    }
+}
+
+bool FlightRecorder::write_dump(const Dump& dump, uint64_t sequence) {
+    std::string path = config_.directory + "/flight_" + std::to_string(::getpid()) + "_" +
+                       std::to_string(sequence) + "_" + dump.header.thread_name + ".bin";
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open flight recorder dump " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    bool ok = std::fwrite(&dump.header, sizeof(dump.header), 1, file) == 1 &&
+              std::fwrite(dump.events.data(), sizeof(FlightEvent), dump.events.size(), file) == dump.events.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write flight recorder dump " << path << std::endl;
+        return false;
+    }
+
+    std::cerr << "Latency spike of " << dump.header.trigger_latency_ns / 1000 << " us on "
+              << dump.header.thread_name << ", flight recorder dump " << path << std::endl;
+    return true;
+}
+
+} // namespace UltraFastAnalysis
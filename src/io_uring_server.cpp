@@ -0,0 +1,1056 @@
+#include "io_uring_server.h"
+#include "thread_name.h"
+#include <linux/io_uring.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+// Completion tags: operation in the top byte, slot generation, then slot
+enum : uint8_t {
+    OP_ACCEPT = 1,
+    OP_RECV = 2,
+    OP_SEND = 3,
+    OP_WAKE = 4,
+    OP_CANCEL = 5,
+    OP_PROVIDE = 6,
+    OP_TICK = 7
+};
+
+constexpr uint16_t RECV_BUFFER_GROUP = 0;
+
+// Server whose event loop runs on this thread
+thread_local const IoUringServer* current_event_loop = nullptr;
+
+uint64_t make_user_data(uint8_t op, uint32_t generation, uint32_t slot) {
+    return (static_cast<uint64_t>(op) << 56) | (static_cast<uint64_t>(generation & 0xFFFFFF) << 32) | slot;
+}
+
+uint8_t user_data_op(uint64_t user_data) { return static_cast<uint8_t>(user_data >> 56); }
+uint32_t user_data_generation(uint64_t user_data) { return static_cast<uint32_t>(user_data >> 32) & 0xFFFFFF; }
+uint32_t user_data_slot(uint64_t user_data) { return static_cast<uint32_t>(user_data); }
+
+// liburing is not required; the three io_uring syscalls are called directly
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// Copy bytes [offset, offset + max) of a queued message's wire form (header, then body)
+size_t copy_message_bytes(const OutboundMessage& message, size_t offset, uint8_t* out, size_t max) {
+    size_t copied = 0;
+    if (offset < sizeof(MessageHeader)) {
+        size_t count = std::min(sizeof(MessageHeader) - offset, max);
+        std::memcpy(out, reinterpret_cast<const uint8_t*>(&message.header) + offset, count);
+        copied += count;
+        offset += count;
+    }
+
+    size_t body_offset = offset - sizeof(MessageHeader);
+    size_t body_length = message.header.message_length;
+    if (copied < max && body_offset < body_length) {
+        const uint8_t* body = message.payload
+            ? reinterpret_cast<const uint8_t*>(message.payload->data())
+            : message.inline_payload.data();
+        size_t count = std::min(body_length - body_offset, max - copied);
+        std::memcpy(out + copied, body + body_offset, count);
+        copied += count;
+    }
+    return copied;
+}
+
+} // namespace
+
+// IoUringConnection implementation
+IoUringConnection::IoUringConnection(IoUringServer& server, int fd, uint32_t slot, uint64_t connection_id,
+                                     std::shared_ptr<const InstrumentRegistry> instruments)
+    : ProtocolSession(connection_id, std::move(instruments)), server_(server), fd_(fd), slot_(slot) {
+    input_.reserve(MAX_MESSAGE_SIZE);
+}
+
+bool IoUringConnection::consume(const uint8_t* data, size_t length) {
+    bool ok = true;
+    uint64_t dispatched = get_messages_dispatched();
+
+    // Common case: whole messages straight from the provided buffer
+    if (input_.empty()) {
+        size_t used = dispatch_messages(data, length, ok);
+        if (ok && used < length) {
+            input_.assign(data + used, data + length);
+        }
+    } else {
+        input_.insert(input_.end(), data, data + length);
+        size_t used = dispatch_messages(input_.data(), input_.size(), ok);
+        input_.erase(input_.begin(), input_.begin() + used);
+    }
+
+    server_.messages_received_.fetch_add(get_messages_dispatched() - dispatched, std::memory_order_relaxed);
+    return ok;
+}
+
+bool IoUringConnection::enqueue(OutboundMessage&& message) {
+    if (!connected_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    bool schedule = false;
+    bool slow_consumer = false;
+    size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (queued_bytes_ + message.wire_size() > max_outbound_bytes_) {
+            slow_consumer = true;
+            queued = queued_bytes_;
+        } else {
+            queued_bytes_ += message.wire_size();
+            pending_.push_back(std::move(message));
+            if (!write_scheduled_) {
+                write_scheduled_ = true;
+                schedule = true;
+            }
+        }
+    }
+
+    if (slow_consumer) {
+        std::cerr << "Connection " << connection_id_ << " is not draining its socket (" << queued
+                  << " bytes queued), disconnecting slow consumer" << std::endl;
+        // The event loop closes connections it finds disconnected
+        connected_.store(false);
+        server_.schedule_write(slot_);
+        return false;
+    }
+
+    if (schedule) {
+        server_.schedule_write(slot_);
+    }
+    return true;
+}
+
+void IoUringConnection::disconnect(bool flush) {
+    // The event loop closes disconnected connections, and flushing ones once their queue is empty
+    if (flush) {
+        close_after_flush_.store(true);
+    } else {
+        connected_.store(false);
+    }
+    server_.schedule_write(slot_);
+}
+
+// IoUringServer implementation
+IoUringServer::IoUringServer(uint16_t port, const IoUringConfig& config)
+    : port_(port), config_(config),
+      instruments_(std::make_shared<InstrumentRegistry>()),
+      subscriptions_(std::make_shared<SubscriptionTable>()),
+      session_store_(std::make_shared<SessionStore>()),
+      tick_interval_(std::make_unique<__kernel_timespec>()) {
+
+    // Every connection needs a subscription slot
+    config_.max_connections = std::clamp<size_t>(config_.max_connections, 1, MAX_SUBSCRIBER_SESSIONS);
+
+    // Buffer ids are 16 bits
+    config_.recv_buffer_count = std::clamp<unsigned>(config_.recv_buffer_count, 1, 65536);
+
+    connections_.resize(config_.max_connections);
+    generations_.resize(config_.max_connections, 0);
+    free_slots_.reserve(config_.max_connections);
+    for (size_t slot = config_.max_connections; slot > 0; --slot) {
+        free_slots_.push_back(static_cast<uint32_t>(slot - 1));
+    }
+}
+
+IoUringServer::~IoUringServer() {
+    stop();
+}
+
+bool IoUringServer::is_supported() {
+    io_uring_params params{};
+    int fd = sys_io_uring_setup(2, &params);
+    if (fd < 0) {
+        return false;
+    }
+
+    // A ring alone is not enough: the event loop needs these opcodes, and
+    // multishot accept and receive. The multishot flags cannot be probed, so
+    // SEND_ZC, added in the same release (6.0) as multishot receive, stands in.
+    constexpr unsigned PROBE_OPS = IORING_OP_LAST;
+    std::vector<uint8_t> storage(sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op), 0);
+    auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+    bool probed = sys_io_uring_register(fd, IORING_REGISTER_PROBE, probe, PROBE_OPS) == 0;
+    close(fd);
+    if (!probed) {
+        return false;
+    }
+
+    for (uint8_t op : {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_READ,
+                       IORING_OP_TIMEOUT, IORING_OP_ASYNC_CANCEL,
+                       IORING_OP_PROVIDE_BUFFERS, IORING_OP_SEND_ZC}) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IoUringServer::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    if (!setup_ring() || !setup_buffers() || !setup_listener()) {
+        release_resources();
+        return false;
+    }
+
+    accept_retry_pending_ = false;
+
+    // Heartbeats for every connection run off one periodic timeout
+    auto tick = std::chrono::duration_cast<std::chrono::nanoseconds>(session_store_->config().timer_tick);
+    tick_interval_->tv_sec = tick.count() / 1000000000;
+    tick_interval_->tv_nsec = tick.count() % 1000000000;
+    session_timers_ = std::make_unique<TimerWheel>(session_store_->config().timer_tick);
+
+    arm_accept();
+    arm_wake();
+    arm_tick();
+
+    running_.store(true);
+    loop_thread_ = std::thread(&IoUringServer::event_loop, this);
+
+    std::cout << "io_uring server started on port " << port_ << std::endl;
+    return true;
+}
+
+void IoUringServer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    std::cout << "Stopping io_uring server..." << std::endl;
+
+    uint64_t value = 1;
+    if (write(wake_fd_, &value, sizeof(value)) < 0) {
+        std::cerr << "Failed to wake io_uring event loop: " << std::strerror(errno) << std::endl;
+    }
+
+    if (loop_thread_.joinable()) {
+        loop_thread_.join();
+    }
+
+    // The loop has exited; close every connection and release the ring
+    {
+        std::unique_lock<std::shared_mutex> lock(clients_mutex_);
+        for (size_t slot = 0; slot < connections_.size(); ++slot) {
+            auto& connection = connections_[slot];
+            if (!connection) {
+                continue;
+            }
+            connection->connected_.store(false);
+            connection->end_session();
+            close(connection->fd_);
+            subscriptions_->remove_session(static_cast<uint32_t>(slot));
+            connection.reset();
+            ++generations_[slot];
+            free_slots_.push_back(static_cast<uint32_t>(slot));
+        }
+        client_count_ = 0;
+    }
+
+    session_store_->flush();
+    release_resources();
+    std::cout << "io_uring server stopped" << std::endl;
+}
+
+bool IoUringServer::is_running() const {
+    return running_.load();
+}
+
+size_t IoUringServer::get_client_count() const {
+    std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+    return client_count_;
+}
+
+void IoUringServer::set_max_outbound_bytes(size_t bytes) {
+    max_outbound_bytes_ = bytes;
+}
+
+std::vector<uint64_t> IoUringServer::get_client_ids() const {
+    std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+
+    std::vector<uint64_t> ids;
+    ids.reserve(client_count_);
+    for (const auto& connection : connections_) {
+        if (connection) {
+            ids.push_back(connection->get_connection_id());
+        }
+    }
+    return ids;
+}
+
+void IoUringServer::broadcast_market_data(const MarketData& data) {
+    std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+
+    std::shared_ptr<const std::string> payload;
+    MessageHeader header;
+
+    uint8_t channel = static_cast<uint8_t>(1u << static_cast<uint8_t>(data.type));
+    subscriptions_->for_each_subscriber(data.symbol, channel, [&](uint32_t slot) {
+        const auto& connection = connections_[slot];
+        if (!connection || !connection->is_connected()) {
+            return;
+        }
+        if (!payload) {
+            payload = ProtocolSession::encode_market_data(data);
+            header = ProtocolSession::make_header(MessageType::MARKET_DATA, payload->size());
+        }
+        connection->send_encoded(header, payload);
+    });
+}
+
+void IoUringServer::broadcast_order_book_update(const OrderBookSnapshot& snapshot) {
+    std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+
+    std::shared_ptr<const std::string> payload;
+    MessageHeader header;
+
+    subscriptions_->for_each_subscriber(snapshot.symbol, CHANNEL_BOOK_SNAPSHOT, [&](uint32_t slot) {
+        const auto& connection = connections_[slot];
+        if (!connection || !connection->is_connected()) {
+            return;
+        }
+        if (!payload) {
+            payload = ProtocolSession::encode_order_book_snapshot(snapshot);
+            header = ProtocolSession::make_header(MessageType::ORDER_BOOK_REQUEST, payload->size());
+        }
+        connection->send_encoded(header, payload);
+    });
+}
+
+void IoUringServer::set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback) {
+    order_submit_callback_ = callback;
+}
+
+void IoUringServer::set_order_cancel_callback(std::function<void(uint64_t, const std::string&)> callback) {
+    order_cancel_callback_ = callback;
+}
+
+void IoUringServer::set_order_modify_callback(std::function<void(uint64_t, const std::string&, uint64_t, double)> callback) {
+    order_modify_callback_ = callback;
+}
+
+void IoUringServer::set_order_mass_cancel_callback(std::function<void(uint64_t, const std::string&, MassCancelSide)> callback) {
+    order_mass_cancel_callback_ = callback;
+}
+
+void IoUringServer::set_order_status_callback(std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> callback) {
+    order_status_callback_ = callback;
+}
+
+void IoUringServer::set_text_protocol_enabled(bool enabled) {
+    text_protocol_enabled_ = enabled;
+}
+
+void IoUringServer::set_session_config(const SessionConfig& config) {
+    session_store_ = std::make_shared<SessionStore>(config);
+}
+
+ThrottleStats IoUringServer::get_throttle_stats() const {
+    return session_store_->get_throttle_stats();
+}
+
+IoUringStats IoUringServer::get_stats() const {
+    IoUringStats stats;
+    stats.enter_calls = enter_calls_.load(std::memory_order_relaxed);
+    stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+    stats.sqes_submitted = sqes_submitted_.load(std::memory_order_relaxed);
+    stats.completions = completions_.load(std::memory_order_relaxed);
+    stats.messages_received = messages_received_.load(std::memory_order_relaxed);
+    stats.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool IoUringServer::setup_ring() {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = config_.queue_depth * 2;
+
+    ring_fd_ = sys_io_uring_setup(config_.queue_depth, &params);
+    if (ring_fd_ < 0 && errno == EINVAL) {
+        // COOP_TASKRUN needs 5.19; run without it on older kernels
+        params = io_uring_params{};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = config_.queue_depth * 2;
+        ring_fd_ = sys_io_uring_setup(config_.queue_depth, &params);
+    }
+    if (ring_fd_ < 0) {
+        std::cerr << "io_uring_setup failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        std::cerr << "Failed to map io_uring submission queue: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            std::cerr << "Failed to map io_uring completion queue: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        std::cerr << "Failed to map io_uring SQEs: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<uint8_t*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_local_tail_ = *sq_tail_;
+
+    // SQE i always sits in array slot i
+    auto* sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < sq_entries_; ++i) {
+        sq_array[i] = i;
+    }
+
+    auto* cq = static_cast<uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    wake_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        std::cerr << "Failed to create io_uring wake eventfd: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IoUringServer::setup_buffers() {
+    // Send buffers: one per connection slot. They are not registered with the ring:
+    // WRITE_FIXED cannot pass MSG_NOSIGNAL, and SIGPIPE is the host's to configure.
+    size_t send_bytes = config_.max_connections * config_.send_buffer_size;
+    void* send = mmap(nullptr, send_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (send == MAP_FAILED) {
+        std::cerr << "Failed to allocate io_uring send buffers: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    send_buffers_ = static_cast<uint8_t*>(send);
+    memory_account_allocate(MemorySubsystem::CONNECTION_BUFFERS, send_bytes);
+
+    // Receive buffers handed to the kernel with IORING_OP_PROVIDE_BUFFERS
+    size_t recv_bytes = static_cast<size_t>(config_.recv_buffer_count) * config_.recv_buffer_size;
+    void* recv = mmap(nullptr, recv_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (recv == MAP_FAILED) {
+        std::cerr << "Failed to allocate io_uring receive buffers: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    recv_buffers_ = static_cast<uint8_t*>(recv);
+    memory_account_allocate(MemorySubsystem::CONNECTION_BUFFERS, recv_bytes);
+
+    // Every buffer is handed to the kernel with the first submission
+    recycled_buffers_.reserve(config_.recv_buffer_count);
+    for (unsigned i = 0; i < config_.recv_buffer_count; ++i) {
+        recycled_buffers_.push_back(static_cast<uint16_t>(i));
+    }
+    return provide_recycled_buffers();
+}
+
+bool IoUringServer::setup_listener() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "Failed to create listening socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    int enable = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port_);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd_, SOMAXCONN) != 0) {
+        std::cerr << "Failed to listen on port " << port_ << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void IoUringServer::release_resources() {
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+    recycled_buffers_.clear();
+    if (recv_buffers_) {
+        size_t recv_bytes = static_cast<size_t>(config_.recv_buffer_count) * config_.recv_buffer_size;
+        munmap(recv_buffers_, recv_bytes);
+        memory_account_free(MemorySubsystem::CONNECTION_BUFFERS, recv_bytes);
+        recv_buffers_ = nullptr;
+    }
+    if (send_buffers_) {
+        size_t send_bytes = config_.max_connections * config_.send_buffer_size;
+        munmap(send_buffers_, send_bytes);
+        memory_account_free(MemorySubsystem::CONNECTION_BUFFERS, send_bytes);
+        send_buffers_ = nullptr;
+    }
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_ring_ && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+    if (sq_ring_) {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+    to_submit_ = 0;
+}
+
+io_uring_sqe* IoUringServer::get_sqe() {
+    // A full submission queue is flushed early rather than dropping the request
+    if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+        submit(false);
+        if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+            return nullptr;
+        }
+    }
+
+    io_uring_sqe* sqe = &sqes_[sq_local_tail_ & sq_mask_];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ++sq_local_tail_;
+    ++to_submit_;
+    return sqe;
+}
+
+bool IoUringServer::submit(bool wait) {
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+
+    // Nothing to submit and completions already waiting: no syscall needed
+    bool completions_ready = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) != *cq_head_;
+    if (to_submit_ == 0 && (!wait || completions_ready)) {
+        return true;
+    }
+
+    unsigned min_complete = (wait && !completions_ready) ? 1 : 0;
+    int result = sys_io_uring_enter(ring_fd_, to_submit_, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0);
+    enter_calls_.fetch_add(1, std::memory_order_relaxed);
+    if (result < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+            return true;
+        }
+        std::cerr << "io_uring_enter failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    sqes_submitted_.fetch_add(static_cast<uint64_t>(result), std::memory_order_relaxed);
+    to_submit_ -= std::min<unsigned>(to_submit_, static_cast<unsigned>(result));
+    return true;
+}
+
+void IoUringServer::event_loop() {
+    set_current_thread_name("io_uring");
+    current_event_loop = this;
+
+    while (running_.load(std::memory_order_relaxed)) {
+        drain_ready_slots();
+        provide_recycled_buffers();
+
+        if (!submit(true)) {
+            break;
+        }
+
+        // Reap every available completion, then release the slots in one store
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            io_uring_cqe cqe = cqes_[head & cq_mask_];
+            ++head;
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+            handle_completion(cqe);
+            tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        }
+    }
+}
+
+void IoUringServer::handle_completion(const io_uring_cqe& cqe) {
+    completions_.fetch_add(1, std::memory_order_relaxed);
+
+    uint8_t op = user_data_op(cqe.user_data);
+    switch (op) {
+        case OP_ACCEPT:
+            if (cqe.res >= 0) {
+                add_connection(cqe.res);
+            } else if (running_.load() && cqe.res != -ECANCELED) {
+                std::cerr << "Accept error: " << std::strerror(-cqe.res) << std::endl;
+            }
+            if (!(cqe.flags & IORING_CQE_F_MORE) && running_.load()) {
+                if (cqe.res == -EINVAL || cqe.res == -EBADF || cqe.res == -ENOTSOCK || cqe.res == -EOPNOTSUPP) {
+                    // Retrying cannot succeed; re-arming would only spin on the same error
+                    std::cerr << "io_uring accept cannot be armed, no longer accepting connections" << std::endl;
+                } else if (cqe.res < 0) {
+                    // Out of descriptors or memory: retry on the next tick rather than at once
+                    accept_retry_pending_ = true;
+                } else {
+                    arm_accept();
+                }
+            }
+            break;
+
+        case OP_PROVIDE:
+            // Only failures complete; the buffers are lost to the receive pool
+            std::cerr << "io_uring provide buffers failed: " << std::strerror(-cqe.res) << std::endl;
+            break;
+
+        case OP_WAKE:
+            wake_pending_.store(false);
+            if (running_.load()) {
+                arm_wake();
+            }
+            break;
+
+        case OP_TICK:
+            // A timeout with no completion count ends with -ETIME
+            if (running_.load()) {
+                if (accept_retry_pending_) {
+                    accept_retry_pending_ = false;
+                    arm_accept();
+                }
+                handle_session_tick();
+                arm_tick();
+            }
+            break;
+
+        case OP_RECV: {
+            IoUringConnection* connection = find_connection(user_data_slot(cqe.user_data),
+                                                             user_data_generation(cqe.user_data));
+            bool has_buffer = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+            uint16_t buffer_id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+            if (!connection) {
+                if (has_buffer) {
+                    recycle_buffer(buffer_id);
+                }
+                break;
+            }
+
+            connection->recv_armed_ = (cqe.flags & IORING_CQE_F_MORE) != 0;
+            if (cqe.res > 0 && has_buffer) {
+                const uint8_t* data = recv_buffers_ + static_cast<size_t>(buffer_id) * config_.recv_buffer_size;
+                bool ok = connection->closing_ || connection->consume(data, static_cast<size_t>(cqe.res));
+                recycle_buffer(buffer_id);
+                if (!ok) {
+                    close_connection(*connection);
+                }
+            } else if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS)) {
+                // Peer closed, or a receive error; ENOBUFS just means the ring ran dry
+                close_connection(*connection);
+            }
+
+            if (connection->closing_) {
+                release_connection_if_idle(*connection);
+            } else if (!connection->recv_armed_) {
+                arm_recv(*connection);
+            }
+            break;
+        }
+
+        case OP_SEND: {
+            IoUringConnection* connection = find_connection(user_data_slot(cqe.user_data),
+                                                             user_data_generation(cqe.user_data));
+            if (!connection) {
+                break;
+            }
+
+            connection->write_inflight_ = false;
+            if (cqe.res < 0) {
+                if (cqe.res != -ECANCELED && cqe.res != -EPIPE && cqe.res != -ECONNRESET) {
+                    std::cerr << "Write error: " << std::strerror(-cqe.res) << std::endl;
+                }
+                close_connection(*connection);
+            } else {
+                bytes_sent_.fetch_add(static_cast<uint64_t>(cqe.res), std::memory_order_relaxed);
+                connection->send_offset_ += static_cast<size_t>(cqe.res);
+                if (!connection->closing_) {
+                    if (connection->send_offset_ < connection->send_length_) {
+                        submit_send(*connection);
+                    } else {
+                        connection->send_offset_ = 0;
+                        connection->send_length_ = 0;
+                        start_write(*connection);
+                    }
+                }
+            }
+
+            if (connection->closing_) {
+                release_connection_if_idle(*connection);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void IoUringServer::arm_accept() {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        std::cerr << "io_uring submission queue full, cannot accept" << std::endl;
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_fd_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = make_user_data(OP_ACCEPT, 0, 0);
+}
+
+void IoUringServer::arm_wake() {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wake_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&wake_value_);
+    sqe->len = sizeof(wake_value_);
+    sqe->user_data = make_user_data(OP_WAKE, 0, 0);
+}
+
+void IoUringServer::arm_tick() {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(tick_interval_.get());
+    sqe->len = 1;
+    sqe->user_data = make_user_data(OP_TICK, 0, 0);
+}
+
+void IoUringServer::handle_session_tick() {
+    auto now = std::chrono::steady_clock::now();
+    expired_timers_.clear();
+    session_timers_->advance(now, expired_timers_);
+
+    // Timers of connections that have gone fail the generation check and are dropped
+    for (uint64_t id : expired_timers_) {
+        uint32_t slot = static_cast<uint32_t>(id);
+        IoUringConnection* connection = find_connection(slot, static_cast<uint32_t>(id >> 32));
+        if (!connection) {
+            continue;
+        }
+        if (auto next = connection->on_session_timer(now)) {
+            session_timers_->schedule(id, *next);
+        }
+    }
+
+    session_store_->flush();
+}
+
+void IoUringServer::arm_recv(IoUringConnection& connection) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        close_connection(connection);
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connection.fd_;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = RECV_BUFFER_GROUP;
+    sqe->user_data = make_user_data(OP_RECV, generations_[connection.slot_], connection.slot_);
+    connection.recv_armed_ = true;
+}
+
+void IoUringServer::recycle_buffer(uint16_t buffer_id) {
+    recycled_buffers_.push_back(buffer_id);
+}
+
+bool IoUringServer::provide_recycled_buffers() {
+    if (recycled_buffers_.empty()) {
+        return true;
+    }
+
+    // Buffers usually come back in order, so runs of consecutive ids share one SQE;
+    // the SQEs ride along with the loop's single io_uring_enter
+    std::sort(recycled_buffers_.begin(), recycled_buffers_.end());
+    size_t run_start = 0;
+    while (run_start < recycled_buffers_.size()) {
+        size_t run_end = run_start + 1;
+        while (run_end < recycled_buffers_.size() &&
+               recycled_buffers_[run_end] == recycled_buffers_[run_end - 1] + 1) {
+            ++run_end;
+        }
+
+        io_uring_sqe* sqe = get_sqe();
+        if (!sqe) {
+            // Keep the rest for the next iteration
+            recycled_buffers_.erase(recycled_buffers_.begin(), recycled_buffers_.begin() + run_start);
+            return false;
+        }
+        uint16_t first = recycled_buffers_[run_start];
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = static_cast<int>(run_end - run_start);
+        sqe->addr = reinterpret_cast<uint64_t>(recv_buffers_ + static_cast<size_t>(first) * config_.recv_buffer_size);
+        sqe->len = static_cast<uint32_t>(config_.recv_buffer_size);
+        sqe->off = first;
+        sqe->buf_group = RECV_BUFFER_GROUP;
+        sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+        sqe->user_data = make_user_data(OP_PROVIDE, 0, 0);
+
+        run_start = run_end;
+    }
+    recycled_buffers_.clear();
+    return true;
+}
+
+void IoUringServer::add_connection(int fd) {
+    std::shared_ptr<IoUringConnection> connection;
+    size_t total = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(clients_mutex_);
+        if (free_slots_.empty()) {
+            std::cerr << "Session limit reached, rejecting client" << std::endl;
+            close(fd);
+            return;
+        }
+
+        uint32_t slot = free_slots_.back();
+        free_slots_.pop_back();
+
+        connection = std::make_shared<IoUringConnection>(*this, fd, slot, next_connection_id_++, instruments_);
+        connection->set_text_protocol_enabled(text_protocol_enabled_);
+        connection->set_order_submit_callback(order_submit_callback_);
+        connection->set_order_cancel_callback(order_cancel_callback_);
+        connection->set_order_modify_callback(order_modify_callback_);
+        connection->set_order_mass_cancel_callback(order_mass_cancel_callback_);
+        connection->set_order_status_callback(order_status_callback_);
+        connection->set_subscriptions(subscriptions_, slot);
+        connection->set_session_store(session_store_);
+        if (max_outbound_bytes_ > 0) {
+            connection->set_max_outbound_bytes(max_outbound_bytes_);
+        }
+
+        connections_[slot] = connection;
+        total = ++client_count_;
+
+        // The first timer only waits for a login
+        uint64_t timer_id = (static_cast<uint64_t>(generations_[slot] & 0xFFFFFF) << 32) | slot;
+        session_timers_->schedule(timer_id, std::chrono::steady_clock::now() + session_store_->config().min_heartbeat_interval);
+    }
+
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    arm_recv(*connection);
+    std::cout << "New client connected, total clients: " << total << std::endl;
+}
+
+IoUringConnection* IoUringServer::find_connection(uint32_t slot, uint32_t generation) const {
+    if (slot >= connections_.size() || (generations_[slot] & 0xFFFFFF) != generation) {
+        return nullptr;
+    }
+    return connections_[slot].get();
+}
+
+void IoUringServer::drain_ready_slots() {
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        if (ready_slots_.empty()) {
+            return;
+        }
+        ready_batch_.swap(ready_slots_);
+    }
+
+    for (uint32_t slot : ready_batch_) {
+        IoUringConnection* connection = connections_[slot].get();
+        if (!connection) {
+            continue;
+        }
+        if (!connection->is_connected()) {
+            close_connection(*connection);
+            release_connection_if_idle(*connection);
+        } else {
+            start_write(*connection);
+            if (connection->closing_) {
+                release_connection_if_idle(*connection);
+            }
+        }
+    }
+    ready_batch_.clear();
+}
+
+void IoUringServer::start_write(IoUringConnection& connection) {
+    if (connection.write_inflight_ || connection.closing_) {
+        return;
+    }
+
+    // Copy as much queued output as fits into the connection's send buffer
+    uint8_t* buffer = send_buffers_ + static_cast<size_t>(connection.slot_) * config_.send_buffer_size;
+    size_t filled = 0;
+    {
+        std::lock_guard<std::mutex> lock(connection.queue_mutex_);
+        while (!connection.pending_.empty() && filled < config_.send_buffer_size) {
+            const OutboundMessage& message = connection.pending_.front();
+            size_t copied = copy_message_bytes(message, connection.front_offset_, buffer + filled,
+                                               config_.send_buffer_size - filled);
+            filled += copied;
+            connection.front_offset_ += copied;
+            if (connection.front_offset_ == message.wire_size()) {
+                connection.pending_.pop_front();
+                connection.front_offset_ = 0;
+            }
+        }
+        connection.queued_bytes_ -= filled;
+
+        if (filled == 0) {
+            connection.write_scheduled_ = false;
+        }
+    }
+
+    // A flushing disconnect closes once everything queued has been written
+    if (filled == 0) {
+        if (connection.close_after_flush_.load()) {
+            close_connection(connection);
+        }
+        return;
+    }
+
+    connection.send_offset_ = 0;
+    connection.send_length_ = filled;
+    submit_send(connection);
+}
+
+void IoUringServer::submit_send(IoUringConnection& connection) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        close_connection(connection);
+        return;
+    }
+
+    uint8_t* buffer = send_buffers_ + static_cast<size_t>(connection.slot_) * config_.send_buffer_size;
+    sqe->opcode = IORING_OP_SEND;
+    sqe->msg_flags = MSG_NOSIGNAL;     // A peer that closed fails the send with EPIPE
+    sqe->fd = connection.fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer + connection.send_offset_);
+    sqe->len = static_cast<uint32_t>(connection.send_length_ - connection.send_offset_);
+    sqe->user_data = make_user_data(OP_SEND, generations_[connection.slot_], connection.slot_);
+    connection.write_inflight_ = true;
+}
+
+void IoUringServer::close_connection(IoUringConnection& connection) {
+    if (connection.closing_) {
+        return;
+    }
+    connection.closing_ = true;
+    connection.connected_.store(false);
+
+    // Shutdown completes the pending receive; the cancel covers kernels that keep it armed
+    shutdown(connection.fd_, SHUT_RDWR);
+    if (connection.recv_armed_) {
+        io_uring_sqe* sqe = get_sqe();
+        if (sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = make_user_data(OP_RECV, generations_[connection.slot_], connection.slot_);
+            sqe->user_data = make_user_data(OP_CANCEL, 0, 0);
+        }
+    }
+}
+
+void IoUringServer::release_connection_if_idle(IoUringConnection& connection) {
+    // The fd and slot are reused only once no operation can still complete for them
+    if (!connection.closing_ || connection.recv_armed_ || connection.write_inflight_) {
+        return;
+    }
+
+    uint32_t slot = connection.slot_;
+    connection.end_session();
+    close(connection.fd_);
+
+    size_t remaining = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(clients_mutex_);
+        subscriptions_->remove_session(slot);
+        connections_[slot].reset();
+        ++generations_[slot];
+        free_slots_.push_back(slot);
+        remaining = --client_count_;
+    }
+    std::cout << "Client disconnected, total clients: " << remaining << std::endl;
+}
+
+void IoUringServer::schedule_write(uint32_t slot) {
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        ready_slots_.push_back(slot);
+    }
+
+    // The event loop drains the list before it next waits, so it only needs waking
+    // when the producer is another thread
+    if (current_event_loop != this && !wake_pending_.exchange(true)) {
+        uint64_t value = 1;
+        if (write(wake_fd_, &value, sizeof(value)) < 0) {
+            std::cerr << "Failed to wake io_uring event loop: " << std::strerror(errno) << std::endl;
+        }
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace UltraFastAnalysis
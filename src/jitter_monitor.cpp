@@ -0,0 +1,270 @@
+#include "jitter_monitor.h"
+#include "performance_monitor.h"
+#include "thread_name.h"
+#include "tsc_clock.h"
+#include <cstring>
+#include <functional>
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#define UFA_RUSAGE_THREAD 1
+#endif
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+bool read_thread_rusage(ThreadSchedStats& stats) {
+#ifdef UFA_RUSAGE_THREAD
+    rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+        return false;
+    }
+    stats.voluntary_switches = static_cast<uint64_t>(usage.ru_nvcsw);
+    stats.involuntary_switches = static_cast<uint64_t>(usage.ru_nivcsw);
+    stats.minor_faults = static_cast<uint64_t>(usage.ru_minflt);
+    stats.major_faults = static_cast<uint64_t>(usage.ru_majflt);
+    return true;
+#else
+    (void)stats;
+    return false;
+#endif
+}
+
+uint64_t ticks_from_ns(uint64_t ns) {
+    return static_cast<uint64_t>(static_cast<unsigned __int128>(ns) * TscClock::ticks_per_second() / 1000000000ULL);
+}
+
+uint64_t ns_from_ticks(uint64_t ticks) {
+    return static_cast<uint64_t>(TscClock::to_duration(ticks).count());
+}
+
+// Engine thread registry
+struct SchedThread {
+    std::string name;
+    std::atomic<uint64_t> voluntary_switches{0};
+    std::atomic<uint64_t> involuntary_switches{0};
+    std::atomic<uint64_t> minor_faults{0};
+    std::atomic<uint64_t> major_faults{0};
+    uint64_t sample_interval_ticks = 0;     // Owning thread only
+    uint64_t next_sample_tsc = 0;
+
+    void sample() {
+        ThreadSchedStats stats;
+        if (read_thread_rusage(stats)) {
+            voluntary_switches.store(stats.voluntary_switches, std::memory_order_relaxed);
+            involuntary_switches.store(stats.involuntary_switches, std::memory_order_relaxed);
+            minor_faults.store(stats.minor_faults, std::memory_order_relaxed);
+            major_faults.store(stats.major_faults, std::memory_order_relaxed);
+        }
+    }
+};
+
+std::mutex sched_registry_mutex;
+std::vector<std::shared_ptr<SchedThread>> sched_registry;
+thread_local SchedThread* sched_thread = nullptr;
+
+constexpr uint64_t SCHED_SAMPLE_INTERVAL_NS = 100000000;    // 100 ms
+constexpr uint64_t RUSAGE_SAMPLE_BATCH = 4096;              // Sampler loop iterations between clock checks
+
+} // namespace
+
+// JitterSampler implementation
+JitterSampler::JitterSampler(const JitterSamplerSpec& spec, std::chrono::nanoseconds gap_threshold)
+    : spec_(spec),
+      threshold_ticks_(ticks_from_ns(static_cast<uint64_t>(std::max<int64_t>(gap_threshold.count(), 1)))),
+      gaps_(std::make_unique<LatencyHistogram>()) {
+}
+
+JitterSampler::~JitterSampler() {
+    stop();
+}
+
+bool JitterSampler::start() {
+    if (running_.load()) {
+        return true;
+    }
+    running_.store(true);
+    std::promise<bool> started;
+    auto pinned = started.get_future();
+    thread_ = std::thread(&JitterSampler::sampler_thread_worker, this, std::ref(started));
+    if (!pinned.get()) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void JitterSampler::stop() {
+    running_.store(false);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+JitterStats JitterSampler::get_stats() const {
+    JitterStats stats;
+    stats.role = spec_.role;
+    stats.cpu = spec_.cpu;
+    stats.sampled_ns = ns_from_ticks(sampled_ticks_.load(std::memory_order_relaxed));
+    stats.stolen_ns = ns_from_ticks(stolen_ticks_.load(std::memory_order_relaxed));
+    stats.gaps = gaps_->get_count();
+    stats.max_gap_ns = gaps_->get_max();
+    stats.p50_gap_ns = gaps_->get_percentile(50.0);
+    stats.p99_gap_ns = gaps_->get_percentile(99.0);
+    stats.p999_gap_ns = gaps_->get_percentile(99.9);
+    stats.sched.name = "jitter-" + spec_.role;
+    stats.sched.voluntary_switches = voluntary_switches_.load(std::memory_order_relaxed);
+    stats.sched.involuntary_switches = involuntary_switches_.load(std::memory_order_relaxed);
+    stats.sched.minor_faults = minor_faults_.load(std::memory_order_relaxed);
+    stats.sched.major_faults = major_faults_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void JitterSampler::sampler_thread_worker(std::promise<bool>& started) {
+    set_current_thread_name("jitter_" + spec_.role);
+#ifdef __linux__
+    // Pin before the first sample so no gap is measured on the wrong CPU
+    if (spec_.cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(spec_.cpu, &cpu_set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+            std::cerr << "Failed to pin jitter sampler " << spec_.role << " to CPU " << spec_.cpu << std::endl;
+            started.set_value(false);
+            return;
+        }
+    }
+#endif
+    started.set_value(true);   // start() returns and `started` goes away
+
+    const uint64_t sample_interval_ticks = ticks_from_ns(SCHED_SAMPLE_INTERVAL_NS);
+    uint64_t start = TscClock::now();
+    uint64_t next_rusage = start + sample_interval_ticks;
+    uint64_t previous = start;
+    uint64_t stolen = 0;
+
+    while (running_.load(std::memory_order_relaxed)) {
+        for (uint64_t i = 0; i < RUSAGE_SAMPLE_BATCH; ++i) {
+            uint64_t now = TscClock::now();
+            uint64_t gap = now - previous;
+            previous = now;
+            if (gap > threshold_ticks_) {
+                gaps_->record_single_writer(ns_from_ticks(gap));
+                stolen += gap;
+            }
+        }
+
+        sampled_ticks_.store(previous - start, std::memory_order_relaxed);
+        stolen_ticks_.store(stolen, std::memory_order_relaxed);
+        if (previous >= next_rusage) {
+            sample_rusage();
+            next_rusage = previous + sample_interval_ticks;
+            // Our own bookkeeping is not host jitter; start over after it
+            previous = TscClock::now();
+        }
+    }
+    sample_rusage();
+}
+
+void JitterSampler::sample_rusage() {
+    ThreadSchedStats stats;
+    if (read_thread_rusage(stats)) {
+        voluntary_switches_.store(stats.voluntary_switches, std::memory_order_relaxed);
+        involuntary_switches_.store(stats.involuntary_switches, std::memory_order_relaxed);
+        minor_faults_.store(stats.minor_faults, std::memory_order_relaxed);
+        major_faults_.store(stats.major_faults, std::memory_order_relaxed);
+    }
+}
+
+// JitterMonitor implementation
+JitterMonitor::JitterMonitor(const JitterConfig& config) {
+    for (const auto& spec : config.samplers) {
+        samplers_.push_back(std::make_unique<JitterSampler>(spec, config.gap_threshold));
+    }
+}
+
+JitterMonitor::~JitterMonitor() {
+    stop();
+}
+
+bool JitterMonitor::start() {
+    TscClock::ticks_per_second();  // Calibrate before the samplers convert thresholds
+    bool ok = true;
+    for (auto& sampler : samplers_) {
+        ok = sampler->start() && ok;
+    }
+    return ok;
+}
+
+void JitterMonitor::stop() {
+    for (auto& sampler : samplers_) {
+        sampler->stop();
+    }
+}
+
+std::vector<JitterStats> JitterMonitor::get_stats() const {
+    std::vector<JitterStats> stats;
+    stats.reserve(samplers_.size());
+    for (const auto& sampler : samplers_) {
+        stats.push_back(sampler->get_stats());
+    }
+    return stats;
+}
+
+// Engine thread registry
+void sched_register_thread(const std::string& name) {
+    if (sched_thread) {
+        return;
+    }
+    auto thread = std::make_shared<SchedThread>();
+    thread->name = name;
+    thread->sample();
+    thread->sample_interval_ticks = ticks_from_ns(SCHED_SAMPLE_INTERVAL_NS);
+    thread->next_sample_tsc = TscClock::now() + thread->sample_interval_ticks;
+    sched_thread = thread.get();
+
+    std::lock_guard<std::mutex> lock(sched_registry_mutex);
+    sched_registry.push_back(std::move(thread));
+}
+
+void sched_sample_thread() {
+    if (!sched_thread) {
+        return;
+    }
+    uint64_t now = TscClock::now();
+    if (now < sched_thread->next_sample_tsc) {
+        return;
+    }
+    sched_thread->sample();
+    sched_thread->next_sample_tsc = now + sched_thread->sample_interval_ticks;
+}
+
+void sched_unregister_thread() {
+    if (!sched_thread) {
+        return;
+    }
+    sched_thread->sample();
+    sched_thread = nullptr;
+}
+
+std::vector<ThreadSchedStats> sched_get_thread_stats() {
+    std::lock_guard<std::mutex> lock(sched_registry_mutex);
+    std::vector<ThreadSchedStats> result;
+    result.reserve(sched_registry.size());
+    for (const auto& thread : sched_registry) {
+        ThreadSchedStats stats;
+        stats.name = thread->name;
+        stats.voluntary_switches = thread->voluntary_switches.load(std::memory_order_relaxed);
+        stats.involuntary_switches = thread->involuntary_switches.load(std::memory_order_relaxed);
+        stats.minor_faults = thread->minor_faults.load(std::memory_order_relaxed);
+        stats.major_faults = thread->major_faults.load(std::memory_order_relaxed);
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+} // namespace UltraFastAnalysis
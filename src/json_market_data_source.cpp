@@ -0,0 +1,583 @@
+#include "json_market_data_source.h"
+#include "thread_name.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+// Find the next '"' or '\\' in [p, end); 16 bytes at a time with SSE2
+inline const char* find_quote_or_escape(const char* p, const char* end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i escape = _mm_set1_epi8('\\');
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                  _mm_cmpeq_epi8(chunk, escape)));
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned int>(mask));
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\') {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* skip_whitespace(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        ++p;
+    }
+    return p;
+}
+
+// p points just past the opening quote; returns the position of the closing quote or nullptr
+inline const char* find_string_end(const char* p, const char* end) {
+    while (true) {
+        p = find_quote_or_escape(p, end);
+        if (p >= end) {
+            return nullptr;
+        }
+        if (*p == '"') {
+            return p;
+        }
+        p += 2; // Skip the escaped character
+    }
+}
+
+// p points at '{' or '['; returns the position just past the matching close bracket
+const char* skip_nested(const char* p, const char* end) {
+    int depth = 0;
+    while (p < end) {
+        char c = *p;
+        if (c == '"') {
+            p = find_string_end(p + 1, end);
+            if (!p) return nullptr;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                return p + 1;
+            }
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+bool parse_unsigned(std::string_view text, uint64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    uint64_t result = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        if (__builtin_mul_overflow(result, 10u, &result) ||
+            __builtin_add_overflow(result, static_cast<uint64_t>(c - '0'), &result)) {
+            return false;
+        }
+    }
+    value = result;
+    return true;
+}
+
+// Message field identifiers
+enum class JsonField : uint8_t {
+    UNKNOWN,
+    TYPE,
+    SYMBOL,
+    SEQ,
+    TRADE_ID,
+    PRICE,
+    SIZE,
+    SIDE,
+    BID,
+    BID_SIZE,
+    ASK,
+    ASK_SIZE
+};
+
+inline JsonField classify_key(std::string_view key) {
+    switch (key.size()) {
+        case 1:
+            if (key == "p") return JsonField::PRICE;
+            if (key == "q") return JsonField::SIZE;
+            if (key == "s") return JsonField::SYMBOL;
+            break;
+        case 3:
+            if (key == "seq") return JsonField::SEQ;
+            if (key == "bid") return JsonField::BID;
+            if (key == "ask") return JsonField::ASK;
+            break;
+        case 4:
+            if (key == "type") return JsonField::TYPE;
+            if (key == "size") return JsonField::SIZE;
+            if (key == "side") return JsonField::SIDE;
+            break;
+        case 5:
+            if (key == "price") return JsonField::PRICE;
+            break;
+        case 6:
+            if (key == "symbol") return JsonField::SYMBOL;
+            break;
+        case 8:
+            if (key == "trade_id") return JsonField::TRADE_ID;
+            if (key == "bid_size") return JsonField::BID_SIZE;
+            if (key == "ask_size") return JsonField::ASK_SIZE;
+            break;
+        default:
+            break;
+    }
+    return JsonField::UNKNOWN;
+}
+
+} // namespace
+
+JsonMarketDataSource::JsonMarketDataSource(const MarketDataConfig& config)
+    : config_(config), price_divisor_(std::pow(10.0, config.price_decimals)) {
+}
+
+JsonMarketDataSource::~JsonMarketDataSource() {
+    stop_streaming();
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool JsonMarketDataSource::connect() {
+    if (connected_.load()) {
+        return true;
+    }
+
+    const std::string& url = config_.data_source_url;
+    if (url.empty()) {
+        report_error("JSON feed requires data_source_url (file path or unix:/path)");
+        return false;
+    }
+
+    if (url.rfind("unix:", 0) == 0) {
+        std::string path = url.substr(5);
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path)) {
+            report_error("Socket path too long: " + path);
+            return false;
+        }
+
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            report_error("Failed to create socket: " + std::string(std::strerror(errno)));
+            return false;
+        }
+
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        if (::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            report_error("Failed to connect to " + path + ": " + std::strerror(errno));
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        is_socket_ = true;
+    } else {
+        fd_ = ::open(url.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            report_error("Failed to open " + url + ": " + std::strerror(errno));
+            return false;
+        }
+        is_socket_ = false;
+    }
+
+    buffer_.assign(std::max<size_t>(config_.json_read_buffer_size, 4096), 0);
+    buffer_begin_ = 0;
+    buffer_end_ = 0;
+
+    connected_.store(true);
+    return true;
+}
+
+void JsonMarketDataSource::disconnect() {
+    stop_streaming();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    connected_.store(false);
+}
+
+bool JsonMarketDataSource::is_connected() const {
+    return connected_.load();
+}
+
+bool JsonMarketDataSource::start_streaming() {
+    if (!connected_.load() || streaming_.load()) {
+        return false;
+    }
+
+    streaming_.store(true);
+    shutdown_requested_.store(false);
+
+    reader_thread_ = std::thread(&JsonMarketDataSource::reader_thread_worker, this);
+    return true;
+}
+
+void JsonMarketDataSource::stop_streaming() {
+    shutdown_requested_.store(true);
+    streaming_.store(false);
+
+    if (reader_thread_.joinable()) {
+        reader_thread_.join();
+    }
+}
+
+void JsonMarketDataSource::set_data_callback(std::function<void(const MarketData&)> callback) {
+    data_callback_ = callback;
+}
+
+void JsonMarketDataSource::set_error_callback(std::function<void(const std::string&)> callback) {
+    error_callback_ = callback;
+}
+
+const MarketDataStats& JsonMarketDataSource::get_stats() const {
+    return stats_;
+}
+
+void JsonMarketDataSource::reset_stats() {
+    stats_.reset();
+}
+
+bool JsonMarketDataSource::parse_decimal_to_ticks(std::string_view text, int decimals, int64_t& ticks) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+
+    int64_t value = 0;
+    bool has_digits = false;
+
+    // Integer part
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (__builtin_mul_overflow(value, 10, &value) ||
+            __builtin_add_overflow(value, *p - '0', &value)) {
+            return false;
+        }
+        has_digits = true;
+        ++p;
+    }
+
+    // Fractional part; digits past the requested decimals may only be zeros, so
+    // no value is silently rounded away
+    int fraction_digits = 0;
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (fraction_digits < decimals) {
+                if (__builtin_mul_overflow(value, 10, &value) ||
+                    __builtin_add_overflow(value, *p - '0', &value)) {
+                    return false;
+                }
+                ++fraction_digits;
+            } else if (*p != '0') {
+                return false;
+            }
+            has_digits = true;
+            ++p;
+        }
+    }
+
+    if (!has_digits || p != end) {
+        return false;
+    }
+
+    for (; fraction_digits < decimals; ++fraction_digits) {
+        if (__builtin_mul_overflow(value, 10, &value)) {
+            return false;
+        }
+    }
+
+    ticks = negative ? -value : value;
+    return true;
+}
+
+bool JsonMarketDataSource::parse_message(std::string_view message, MarketData& out) const {
+    const char* p = skip_whitespace(message.data(), message.data() + message.size());
+    const char* end = message.data() + message.size();
+
+    if (p >= end || *p != '{') {
+        return false;
+    }
+    ++p;
+
+    std::string_view type;
+    std::string_view side;
+    int64_t price_ticks = 0, bid_ticks = 0, ask_ticks = 0;
+    int64_t size_lots = 0, bid_lots = 0, ask_lots = 0;
+    uint64_t sequence = 0, trade_id = 0;
+    bool has_symbol = false;
+
+    while (true) {
+        p = skip_whitespace(p, end);
+        if (p >= end) return false;
+        if (*p == '}') break;
+        if (*p == ',') {
+            ++p;
+            continue;
+        }
+        if (*p != '"') return false;
+
+        // Key
+        const char* key_end = find_string_end(p + 1, end);
+        if (!key_end) return false;
+        JsonField field = classify_key(std::string_view(p + 1, key_end - p - 1));
+
+        p = skip_whitespace(key_end + 1, end);
+        if (p >= end || *p != ':') return false;
+        p = skip_whitespace(p + 1, end);
+        if (p >= end) return false;
+
+        // Value: strings and scalars are captured as views, nested values are skipped
+        std::string_view value;
+        if (*p == '"') {
+            const char* value_end = find_string_end(p + 1, end);
+            if (!value_end) return false;
+            value = std::string_view(p + 1, value_end - p - 1);
+            p = value_end + 1;
+        } else if (*p == '{' || *p == '[') {
+            p = skip_nested(p, end);
+            if (!p) return false;
+            continue;
+        } else {
+            const char* value_start = p;
+            while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t' &&
+                   *p != '\r' && *p != '\n') {
+                ++p;
+            }
+            value = std::string_view(value_start, p - value_start);
+        }
+
+        bool ok = true;
+        switch (field) {
+            case JsonField::TYPE:
+                type = value;
+                break;
+            case JsonField::SYMBOL:
+                out.symbol.assign(value.data(), value.size());
+                has_symbol = true;
+                break;
+            case JsonField::SEQ:
+                ok = parse_unsigned(value, sequence);
+                break;
+            case JsonField::TRADE_ID:
+                ok = parse_unsigned(value, trade_id);
+                break;
+            case JsonField::PRICE:
+                ok = parse_decimal_to_ticks(value, config_.price_decimals, price_ticks);
+                break;
+            case JsonField::SIZE:
+                ok = parse_decimal_to_ticks(value, config_.quantity_decimals, size_lots);
+                break;
+            case JsonField::SIDE:
+                side = value;
+                break;
+            case JsonField::BID:
+                ok = parse_decimal_to_ticks(value, config_.price_decimals, bid_ticks);
+                break;
+            case JsonField::BID_SIZE:
+                ok = parse_decimal_to_ticks(value, config_.quantity_decimals, bid_lots);
+                break;
+            case JsonField::ASK:
+                ok = parse_decimal_to_ticks(value, config_.price_decimals, ask_ticks);
+                break;
+            case JsonField::ASK_SIZE:
+                ok = parse_decimal_to_ticks(value, config_.quantity_decimals, ask_lots);
+                break;
+            case JsonField::UNKNOWN:
+                break;
+        }
+        if (!ok) return false;
+    }
+
+    if (!has_symbol || size_lots < 0 || bid_lots < 0 || ask_lots < 0) {
+        return false;
+    }
+
+    out.sequence_number = sequence;
+
+    if (type == "trade" || type == "tick") {
+        out.type = (type == "trade") ? MarketDataType::TRADE : MarketDataType::TICK;
+        out.trade_price = price_ticks / price_divisor_;
+        out.trade_quantity = static_cast<uint64_t>(size_lots);
+        out.trade_id = trade_id;
+    } else if (type == "quote") {
+        out.type = MarketDataType::QUOTE;
+        out.bid_price = bid_ticks / price_divisor_;
+        out.bid_quantity = static_cast<uint64_t>(bid_lots);
+        out.ask_price = ask_ticks / price_divisor_;
+        out.ask_quantity = static_cast<uint64_t>(ask_lots);
+    } else if (type == "book") {
+        // A level on a guessed side would corrupt the book; drop it instead
+        bool is_bid = (side == "bid" || side == "buy");
+        if (!is_bid && side != "ask" && side != "sell") {
+            return false;
+        }
+        out.type = MarketDataType::ORDER_BOOK_UPDATE;
+        out.price = price_ticks / price_divisor_;
+        out.quantity = static_cast<uint64_t>(size_lots);
+        out.is_bid = is_bid;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+void JsonMarketDataSource::reader_thread_worker() {
+    set_current_thread_name("json_feed");
+    std::cout << "JSON feed reader thread started: " << std::this_thread::get_id() << std::endl;
+
+    while (!shutdown_requested_.load(std::memory_order_relaxed)) {
+        // Sockets are polled so that shutdown is noticed while the feed is idle
+        if (is_socket_) {
+            pollfd poll_fd{fd_, POLLIN, 0};
+            int ready = ::poll(&poll_fd, 1, 10);
+            if (ready == 0 || (ready < 0 && errno == EINTR)) {
+                continue;
+            }
+        }
+
+        // Move any partial message to the front before reading more
+        if (buffer_begin_ > 0) {
+            std::memmove(buffer_.data(), buffer_.data() + buffer_begin_, buffer_end_ - buffer_begin_);
+            buffer_end_ -= buffer_begin_;
+            buffer_begin_ = 0;
+        }
+
+        if (buffer_end_ == buffer_.size()) {
+            report_error("JSON message exceeds read buffer, discarding buffered data");
+            stats_.messages_dropped.fetch_add(1, std::memory_order_relaxed);
+            buffer_end_ = 0;
+        }
+
+        ssize_t bytes = ::read(fd_, buffer_.data() + buffer_end_, buffer_.size() - buffer_end_);
+        if (bytes < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            report_error("JSON feed read failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+        if (bytes == 0) {
+            // End of file, or the peer closed the socket
+            process_buffer();
+            if (is_socket_) {
+                report_error("JSON feed socket closed");
+                connected_.store(false);
+            }
+            break;
+        }
+
+        buffer_end_ += static_cast<size_t>(bytes);
+        process_buffer();
+    }
+
+    streaming_.store(false);
+    std::cout << "JSON feed reader thread stopped: " << std::this_thread::get_id() << std::endl;
+}
+
+size_t JsonMarketDataSource::process_buffer() {
+    size_t processed = 0;
+    const char* data = buffer_.data();
+
+    if (config_.json_framing == JsonFraming::NEWLINE_DELIMITED) {
+        while (buffer_begin_ < buffer_end_) {
+            const char* start = data + buffer_begin_;
+            const auto* newline = static_cast<const char*>(
+                std::memchr(start, '\n', buffer_end_ - buffer_begin_));
+            if (!newline) {
+                break;
+            }
+
+            std::string_view message(start, newline - start);
+            buffer_begin_ = (newline - data) + 1;
+
+            // Tolerate blank lines and CRLF endings
+            if (!message.empty() && message.back() == '\r') {
+                message.remove_suffix(1);
+            }
+            if (!message.empty()) {
+                dispatch_message(message);
+                ++processed;
+            }
+        }
+    } else {
+        while (buffer_end_ - buffer_begin_ >= sizeof(uint32_t)) {
+            uint32_t length;
+            std::memcpy(&length, data + buffer_begin_, sizeof(length));
+            if (length > buffer_.size() - sizeof(uint32_t)) {
+                report_error("JSON frame length " + std::to_string(length) + " exceeds read buffer");
+                stats_.messages_dropped.fetch_add(1, std::memory_order_relaxed);
+                buffer_begin_ = buffer_end_;
+                break;
+            }
+            if (buffer_end_ - buffer_begin_ < sizeof(uint32_t) + length) {
+                break;
+            }
+
+            dispatch_message(std::string_view(data + buffer_begin_ + sizeof(uint32_t), length));
+            buffer_begin_ += sizeof(uint32_t) + length;
+            ++processed;
+        }
+    }
+
+    return processed;
+}
+
+void JsonMarketDataSource::dispatch_message(std::string_view message) {
+    decoded_.reset();
+
+    if (!parse_message(message, decoded_)) {
+        stats_.validation_errors.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    decoded_.timestamp = std::chrono::high_resolution_clock::now();
+    stats_.messages_received.fetch_add(1, std::memory_order_relaxed);
+
+    if (data_callback_) {
+        data_callback_(decoded_);
+    }
+}
+
+void JsonMarketDataSource::report_error(const std::string& error) {
+    if (error_callback_) {
+        error_callback_(error);
+    } else {
+        std::cerr << error << std::endl;
+    }
+}
+
+} // namespace UltraFastAnalysis
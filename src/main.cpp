@@ -1,5 +1,6 @@
 #include "order_matching_engine.h"
 #include "performance_monitor.h"
+#include "flight_recorder.h"
 #include <iostream>
 #include <csignal>
 #include <memory>
@@ -47,6 +48,38 @@ void print_usage(const char* program_name) {
               << "  -v, --verbose           Enable verbose logging\n"
               << "  --no-performance        Disable performance monitoring\n"
               << "  --simulate-only         Run in simulation mode only\n"
+              << "  --no-text-protocol      Accept binary order entry messages only\n"
+              << "  --io-uring              Use the io_uring network backend (Linux 6.0+)\n"
+              << "  --io-per-thread         One io_context per network thread, connections stay on one thread\n"
+              << "  --affinity <policy>     Worker choice with --io-per-thread: round-robin or address\n"
+              << "  --reuse-port            With --io-per-thread, one SO_REUSEPORT acceptor per thread\n"
+              << "  --pin-network-threads   Pin network thread i to CPU i\n"
+              << "  --journal-dir <dir>     Keep outbound session journals here for resends across restarts\n"
+              << "  --heartbeat <seconds>   Default session heartbeat interval (default: 30)\n"
+              << "  --throttle <rate>[:<burst>] Order entry messages per second per session (default: off)\n"
+              << "  --instrument-throttle <rate>[:<burst>] Per session and instrument (default: off)\n"
+              << "  --throttle-delay <ms>   Hold throttled messages up to <ms> instead of rejecting them\n"
+              << "  --fix-port <port>       Start the FIX 4.4 acceptor on this port (default: off)\n"
+              << "  --fix-comp-id <id>      FIX SenderCompID (default: UFAENGINE)\n"
+              << "  --shm-order-entry <name> Accept shared-memory order entry through /dev/shm<name> (default: off)\n"
+              << "  --shm-books <name>      Publish L2 books to /dev/shm<name> for local readers (default: off)\n"
+              << "  --flight-recorder <dir> Dump recent matching events here when an order exceeds the latency threshold\n"
+              << "  --flight-recorder-events <num> Events kept per matching thread (default: 4096)\n"
+              << "  --latency-threshold <us> End-to-end order latency that triggers a dump (default: 100)\n"
+              << "  --jitter-sampler <role>[:<cpu>] Spin a TSC jitter sampler for <role>, pinned to <cpu> (repeatable)\n"
+              << "  --jitter-threshold <ns> Smallest gap the jitter samplers record (default: 1000)\n"
+              << "  --md-udp <group>:<port>[,<group>:<port>] Read market data from UDP multicast line A and optional line B\n"
+              << "  --md-interface <addr>   Local interface for the multicast lines (default: 0.0.0.0)\n"
+              << "  --md-udp-hold <us>      Wait this long for the other line before declaring a gap (default: 200)\n"
+              << "  --md-json <path>        Read JSON market data from a file or unix:<socket path>\n"
+              << "  --md-json-framing <framing> JSON framing: newline or length (default: newline)\n"
+              << "  --md-decimals <price>[:<quantity>] Decimal places kept from JSON prices and sizes (default: 8:0)\n"
+              << "  --md-plugin <path>      Read market data from a feed plugin shared library\n"
+              << "  --md-plugin-config <string> Passed verbatim to the feed plugin\n"
+              << "  --md-replay <file>      Replay a market data recording\n"
+              << "  --md-replay-speed <x>   Replay pace: 1 as recorded, N times faster, 0 as fast as possible (default: 1)\n"
+              << "  --md-replay-max-gap <us> Cap on replayed idle gaps (default: 0, keep them all)\n"
+              << "  --md-record <file>      Record every market data event to this file\n"
               << std::endl;
 }
 
@@ -88,6 +121,180 @@ EngineConfig parse_arguments(int argc, char* argv[]) {
             config.enable_performance_monitoring = false;
         } else if (arg == "--simulate-only") {
             config.simulation_mode = true;
+        } else if (arg == "--no-text-protocol") {
+            config.enable_text_protocol = false;
+        } else if (arg == "--io-uring") {
+            config.network_backend = NetworkBackend::IO_URING;
+        } else if (arg == "--io-per-thread") {
+            config.network_threading = IoThreadingModel::PER_THREAD;
+        } else if (arg == "--affinity") {
+            if (++i < argc) {
+                std::string policy = argv[i];
+                if (policy == "round-robin") {
+                    config.network_affinity = ConnectionAffinity::ROUND_ROBIN;
+                } else if (policy == "address") {
+                    config.network_affinity = ConnectionAffinity::CLIENT_ADDRESS;
+                } else {
+                    std::cerr << "Warning: Unknown affinity policy '" << policy << "', using round-robin" << std::endl;
+                }
+            }
+        } else if (arg == "--reuse-port") {
+            config.network_reuse_port = true;
+        } else if (arg == "--pin-network-threads") {
+            config.pin_network_threads = true;
+        } else if (arg == "--journal-dir") {
+            if (++i < argc) {
+                config.session_journal_directory = argv[i];
+            }
+        } else if (arg == "--heartbeat") {
+            if (++i < argc) {
+                config.heartbeat_interval = std::chrono::seconds(std::stoi(argv[i]));
+            }
+        } else if (arg == "--throttle" || arg == "--instrument-throttle") {
+            if (++i < argc) {
+                std::string limit = argv[i];
+                size_t colon = limit.find(':');
+                uint32_t rate = static_cast<uint32_t>(std::stoul(limit.substr(0, colon)));
+                if (arg == "--throttle") {
+                    config.order_throttle.session_rate = rate;
+                    if (colon != std::string::npos) {
+                        config.order_throttle.session_burst = static_cast<uint32_t>(std::stoul(limit.substr(colon + 1)));
+                    }
+                } else {
+                    config.order_throttle.instrument_rate = rate;
+                    if (colon != std::string::npos) {
+                        config.order_throttle.instrument_burst = static_cast<uint32_t>(std::stoul(limit.substr(colon + 1)));
+                    }
+                }
+            }
+        } else if (arg == "--throttle-delay") {
+            if (++i < argc) {
+                config.order_throttle.action = ThrottleAction::DELAY;
+                config.order_throttle.max_delay = std::chrono::milliseconds(std::stoi(argv[i]));
+            }
+        } else if (arg == "--fix-port") {
+            if (++i < argc) {
+                config.fix_port = std::stoi(argv[i]);
+            }
+        } else if (arg == "--fix-comp-id") {
+            if (++i < argc) {
+                config.fix_sender_comp_id = argv[i];
+            }
+        } else if (arg == "--shm-order-entry") {
+            if (++i < argc) {
+                config.shm_order_entry_name = argv[i];
+            }
+        } else if (arg == "--shm-books") {
+            if (++i < argc) {
+                config.shm_book_name = argv[i];
+            }
+        } else if (arg == "--flight-recorder") {
+            if (++i < argc) {
+                config.flight_recorder_directory = argv[i];
+            }
+        } else if (arg == "--flight-recorder-events") {
+            if (++i < argc) {
+                config.flight_recorder_events = std::stoul(argv[i]);
+            }
+        } else if (arg == "--latency-threshold") {
+            if (++i < argc) {
+                config.max_latency_threshold = std::chrono::microseconds(std::stoul(argv[i]));
+            }
+        } else if (arg == "--jitter-sampler") {
+            if (++i < argc) {
+                std::string spec = argv[i];
+                auto colon = spec.find(':');
+                JitterSamplerSpec sampler;
+                sampler.role = spec.substr(0, colon);
+                if (colon != std::string::npos) {
+                    sampler.cpu = std::stoi(spec.substr(colon + 1));
+                }
+                config.jitter.samplers.push_back(sampler);
+            }
+        } else if (arg == "--jitter-threshold") {
+            if (++i < argc) {
+                config.jitter.gap_threshold = std::chrono::nanoseconds(std::stoul(argv[i]));
+            }
+        } else if (arg == "--md-udp") {
+            if (++i < argc) {
+                // Line A, then an optional line B; without one the feed runs a single line
+                std::string lines = argv[i];
+                size_t comma = lines.find(',');
+                std::string line_a = lines.substr(0, comma);
+                std::string line_b = comma != std::string::npos ? lines.substr(comma + 1) : std::string();
+                size_t colon_a = line_a.rfind(':');
+                size_t colon_b = line_b.rfind(':');
+                if (colon_a == std::string::npos || (!line_b.empty() && colon_b == std::string::npos)) {
+                    std::cerr << "Warning: --md-udp expects <group>:<port>[,<group>:<port>], ignoring '" << lines << "'" << std::endl;
+                    continue;
+                }
+                config.market_data.source_type = DataSourceType::UDP_MULTICAST;
+                config.market_data.multicast_group_a = line_a.substr(0, colon_a);
+                config.market_data.multicast_port_a = static_cast<uint16_t>(std::stoi(line_a.substr(colon_a + 1)));
+                config.market_data.multicast_group_b = line_b.empty() ? std::string() : line_b.substr(0, colon_b);
+                if (!line_b.empty()) {
+                    config.market_data.multicast_port_b = static_cast<uint16_t>(std::stoi(line_b.substr(colon_b + 1)));
+                }
+            }
+        } else if (arg == "--md-interface") {
+            if (++i < argc) {
+                config.market_data.multicast_interface = argv[i];
+            }
+        } else if (arg == "--md-udp-hold") {
+            if (++i < argc) {
+                config.market_data.arbitration_hold = std::chrono::microseconds(std::stoul(argv[i]));
+            }
+        } else if (arg == "--md-json") {
+            if (++i < argc) {
+                config.market_data.source_type = DataSourceType::CRYPTO_EXCHANGE;
+                config.market_data.data_source_url = argv[i];
+            }
+        } else if (arg == "--md-json-framing") {
+            if (++i < argc) {
+                std::string framing = argv[i];
+                if (framing == "newline") {
+                    config.market_data.json_framing = JsonFraming::NEWLINE_DELIMITED;
+                } else if (framing == "length") {
+                    config.market_data.json_framing = JsonFraming::LENGTH_PREFIXED;
+                } else {
+                    std::cerr << "Warning: Unknown JSON framing '" << framing << "', using newline" << std::endl;
+                }
+            }
+        } else if (arg == "--md-decimals") {
+            if (++i < argc) {
+                std::string decimals = argv[i];
+                size_t colon = decimals.find(':');
+                config.market_data.price_decimals = std::stoi(decimals.substr(0, colon));
+                if (colon != std::string::npos) {
+                    config.market_data.quantity_decimals = std::stoi(decimals.substr(colon + 1));
+                }
+            }
+        } else if (arg == "--md-plugin") {
+            if (++i < argc) {
+                config.market_data.source_type = DataSourceType::CUSTOM_FEED;
+                config.market_data.plugin_path = argv[i];
+            }
+        } else if (arg == "--md-plugin-config") {
+            if (++i < argc) {
+                config.market_data.plugin_config = argv[i];
+            }
+        } else if (arg == "--md-replay") {
+            if (++i < argc) {
+                config.market_data.source_type = DataSourceType::REPLAY;
+                config.market_data.data_source_url = argv[i];
+            }
+        } else if (arg == "--md-replay-speed") {
+            if (++i < argc) {
+                config.market_data.replay_speed = std::stod(argv[i]);
+            }
+        } else if (arg == "--md-replay-max-gap") {
+            if (++i < argc) {
+                config.market_data.replay_max_gap = std::chrono::microseconds(std::stoul(argv[i]));
+            }
+        } else if (arg == "--md-record") {
+            if (++i < argc) {
+                config.market_data.record_path = argv[i];
+            }
         } else {
             std::cerr << "Unknown option: " << arg << std::endl;
             print_usage(argv[0]);
@@ -102,6 +309,70 @@ EngineConfig parse_arguments(int argc, char* argv[]) {
 void print_config(const EngineConfig& config) {
     std::cout << "\n=== Engine Configuration ===" << std::endl;
     std::cout << "TCP Port: " << config.tcp_port << std::endl;
+    std::cout << "Network Backend: " << network_backend_name(config.network_backend) << std::endl;
+    if (config.network_backend == NetworkBackend::ASIO) {
+        std::cout << "Network Threading: " << io_threading_model_name(config.network_threading)
+                  << (config.network_reuse_port ? " (SO_REUSEPORT)" : "") << std::endl;
+    }
+    std::cout << "Session Journals: " << (config.session_journal_directory.empty() ? "Memory only" : config.session_journal_directory)
+              << ", heartbeat " << config.heartbeat_interval.count() << "s" << std::endl;
+    if (config.order_throttle.enabled()) {
+        std::cout << "Order Throttle: " << config.order_throttle.session_rate << "/s burst " << config.order_throttle.session_burst
+                  << " per session, " << config.order_throttle.instrument_rate << "/s burst " << config.order_throttle.instrument_burst
+                  << " per instrument, "
+                  << (config.order_throttle.action == ThrottleAction::DELAY
+                          ? "delay up to " + std::to_string(config.order_throttle.max_delay.count()) + "ms"
+                          : std::string("reject")) << std::endl;
+    } else {
+        std::cout << "Order Throttle: Disabled" << std::endl;
+    }
+    std::cout << "FIX Port: " << (config.fix_port ? std::to_string(config.fix_port) : "Disabled") << std::endl;
+    std::cout << "Shared-Memory Order Entry: " << (config.shm_order_entry_name.empty() ? "Disabled" : config.shm_order_entry_name) << std::endl;
+    std::cout << "Shared-Memory Books: " << (config.shm_book_name.empty() ? "Disabled" : config.shm_book_name) << std::endl;
+    if (config.flight_recorder_directory.empty()) {
+        std::cout << "Flight Recorder: Disabled" << std::endl;
+    } else {
+        std::cout << "Flight Recorder: " << config.flight_recorder_directory << ", " << config.flight_recorder_events
+                  << " events per thread, threshold " << config.max_latency_threshold.count() << "us" << std::endl;
+    }
+    if (config.jitter.enabled()) {
+        std::cout << "Jitter Samplers:";
+        for (const auto& sampler : config.jitter.samplers) {
+            std::cout << " " << sampler.role;
+            if (sampler.cpu >= 0) {
+                std::cout << "@" << sampler.cpu;
+            }
+        }
+        std::cout << ", threshold " << config.jitter.gap_threshold.count() << "ns" << std::endl;
+    }
+    const MarketDataConfig& market_data = config.market_data;
+    std::cout << "Market Data Source: ";
+    switch (market_data.source_type) {
+        case DataSourceType::UDP_MULTICAST:
+            std::cout << "UDP " << market_data.multicast_group_a << ":" << market_data.multicast_port_a;
+            if (!market_data.multicast_group_b.empty()) {
+                std::cout << " + " << market_data.multicast_group_b << ":" << market_data.multicast_port_b;
+            }
+            std::cout << " on " << market_data.multicast_interface << ", hold " << market_data.arbitration_hold.count() << "us";
+            break;
+        case DataSourceType::CRYPTO_EXCHANGE:
+            std::cout << "JSON " << market_data.data_source_url
+                      << (market_data.json_framing == JsonFraming::LENGTH_PREFIXED ? " (length-prefixed)" : " (newline)")
+                      << ", " << market_data.price_decimals << "/" << market_data.quantity_decimals << " decimals";
+            break;
+        case DataSourceType::CUSTOM_FEED:
+            std::cout << "Plugin " << market_data.plugin_path;
+            break;
+        case DataSourceType::REPLAY:
+            std::cout << "Replay " << market_data.data_source_url << " at "
+                      << (market_data.replay_speed > 0 ? std::to_string(market_data.replay_speed) + "x" : std::string("full speed"));
+            break;
+        default:
+            std::cout << "Simulated";
+            break;
+    }
+    std::cout << std::endl;
+    std::cout << "Market Data Recording: " << (market_data.record_path.empty() ? "Disabled" : market_data.record_path) << std::endl;
     std::cout << "Matching Threads: " << config.num_matching_threads << std::endl;
     std::cout << "Market Data Threads: " << config.num_market_data_threads << std::endl;
     std::cout << "Ring Buffer Size: " << config.ring_buffer_size << std::endl;
@@ -124,10 +395,20 @@ void run_application(const EngineConfig& config) {
                 return;
             }
             std::cout << "Performance monitor started" << std::endl;
+            if (!performance_monitor->start_jitter_sampling(config.jitter)) {
+                std::cerr << "Some jitter samplers failed to start" << std::endl;
+            }
         }
         
         // Initialize order matching engine
         engine = std::make_unique<OrderMatchingEngine>(config);
+        engine->set_performance_monitor(performance_monitor.get());
+        
+        // Default instruments for the binary order entry protocol
+        const char* default_symbols[] = {"AAPL", "GOOGL", "MSFT", "TSLA", "AMZN"};
+        for (uint32_t i = 0; i < 5; ++i) {
+            engine->register_instrument(i + 1, default_symbols[i], 0.01);
+        }
         
         // Start the engine
         if (!engine->start()) {
@@ -183,6 +464,18 @@ void print_engine_stats() {
     std::cout << "Orders/sec: " << metrics.orders_per_second.load() << std::endl;
     std::cout << "Trades/sec: " << metrics.trades_per_second.load() << std::endl;
     std::cout << "Market Data/sec: " << metrics.market_data_per_second.load() << std::endl;
+    
+    ThrottleStats throttle = engine->get_throttle_stats();
+    if (throttle.rejected > 0 || throttle.delayed > 0) {
+        std::cout << "Throttled: " << throttle.rejected << " rejected, " << throttle.delayed << " delayed ("
+                  << throttle.delay_ns / 1000000 << " ms total)" << std::endl;
+    }
+    
+    FlightRecorderStats flight = engine->get_flight_recorder_stats();
+    if (flight.triggers > 0) {
+        std::cout << "Latency Spikes: " << flight.triggers << " (" << flight.dumps_written << " dumps written, "
+                  << flight.dumps_dropped << " suppressed)" << std::endl;
+    }
     std::cout << "=========================" << std::endl;
 }
 
@@ -1,4 +1,11 @@
 #include "market_data_processor.h"
+#include "thread_name.h"
+#include "replay_market_data_source.h"
+#ifdef __linux__
+#include "udp_market_data_source.h"
+#include "json_market_data_source.h"
+#include "plugin_market_data_source.h"
+#endif
 #include <iostream>
 #include <random>
 #include <chrono>
@@ -107,6 +114,7 @@ void SimulatedMarketDataSource::set_volatility(double volatility) {
 }
 
 void SimulatedMarketDataSource::streaming_thread_worker() {
+    set_current_thread_name("sim_feed");
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_real_distribution<> dis(0.0, 1.0);
@@ -227,12 +235,30 @@ MarketDataProcessor::MarketDataProcessor(const MarketDataConfig& config)
     
     // Initialize ring buffer
     input_buffer_ = std::make_unique<MarketDataRingBuffer<65536>>();
+    recorder_ = std::make_unique<MarketDataRecorder>();
     
     // Create appropriate data source based on config
-    if (config.source_type == DataSourceType::SIMULATED) {
-        data_source_ = std::make_unique<SimulatedMarketDataSource>(config);
+    set_data_source(create_data_source(config));
+}
+
+std::unique_ptr<MarketDataSource> MarketDataProcessor::create_data_source(const MarketDataConfig& config) {
+    switch (config.source_type) {
+        case DataSourceType::SIMULATED:
+            return std::make_unique<SimulatedMarketDataSource>(config);
+        case DataSourceType::REPLAY:
+            return std::make_unique<ReplayMarketDataSource>(config);
+#ifdef __linux__
+        case DataSourceType::UDP_MULTICAST:
+            return std::make_unique<UdpMulticastDataSource>(config);
+        case DataSourceType::CRYPTO_EXCHANGE:
+            return std::make_unique<JsonMarketDataSource>(config);
+        case DataSourceType::CUSTOM_FEED:
+            return std::make_unique<PluginMarketDataSource>(config);
+#endif
+        default:
+            // Add other data source types here as needed
+            return nullptr;
     }
-    // Add other data source types here as needed
 }
 
 MarketDataProcessor::~MarketDataProcessor() {
@@ -245,7 +271,18 @@ bool MarketDataProcessor::start() {
     }
 
     try {
+        // Open the recording before the source starts so no events are missed
+        if (!config_.record_path.empty() && !recorder_->is_recording() &&
+            !recorder_->open(config_.record_path)) {
+            return false;
+        }
+        
         // Start data source
+        if (data_source_ && !data_source_->is_connected() && !data_source_->connect()) {
+            std::cerr << "Failed to connect data source" << std::endl;
+            return false;
+        }
+        
         if (data_source_ && !data_source_->start_streaming()) {
             std::cerr << "Failed to start data source" << std::endl;
             return false;
@@ -289,6 +326,8 @@ void MarketDataProcessor::stop() {
     }
     processing_threads_.clear();
 
+    recorder_->close();
+
     std::cout << "Market data processor stopped" << std::endl;
 }
 
@@ -296,6 +335,25 @@ bool MarketDataProcessor::is_running() const {
     return running_.load();
 }
 
+void MarketDataProcessor::set_data_source(std::unique_ptr<MarketDataSource> source) {
+    if (running_.load()) {
+        std::cerr << "Cannot replace data source while the processor is running" << std::endl;
+        return;
+    }
+    
+    data_source_ = std::move(source);
+    
+    // Route source events through validation and the input buffer
+    if (data_source_) {
+        data_source_->set_data_callback([this](const MarketData& data) {
+            submit_market_data(data);
+        });
+        data_source_->set_error_callback([this](const std::string& error) {
+            handle_processing_error(error);
+        });
+    }
+}
+
 bool MarketDataProcessor::connect_data_source() {
     if (!data_source_) {
         return false;
@@ -320,6 +378,11 @@ bool MarketDataProcessor::submit_market_data(const MarketData& data) {
 
     auto start_time = std::chrono::high_resolution_clock::now();
 
+    // Record before validation so replays reproduce exactly what was received
+    if (recorder_->is_recording()) {
+        recorder_->record(data);
+    }
+
     // Validate data
     if (config_.enable_validation && !validate_market_data(data)) {
         stats_.validation_errors.fetch_add(1);
@@ -354,6 +417,22 @@ void MarketDataProcessor::set_error_callback(std::function<void(const std::strin
     error_callback_ = callback;
 }
 
+bool MarketDataProcessor::start_recording(const std::string& path) {
+    return recorder_->open(path);
+}
+
+void MarketDataProcessor::stop_recording() {
+    recorder_->close();
+}
+
+bool MarketDataProcessor::is_recording() const {
+    return recorder_->is_recording();
+}
+
+const RecorderStats& MarketDataProcessor::get_recorder_stats() const {
+    return recorder_->get_stats();
+}
+
 MarketDataConfig MarketDataProcessor::get_config() const {
     return config_;
 }
@@ -379,6 +458,7 @@ double MarketDataProcessor::get_processing_latency_microseconds() const {
 }
 
 void MarketDataProcessor::processing_thread_worker() {
+    set_current_thread_name("md_processor");
     std::cout << "Market data processing thread started: " << std::this_thread::get_id() << std::endl;
 
     while (!shutdown_requested_.load()) {
@@ -462,7 +542,7 @@ bool MarketDataProcessor::validate_market_data(const MarketData& data) {
     return true;
 }
 
-void MarketDataProcessor::update_statistics(const MarketData& data, uint64_t latency_ns) {
+void MarketDataProcessor::update_statistics(const MarketData& /*data*/, uint64_t latency_ns) {
     stats_.total_latency_ns.fetch_add(latency_ns);
     
     // Update min/max latency
@@ -482,7 +562,7 @@ void MarketDataProcessor::handle_processing_error(const std::string& error) {
     }
 }
 
-void MarketDataProcessor::handle_validation_error(const MarketData& data, const std::string& error) {
+void MarketDataProcessor::handle_validation_error(const MarketData& /*data*/, const std::string& error) {
     stats_.validation_errors.fetch_add(1);
     if (error_callback_) {
         error_callback_(error);
@@ -0,0 +1,183 @@
+#include "market_data_recorder.h"
+#include "thread_name.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <algorithm>
+
+namespace UltraFastAnalysis {
+
+void encode_market_data_record(const MarketData& data, uint64_t receive_timestamp_ns, MarketDataRecord& record) {
+    std::memset(&record, 0, sizeof(record));
+    record.receive_timestamp_ns = receive_timestamp_ns;
+    record.event_timestamp_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(data.timestamp.time_since_epoch()).count());
+    record.sequence_number = data.sequence_number;
+    record.trade_id = data.trade_id;
+    std::memcpy(record.symbol, data.symbol.data(), std::min(data.symbol.size(), sizeof(record.symbol)));
+    record.type = static_cast<uint8_t>(data.type);
+    record.is_bid = data.is_bid ? 1 : 0;
+    record.trade_price = data.trade_price;
+    record.trade_quantity = data.trade_quantity;
+    record.bid_price = data.bid_price;
+    record.bid_quantity = data.bid_quantity;
+    record.ask_price = data.ask_price;
+    record.ask_quantity = data.ask_quantity;
+    record.price = data.price;
+    record.quantity = data.quantity;
+}
+
+void decode_market_data_record(const MarketDataRecord& record, MarketData& data) {
+    data.sequence_number = record.sequence_number;
+    data.symbol.assign(record.symbol, strnlen(record.symbol, sizeof(record.symbol)));
+    data.type = static_cast<MarketDataType>(record.type);
+    data.timestamp = std::chrono::high_resolution_clock::time_point(
+        std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+            std::chrono::nanoseconds(record.event_timestamp_ns)));
+    data.trade_price = record.trade_price;
+    data.trade_quantity = record.trade_quantity;
+    data.trade_id = record.trade_id;
+    data.bid_price = record.bid_price;
+    data.bid_quantity = record.bid_quantity;
+    data.ask_price = record.ask_price;
+    data.ask_quantity = record.ask_quantity;
+    data.price = record.price;
+    data.quantity = record.quantity;
+    data.is_bid = record.is_bid != 0;
+}
+
+MarketDataRecorder::MarketDataRecorder()
+    : ring_(std::make_unique<LockFreeRingBuffer<MarketDataRecord, RING_SIZE>>()) {
+    write_buffer_.resize(4096);
+}
+
+MarketDataRecorder::~MarketDataRecorder() {
+    close();
+}
+
+bool MarketDataRecorder::open(const std::string& path) {
+    if (recording_.load()) {
+        return false;
+    }
+
+    // Discard anything pushed after the previous recording was closed
+    while (drain_ring() > 0) {}
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::cerr << "Failed to open market data recording " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+
+    RecordingFileHeader header{};
+    std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.version = RECORDING_VERSION;
+    header.record_size = sizeof(MarketDataRecord);
+    header.created_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+        std::cerr << "Failed to write recording header to " << path << std::endl;
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    path_ = path;
+    stats_.reset();
+    stats_.bytes_written.store(sizeof(header));
+    shutdown_requested_.store(false);
+    recording_.store(true);
+
+    writer_thread_ = std::thread(&MarketDataRecorder::writer_thread_worker, this);
+    std::cout << "Recording market data to " << path << std::endl;
+    return true;
+}
+
+void MarketDataRecorder::close() {
+    if (!recording_.load()) {
+        return;
+    }
+
+    recording_.store(false);
+    shutdown_requested_.store(true);
+
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+
+    std::fclose(file_);
+    file_ = nullptr;
+
+    std::cout << "Market data recording closed: " << stats_.records_written.load() << " records, "
+              << stats_.records_dropped.load() << " dropped" << std::endl;
+}
+
+bool MarketDataRecorder::is_recording() const {
+    return recording_.load(std::memory_order_relaxed);
+}
+
+bool MarketDataRecorder::record(const MarketData& data) {
+    if (!recording_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    uint64_t receive_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+
+    MarketDataRecord record;
+    encode_market_data_record(data, receive_ns, record);
+
+    if (!ring_->try_push(record)) {
+        stats_.records_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+const RecorderStats& MarketDataRecorder::get_stats() const {
+    return stats_;
+}
+
+std::string MarketDataRecorder::get_path() const {
+    return path_;
+}
+
+void MarketDataRecorder::writer_thread_worker() {
+    set_current_thread_name("md_recorder");
+    while (!shutdown_requested_.load(std::memory_order_relaxed)) {
+        if (drain_ring() == 0) {
+            // Idle; nothing is waiting on the writer so a short sleep is fine
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    // Flush whatever was recorded before close()
+    while (drain_ring() > 0) {}
+    std::fflush(file_);
+}
+
+size_t MarketDataRecorder::drain_ring() {
+    size_t count = 0;
+    while (count < write_buffer_.size() && ring_->try_pop(write_buffer_[count])) {
+        ++count;
+    }
+
+    if (count == 0 || !file_) {
+        return count;
+    }
+
+    size_t written = std::fwrite(write_buffer_.data(), sizeof(MarketDataRecord), count, file_);
+    if (written != count) {
+        stats_.write_errors.fetch_add(1, std::memory_order_relaxed);
+        stats_.records_dropped.fetch_add(count - written, std::memory_order_relaxed);
+    }
+
+    stats_.records_written.fetch_add(written, std::memory_order_relaxed);
+    stats_.bytes_written.fetch_add(written * sizeof(MarketDataRecord), std::memory_order_relaxed);
+    return count;
+}
+
+} // namespace UltraFastAnalysis
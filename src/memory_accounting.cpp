@@ -0,0 +1,89 @@
+#include "memory_accounting.h"
+#include <algorithm>
+#include <atomic>
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+struct alignas(64) SubsystemCounters {
+    std::atomic<uint64_t> live_bytes{0};
+    std::atomic<uint64_t> peak_bytes{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+};
+
+SubsystemCounters subsystem_counters[MEMORY_SUBSYSTEM_COUNT];
+
+SubsystemCounters& counters_for(MemorySubsystem subsystem) {
+    return subsystem_counters[static_cast<size_t>(subsystem)];
+}
+
+} // namespace
+
+const char* memory_subsystem_name(MemorySubsystem subsystem) {
+    switch (subsystem) {
+        case MemorySubsystem::ORDER_BOOKS: return "order_books";
+        case MemorySubsystem::ORDERS: return "orders";
+        case MemorySubsystem::RING_BUFFERS: return "ring_buffers";
+        case MemorySubsystem::TRADE_TAPES: return "trade_tapes";
+        case MemorySubsystem::CONNECTION_BUFFERS: return "connection_buffers";
+        case MemorySubsystem::HISTOGRAMS: return "histograms";
+        case MemorySubsystem::SESSIONS: return "sessions";
+        case MemorySubsystem::COUNT: break;
+    }
+    return "unknown";
+}
+
+void memory_account_allocate(MemorySubsystem subsystem, size_t bytes) noexcept {
+    if (bytes == 0) {
+        return;
+    }
+    SubsystemCounters& counters = counters_for(subsystem);
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    uint64_t live = counters.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    // Only a new high costs more than the add
+    uint64_t peak = counters.peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak &&
+           !counters.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+void memory_account_free(MemorySubsystem subsystem, size_t bytes) noexcept {
+    if (bytes == 0) {
+        return;
+    }
+    SubsystemCounters& counters = counters_for(subsystem);
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+std::array<MemorySubsystemStats, MEMORY_SUBSYSTEM_COUNT> get_memory_subsystem_stats() {
+    std::array<MemorySubsystemStats, MEMORY_SUBSYSTEM_COUNT> result;
+    for (size_t i = 0; i < MEMORY_SUBSYSTEM_COUNT; ++i) {
+        const SubsystemCounters& counters = subsystem_counters[i];
+        MemorySubsystemStats& stats = result[i];
+        stats.name = memory_subsystem_name(static_cast<MemorySubsystem>(i));
+        stats.live_bytes = counters.live_bytes.load(std::memory_order_relaxed);
+        stats.peak_bytes = std::max(counters.peak_bytes.load(std::memory_order_relaxed), stats.live_bytes);
+        stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+        stats.frees = counters.frees.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+uint64_t get_memory_accounted_bytes() {
+    uint64_t total = 0;
+    for (const auto& counters : subsystem_counters) {
+        total += counters.live_bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void reset_memory_subsystem_peaks() {
+    for (auto& counters : subsystem_counters) {
+        counters.peak_bytes.store(counters.live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,41 @@
+#include "network_server.h"
+#include "tcp_server.h"
+#ifdef __linux__
+#include "io_uring_server.h"
+#endif
+#include <iostream>
+
+namespace UltraFastAnalysis {
+
+std::unique_ptr<NetworkServer> create_network_server(NetworkBackend backend, const NetworkServerConfig& config) {
+    if (backend == NetworkBackend::IO_URING) {
+#ifdef __linux__
+        // One event loop thread owns the ring, so the threading options do not apply
+        if (IoUringServer::is_supported()) {
+            return std::make_unique<IoUringServer>(config.port);
+        }
+        std::cerr << "io_uring is not available on this kernel, using the Asio backend" << std::endl;
+#else
+        std::cerr << "io_uring backend requires Linux, using the Asio backend" << std::endl;
+#endif
+    }
+    return std::make_unique<TCPServer>(config);
+}
+
+const char* network_backend_name(NetworkBackend backend) {
+    switch (backend) {
+        case NetworkBackend::ASIO: return "asio";
+        case NetworkBackend::IO_URING: return "io_uring";
+    }
+    return "unknown";
+}
+
+const char* io_threading_model_name(IoThreadingModel model) {
+    switch (model) {
+        case IoThreadingModel::SHARED: return "shared io_context";
+        case IoThreadingModel::PER_THREAD: return "io_context per thread";
+    }
+    return "unknown";
+}
+
+} // namespace UltraFastAnalysis
@@ -1,4 +1,6 @@
 #include "order_book.h"
+#include "perf_counters.h"
+#include "flight_recorder.h"
 #include <algorithm>
 #include <stdexcept>
 #include <iostream>
@@ -34,6 +36,7 @@ bool OrderBook::add_order(std::shared_ptr<Order> order) {
     }
     
     total_orders_++;
+    status_table_.record(*order);
     
     // Process order based on type
     if (order->type == OrderType::MARKET) {
@@ -45,6 +48,7 @@ bool OrderBook::add_order(std::shared_ptr<Order> order) {
     // Try to match orders
     match_orders();
     
+    publish_depth();
     return true;
 }
 
@@ -52,6 +56,7 @@ bool OrderBook::cancel_order(uint64_t order_id) {
     std::unique_lock<std::shared_mutex> lock(rw_mutex_);
     
     auto it = orders_by_id_.find(order_id);
+    flight_record(FlightEventType::CANCEL, order_id, 0, it != orders_by_id_.end() ? 1 : 0);
     if (it == orders_by_id_.end()) {
         return false;
     }
@@ -70,13 +75,48 @@ bool OrderBook::cancel_order(uint64_t order_id) {
     
     // Update order status
     order->status = OrderStatus::CANCELLED;
+    record_execution(*order);
     
     total_orders_--;
     
     cleanup_empty_levels();
+    publish_depth();
     return true;
 }
 
+size_t OrderBook::cancel_client_orders(uint64_t client_id, bool cancel_bids, bool cancel_asks) {
+    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
+    
+    size_t cancelled = 0;
+    for (auto it = orders_by_id_.begin(); it != orders_by_id_.end();) {
+        Order* order = it->second.get();
+        bool side_selected = (order->side == OrderSide::BUY) ? cancel_bids : cancel_asks;
+        
+        if (order->client_id != client_id || !side_selected) {
+            ++it;
+            continue;
+        }
+        
+        if (order->side == OrderSide::BUY) {
+            remove_from_bid_level(order->price, order->order_id);
+        } else {
+            remove_from_ask_level(order->price, order->order_id);
+        }
+        
+        order->status = OrderStatus::CANCELLED;
+        record_execution(*order);
+        it = orders_by_id_.erase(it);
+        total_orders_--;
+        cancelled++;
+    }
+    
+    if (cancelled > 0) {
+        cleanup_empty_levels();
+        publish_depth();
+    }
+    return cancelled;
+}
+
 bool OrderBook::modify_order(uint64_t order_id, uint64_t new_quantity, double new_price) {
     std::unique_lock<std::shared_mutex> lock(rw_mutex_);
     
@@ -98,6 +138,7 @@ bool OrderBook::modify_order(uint64_t order_id, uint64_t new_quantity, double ne
     order->quantity = new_quantity;
     order->price = new_price;
     order->timestamp = std::chrono::high_resolution_clock::now();
+    record_execution(*order);
     
     // Add to new price level
     if (order->side == OrderSide::BUY) {
@@ -110,6 +151,7 @@ bool OrderBook::modify_order(uint64_t order_id, uint64_t new_quantity, double ne
     match_orders();
     
     cleanup_empty_levels();
+    publish_depth();
     return true;
 }
 
@@ -242,6 +284,19 @@ void OrderBook::unlock_for_reading() const {
     rw_mutex_.unlock_shared();
 }
 
+void OrderBook::set_execution_callback(ExecutionCallback callback) {
+    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
+    execution_callback_ = std::move(callback);
+}
+
+void OrderBook::set_depth_callback(DepthCallback callback) {
+    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
+    depth_callback_ = std::move(callback);
+    if (depth_callback_) {
+        publish_depth();
+    }
+}
+
 void OrderBook::lock_for_writing() {
     rw_mutex_.lock();
 }
@@ -250,19 +305,20 @@ void OrderBook::unlock_for_writing() {
     rw_mutex_.unlock();
 }
 
-void OrderBook::process_market_order(std::shared_ptr<Order> order) {
+void OrderBook::process_market_order(std::shared_ptr<Order> /*order*/) {
     // Market orders are immediately matched against the opposite side
     // No need to store them in the order book
     match_orders();
 }
 
-void OrderBook::process_limit_order(std::shared_ptr<Order> order) {
+void OrderBook::process_limit_order(std::shared_ptr<Order> /*order*/) {
     // Limit orders are already added to the price levels
     // Just try to match them
     match_orders();
 }
 
 void OrderBook::match_orders() {
+    PerfScope perf_scope(PerfRegion::MATCH);
     while (!bids_.empty() && !asks_.empty()) {
         double best_bid = bids_.begin()->first;
         double best_ask = asks_.begin()->first;
@@ -291,10 +347,16 @@ void OrderBook::match_orders() {
         
         // Execute the trade
         record_trade(buy_order.get(), sell_order.get(), match_price, match_quantity);
+        flight_record(FlightEventType::TRADE, buy_order->order_id, match_quantity,
+                      static_cast<uint32_t>(sell_order->order_id));
         
         // Update order quantities
         buy_order->filled_quantity += match_quantity;
         sell_order->filled_quantity += match_quantity;
+        buy_order->status = buy_order->is_filled() ? OrderStatus::FILLED : OrderStatus::PARTIALLY_FILLED;
+        sell_order->status = sell_order->is_filled() ? OrderStatus::FILLED : OrderStatus::PARTIALLY_FILLED;
+        record_execution(*buy_order, match_quantity, match_price);
+        record_execution(*sell_order, match_quantity, match_price);
         
         // Remove filled orders
         if (buy_order->is_filled()) {
@@ -319,7 +381,7 @@ void OrderBook::match_orders() {
     }
 }
 
-void OrderBook::record_trade(const Order* buy_order, const Order* sell_order, 
+void OrderBook::record_trade(const Order* /*buy_order*/, const Order* /*sell_order*/, 
                             double price, uint64_t quantity) {
     MarketData trade;
     trade.type = MarketDataType::TRADE;
@@ -340,6 +402,46 @@ void OrderBook::record_trade(const Order* buy_order, const Order* sell_order,
     total_volume_ += price * quantity;
 }
 
+void OrderBook::record_execution(const Order& order, uint64_t fill_quantity, double fill_price) {
+    status_table_.record(order, fill_quantity, fill_price);
+    if (execution_callback_) {
+        execution_callback_(order, fill_quantity, fill_price);
+    }
+}
+
+void OrderBook::publish_depth() {
+    if (!depth_callback_) {
+        return;
+    }
+    
+    auto fill_levels = [](const auto& levels, auto& out) {
+        size_t count = 0;
+        for (const auto& [price, orders] : levels) {
+            if (count == out.size()) break;
+            
+            uint64_t total_quantity = 0;
+            for (const auto& order : orders) {
+                total_quantity += order->remaining_quantity();
+            }
+            if (total_quantity == 0) continue;
+            
+            out[count++] = {price, total_quantity};
+        }
+        return count;
+    };
+    
+    depth_.bid_count = fill_levels(bids_, depth_.bids);
+    depth_.ask_count = fill_levels(asks_, depth_.asks);
+    depth_.update_sequence++;
+    depth_.trade_count = total_trades_;
+    if (!recent_trades_.empty()) {
+        depth_.last_trade_price = recent_trades_.back().trade_price;
+        depth_.last_trade_quantity = recent_trades_.back().trade_quantity;
+    }
+    
+    depth_callback_(symbol_, depth_);
+}
+
 void OrderBook::add_to_bid_level(double price, std::shared_ptr<Order> order) {
     auto& price_level = bids_[price];
     price_level.push_back(order);
@@ -420,6 +522,12 @@ std::shared_ptr<OrderBook> OrderBookManager::get_or_create_order_book(const std:
     }
     
     auto order_book = std::make_shared<OrderBook>(symbol);
+    if (execution_callback_) {
+        order_book->set_execution_callback(execution_callback_);
+    }
+    if (depth_callback_) {
+        order_book->set_depth_callback(depth_callback_);
+    }
     order_books_[symbol] = order_book;
     return order_book;
 }
@@ -454,4 +562,20 @@ void OrderBookManager::remove_order_book(const std::string& symbol) {
     order_books_.erase(symbol);
 }
 
+void OrderBookManager::set_execution_callback(ExecutionCallback callback) {
+    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
+    execution_callback_ = std::move(callback);
+    for (auto& [symbol, order_book] : order_books_) {
+        order_book->set_execution_callback(execution_callback_);
+    }
+}
+
+void OrderBookManager::set_depth_callback(DepthCallback callback) {
+    std::unique_lock<std::shared_mutex> lock(rw_mutex_);
+    depth_callback_ = std::move(callback);
+    for (auto& [symbol, order_book] : order_books_) {
+        order_book->set_depth_callback(depth_callback_);
+    }
+}
+
 } // namespace UltraFastAnalysis
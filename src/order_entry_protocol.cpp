@@ -0,0 +1,79 @@
+#include "order_entry_protocol.h"
+#include "order.h"
+#include <iostream>
+#include <cmath>
+
+namespace UltraFastAnalysis {
+
+bool InstrumentRegistry::register_instrument(uint32_t instrument_id, const std::string& symbol, double tick_size) {
+    if (instrument_id == 0 || instrument_id >= MAX_INSTRUMENT_ID) {
+        std::cerr << "Invalid instrument id " << instrument_id << " for " << symbol << std::endl;
+        return false;
+    }
+
+    if (symbol.empty() || tick_size <= 0.0) {
+        std::cerr << "Invalid instrument definition for id " << instrument_id << std::endl;
+        return false;
+    }
+
+    if (instrument_id >= instruments_.size()) {
+        instruments_.resize(instrument_id + 1);
+    }
+
+    InstrumentInfo& info = instruments_[instrument_id];
+    if (info.instrument_id == 0) {
+        ++count_;
+    } else {
+        auto previous = symbol_index_.find(info.symbol);
+        if (previous != symbol_index_.end() && previous->second == instrument_id) {
+            symbol_index_.erase(previous);
+        }
+    }
+
+    info.instrument_id = instrument_id;
+    info.symbol = symbol;
+    info.tick_size = tick_size;
+    symbol_index_[symbol] = instrument_id;
+    return true;
+}
+
+const InstrumentInfo* InstrumentRegistry::find_by_symbol(std::string_view symbol) const {
+    auto it = symbol_index_.find(symbol);
+    return it != symbol_index_.end() ? &instruments_[it->second] : nullptr;
+}
+
+std::vector<const InstrumentInfo*> InstrumentRegistry::get_instruments() const {
+    std::vector<const InstrumentInfo*> instruments;
+    instruments.reserve(count_);
+    for (const auto& info : instruments_) {
+        if (info.instrument_id != 0) {
+            instruments.push_back(&info);
+        }
+    }
+    return instruments;
+}
+
+int64_t InstrumentRegistry::price_to_ticks(const InstrumentInfo& instrument, double price) {
+    return static_cast<int64_t>(std::llround(price / instrument.tick_size));
+}
+
+OrderRejectReason validate_new_order(const NewOrderMessage& message, const InstrumentInfo* instrument) {
+    if (!instrument) {
+        return OrderRejectReason::UNKNOWN_INSTRUMENT;
+    }
+    if (message.quantity == 0) {
+        return OrderRejectReason::INVALID_QUANTITY;
+    }
+    if (message.side > static_cast<uint8_t>(OrderSide::SELL)) {
+        return OrderRejectReason::INVALID_SIDE;
+    }
+    if (message.order_type > static_cast<uint8_t>(OrderType::STOP_LIMIT)) {
+        return OrderRejectReason::INVALID_ORDER_TYPE;
+    }
+    if (static_cast<OrderType>(message.order_type) != OrderType::MARKET && message.price <= 0) {
+        return OrderRejectReason::INVALID_PRICE;
+    }
+    return OrderRejectReason::NONE;
+}
+
+} // namespace UltraFastAnalysis
@@ -1,6 +1,11 @@
 #include "order_matching_engine.h"
-#include "tcp_server.h"
+#include "thread_name.h"
+#include "fix_gateway.h"
+#include "shm_order_entry.h"
+#include "shm_book_publisher.h"
 #include "market_data_processor.h"
+#include "flight_recorder.h"
+#include "perf_counters.h"
 #include <iostream>
 #include <chrono>
 #include <algorithm>
@@ -16,23 +21,131 @@ OrderMatchingEngine::OrderMatchingEngine(const EngineConfig& config)
     
     // Initialize core components
     order_book_manager_ = std::make_unique<OrderBookManager>();
-    tcp_server_ = std::make_unique<TCPServer>(8080, config.num_matching_threads);
-    market_data_processor_ = std::make_unique<MarketDataProcessor>();
-    
-    // Set up TCP server callbacks
-    tcp_server_->set_order_submit_callback([this](std::shared_ptr<Order> order) {
-        submit_order(order);
+    NetworkServerConfig network_config;
+    network_config.port = config.tcp_port;
+    network_config.num_threads = config.num_matching_threads;
+    network_config.threading = config.network_threading;
+    network_config.affinity = config.network_affinity;
+    network_config.reuse_port = config.network_reuse_port;
+    network_config.pin_threads = config.pin_network_threads;
+    network_server_ = create_network_server(config.network_backend, network_config);
+    market_data_processor_ = std::make_unique<MarketDataProcessor>(config.market_data);
+    
+    // Set up network server callbacks
+    network_server_->set_order_submit_callback([this](std::shared_ptr<Order> order) {
+        return submit_order(order);
     });
     
-    tcp_server_->set_order_cancel_callback([this](uint64_t order_id, const std::string& symbol) {
+    network_server_->set_order_cancel_callback([this](uint64_t order_id, const std::string& symbol) {
         cancel_order(order_id, symbol);
     });
     
-    tcp_server_->set_order_modify_callback([this](uint64_t order_id, const std::string& symbol, 
+    network_server_->set_order_modify_callback([this](uint64_t order_id, const std::string& symbol, 
                                                  uint64_t new_quantity, double new_price) {
         modify_order(order_id, symbol, new_quantity, new_price);
     });
     
+    network_server_->set_order_mass_cancel_callback([this](uint64_t client_id, const std::string& symbol,
+                                                      MassCancelSide side) {
+        mass_cancel(client_id, symbol, side != MassCancelSide::SELL, side != MassCancelSide::BUY);
+    });
+    
+    network_server_->set_order_status_callback([this](uint64_t order_id, const std::string& symbol,
+                                                      OrderStatusEntry& entry) {
+        return get_order_status(order_id, symbol, entry);
+    });
+    
+    network_server_->set_text_protocol_enabled(config.enable_text_protocol);
+    
+    SessionConfig session_config;
+    session_config.journal_directory = config.session_journal_directory;
+    session_config.heartbeat_interval = config.heartbeat_interval;
+    session_config.throttle = config.order_throttle;
+    network_server_->set_session_config(session_config);
+    
+    // Optional FIX acceptor; sessions acknowledge from these results and get fills from the books
+    if (config.fix_port != 0) {
+        FixGatewayConfig fix_config;
+        fix_config.port = config.fix_port;
+        fix_config.sender_comp_id = config.fix_sender_comp_id;
+        fix_gateway_ = std::make_unique<FixGateway>(fix_config);
+        
+        fix_gateway_->set_order_submit_callback([this](std::shared_ptr<Order> order) {
+            return submit_order(order);
+        });
+        
+        fix_gateway_->set_order_cancel_callback([this](uint64_t order_id, const std::string& symbol) {
+            return cancel_order(order_id, symbol);
+        });
+        
+        fix_gateway_->set_order_modify_callback([this](uint64_t order_id, const std::string& symbol,
+                                                      uint64_t new_quantity, double new_price) {
+            return modify_order(order_id, symbol, new_quantity, new_price);
+        });
+    }
+    
+    // Optional shared-memory order entry; its clients get execution reports straight from the books
+    if (!config.shm_order_entry_name.empty()) {
+        ShmOrderEntryConfig shm_config;
+        shm_config.name = config.shm_order_entry_name;
+        shm_order_entry_ = std::make_unique<ShmOrderEntryGateway>(shm_config, network_server_->get_instrument_registry());
+        
+        shm_order_entry_->set_order_submit_callback([this](std::shared_ptr<Order> order) {
+            return submit_order(order);
+        });
+        
+        shm_order_entry_->set_order_cancel_callback([this](uint64_t order_id, const std::string& symbol) {
+            return cancel_order(order_id, symbol);
+        });
+        
+        shm_order_entry_->set_order_modify_callback([this](uint64_t order_id, const std::string& symbol,
+                                                          uint64_t new_quantity, double new_price) {
+            return modify_order(order_id, symbol, new_quantity, new_price);
+        });
+        
+        shm_order_entry_->set_order_mass_cancel_callback([this](uint64_t client_id, const std::string& symbol,
+                                                               MassCancelSide side) {
+            return mass_cancel(client_id, symbol, side != MassCancelSide::SELL, side != MassCancelSide::BUY);
+        });
+        
+        shm_order_entry_->set_order_status_callback([this](uint64_t order_id, const std::string& symbol,
+                                                          OrderStatusEntry& entry) {
+            return get_order_status(order_id, symbol, entry);
+        });
+    }
+    
+    // Books report fills, cancels and amends; each gateway picks out its own clients' orders
+    if (fix_gateway_ || shm_order_entry_) {
+        order_book_manager_->set_execution_callback([this](const Order& order, uint64_t fill_quantity, double fill_price) {
+            if (fix_gateway_) {
+                fix_gateway_->on_execution(order, fill_quantity, fill_price);
+            }
+            if (shm_order_entry_) {
+                shm_order_entry_->on_execution(order, fill_quantity, fill_price);
+            }
+        });
+    }
+    
+    // Optional shared-memory books; each book publishes its own depth on change
+    if (!config.shm_book_name.empty()) {
+        ShmBookConfig book_config;
+        book_config.name = config.shm_book_name;
+        book_publisher_ = std::make_unique<ShmBookPublisher>(book_config);
+        
+        order_book_manager_->set_depth_callback([this](const std::string& symbol, const BookDepth& depth) {
+            book_publisher_->publish(symbol, depth);
+        });
+    }
+    
+    // Optional flight recorder; matching threads register with it once started
+    if (!config.flight_recorder_directory.empty()) {
+        FlightRecorderConfig recorder_config;
+        recorder_config.directory = config.flight_recorder_directory;
+        recorder_config.events_per_thread = config.flight_recorder_events;
+        recorder_config.threshold = config.max_latency_threshold;
+        flight_recorder_ = std::make_unique<FlightRecorder>(recorder_config);
+    }
+    
     // Set up market data processor callback
     market_data_processor_->set_data_callback([this](const MarketData& data) {
         submit_market_data(data);
@@ -49,19 +162,63 @@ bool OrderMatchingEngine::start() {
     }
     
     try {
-        // Start TCP server
-        if (!tcp_server_->start()) {
-            std::cerr << "Failed to start TCP server" << std::endl;
+        // Start network server
+        if (!network_server_->start()) {
+            std::cerr << "Failed to start network server" << std::endl;
+            return false;
+        }
+        
+        // Start FIX gateway
+        if (fix_gateway_ && !fix_gateway_->start()) {
+            std::cerr << "Failed to start FIX gateway" << std::endl;
+            network_server_->stop();
+            return false;
+        }
+        
+        // Start shared-memory book publication before anything can change a book
+        if (book_publisher_ && !book_publisher_->start()) {
+            std::cerr << "Failed to start shared-memory book publisher" << std::endl;
+            network_server_->stop();
+            if (fix_gateway_) {
+                fix_gateway_->stop();
+            }
+            return false;
+        }
+        
+        // Start shared-memory order entry
+        if (shm_order_entry_ && !shm_order_entry_->start()) {
+            std::cerr << "Failed to start shared-memory order entry" << std::endl;
+            network_server_->stop();
+            if (fix_gateway_) {
+                fix_gateway_->stop();
+            }
+            if (book_publisher_) {
+                book_publisher_->stop();
+            }
             return false;
         }
         
         // Start market data processor
         if (!market_data_processor_->start()) {
             std::cerr << "Failed to start market data processor" << std::endl;
-            tcp_server_->stop();
+            network_server_->stop();
+            if (fix_gateway_) {
+                fix_gateway_->stop();
+            }
+            if (shm_order_entry_) {
+                shm_order_entry_->stop();
+            }
+            if (book_publisher_) {
+                book_publisher_->stop();
+            }
             return false;
         }
         
+        // A diagnostic only; the engine runs without it
+        if (flight_recorder_ && !flight_recorder_->start()) {
+            std::cerr << "Flight recorder disabled" << std::endl;
+        }
+        
         // Start matching threads
         for (size_t i = 0; i < config_.num_matching_threads; ++i) {
             matching_threads_.emplace_back(&OrderMatchingEngine::matching_thread_worker, this);
@@ -102,9 +259,19 @@ void OrderMatchingEngine::stop() {
     // Signal shutdown
     shutdown_requested_.store(true);
     
-    // Stop TCP server
-    if (tcp_server_) {
-        tcp_server_->stop();
+    // Stop network server
+    if (network_server_) {
+        network_server_->stop();
+    }
+    
+    // Stop FIX gateway
+    if (fix_gateway_) {
+        fix_gateway_->stop();
+    }
+    
+    // Stop shared-memory order entry
+    if (shm_order_entry_) {
+        shm_order_entry_->stop();
     }
     
     // Stop market data processor
@@ -131,6 +298,16 @@ void OrderMatchingEngine::stop() {
         metrics_thread_.join();
     }
     
+    // Matching threads flushed their rings on exit; write what they queued
+    if (flight_recorder_) {
+        flight_recorder_->stop();
+    }
+    
+    // Readers keep the last published books until the segment is recreated
+    if (book_publisher_) {
+        book_publisher_->stop();
+    }
+    
     running_.store(false);
     shutdown_requested_.store(false);
     
@@ -158,6 +335,9 @@ bool OrderMatchingEngine::submit_order(std::shared_ptr<Order> order) {
     auto end_time = std::chrono::high_resolution_clock::now();
     auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
     update_performance_metrics(latency.count());
+    if (performance_monitor_) {
+        performance_monitor_->record_latency(submit_latency_, static_cast<uint64_t>(latency.count()));
+    }
     
     return true;
 }
@@ -189,6 +369,36 @@ bool OrderMatchingEngine::modify_order(uint64_t order_id, const std::string& sym
     return order_book->modify_order(order_id, new_quantity, new_price);
 }
 
+size_t OrderMatchingEngine::mass_cancel(uint64_t client_id, const std::string& symbol,
+                                        bool cancel_bids, bool cancel_asks) {
+    if (!running_.load()) {
+        return 0;
+    }
+    
+    // An empty symbol cancels the client's orders in every book
+    if (!symbol.empty()) {
+        auto order_book = order_book_manager_->get_order_book(symbol);
+        return order_book ? order_book->cancel_client_orders(client_id, cancel_bids, cancel_asks) : 0;
+    }
+    
+    size_t cancelled = 0;
+    for (const auto& book_symbol : order_book_manager_->get_symbols()) {
+        auto order_book = order_book_manager_->get_order_book(book_symbol);
+        if (order_book) {
+            cancelled += order_book->cancel_client_orders(client_id, cancel_bids, cancel_asks);
+        }
+    }
+    return cancelled;
+}
+
+bool OrderMatchingEngine::register_instrument(uint32_t instrument_id, const std::string& symbol, double tick_size) {
+    if (running_.load()) {
+        std::cerr << "Instruments must be registered before the engine starts" << std::endl;
+        return false;
+    }
+    return network_server_->get_instrument_registry().register_instrument(instrument_id, symbol, tick_size);
+}
+
 bool OrderMatchingEngine::submit_market_data(const MarketData& data) {
     if (!running_.load()) {
         return false;
@@ -211,6 +421,11 @@ std::shared_ptr<OrderBook> OrderMatchingEngine::get_order_book(const std::string
     return order_book_manager_->get_order_book(symbol);
 }
 
+bool OrderMatchingEngine::get_order_status(uint64_t order_id, const std::string& symbol, OrderStatusEntry& entry) const {
+    auto order_book = order_book_manager_->get_order_book(symbol);
+    return order_book && order_book->get_status_table().lookup(order_id, entry);
+}
+
 OrderBookSnapshot OrderMatchingEngine::get_order_book_snapshot(const std::string& symbol) const {
     auto order_book = order_book_manager_->get_order_book(symbol);
     if (!order_book) {
@@ -223,6 +438,19 @@ const PerformanceMetrics& OrderMatchingEngine::get_performance_metrics() const {
     return metrics_;
 }
 
+void OrderMatchingEngine::set_performance_monitor(PerformanceMonitor* monitor) {
+    if (running_.load()) {
+        std::cerr << "The performance monitor must be set before the engine starts" << std::endl;
+        return;
+    }
+    performance_monitor_ = monitor;
+    if (monitor) {
+        submit_latency_ = monitor->register_latency_metric("order.submit");
+        match_latency_ = monitor->register_latency_metric("order.match");
+        end_to_end_latency_ = monitor->register_latency_metric("order.end_to_end");
+    }
+}
+
 void OrderMatchingEngine::reset_performance_metrics() {
     metrics_.reset();
 }
@@ -237,6 +465,14 @@ void OrderMatchingEngine::update_config(const EngineConfig& config) {
     config_ = config;
 }
 
+ThrottleStats OrderMatchingEngine::get_throttle_stats() const {
+    return network_server_->get_throttle_stats();
+}
+
+FlightRecorderStats OrderMatchingEngine::get_flight_recorder_stats() const {
+    return flight_recorder_ ? flight_recorder_->get_stats() : FlightRecorderStats{};
+}
+
 size_t OrderMatchingEngine::get_total_order_count() const {
     size_t total = 0;
     auto symbols = order_book_manager_->get_symbols();
@@ -267,31 +503,56 @@ std::vector<std::string> OrderMatchingEngine::get_active_symbols() const {
 
 void OrderMatchingEngine::matching_thread_worker() {
     std::cout << "Matching thread started: " << std::this_thread::get_id() << std::endl;
+    std::string thread_name = "matching" + std::to_string(matching_thread_index_.fetch_add(1));
+    set_current_thread_name(thread_name);
+    if (config_.enable_performance_monitoring) {
+        perf_register_thread(thread_name);
+        sched_register_thread(thread_name);
+    }
+    if (flight_recorder_) {
+        flight_recorder_->register_thread(thread_name);
+    }
     
     while (!shutdown_requested_.load()) {
         process_order_batch();
+        sched_sample_thread();
         
         // Small sleep to prevent busy waiting
         std::this_thread::sleep_for(std::chrono::microseconds(1));
     }
     
+    if (flight_recorder_) {
+        flight_recorder_->unregister_thread();
+    }
+    perf_unregister_thread();
+    sched_unregister_thread();
     std::cout << "Matching thread stopped: " << std::this_thread::get_id() << std::endl;
 }
 
 void OrderMatchingEngine::market_data_thread_worker() {
     std::cout << "Market data thread started: " << std::this_thread::get_id() << std::endl;
+    std::string thread_name = "market_data" + std::to_string(market_data_thread_index_.fetch_add(1));
+    set_current_thread_name(thread_name);
+    if (config_.enable_performance_monitoring) {
+        perf_register_thread(thread_name);
+        sched_register_thread(thread_name);
+    }
     
     while (!shutdown_requested_.load()) {
         process_market_data_batch();
+        sched_sample_thread();
         
         // Small sleep to prevent busy waiting
         std::this_thread::sleep_for(std::chrono::microseconds(1));
     }
     
+    perf_unregister_thread();
+    sched_unregister_thread();
     std::cout << "Market data thread stopped: " << std::this_thread::get_id() << std::endl;
 }
 
 void OrderMatchingEngine::metrics_thread_worker() {
+    set_current_thread_name("metrics");
     std::cout << "Metrics thread started: " << std::this_thread::get_id() << std::endl;
     
     auto last_update = std::chrono::high_resolution_clock::now();
@@ -328,12 +589,49 @@ void OrderMatchingEngine::process_order_batch() {
         return;
     }
     
+    PerfScope perf_scope(PerfRegion::ORDER_BATCH);
+    perf_scope.add_items(orders.size());
+    
+    FlightRing* flight_ring = current_flight_ring();
+    if (flight_ring) {
+        flight_ring->record(FlightEventType::BATCH, 0, orders.size(), static_cast<uint32_t>(order_buffer_->size()));
+    }
+    
     // Process orders
     for (auto& order : orders) {
+        if (flight_ring) {
+            flight_ring->record(FlightEventType::ORDER_IN, order->order_id, order->quantity,
+                                static_cast<uint32_t>(order_buffer_->size()));
+        }
+        
         auto order_book = order_book_manager_->get_or_create_order_book(order->symbol);
-        if (order_book->add_order(order)) {
+        auto match_start = performance_monitor_ ? std::chrono::high_resolution_clock::now()
+                                                : std::chrono::high_resolution_clock::time_point{};
+        bool accepted = order_book->add_order(order);
+        if (accepted) {
             metrics_.orders_processed.fetch_add(1, std::memory_order_relaxed);
         }
+        if (!flight_ring && !performance_monitor_) {
+            continue;
+        }
+        
+        auto now = std::chrono::high_resolution_clock::now();
+        if (performance_monitor_) {
+            performance_monitor_->record_latency(match_latency_, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - match_start).count()));
+        }
+        
+        // End to end: from order creation at the gateway until the book has it
+        if (order->timestamp.time_since_epoch().count() != 0) {
+            uint64_t latency_ns = static_cast<uint64_t>(std::max<int64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - order->timestamp).count(), 0));
+            if (performance_monitor_) {
+                performance_monitor_->record_latency(end_to_end_latency_, latency_ns);
+            }
+            if (flight_ring) {
+                flight_ring->order_done(order->order_id, latency_ns, accepted);
+            }
+        }
     }
 }
 
@@ -0,0 +1,139 @@
+#include "order_status_table.h"
+#include <algorithm>
+#include <bit>
+#include <thread>
+
+namespace UltraFastAnalysis {
+
+OrderStatusTable::OrderStatusTable(size_t capacity) {
+    size_t slots = std::bit_ceil(std::max(capacity, PROBE_LIMIT));
+    slots_ = std::make_unique<Slot[]>(slots);
+    mask_ = slots - 1;
+    slots_memory_.resize(slots * sizeof(Slot));
+}
+
+void OrderStatusTable::record(const Order& order, uint64_t fill_quantity, double fill_price) {
+    if (order.order_id == 0) {
+        return;
+    }
+    Slot& slot = find_slot_for_write(order.order_id);
+
+    // The writer is the only thread changing the slot, so it reads its own fields directly
+    double average_price = 0.0;
+    if (slot.order_id.load(std::memory_order_relaxed) == order.order_id) {
+        average_price = slot.average_price.load(std::memory_order_relaxed);
+    }
+    if (fill_quantity > 0 && order.filled_quantity >= fill_quantity) {
+        uint64_t previous = order.filled_quantity - fill_quantity;
+        average_price = (average_price * static_cast<double>(previous) +
+                         fill_price * static_cast<double>(fill_quantity)) /
+                        static_cast<double>(order.filled_quantity);
+    }
+
+    uint64_t update_sequence = update_count_.load(std::memory_order_relaxed) + 1;
+    update_count_.store(update_sequence, std::memory_order_relaxed);
+
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.order_id.store(order.order_id, std::memory_order_relaxed);
+    slot.client_id.store(order.client_id, std::memory_order_relaxed);
+    slot.quantity.store(order.quantity, std::memory_order_relaxed);
+    slot.filled_quantity.store(order.filled_quantity, std::memory_order_relaxed);
+    slot.average_price.store(average_price, std::memory_order_relaxed);
+    slot.update_sequence.store(update_sequence, std::memory_order_relaxed);
+    slot.status.store(static_cast<uint8_t>(order.status), std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool OrderStatusTable::lookup(uint64_t order_id, OrderStatusEntry& entry) const {
+    if (order_id == 0) {
+        return false;
+    }
+
+    size_t home = home_slot(order_id);
+    for (size_t i = 0; i < PROBE_LIMIT; ++i) {
+        const Slot& slot = slots_[(home + i) & mask_];
+        if (slot.order_id.load(std::memory_order_relaxed) != order_id) {
+            continue;
+        }
+        // The slot may have been reused between the check and the read
+        if (read_slot(slot, entry) && entry.order_id == order_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t OrderStatusTable::home_slot(uint64_t order_id) const {
+    // Order ids are client id and per-client counter; mixing spreads both halves
+    return static_cast<size_t>((order_id * 0x9E3779B97F4A7C15ULL) >> 32) & mask_;
+}
+
+OrderStatusTable::Slot& OrderStatusTable::find_slot_for_write(uint64_t order_id) {
+    size_t home = home_slot(order_id);
+    Slot* empty = nullptr;
+    Slot* oldest_finished = nullptr;
+    Slot* oldest = nullptr;
+
+    for (size_t i = 0; i < PROBE_LIMIT; ++i) {
+        Slot& slot = slots_[(home + i) & mask_];
+        uint64_t slot_order = slot.order_id.load(std::memory_order_relaxed);
+        if (slot_order == order_id) {
+            return slot;
+        }
+        if (slot_order == 0) {
+            if (!empty) {
+                empty = &slot;
+            }
+            continue;
+        }
+
+        uint64_t age = slot.update_sequence.load(std::memory_order_relaxed);
+        if (!oldest || age < oldest->update_sequence.load(std::memory_order_relaxed)) {
+            oldest = &slot;
+        }
+        if (is_finished(static_cast<OrderStatus>(slot.status.load(std::memory_order_relaxed))) &&
+            (!oldest_finished || age < oldest_finished->update_sequence.load(std::memory_order_relaxed))) {
+            oldest_finished = &slot;
+        }
+    }
+
+    if (empty) {
+        return *empty;
+    }
+    return oldest_finished ? *oldest_finished : *oldest;
+}
+
+bool OrderStatusTable::read_slot(const Slot& slot, OrderStatusEntry& entry) {
+    // Retry until a read saw no write in progress and no write in between
+    for (;;) {
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            // The writer may have been preempted mid-write; let it finish
+            std::this_thread::yield();
+            continue;
+        }
+
+        entry.order_id = slot.order_id.load(std::memory_order_relaxed);
+        entry.client_id = slot.client_id.load(std::memory_order_relaxed);
+        entry.quantity = slot.quantity.load(std::memory_order_relaxed);
+        entry.filled_quantity = slot.filled_quantity.load(std::memory_order_relaxed);
+        entry.average_price = slot.average_price.load(std::memory_order_relaxed);
+        entry.update_sequence = slot.update_sequence.load(std::memory_order_relaxed);
+        entry.status = static_cast<OrderStatus>(slot.status.load(std::memory_order_relaxed));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            return entry.order_id != 0;
+        }
+    }
+}
+
+bool OrderStatusTable::is_finished(OrderStatus status) {
+    return status == OrderStatus::FILLED || status == OrderStatus::CANCELLED || status == OrderStatus::REJECTED;
+}
+
+} // namespace UltraFastAnalysis
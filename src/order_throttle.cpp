@@ -0,0 +1,85 @@
+#include "order_throttle.h"
+#include <algorithm>
+
+namespace UltraFastAnalysis {
+
+// TokenBucket implementation
+void TokenBucket::configure(uint32_t rate, uint32_t burst, uint64_t ticks_per_second) {
+    if (rate == 0) {
+        interval_ = 0;
+        return;
+    }
+    interval_ = std::max<uint64_t>(ticks_per_second / rate, 1);
+    capacity_ = interval_ * std::max<uint32_t>(burst, 1);
+    level_ = capacity_;     // A new session starts with a full burst
+    last_ = TscClock::now();
+}
+
+uint64_t TokenBucket::wait_ticks(uint64_t now) {
+    if (now > last_) {
+        level_ = std::min(capacity_, level_ + (now - last_));
+        last_ = now;
+    }
+    return level_ >= interval_ ? 0 : interval_ - level_;
+}
+
+// OrderThrottle implementation
+void OrderThrottle::configure(const ThrottleConfig& config, ThrottleCounters* counters) {
+    config_ = config;
+    counters_ = counters;
+    enabled_ = config.enabled();
+    instrument_buckets_.clear();
+    if (!enabled_) {
+        return;
+    }
+
+    ticks_per_second_ = TscClock::ticks_per_second();
+    max_delay_ticks_ = static_cast<uint64_t>(
+        static_cast<unsigned __int128>(ticks_per_second_) * static_cast<uint64_t>(config.max_delay.count()) / 1000);
+    session_bucket_.configure(config.session_rate, config.session_burst, ticks_per_second_);
+}
+
+uint64_t OrderThrottle::acquire(uint32_t instrument_id, uint64_t now) {
+    uint64_t wait = session_bucket_.enabled() ? session_bucket_.wait_ticks(now) : 0;
+
+    TokenBucket* instrument_bucket = nullptr;
+    if (config_.instrument_rate != 0) {
+        auto [it, inserted] = instrument_buckets_.try_emplace(instrument_id);
+        if (inserted) {
+            it->second.configure(config_.instrument_rate, config_.instrument_burst, ticks_per_second_);
+        }
+        instrument_bucket = &it->second;
+        wait = std::max(wait, instrument_bucket->wait_ticks(now));
+    }
+
+    // Charge nothing unless both limits admit the message
+    if (wait != 0) {
+        return wait;
+    }
+    if (session_bucket_.enabled()) {
+        session_bucket_.take();
+    }
+    if (instrument_bucket) {
+        instrument_bucket->take();
+    }
+    if (counters_) {
+        counters_->admitted.fetch_add(1, std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+void OrderThrottle::record_rejected() {
+    if (counters_) {
+        counters_->rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void OrderThrottle::record_delayed(uint64_t ticks) {
+    if (counters_) {
+        counters_->delayed.fetch_add(1, std::memory_order_relaxed);
+        counters_->delay_ns.fetch_add(static_cast<uint64_t>(TscClock::to_duration(ticks).count()),
+                                      std::memory_order_relaxed);
+    }
+}
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,387 @@
+#include "perf_counters.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define UFA_PERF_EVENTS 1
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#define UFA_PERF_RDPMC 1
+#endif
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<PerfThreadCounters>> registry;
+
+thread_local PerfThreadCounters* thread_counters = nullptr;   // Registered by this thread
+thread_local PerfThreadCounters* scope_counters = nullptr;    // Same, when rdpmc works
+
+#ifdef UFA_PERF_EVENTS
+
+struct EventSpec {
+    uint32_t type;
+    uint64_t config;
+};
+
+const EventSpec HARDWARE_EVENTS[PERF_HARDWARE_EVENT_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                         (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+int perf_event_open(perf_event_attr* attr, int group_fd) {
+    // This thread, any CPU
+    return static_cast<int>(syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0));
+}
+
+perf_event_attr make_attr(uint32_t type, uint64_t config, bool leader) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = leader ? 1 : 0;   // The group starts once complete
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    if (leader) {
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    }
+    return attr;
+}
+
+#ifdef UFA_PERF_RDPMC
+// Self-monitoring read of a counter from its mmapped page (see perf_event_open(2)).
+// Fails while the counter is not scheduled on this CPU, e.g. when multiplexed out.
+bool rdpmc_read(const perf_event_mmap_page* page, uint64_t& value) {
+    uint32_t seq;
+    bool ok;
+    do {
+        seq = page->lock;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        uint32_t index = page->index;
+        int64_t count = page->offset;
+        ok = page->cap_user_rdpmc && index != 0;
+        if (ok) {
+            uint32_t width = page->pmc_width;
+            int64_t pmc = static_cast<int64_t>(__rdpmc(static_cast<int>(index - 1)));
+            pmc <<= 64 - width;
+            pmc >>= 64 - width;
+            count += pmc;
+        }
+        value = static_cast<uint64_t>(count);
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    } while (page->lock != seq);
+    return ok;
+}
+#endif
+
+#endif // UFA_PERF_EVENTS
+
+} // namespace
+
+const char* perf_event_name(PerfEvent event) {
+    switch (event) {
+        case PerfEvent::CYCLES: return "cycles";
+        case PerfEvent::INSTRUCTIONS: return "instructions";
+        case PerfEvent::L1D_MISSES: return "l1d_misses";
+        case PerfEvent::LLC_MISSES: return "llc_misses";
+        case PerfEvent::BRANCH_MISSES: return "branch_misses";
+        case PerfEvent::CONTEXT_SWITCHES: return "context_switches";
+    }
+    return "unknown";
+}
+
+const char* perf_region_name(PerfRegion region) {
+    switch (region) {
+        case PerfRegion::ORDER_BATCH: return "order_batch";
+        case PerfRegion::MATCH: return "match";
+    }
+    return "unknown";
+}
+
+// PerfCounts implementation
+double PerfCounts::ipc() const {
+    uint64_t cycles = get(PerfEvent::CYCLES);
+    return cycles == 0 ? 0.0 : static_cast<double>(get(PerfEvent::INSTRUCTIONS)) / static_cast<double>(cycles);
+}
+
+double PerfCounts::per_item(PerfEvent event) const {
+    uint64_t divisor = items != 0 ? items : calls;
+    return divisor == 0 ? 0.0 : static_cast<double>(get(event)) / static_cast<double>(divisor);
+}
+
+void PerfCounts::add(const PerfCounts& other) {
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        values[i] += other.values[i];
+    }
+    calls += other.calls;
+    items += other.items;
+}
+
+// PerfThreadCounters implementation
+PerfThreadCounters::PerfThreadCounters(const std::string& name) : name_(name) {
+    fds_.fill(-1);
+    pages_.fill(nullptr);
+}
+
+PerfThreadCounters::~PerfThreadCounters() {
+    close();
+}
+
+bool PerfThreadCounters::open() {
+#ifdef UFA_PERF_EVENTS
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+
+    // Whatever the PMU lacks is skipped; the first event that opens leads the group
+    for (size_t i = 0; i < PERF_HARDWARE_EVENT_COUNT; ++i) {
+        perf_event_attr attr = make_attr(HARDWARE_EVENTS[i].type, HARDWARE_EVENTS[i].config, group_fd_ < 0);
+        int fd = perf_event_open(&attr, group_fd_);
+        if (fd < 0) {
+            continue;
+        }
+        fds_[i] = fd;
+        if (group_fd_ < 0) {
+            group_fd_ = fd;
+        }
+    }
+
+    // Switches happen in the kernel, so excluding it counts nothing; retry if paranoid forbids it
+    perf_event_attr attr = make_attr(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, false);
+    attr.exclude_kernel = 0;
+    context_switch_fd_ = perf_event_open(&attr, -1);
+    if (context_switch_fd_ < 0) {
+        attr.exclude_kernel = 1;
+        context_switch_fd_ = perf_event_open(&attr, -1);
+    }
+
+    if (group_fd_ < 0 && context_switch_fd_ < 0) {
+        return false;
+    }
+
+#ifdef UFA_PERF_RDPMC
+    // rdpmc needs every hardware counter mapped and readable from user space
+    page_size_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    rdpmc_ = group_fd_ >= 0;
+    for (size_t i = 0; i < PERF_HARDWARE_EVENT_COUNT && rdpmc_; ++i) {
+        if (fds_[i] < 0) {
+            continue;
+        }
+        void* page = mmap(nullptr, page_size_, PROT_READ, MAP_SHARED, fds_[i], 0);
+        if (page == MAP_FAILED) {
+            rdpmc_ = false;
+            break;
+        }
+        pages_[i] = page;
+        rdpmc_ = static_cast<const perf_event_mmap_page*>(page)->cap_user_rdpmc != 0;
+    }
+#endif
+
+    if (group_fd_ >= 0) {
+        ioctl(group_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(group_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    open_.store(true, std::memory_order_relaxed);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PerfThreadCounters::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    read_totals_locked(final_totals_);
+    open_.store(false, std::memory_order_relaxed);
+    rdpmc_ = false;
+
+#ifdef UFA_PERF_EVENTS
+    for (size_t i = 0; i < PERF_HARDWARE_EVENT_COUNT; ++i) {
+        if (pages_[i]) {
+            munmap(pages_[i], page_size_);
+            pages_[i] = nullptr;
+        }
+    }
+    // Siblings first, then the leader
+    for (size_t i = 0; i < PERF_HARDWARE_EVENT_COUNT; ++i) {
+        if (fds_[i] >= 0 && fds_[i] != group_fd_) {
+            ::close(fds_[i]);
+        }
+        fds_[i] = -1;
+    }
+    if (group_fd_ >= 0) {
+        ::close(group_fd_);
+        group_fd_ = -1;
+    }
+    if (context_switch_fd_ >= 0) {
+        ::close(context_switch_fd_);
+        context_switch_fd_ = -1;
+    }
+#endif
+}
+
+bool PerfThreadCounters::read_hardware(std::array<uint64_t, PERF_HARDWARE_EVENT_COUNT>& values) const {
+#if defined(UFA_PERF_EVENTS) && defined(UFA_PERF_RDPMC)
+    for (size_t i = 0; i < PERF_HARDWARE_EVENT_COUNT; ++i) {
+        values[i] = 0;
+        if (pages_[i] && !rdpmc_read(static_cast<const perf_event_mmap_page*>(pages_[i]), values[i])) {
+            return false;
+        }
+    }
+    return true;
+#else
+    (void)values;
+    return false;
+#endif
+}
+
+bool PerfThreadCounters::read_totals(PerfCounts& counts) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_.load(std::memory_order_relaxed)) {
+        counts = final_totals_;
+        return true;
+    }
+    return read_totals_locked(counts);
+}
+
+bool PerfThreadCounters::read_totals_locked(PerfCounts& counts) const {
+    counts = PerfCounts{};
+#ifdef UFA_PERF_EVENTS
+    bool ok = true;
+    if (group_fd_ >= 0) {
+        // { nr, time_enabled, time_running, value[nr] } in the order the events joined
+        uint64_t buffer[3 + PERF_HARDWARE_EVENT_COUNT];
+        ssize_t bytes = ::read(group_fd_, buffer, sizeof(buffer));
+        if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+            ok = false;
+        } else {
+            uint64_t nr = buffer[0];
+            uint64_t enabled = buffer[1];
+            uint64_t running = buffer[2];
+            size_t slot = 0;
+            for (size_t i = 0; i < PERF_HARDWARE_EVENT_COUNT && slot < nr; ++i) {
+                if (fds_[i] < 0) {
+                    continue;
+                }
+                uint64_t value = buffer[3 + slot++];
+                // Estimate the full count when the PMU was shared with other groups
+                if (running == 0) {
+                    value = 0;
+                } else if (running < enabled) {
+                    value = static_cast<uint64_t>(static_cast<unsigned __int128>(value) * enabled / running);
+                }
+                counts.values[i] = value;
+            }
+        }
+    }
+    if (context_switch_fd_ >= 0) {
+        uint64_t value = 0;
+        if (::read(context_switch_fd_, &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value))) {
+            counts.values[static_cast<size_t>(PerfEvent::CONTEXT_SWITCHES)] = value;
+        } else {
+            ok = false;
+        }
+    }
+    return ok;
+#else
+    return false;
+#endif
+}
+
+void PerfThreadCounters::add_region(PerfRegion region, const std::array<uint64_t, PERF_HARDWARE_EVENT_COUNT>& delta,
+                                    uint64_t items) {
+    RegionCounts& counts = regions_[static_cast<size_t>(region)];
+    for (size_t i = 0; i < PERF_HARDWARE_EVENT_COUNT; ++i) {
+        counts.values[i].store(counts.values[i].load(std::memory_order_relaxed) + delta[i], std::memory_order_relaxed);
+    }
+    counts.calls.store(counts.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    counts.items.store(counts.items.load(std::memory_order_relaxed) + items, std::memory_order_relaxed);
+}
+
+PerfCounts PerfThreadCounters::get_region(PerfRegion region) const {
+    const RegionCounts& counts = regions_[static_cast<size_t>(region)];
+    PerfCounts result;
+    for (size_t i = 0; i < PERF_HARDWARE_EVENT_COUNT; ++i) {
+        result.values[i] = counts.values[i].load(std::memory_order_relaxed);
+    }
+    result.calls = counts.calls.load(std::memory_order_relaxed);
+    result.items = counts.items.load(std::memory_order_relaxed);
+    return result;
+}
+
+// Registry
+PerfThreadCounters* perf_register_thread(const std::string& name) {
+    if (thread_counters) {
+        return thread_counters;
+    }
+
+    auto counters = std::make_shared<PerfThreadCounters>(name);
+    if (!counters->open()) {
+        std::cerr << "Performance counters unavailable for thread " << name
+                  << " (perf_event_open failed; check /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+        return nullptr;
+    }
+
+    thread_counters = counters.get();
+    scope_counters = counters->uses_rdpmc() ? counters.get() : nullptr;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.push_back(std::move(counters));
+    return thread_counters;
+}
+
+void perf_unregister_thread() {
+    if (!thread_counters) {
+        return;
+    }
+    thread_counters->close();
+    thread_counters = nullptr;
+    scope_counters = nullptr;
+}
+
+std::vector<std::shared_ptr<PerfThreadCounters>> perf_get_registered_threads() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    return registry;
+}
+
+// PerfScope implementation
+PerfScope::PerfScope(PerfRegion region) : counters_(scope_counters), region_(region) {
+    if (counters_ && !counters_->read_hardware(start_)) {
+        counters_ = nullptr;
+    }
+}
+
+PerfScope::~PerfScope() {
+    if (!counters_) {
+        return;
+    }
+    std::array<uint64_t, PERF_HARDWARE_EVENT_COUNT> end;
+    // Drop the sample if a counter was descheduled in between
+    if (!counters_->read_hardware(end)) {
+        return;
+    }
+    for (size_t i = 0; i < PERF_HARDWARE_EVENT_COUNT; ++i) {
+        end[i] = end[i] >= start_[i] ? end[i] - start_[i] : 0;
+    }
+    counters_->add_region(region_, end, items_);
+}
+
+} // namespace UltraFastAnalysis
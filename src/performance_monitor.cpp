@@ -1,4 +1,5 @@
 #include "performance_monitor.h"
+#include "thread_name.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -6,6 +7,7 @@
 #include <chrono>
 #include <thread>
 #include <algorithm>
+#include <bit>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -16,6 +18,8 @@
 #include <sys/time.h>
 #include <unistd.h>
 #include <sys/sysinfo.h>
+#include <dirent.h>
+#include <time.h>
 #endif
 
 namespace UltraFastAnalysis {
@@ -23,10 +27,13 @@ namespace UltraFastAnalysis {
 // PerformanceCounter implementation
 PerformanceCounter::PerformanceCounter(CounterType type)
     : type_(type) {
+    if (type == CounterType::LATENCY || type == CounterType::HISTOGRAM) {
+        histogram_ = std::make_unique<LatencyHistogram>();
+    }
 }
 
-PerformanceCounter::PerformanceCounter(const std::string& name, CounterType type)
-    : type_(type) {
+PerformanceCounter::PerformanceCounter(const std::string& /*name*/, CounterType type)
+    : PerformanceCounter(type) {
 }
 
 void PerformanceCounter::increment(uint64_t value) {
@@ -47,6 +54,9 @@ void PerformanceCounter::set(uint64_t value) {
 
 void PerformanceCounter::record_latency(uint64_t latency_ns) {
     increment(latency_ns);
+    if (histogram_) {
+        histogram_->record_latency(latency_ns);
+    }
 }
 
 void PerformanceCounter::update(uint64_t value) {
@@ -75,14 +85,22 @@ uint64_t PerformanceCounter::get_max() const {
 }
 
 std::vector<uint64_t> PerformanceCounter::get_histogram() const {
-    // Simplified histogram implementation
-    std::vector<uint64_t> result(100, 0);
+    std::vector<uint64_t> result;
+    if (!histogram_) {
+        return result;
+    }
+    result.reserve(100);
+    for (int percentile = 1; percentile <= 100; ++percentile) {
+        result.push_back(histogram_->get_percentile(percentile));
+    }
     return result;
 }
 
 double PerformanceCounter::get_percentile(double percentile) const {
-    // Simplified percentile implementation
-    return get_average();
+    if (!histogram_) {
+        return get_average();
+    }
+    return static_cast<double>(histogram_->get_percentile(percentile));
 }
 
 void PerformanceCounter::reset() {
@@ -91,51 +109,149 @@ void PerformanceCounter::reset() {
     min_.store(UINT64_MAX);
     max_.store(0);
     value.store(0);
+    if (histogram_) {
+        histogram_->reset();
+    }
 }
 
 // LatencyHistogram implementation
+namespace {
+
+constexpr uint32_t HISTOGRAM_MAGIC = 0x31484855; // "UHH1"
+constexpr size_t HISTOGRAM_HEADER_SIZE = 8 + 6 * sizeof(uint64_t);
+
+void put_u64(std::vector<uint8_t>& out, uint64_t value) {
+    uint8_t bytes[sizeof(uint64_t)];
+    std::memcpy(bytes, &value, sizeof(value));
+    out.insert(out.end(), bytes, bytes + sizeof(bytes));
+}
+
+void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool get_varint(const uint8_t* data, size_t length, size_t& offset, uint64_t& value) {
+    value = 0;
+    for (uint32_t shift = 0; shift < 64 && offset < length; shift += 7) {
+        uint8_t byte = data[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 LatencyHistogram::LatencyHistogram()
-    : num_buckets_(100), bucket_size_ns_(1000) { // Default constructor
-    
-    buckets_.resize(num_buckets_, 0);
+    : LatencyHistogram(1, DEFAULT_HIGHEST_TRACKABLE_NS, DEFAULT_SIGNIFICANT_DIGITS) {
+}
+
+LatencyHistogram::LatencyHistogram(uint64_t lowest_discernible, uint64_t highest_trackable, int significant_digits) {
+    configure(lowest_discernible, highest_trackable, significant_digits);
 }
 
-LatencyHistogram::LatencyHistogram(size_t num_buckets)
-    : num_buckets_(num_buckets), bucket_size_ns_(1000) { // 1 microsecond buckets
+void LatencyHistogram::configure(uint64_t lowest_discernible, uint64_t highest_trackable, int significant_digits) {
+    lowest_discernible_ = std::max<uint64_t>(1, lowest_discernible);
+    highest_trackable_ = std::max(highest_trackable, 2 * lowest_discernible_);
+    significant_digits_ = std::clamp(significant_digits, 1, 5);
+    
+    // Enough sub-buckets per power of two to tell apart values 10^-digits apart
+    uint64_t largest_single_unit_resolution = 2;
+    for (int i = 0; i < significant_digits_; ++i) {
+        largest_single_unit_resolution *= 10;
+    }
+    uint32_t sub_bucket_count_magnitude = static_cast<uint32_t>(std::bit_width(largest_single_unit_resolution - 1));
+    sub_bucket_half_count_magnitude_ = std::max<uint32_t>(sub_bucket_count_magnitude, 1) - 1;
+    unit_magnitude_ = static_cast<uint32_t>(std::bit_width(lowest_discernible_)) - 1;
+    sub_bucket_count_ = 1ULL << (sub_bucket_half_count_magnitude_ + 1);
+    sub_bucket_half_count_ = sub_bucket_count_ / 2;
+    sub_bucket_mask_ = (sub_bucket_count_ - 1) << unit_magnitude_;
+    
+    // Each further bucket doubles the range covered
+    uint64_t smallest_untrackable = sub_bucket_count_ << unit_magnitude_;
+    bucket_count_ = 1;
+    while (smallest_untrackable <= highest_trackable_) {
+        if (smallest_untrackable > static_cast<uint64_t>(INT64_MAX) / 2) {
+            ++bucket_count_;
+            break;
+        }
+        smallest_untrackable <<= 1;
+        ++bucket_count_;
+    }
+    counts_length_ = (bucket_count_ + 1) * sub_bucket_half_count_;
+    counts_ = std::make_unique<std::atomic<uint64_t>[]>(counts_length_);
+    counts_memory_.resize(counts_length_ * sizeof(std::atomic<uint64_t>));
     
-    buckets_.resize(num_buckets, 0);
+    total_count_.store(0, std::memory_order_relaxed);
+    total_sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record_latency(uint64_t latency_ns) {
+    record_latency(latency_ns, 1);
 }
 
 void LatencyHistogram::add_latency(uint64_t latency_ns) {
-    size_t bucket_index = get_bucket_index(latency_ns);
-    if (bucket_index < buckets_.size()) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        buckets_[bucket_index]++;
-        total_count_.fetch_add(1);
+    record_latency(latency_ns, 1);
+}
+
+void LatencyHistogram::record_latency(uint64_t latency_ns, uint64_t count) {
+    uint64_t value = std::min(latency_ns, highest_trackable_);
+    counts_[get_bucket_index(value)].fetch_add(count, std::memory_order_relaxed);
+    total_count_.fetch_add(count, std::memory_order_relaxed);
+    total_sum_.fetch_add(value * count, std::memory_order_relaxed);
+    update_min_max(value);
+}
+
+void LatencyHistogram::record_single_writer(uint64_t latency_ns) {
+    uint64_t value = std::min(latency_ns, highest_trackable_);
+    auto& bucket = counts_[get_bucket_index(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    total_count_.store(total_count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    total_sum_.store(total_sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    if (value < min_.load(std::memory_order_relaxed)) {
+        min_.store(value, std::memory_order_relaxed);
+    }
+    if (value > max_.load(std::memory_order_relaxed)) {
+        max_.store(value, std::memory_order_relaxed);
     }
 }
 
+void LatencyHistogram::update_min_max(uint64_t value) {
+    uint64_t current_min = min_.load(std::memory_order_relaxed);
+    while (value < current_min &&
+           !min_.compare_exchange_weak(current_min, value, std::memory_order_relaxed)) {}
+    
+    uint64_t current_max = max_.load(std::memory_order_relaxed);
+    while (value > current_max &&
+           !max_.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {}
+}
+
 void LatencyHistogram::reset() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (auto& bucket : buckets_) {
-        bucket = 0;
+    for (size_t i = 0; i < counts_length_; ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
     }
-    total_count_.store(0);
+    total_count_.store(0, std::memory_order_relaxed);
+    total_sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
 }
 
 std::vector<std::pair<uint64_t, uint64_t>> LatencyHistogram::get_histogram() const {
     std::vector<std::pair<uint64_t, uint64_t>> result;
-    result.reserve(buckets_.size());
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (size_t i = 0; i < buckets_.size(); ++i) {
-        uint64_t count = buckets_[i];
+    for (size_t i = 0; i < counts_length_; ++i) {
+        uint64_t count = counts_[i].load(std::memory_order_relaxed);
         if (count > 0) {
-            uint64_t latency_ns = i * bucket_size_ns_;
-            result.emplace_back(latency_ns, count);
+            result.emplace_back(highest_equivalent(value_at_index(i)), count);
         }
     }
-    
     return result;
 }
 
@@ -144,29 +260,218 @@ uint64_t LatencyHistogram::get_percentile(double percentile) const {
         return 0;
     }
     
-    uint64_t total = total_count_.load();
+    uint64_t total = total_count_.load(std::memory_order_relaxed);
     if (total == 0) {
         return 0;
     }
+    if (percentile == 0.0) {
+        return get_min();
+    }
     
-    uint64_t target_count = static_cast<uint64_t>(total * percentile / 100.0);
+    // The value below which `percentile` of the samples fall, to bucket precision
+    uint64_t target_count = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total)));
+    target_count = std::clamp<uint64_t>(target_count, 1, total);
     uint64_t current_count = 0;
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (size_t i = 0; i < buckets_.size(); ++i) {
-        current_count += buckets_[i];
+    for (size_t i = 0; i < counts_length_; ++i) {
+        current_count += counts_[i].load(std::memory_order_relaxed);
         if (current_count >= target_count) {
-            return i * bucket_size_ns_;
+            return std::min(highest_equivalent(value_at_index(i)), get_max());
+        }
+    }
+    return get_max();
+}
+
+uint64_t LatencyHistogram::get_min() const {
+    uint64_t value = min_.load(std::memory_order_relaxed);
+    return value == UINT64_MAX ? 0 : value;
+}
+
+double LatencyHistogram::get_mean() const {
+    uint64_t count = total_count_.load(std::memory_order_relaxed);
+    return count > 0 ? static_cast<double>(total_sum_.load(std::memory_order_relaxed)) / count : 0.0;
+}
+
+bool LatencyHistogram::same_layout(const LatencyHistogram& other) const {
+    return lowest_discernible_ == other.lowest_discernible_ &&
+           highest_trackable_ == other.highest_trackable_ &&
+           significant_digits_ == other.significant_digits_;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (!same_layout(other)) {
+        for (size_t i = 0; i < other.counts_length_; ++i) {
+            uint64_t count = other.counts_[i].load(std::memory_order_relaxed);
+            if (count > 0) {
+                record_latency(other.value_at_index(i), count);
+            }
+        }
+        return;
+    }
+    
+    // The total is summed from the buckets read, so a histogram still being
+    // recorded into merges as a consistent snapshot
+    uint64_t other_count = 0;
+    for (size_t i = 0; i < counts_length_; ++i) {
+        uint64_t count = other.counts_[i].load(std::memory_order_relaxed);
+        if (count > 0) {
+            counts_[i].fetch_add(count, std::memory_order_relaxed);
+            other_count += count;
+        }
+    }
+    total_count_.fetch_add(other_count, std::memory_order_relaxed);
+    total_sum_.fetch_add(other.total_sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (other_count > 0) {
+        update_min_max(other.get_min());
+        update_min_max(other.get_max());
+    }
+}
+
+bool LatencyHistogram::subtract(const LatencyHistogram& other) {
+    if (!same_layout(other)) {
+        return false;
+    }
+    for (size_t i = 0; i < counts_length_; ++i) {
+        if (counts_[i].load(std::memory_order_relaxed) < other.counts_[i].load(std::memory_order_relaxed)) {
+            return false;
         }
     }
     
-    return (buckets_.size() - 1) * bucket_size_ns_;
+    uint64_t other_count = 0;
+    for (size_t i = 0; i < counts_length_; ++i) {
+        uint64_t count = other.counts_[i].load(std::memory_order_relaxed);
+        if (count > 0) {
+            counts_[i].fetch_sub(count, std::memory_order_relaxed);
+            other_count += count;
+        }
+    }
+    total_count_.fetch_sub(other_count, std::memory_order_relaxed);
+    total_sum_.fetch_sub(other.total_sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    recompute_min_max();
+    return true;
+}
+
+// Exact extremes are lost once samples are removed; fall back to bucket bounds
+void LatencyHistogram::recompute_min_max() {
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < counts_length_; ++i) {
+        if (counts_[i].load(std::memory_order_relaxed) > 0) {
+            update_min_max(value_at_index(i));
+            update_min_max(std::min(highest_equivalent(value_at_index(i)), highest_trackable_));
+        }
+    }
+}
+
+std::vector<uint8_t> LatencyHistogram::serialize() const {
+    std::vector<uint8_t> out;
+    out.reserve(HISTOGRAM_HEADER_SIZE + 64);
+    
+    uint32_t magic = HISTOGRAM_MAGIC;
+    uint8_t magic_bytes[sizeof(magic)];
+    std::memcpy(magic_bytes, &magic, sizeof(magic));
+    out.insert(out.end(), magic_bytes, magic_bytes + sizeof(magic_bytes));
+    out.push_back(static_cast<uint8_t>(significant_digits_));
+    out.insert(out.end(), 3, 0);
+    put_u64(out, lowest_discernible_);
+    put_u64(out, highest_trackable_);
+    put_u64(out, total_count_.load(std::memory_order_relaxed));
+    put_u64(out, total_sum_.load(std::memory_order_relaxed));
+    put_u64(out, min_.load(std::memory_order_relaxed));
+    put_u64(out, max_.load(std::memory_order_relaxed));
+    
+    // A zero count is followed by the length of its run; trailing zeros are dropped
+    size_t zero_run = 0;
+    for (size_t i = 0; i < counts_length_; ++i) {
+        uint64_t count = counts_[i].load(std::memory_order_relaxed);
+        if (count == 0) {
+            ++zero_run;
+            continue;
+        }
+        if (zero_run > 0) {
+            put_varint(out, 0);
+            put_varint(out, zero_run);
+            zero_run = 0;
+        }
+        put_varint(out, count);
+    }
+    return out;
+}
+
+bool LatencyHistogram::deserialize(const uint8_t* data, size_t length) {
+    if (!data || length < HISTOGRAM_HEADER_SIZE) {
+        return false;
+    }
+    
+    uint32_t magic;
+    std::memcpy(&magic, data, sizeof(magic));
+    if (magic != HISTOGRAM_MAGIC) {
+        return false;
+    }
+    uint64_t header[6];
+    std::memcpy(header, data + 8, sizeof(header));
+    configure(header[0], header[1], data[4]);
+    
+    size_t offset = HISTOGRAM_HEADER_SIZE;
+    size_t index = 0;
+    while (offset < length) {
+        uint64_t count;
+        if (!get_varint(data, length, offset, count)) {
+            reset();
+            return false;
+        }
+        if (count == 0) {
+            uint64_t zero_run;
+            if (!get_varint(data, length, offset, zero_run) || zero_run > counts_length_ - index) {
+                reset();
+                return false;
+            }
+            index += zero_run;
+            continue;
+        }
+        if (index >= counts_length_) {
+            reset();
+            return false;
+        }
+        counts_[index++].store(count, std::memory_order_relaxed);
+    }
+    
+    total_count_.store(header[2], std::memory_order_relaxed);
+    total_sum_.store(header[3], std::memory_order_relaxed);
+    min_.store(header[4], std::memory_order_relaxed);
+    max_.store(header[5], std::memory_order_relaxed);
+    return true;
 }
 
 size_t LatencyHistogram::get_bucket_index(uint64_t latency_ns) const {
-    uint64_t bucket_index = latency_ns / bucket_size_ns_;
-    uint64_t max_bucket = static_cast<uint64_t>(num_buckets_ - 1);
-    return static_cast<size_t>((bucket_index < max_bucket) ? bucket_index : max_bucket);
+    // Bucket: the power of two above the sub-bucket range; sub-bucket: the top bits
+    uint32_t pow2_ceiling = static_cast<uint32_t>(std::bit_width(latency_ns | sub_bucket_mask_));
+    uint32_t bucket_index = pow2_ceiling - unit_magnitude_ - (sub_bucket_half_count_magnitude_ + 1);
+    uint64_t sub_bucket_index = latency_ns >> (bucket_index + unit_magnitude_);
+    size_t index = static_cast<size_t>((static_cast<uint64_t>(bucket_index + 1) << sub_bucket_half_count_magnitude_) +
+                                       sub_bucket_index - sub_bucket_half_count_);
+    return std::min(index, counts_length_ - 1);
+}
+
+uint64_t LatencyHistogram::value_at_index(size_t index) const {
+    int64_t bucket_index = static_cast<int64_t>(index >> sub_bucket_half_count_magnitude_) - 1;
+    uint64_t sub_bucket_index = (index & (sub_bucket_half_count_ - 1)) + sub_bucket_half_count_;
+    if (bucket_index < 0) {
+        sub_bucket_index -= sub_bucket_half_count_;
+        bucket_index = 0;
+    }
+    return sub_bucket_index << (static_cast<uint32_t>(bucket_index) + unit_magnitude_);
+}
+
+uint64_t LatencyHistogram::lowest_equivalent(uint64_t value) const {
+    return value_at_index(get_bucket_index(std::min(value, highest_trackable_)));
+}
+
+uint64_t LatencyHistogram::highest_equivalent(uint64_t value) const {
+    // Every sub-bucket of a bucket spans 2^(bucket + unit magnitude) values
+    uint32_t pow2_ceiling = static_cast<uint32_t>(std::bit_width(value | sub_bucket_mask_));
+    uint32_t bucket_index = pow2_ceiling - unit_magnitude_ - (sub_bucket_half_count_magnitude_ + 1);
+    uint64_t sub_bucket_index = value >> (bucket_index + unit_magnitude_);
+    return ((sub_bucket_index + 1) << (bucket_index + unit_magnitude_)) - 1;
 }
 
 // MemoryTracker implementation
@@ -212,6 +517,7 @@ void MemoryTracker::stop_monitoring() {
 }
 
 void MemoryTracker::monitoring_thread_worker() {
+    set_current_thread_name("mem_tracker");
     while (!shutdown_requested_.load()) {
         update_memory_usage();
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -271,8 +577,10 @@ size_t MemoryTracker::get_process_memory_usage() const {
 
 // CPUTracker implementation
 CPUTracker::CPUTracker() : last_cpu_time_(0.0) {
-    last_update_ = std::chrono::high_resolution_clock::now();
-    update_cpu_usage();
+    // Baseline only; the first reading covers the first interval
+    last_update_ = std::chrono::steady_clock::now();
+    last_cpu_time_ = get_process_cpu_time();
+    update_thread_cpu_usage(0.0);
 }
 
 CPUTracker::~CPUTracker() {
@@ -280,23 +588,102 @@ CPUTracker::~CPUTracker() {
 }
 
 void CPUTracker::update_cpu_usage() {
-    auto now = std::chrono::high_resolution_clock::now();
+    auto now = std::chrono::steady_clock::now();
     double current_cpu_time = get_process_cpu_time();
-    double system_cpu_time = get_system_cpu_time();
     
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_update_).count();
-    if (elapsed > 0) {
+    // Percent of one core, like top
+    double elapsed = std::chrono::duration<double>(now - last_update_).count();
+    if (elapsed > 0.0) {
         double cpu_usage = ((current_cpu_time - last_cpu_time_) / elapsed) * 100.0;
         current_cpu_.store(cpu_usage);
         
         total_cpu_.fetch_add(cpu_usage);
         cpu_readings_.fetch_add(1);
     }
+    update_thread_cpu_usage(elapsed);
     
     last_cpu_time_ = current_cpu_time;
     last_update_ = now;
 }
 
+void CPUTracker::update_thread_cpu_usage(double elapsed_seconds) {
+#ifdef __linux__
+    DIR* tasks = opendir("/proc/self/task");
+    if (!tasks) {
+        return;
+    }
+    
+    std::unordered_map<int, ThreadCpuState> current;
+    static const long clock_ticks = sysconf(_SC_CLK_TCK);
+    while (dirent* entry = readdir(tasks)) {
+        int tid = std::atoi(entry->d_name);
+        if (tid <= 0) {
+            continue;
+        }
+        std::string task_path = std::string("/proc/self/task/") + entry->d_name;
+        
+        ThreadCpuState state;
+        state.stats.tid = tid;
+        std::ifstream comm(task_path + "/comm");
+        std::getline(comm, state.stats.name);
+        
+        // The thread CPU clock of a tid, as pthread_getcpuclockid() builds it: nanoseconds
+        // where /proc/<tid>/stat only has clock ticks
+        timespec ts;
+        clockid_t clock = static_cast<clockid_t>((~static_cast<unsigned>(tid) << 3) | 6);
+        if (clock_gettime(clock, &ts) == 0) {
+            state.cpu_time_ns = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+        } else {
+            std::ifstream stat(task_path + "/stat");
+            std::string line;
+            std::getline(stat, line);
+            size_t paren = line.rfind(')');   // Names may hold spaces and parentheses
+            if (paren == std::string::npos) {
+                continue;
+            }
+            std::istringstream fields(line.substr(paren + 2));
+            std::string field;
+            uint64_t utime = 0, stime = 0;
+            for (int i = 3; i <= 15 && fields >> field; ++i) {
+                if (i == 14) utime = std::stoull(field);
+                if (i == 15) stime = std::stoull(field);
+            }
+            state.cpu_time_ns = (utime + stime) * (1000000000ULL / static_cast<uint64_t>(clock_ticks));
+        }
+        state.stats.cpu_time_ns = state.cpu_time_ns;
+        current.emplace(tid, std::move(state));
+    }
+    closedir(tasks);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [tid, state] : current) {
+        auto previous = threads_.find(tid);
+        if (previous != threads_.end() && elapsed_seconds > 0.0 && state.cpu_time_ns >= previous->second.cpu_time_ns) {
+            state.stats.utilization = static_cast<double>(state.cpu_time_ns - previous->second.cpu_time_ns) /
+                                      (elapsed_seconds * 1e9) * 100.0;
+        }
+    }
+    threads_ = std::move(current);  // Exited threads drop out
+#else
+    (void)elapsed_seconds;
+#endif
+}
+
+std::vector<ThreadCpuStats> CPUTracker::get_thread_cpu_usage() const {
+    std::vector<ThreadCpuStats> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        result.reserve(threads_.size());
+        for (const auto& [tid, state] : threads_) {
+            result.push_back(state.stats);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const ThreadCpuStats& a, const ThreadCpuStats& b) {
+        return a.utilization != b.utilization ? a.utilization > b.utilization : a.tid < b.tid;
+    });
+    return result;
+}
+
 void CPUTracker::start_monitoring() {
     if (monitoring_.load()) {
         return;
@@ -322,6 +709,7 @@ void CPUTracker::stop_monitoring() {
 }
 
 void CPUTracker::monitoring_thread_worker() {
+    set_current_thread_name("cpu_tracker");
     while (!shutdown_requested_.load()) {
         update_cpu_usage();
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -389,12 +777,10 @@ double CPUTracker::get_system_cpu_time() const {
 
 // CacheMonitor implementation
 CacheMonitor::CacheMonitor() {
-    initialize_perf_counters();
 }
 
 CacheMonitor::~CacheMonitor() {
     stop_monitoring();
-    cleanup_perf_counters();
 }
 
 void CacheMonitor::start_monitoring() {
@@ -419,6 +805,7 @@ void CacheMonitor::stop_monitoring() {
     if (monitoring_thread_.joinable()) {
         monitoring_thread_.join();
     }
+    update_cache_metrics();
 }
 
 bool CacheMonitor::is_monitoring() const {
@@ -437,13 +824,57 @@ uint64_t CacheMonitor::get_context_switches() const {
     return context_switches_.load();
 }
 
+uint64_t CacheMonitor::get_cycles() const {
+    return cycles_.load();
+}
+
+uint64_t CacheMonitor::get_instructions() const {
+    return instructions_.load();
+}
+
+uint64_t CacheMonitor::get_l1d_misses() const {
+    return l1d_misses_.load();
+}
+
+double CacheMonitor::get_ipc() const {
+    uint64_t cycles = cycles_.load();
+    return cycles == 0 ? 0.0 : static_cast<double>(instructions_.load()) / static_cast<double>(cycles);
+}
+
+bool CacheMonitor::has_perf_counters() const {
+    return perf_available_.load();
+}
+
+PerfCounts CacheMonitor::get_region_counts(PerfRegion region) const {
+    PerfCounts counts = read_region_totals(region);
+    std::lock_guard<std::mutex> lock(baseline_mutex_);
+    const PerfCounts& baseline = region_baseline_[static_cast<size_t>(region)];
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        counts.values[i] -= std::min(counts.values[i], baseline.values[i]);
+    }
+    counts.calls -= std::min(counts.calls, baseline.calls);
+    counts.items -= std::min(counts.items, baseline.items);
+    return counts;
+}
+
 void CacheMonitor::reset() {
+    {
+        std::lock_guard<std::mutex> lock(baseline_mutex_);
+        baseline_ = read_thread_totals();
+        for (size_t i = 0; i < PERF_REGION_COUNT; ++i) {
+            region_baseline_[i] = read_region_totals(static_cast<PerfRegion>(i));
+        }
+    }
     cache_misses_.store(0);
     branch_misses_.store(0);
     context_switches_.store(0);
+    cycles_.store(0);
+    instructions_.store(0);
+    l1d_misses_.store(0);
 }
 
 void CacheMonitor::monitoring_thread_worker() {
+    set_current_thread_name("cache_monitor");
     while (!shutdown_requested_.load()) {
         update_cache_metrics();
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -451,28 +882,72 @@ void CacheMonitor::monitoring_thread_worker() {
 }
 
 void CacheMonitor::update_cache_metrics() {
-    // Platform-specific cache monitoring implementation
-    // This is a simplified version - in production you'd use proper performance counters
-#ifdef _WIN32
-    // Windows implementation would use PdhCollectQueryData or similar
-#else
-    // Linux implementation would read from /proc/self/status or use perf_event_open
-#endif
+    // Threads register their own counters (perf_event_open only measures the
+    // calling thread); this sums what they have counted so far
+    PerfCounts totals = read_thread_totals();
+    PerfCounts baseline;
+    {
+        std::lock_guard<std::mutex> lock(baseline_mutex_);
+        baseline = baseline_;
+    }
+    auto since_reset = [&](PerfEvent event) {
+        uint64_t value = totals.get(event);
+        uint64_t base = baseline.get(event);
+        return value > base ? value - base : 0;
+    };
+    
+    cache_misses_.store(since_reset(PerfEvent::LLC_MISSES));
+    branch_misses_.store(since_reset(PerfEvent::BRANCH_MISSES));
+    context_switches_.store(since_reset(PerfEvent::CONTEXT_SWITCHES));
+    cycles_.store(since_reset(PerfEvent::CYCLES));
+    instructions_.store(since_reset(PerfEvent::INSTRUCTIONS));
+    l1d_misses_.store(since_reset(PerfEvent::L1D_MISSES));
+}
+
+PerfCounts CacheMonitor::read_thread_totals() const {
+    PerfCounts totals;
+    auto threads = perf_get_registered_threads();
+    for (const auto& thread : threads) {
+        PerfCounts counts;
+        if (thread->read_totals(counts)) {
+            totals.add(counts);
+        }
+    }
+    perf_available_.store(!threads.empty());
+    return totals;
 }
 
-bool CacheMonitor::initialize_perf_counters() {
-    // Platform-specific initialization
-    // This is a placeholder - in production you'd set up proper performance monitoring
-    return true;
+PerfCounts CacheMonitor::read_region_totals(PerfRegion region) const {
+    PerfCounts totals;
+    for (const auto& thread : perf_get_registered_threads()) {
+        totals.add(thread->get_region(region));
+    }
+    return totals;
 }
 
-void CacheMonitor::cleanup_perf_counters() {
-    // Platform-specific cleanup
+// PerformanceMonitor implementation
+namespace {
+
+std::atomic<uint64_t> next_monitor_instance{1};
+
+// Recorder of the monitor this thread last recorded to
+struct RecorderCache {
+    uint64_t instance = 0;
+    void* recorder = nullptr;
+};
+thread_local RecorderCache recorder_cache;
+
+} // namespace
+
+PerformanceMonitor::ThreadRecorder::~ThreadRecorder() {
+    for (auto& histogram : histograms) {
+        delete histogram.load(std::memory_order_relaxed);
+    }
 }
 
-// PerformanceMonitor implementation
 PerformanceMonitor::PerformanceMonitor(bool enable_detailed_monitoring)
-    : detailed_monitoring_enabled_(enable_detailed_monitoring) {
+    : instance_id_(next_monitor_instance.fetch_add(1)),
+      detailed_monitoring_enabled_(enable_detailed_monitoring) {
     
     // Initialize monitoring components
     memory_tracker_ = std::make_unique<MemoryTracker>();
@@ -523,11 +998,18 @@ void PerformanceMonitor::stop() {
         cache_monitor_->stop_monitoring();
     }
     
+    if (jitter_monitor_) {
+        jitter_monitor_->stop();
+    }
+    
     // Wait for monitoring thread
     if (monitoring_thread_.joinable()) {
         monitoring_thread_.join();
     }
     
+    // Include samples recorded since the last interval
+    collect_latency_metrics();
+    
     std::cout << "Performance monitor stopped" << std::endl;
 }
 
@@ -552,61 +1034,185 @@ void PerformanceMonitor::create_counter(const std::string& name, CounterType typ
     counters_[name] = std::make_unique<PerformanceCounter>(name, type);
 }
 
+PerformanceCounter* PerformanceMonitor::get_or_create_counter(const std::string& name, CounterType type) {
+    std::lock_guard<std::mutex> lock(counters_mutex_);
+    auto& counter = counters_[name];
+    if (!counter) {
+        counter = std::make_unique<PerformanceCounter>(name, type);
+    }
+    return counter.get();
+}
+
 void PerformanceMonitor::remove_counter(const std::string& name) {
     std::lock_guard<std::mutex> lock(counters_mutex_);
     counters_.erase(name);
 }
 
 void PerformanceMonitor::record_latency(const std::string& operation, uint64_t latency_ns) {
-    // Get or create counter
-    PerformanceCounter* counter = get_counter(operation);
-    if (!counter) {
-        create_counter(operation, CounterType::LATENCY);
-        counter = get_counter(operation);
-    }
+    PerformanceCounter* counter = get_or_create_counter(operation, CounterType::LATENCY);
     
-    if (counter) {
+    // The latency histogram is only kept when detailed monitoring is enabled
+    if (detailed_monitoring_enabled_) {
+        counter->record_latency(latency_ns);
+    } else {
         counter->update(latency_ns);
-        
-        // Update latency histogram if detailed monitoring is enabled
-        if (detailed_monitoring_enabled_) {
-            std::lock_guard<std::mutex> lock(histograms_mutex_);
-            if (latency_histograms_.find(operation) == latency_histograms_.end()) {
-                latency_histograms_[operation] = std::make_unique<LatencyHistogram>();
-            }
-            latency_histograms_[operation]->add_latency(latency_ns);
-        }
     }
 }
 
 double PerformanceMonitor::get_average_latency(const std::string& operation) const {
+    LatencyMetric metric = find_latency_metric(operation);
+    if (metric.valid()) {
+        std::lock_guard<std::mutex> lock(metrics_mutex_);
+        return latency_metrics_[metric.id]->cumulative.get_mean();
+    }
+    
     auto counter = get_counter(operation);
     return counter ? counter->get_average() : 0.0;
 }
 
 double PerformanceMonitor::get_percentile_latency(const std::string& operation, double percentile) const {
+    LatencyMetric metric = find_latency_metric(operation);
+    if (metric.valid()) {
+        return get_cumulative_percentile(metric, percentile);
+    }
     if (!detailed_monitoring_enabled_) {
         return 0.0;
     }
     
-    std::lock_guard<std::mutex> lock(histograms_mutex_);
-    auto it = latency_histograms_.find(operation);
-    if (it != latency_histograms_.end()) {
-        return it->second->get_percentile(percentile);
+    auto counter = get_counter(operation);
+    return counter ? counter->get_percentile(percentile) : 0.0;
+}
+
+LatencyMetric PerformanceMonitor::register_latency_metric(const std::string& name) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    for (size_t i = 0; i < latency_metrics_.size(); ++i) {
+        if (latency_metrics_[i]->name == name) {
+            return LatencyMetric{static_cast<uint32_t>(i)};
+        }
     }
-    return 0.0;
+    if (latency_metrics_.size() >= MAX_LATENCY_METRICS) {
+        std::cerr << "Too many latency metrics, not registering " << name << std::endl;
+        return LatencyMetric{};
+    }
+    
+    auto state = std::make_unique<LatencyMetricState>();
+    state->name = name;
+    latency_metrics_.push_back(std::move(state));
+    latency_metric_count_.store(latency_metrics_.size(), std::memory_order_release);
+    return LatencyMetric{static_cast<uint32_t>(latency_metrics_.size() - 1)};
+}
+
+LatencyMetric PerformanceMonitor::find_latency_metric(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    for (size_t i = 0; i < latency_metrics_.size(); ++i) {
+        if (latency_metrics_[i]->name == name) {
+            return LatencyMetric{static_cast<uint32_t>(i)};
+        }
+    }
+    return LatencyMetric{};
 }
 
-void PerformanceMonitor::record_throughput(const std::string& operation, uint64_t count) {
-    PerformanceCounter* counter = get_counter(operation);
-    if (!counter) {
-        create_counter(operation, CounterType::THROUGHPUT);
-        counter = get_counter(operation);
+PerformanceMonitor::ThreadRecorder* PerformanceMonitor::get_thread_recorder() {
+    if (recorder_cache.instance == instance_id_) {
+        return static_cast<ThreadRecorder*>(recorder_cache.recorder);
+    }
+    
+    // First recording from this thread, or it last recorded to another monitor
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    ThreadRecorder* recorder = nullptr;
+    for (auto& existing : recorders_) {
+        if (existing->thread_id == std::this_thread::get_id()) {
+            recorder = existing.get();
+            break;
+        }
+    }
+    if (!recorder) {
+        recorders_.push_back(std::make_unique<ThreadRecorder>());
+        recorder = recorders_.back().get();
+        recorder->thread_id = std::this_thread::get_id();
+    }
+    recorder_cache.instance = instance_id_;
+    recorder_cache.recorder = recorder;
+    return recorder;
+}
+
+void PerformanceMonitor::record_latency(LatencyMetric metric, uint64_t latency_ns) {
+    if (metric.id >= latency_metric_count_.load(std::memory_order_relaxed)) {
+        return;
     }
     
-    if (counter) {
-        counter->update(count);
+    ThreadRecorder* recorder = get_thread_recorder();
+    auto& slot = recorder->histograms[metric.id];
+    LatencyHistogram* histogram = slot.load(std::memory_order_relaxed);
+    if (!histogram) {
+        histogram = new LatencyHistogram();
+        slot.store(histogram, std::memory_order_release);
     }
+    histogram->record_single_writer(latency_ns);
+}
+
+void PerformanceMonitor::collect_latency_metrics() {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    for (auto& metric : latency_metrics_) {
+        metric->interval.reset();
+    }
+    
+    // Each recorder's histogram only grows; what it gained since the previous
+    // pass is this interval's share
+    for (auto& recorder : recorders_) {
+        for (size_t id = 0; id < latency_metrics_.size(); ++id) {
+            const LatencyHistogram* live = recorder->histograms[id].load(std::memory_order_acquire);
+            if (!live) {
+                continue;
+            }
+            auto& previous = recorder->previous[id];
+            if (!previous) {
+                previous = std::make_unique<LatencyHistogram>();
+            }
+            
+            LatencyMetricState& metric = *latency_metrics_[id];
+            metric.scratch.reset();
+            metric.scratch.merge(*live);
+            if (!metric.scratch.subtract(*previous) || metric.scratch.get_count() == 0) {
+                continue;
+            }
+            previous->merge(metric.scratch);
+            metric.interval.merge(metric.scratch);
+            metric.cumulative.merge(metric.scratch);
+        }
+    }
+}
+
+const PerformanceMonitor::LatencyMetricState* PerformanceMonitor::get_metric_state(LatencyMetric metric) const {
+    return metric.id < latency_metrics_.size() ? latency_metrics_[metric.id].get() : nullptr;
+}
+
+double PerformanceMonitor::get_interval_percentile(LatencyMetric metric, double percentile) const {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    const LatencyMetricState* state = get_metric_state(metric);
+    return state ? static_cast<double>(state->interval.get_percentile(percentile)) : 0.0;
+}
+
+double PerformanceMonitor::get_cumulative_percentile(LatencyMetric metric, double percentile) const {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    const LatencyMetricState* state = get_metric_state(metric);
+    return state ? static_cast<double>(state->cumulative.get_percentile(percentile)) : 0.0;
+}
+
+uint64_t PerformanceMonitor::get_interval_count(LatencyMetric metric) const {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    const LatencyMetricState* state = get_metric_state(metric);
+    return state ? state->interval.get_count() : 0;
+}
+
+uint64_t PerformanceMonitor::get_cumulative_count(LatencyMetric metric) const {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    const LatencyMetricState* state = get_metric_state(metric);
+    return state ? state->cumulative.get_count() : 0;
+}
+
+void PerformanceMonitor::record_throughput(const std::string& operation, uint64_t count) {
+    get_or_create_counter(operation, CounterType::THROUGHPUT)->update(count);
 }
 
 uint64_t PerformanceMonitor::get_throughput(const std::string& operation) const {
@@ -622,6 +1228,14 @@ double PerformanceMonitor::get_current_cpu_usage() const {
     return cpu_tracker_ ? cpu_tracker_->get_current_cpu_usage() : 0.0;
 }
 
+std::vector<ThreadCpuStats> PerformanceMonitor::get_thread_cpu_usage() const {
+    return cpu_tracker_ ? cpu_tracker_->get_thread_cpu_usage() : std::vector<ThreadCpuStats>{};
+}
+
+std::array<MemorySubsystemStats, MEMORY_SUBSYSTEM_COUNT> PerformanceMonitor::get_memory_by_subsystem() const {
+    return get_memory_subsystem_stats();
+}
+
 uint64_t PerformanceMonitor::get_cache_misses() const {
     return cache_monitor_ ? cache_monitor_->get_cache_misses() : 0;
 }
@@ -630,6 +1244,22 @@ uint64_t PerformanceMonitor::get_branch_misses() const {
     return cache_monitor_ ? cache_monitor_->get_branch_misses() : 0;
 }
 
+bool PerformanceMonitor::start_jitter_sampling(const JitterConfig& config) {
+    if (!config.enabled() || jitter_monitor_) {
+        return true;
+    }
+    jitter_monitor_ = std::make_unique<JitterMonitor>(config);
+    return jitter_monitor_->start();
+}
+
+std::vector<JitterStats> PerformanceMonitor::get_jitter_stats() const {
+    return jitter_monitor_ ? jitter_monitor_->get_stats() : std::vector<JitterStats>{};
+}
+
+std::vector<ThreadSchedStats> PerformanceMonitor::get_thread_sched_stats() const {
+    return sched_get_thread_stats();
+}
+
 void PerformanceMonitor::generate_report(const std::string& filename) {
     if (filename.empty()) {
         write_csv_report("performance_report.csv");
@@ -649,6 +1279,14 @@ void PerformanceMonitor::print_summary() const {
         std::cout << "Memory Usage: " << std::fixed << std::setprecision(2)
                   << memory_tracker_->get_memory_usage_mb() << " MB (Peak: "
                   << memory_tracker_->get_peak_memory_usage_mb() << " MB)" << std::endl;
+        
+        // Which part of the process grew
+        for (const auto& subsystem : get_memory_by_subsystem()) {
+            if (subsystem.peak_bytes == 0) continue;
+            std::cout << "  " << std::left << std::setw(20) << subsystem.name << std::right
+                      << std::setw(10) << std::setprecision(1) << subsystem.live_bytes / 1024.0 << " KB (Peak: "
+                      << subsystem.peak_bytes / 1024.0 << " KB)" << std::endl;
+        }
     }
     
     // CPU usage
@@ -656,12 +1294,61 @@ void PerformanceMonitor::print_summary() const {
         std::cout << "CPU Usage: " << std::fixed << std::setprecision(2)
                   << cpu_tracker_->get_current_cpu_usage() << "% (Avg: "
                   << cpu_tracker_->get_average_cpu_usage() << "%)" << std::endl;
+        
+        // A saturated thread hides in the process average
+        auto threads = cpu_tracker_->get_thread_cpu_usage();
+        if (!threads.empty()) {
+            std::cout << "Thread CPU:" << std::endl;
+            for (const auto& thread : threads) {
+                std::cout << "  " << std::left << std::setw(16) << thread.name << std::right
+                          << std::setw(7) << std::setprecision(1) << thread.utilization << "%  "
+                          << std::setprecision(3) << thread.cpu_time_ns / 1e9 << " s" << std::endl;
+            }
+        }
     }
     
     // Cache performance
     if (cache_monitor_ && detailed_monitoring_enabled_) {
-        std::cout << "Cache Misses: " << cache_monitor_->get_cache_misses() << std::endl;
-        std::cout << "Branch Misses: " << cache_monitor_->get_branch_misses() << std::endl;
+        if (cache_monitor_->has_perf_counters()) {
+            std::cout << "Cycles: " << cache_monitor_->get_cycles()
+                      << " (IPC: " << std::fixed << std::setprecision(2) << cache_monitor_->get_ipc() << ")" << std::endl;
+            std::cout << "L1D Misses: " << cache_monitor_->get_l1d_misses() << std::endl;
+            std::cout << "Cache Misses: " << cache_monitor_->get_cache_misses() << std::endl;
+            std::cout << "Branch Misses: " << cache_monitor_->get_branch_misses() << std::endl;
+            std::cout << "Context Switches: " << cache_monitor_->get_context_switches() << std::endl;
+            for (size_t i = 0; i < PERF_REGION_COUNT; ++i) {
+                PerfRegion region = static_cast<PerfRegion>(i);
+                PerfCounts counts = cache_monitor_->get_region_counts(region);
+                if (counts.calls == 0) {
+                    continue;
+                }
+                std::cout << "  " << perf_region_name(region) << ": IPC " << std::setprecision(2) << counts.ipc()
+                          << ", per order: " << std::setprecision(1)
+                          << counts.per_item(PerfEvent::CYCLES) << " cycles, "
+                          << counts.per_item(PerfEvent::L1D_MISSES) << " L1D misses, "
+                          << counts.per_item(PerfEvent::LLC_MISSES) << " LLC misses, "
+                          << counts.per_item(PerfEvent::BRANCH_MISSES) << " branch misses" << std::endl;
+            }
+        } else {
+            std::cout << "Hardware Counters: unavailable" << std::endl;
+        }
+    }
+    
+    // Host noise seen by the samplers, and how often engine threads were preempted or faulted
+    for (const auto& jitter : get_jitter_stats()) {
+        std::cout << "Jitter " << jitter.role << " (CPU " << jitter.cpu << "): " << jitter.gaps << " gaps, "
+                  << std::fixed << std::setprecision(4) << jitter.stolen_fraction() * 100.0 << "% stolen, p99 "
+                  << jitter.p99_gap_ns << " ns, p99.9 " << jitter.p999_gap_ns << " ns, max " << jitter.max_gap_ns
+                  << " ns, " << jitter.sched.involuntary_switches << " preemptions" << std::endl;
+    }
+    auto sched_stats = get_thread_sched_stats();
+    if (!sched_stats.empty()) {
+        std::cout << "Thread Scheduling:" << std::endl;
+        for (const auto& thread : sched_stats) {
+            std::cout << "  " << thread.name << ": " << thread.involuntary_switches << " involuntary / "
+                      << thread.voluntary_switches << " voluntary switches, " << thread.minor_faults << " minor / "
+                      << thread.major_faults << " major faults" << std::endl;
+        }
     }
     
     // Counter summary
@@ -669,7 +1356,28 @@ void PerformanceMonitor::print_summary() const {
     std::lock_guard<std::mutex> lock(counters_mutex_);
     for (const auto& [name, counter] : counters_) {
         std::cout << "  " << name << ": " << counter->value.load()
-                  << " (Avg: " << std::fixed << std::setprecision(2) << counter->get_average() << ")" << std::endl;
+                  << " (Avg: " << std::fixed << std::setprecision(2) << counter->get_average();
+        if (counter->has_histogram() && counter->get_count() > 0) {
+            std::cout << ", p50: " << counter->get_percentile(50.0)
+                      << ", p99: " << counter->get_percentile(99.0)
+                      << ", p99.9: " << counter->get_percentile(99.9);
+        }
+        std::cout << ")" << std::endl;
+    }
+    
+    // Registered latency metrics, as of the last monitoring interval
+    std::lock_guard<std::mutex> metrics_lock(metrics_mutex_);
+    if (!latency_metrics_.empty()) {
+        std::cout << "\nLatency (ns, last interval | cumulative):" << std::endl;
+    }
+    for (const auto& metric : latency_metrics_) {
+        std::cout << "  " << metric->name << ": p50 " << metric->interval.get_percentile(50.0)
+                  << ", p99 " << metric->interval.get_percentile(99.0)
+                  << " (" << metric->interval.get_count() << ") | p50 " << metric->cumulative.get_percentile(50.0)
+                  << ", p99 " << metric->cumulative.get_percentile(99.0)
+                  << ", p99.9 " << metric->cumulative.get_percentile(99.9)
+                  << ", max " << metric->cumulative.get_max()
+                  << " (" << metric->cumulative.get_count() << ")" << std::endl;
     }
     
     std::cout << "===================================" << std::endl;
@@ -689,21 +1397,26 @@ void PerformanceMonitor::reset_all_counters() {
         counter->reset();
     }
     
-    std::lock_guard<std::mutex> hist_lock(histograms_mutex_);
-    for (auto& [name, histogram] : latency_histograms_) {
-        histogram->reset();
+    // Recorders keep counting; only what was already folded in is dropped
+    std::lock_guard<std::mutex> metrics_lock(metrics_mutex_);
+    for (auto& metric : latency_metrics_) {
+        metric->interval.reset();
+        metric->cumulative.reset();
     }
     
     if (memory_tracker_) memory_tracker_->reset();
+    reset_memory_subsystem_peaks();
     if (cpu_tracker_) cpu_tracker_->reset();
     if (cache_monitor_) cache_monitor_->reset();
 }
 
 void PerformanceMonitor::monitoring_thread_worker() {
+    set_current_thread_name("perf_monitor");
     std::cout << "Performance monitoring thread started: " << std::this_thread::get_id() << std::endl;
     
     while (!shutdown_requested_.load()) {
         update_system_metrics();
+        collect_latency_metrics();
         cleanup_old_data();
         
         std::this_thread::sleep_for(monitoring_interval_);
@@ -776,11 +1489,62 @@ void PerformanceMonitor::write_json_report(const std::string& filename) {
         file << "      \"min\": " << counter->min_value.load() << ",\n";
         file << "      \"max\": " << counter->max_value.load() << ",\n";
         file << "      \"average\": " << std::fixed << std::setprecision(2) << counter->get_average() << ",\n";
+        if (counter->has_histogram()) {
+            file << "      \"p50\": " << counter->get_percentile(50.0) << ",\n";
+            file << "      \"p99\": " << counter->get_percentile(99.0) << ",\n";
+            file << "      \"p99_9\": " << counter->get_percentile(99.9) << ",\n";
+        }
         file << "      \"count\": " << counter->count.load() << "\n";
         file << "    }";
         first = false;
     }
     
+    file << "\n  ],\n";
+    
+    file << "  \"memory_subsystems\": [\n";
+    first = true;
+    for (const auto& subsystem : get_memory_by_subsystem()) {
+        if (!first) file << ",\n";
+        file << "    {\"name\": \"" << subsystem.name << "\", \"live_bytes\": " << subsystem.live_bytes
+             << ", \"peak_bytes\": " << subsystem.peak_bytes << ", \"allocations\": " << subsystem.allocations
+             << ", \"frees\": " << subsystem.frees << "}";
+        first = false;
+    }
+    file << "\n  ],\n";
+    
+    file << "  \"thread_cpu\": [\n";
+    first = true;
+    for (const auto& thread : get_thread_cpu_usage()) {
+        if (!first) file << ",\n";
+        file << "    {\"tid\": " << thread.tid << ", \"name\": \"" << thread.name << "\", \"cpu_time_ns\": "
+             << thread.cpu_time_ns << ", \"utilization\": " << std::setprecision(2) << thread.utilization << "}";
+        first = false;
+    }
+    file << "\n  ],\n";
+    
+    file << "  \"jitter\": [\n";
+    first = true;
+    for (const auto& jitter : get_jitter_stats()) {
+        if (!first) file << ",\n";
+        file << "    {\"role\": \"" << jitter.role << "\", \"cpu\": " << jitter.cpu
+             << ", \"sampled_ns\": " << jitter.sampled_ns << ", \"gaps\": " << jitter.gaps
+             << ", \"stolen_ns\": " << jitter.stolen_ns << ", \"p50_ns\": " << jitter.p50_gap_ns
+             << ", \"p99_ns\": " << jitter.p99_gap_ns << ", \"p99_9_ns\": " << jitter.p999_gap_ns
+             << ", \"max_ns\": " << jitter.max_gap_ns
+             << ", \"involuntary_switches\": " << jitter.sched.involuntary_switches << "}";
+        first = false;
+    }
+    file << "\n  ],\n";
+    
+    file << "  \"threads\": [\n";
+    first = true;
+    for (const auto& thread : get_thread_sched_stats()) {
+        if (!first) file << ",\n";
+        file << "    {\"name\": \"" << thread.name << "\", \"voluntary_switches\": " << thread.voluntary_switches
+             << ", \"involuntary_switches\": " << thread.involuntary_switches
+             << ", \"minor_faults\": " << thread.minor_faults << ", \"major_faults\": " << thread.major_faults << "}";
+        first = false;
+    }
     file << "\n  ]\n";
     file << "}\n";
     
@@ -0,0 +1,237 @@
+#include "plugin_market_data_source.h"
+#include "thread_name.h"
+#include <iostream>
+#include <cstring>
+#include <cmath>
+
+#include <dlfcn.h>
+
+namespace UltraFastAnalysis {
+
+static_assert(UFA_FEED_EVENT_TRADE == static_cast<int>(MarketDataType::TRADE) &&
+              UFA_FEED_EVENT_QUOTE == static_cast<int>(MarketDataType::QUOTE) &&
+              UFA_FEED_EVENT_BOOK_UPDATE == static_cast<int>(MarketDataType::ORDER_BOOK_UPDATE) &&
+              UFA_FEED_EVENT_TICK == static_cast<int>(MarketDataType::TICK),
+              "Plugin event types must match MarketDataType");
+
+PluginMarketDataSource::PluginMarketDataSource(const MarketDataConfig& config)
+    : config_(config) {
+}
+
+PluginMarketDataSource::~PluginMarketDataSource() {
+    disconnect();
+}
+
+bool PluginMarketDataSource::connect() {
+    if (connected_.load()) {
+        return true;
+    }
+
+    if (!load_plugin()) {
+        unload_plugin();
+        return false;
+    }
+
+    events_.resize(std::max<size_t>(config_.batch_size, 1));
+    connected_.store(true);
+    return true;
+}
+
+void PluginMarketDataSource::disconnect() {
+    stop_streaming();
+    unload_plugin();
+    connected_.store(false);
+}
+
+bool PluginMarketDataSource::is_connected() const {
+    return connected_.load();
+}
+
+bool PluginMarketDataSource::start_streaming() {
+    if (!connected_.load() || streaming_.load()) {
+        return false;
+    }
+
+    if (plugin_->start(instance_) != 0) {
+        const char* error = plugin_->last_error ? plugin_->last_error(instance_) : nullptr;
+        report_error("Feed plugin failed to start: " + std::string(error ? error : "unknown error"));
+        return false;
+    }
+
+    streaming_.store(true);
+    shutdown_requested_.store(false);
+
+    poll_thread_ = std::thread(&PluginMarketDataSource::poll_thread_worker, this);
+    return true;
+}
+
+void PluginMarketDataSource::stop_streaming() {
+    if (!streaming_.load()) {
+        return;
+    }
+
+    shutdown_requested_.store(true);
+    streaming_.store(false);
+
+    if (poll_thread_.joinable()) {
+        poll_thread_.join();
+    }
+
+    plugin_->stop(instance_);
+}
+
+void PluginMarketDataSource::set_data_callback(std::function<void(const MarketData&)> callback) {
+    data_callback_ = callback;
+}
+
+void PluginMarketDataSource::set_error_callback(std::function<void(const std::string&)> callback) {
+    error_callback_ = callback;
+}
+
+const MarketDataStats& PluginMarketDataSource::get_stats() const {
+    return stats_;
+}
+
+void PluginMarketDataSource::reset_stats() {
+    stats_.reset();
+}
+
+std::string PluginMarketDataSource::get_plugin_name() const {
+    return (plugin_ && plugin_->name) ? plugin_->name : "";
+}
+
+bool PluginMarketDataSource::load_plugin() {
+    if (config_.plugin_path.empty()) {
+        report_error("CUSTOM_FEED requires plugin_path");
+        return false;
+    }
+
+    library_handle_ = ::dlopen(config_.plugin_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library_handle_) {
+        report_error("Failed to load feed plugin: " + std::string(::dlerror()));
+        return false;
+    }
+
+    auto entry = reinterpret_cast<ufa_feed_plugin_entry_fn>(::dlsym(library_handle_, UFA_FEED_PLUGIN_ENTRY));
+    if (!entry) {
+        report_error("Feed plugin " + config_.plugin_path + " does not export " UFA_FEED_PLUGIN_ENTRY);
+        return false;
+    }
+
+    plugin_ = entry();
+    if (!plugin_) {
+        report_error("Feed plugin entry point returned no descriptor");
+        return false;
+    }
+
+    // Refuse plugins built against a different event layout
+    if (plugin_->abi_version != UFA_FEED_PLUGIN_ABI_VERSION || plugin_->event_size != sizeof(ufa_feed_event)) {
+        report_error("Feed plugin ABI mismatch: version " + std::to_string(plugin_->abi_version) +
+                     ", event size " + std::to_string(plugin_->event_size));
+        plugin_ = nullptr;
+        return false;
+    }
+
+    if (!plugin_->create || !plugin_->destroy || !plugin_->start || !plugin_->stop || !plugin_->poll) {
+        report_error("Feed plugin descriptor is incomplete");
+        plugin_ = nullptr;
+        return false;
+    }
+
+    instance_ = plugin_->create(config_.plugin_config.c_str());
+    if (!instance_) {
+        report_error("Feed plugin failed to create an instance");
+        return false;
+    }
+
+    price_divisor_ = std::pow(10.0, plugin_->price_decimals);
+    std::cout << "Loaded feed plugin: " << get_plugin_name() << std::endl;
+    return true;
+}
+
+void PluginMarketDataSource::unload_plugin() {
+    if (plugin_ && instance_) {
+        plugin_->destroy(instance_);
+    }
+    instance_ = nullptr;
+    plugin_ = nullptr;
+
+    if (library_handle_) {
+        ::dlclose(library_handle_);
+        library_handle_ = nullptr;
+    }
+}
+
+void PluginMarketDataSource::poll_thread_worker() {
+    set_current_thread_name("plugin_feed");
+    std::cout << "Feed plugin poll thread started: " << std::this_thread::get_id() << std::endl;
+
+    while (!shutdown_requested_.load(std::memory_order_relaxed)) {
+        int64_t count = plugin_->poll(instance_, events_.data(), events_.size(), 1000);
+
+        if (count < 0) {
+            const char* error = plugin_->last_error ? plugin_->last_error(instance_) : nullptr;
+            stats_.processing_errors.fetch_add(1, std::memory_order_relaxed);
+            report_error("Feed plugin poll failed: " + std::string(error ? error : "unknown error"));
+            
+            // Back off so a failing plugin does not flood the error callback
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        size_t received = std::min(static_cast<size_t>(count), events_.size());
+        for (size_t i = 0; i < received; ++i) {
+            dispatch_event(events_[i]);
+        }
+    }
+
+    std::cout << "Feed plugin poll thread stopped: " << std::this_thread::get_id() << std::endl;
+}
+
+void PluginMarketDataSource::dispatch_event(const ufa_feed_event& event) {
+    decoded_.reset();
+    decoded_.sequence_number = event.sequence_number;
+    decoded_.symbol.assign(event.symbol, strnlen(event.symbol, UFA_FEED_SYMBOL_LENGTH));
+    decoded_.type = static_cast<MarketDataType>(event.type);
+    decoded_.timestamp = std::chrono::high_resolution_clock::now();
+
+    double price = event.price / price_divisor_;
+
+    switch (event.type) {
+        case UFA_FEED_EVENT_TRADE:
+        case UFA_FEED_EVENT_TICK:
+            decoded_.trade_price = price;
+            decoded_.trade_quantity = event.quantity;
+            decoded_.trade_id = event.trade_id;
+            break;
+        case UFA_FEED_EVENT_QUOTE:
+            decoded_.bid_price = price;
+            decoded_.bid_quantity = event.quantity;
+            decoded_.ask_price = event.ask_price / price_divisor_;
+            decoded_.ask_quantity = event.ask_quantity;
+            break;
+        case UFA_FEED_EVENT_BOOK_UPDATE:
+            decoded_.price = price;
+            decoded_.quantity = event.quantity;
+            decoded_.is_bid = event.is_bid != 0;
+            break;
+        default:
+            stats_.validation_errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+    }
+
+    stats_.messages_received.fetch_add(1, std::memory_order_relaxed);
+    if (data_callback_) {
+        data_callback_(decoded_);
+    }
+}
+
+void PluginMarketDataSource::report_error(const std::string& error) {
+    if (error_callback_) {
+        error_callback_(error);
+    } else {
+        std::cerr << error << std::endl;
+    }
+}
+
+} // namespace UltraFastAnalysis
@@ -6,6 +6,7 @@
 #include "order_book.h"
 #include "market_data.h"
 #include "performance_monitor.h"
+#include "shm_book_publisher.h"
 
 namespace py = pybind11;
 using namespace UltraFastAnalysis;
@@ -15,7 +16,7 @@ class PyOrder {
 public:
     PyOrder(uint64_t order_id, uint64_t client_id, const std::string& symbol, 
             const std::string& side, const std::string& type, uint64_t quantity, double price)
-        : order_(std::make_shared<Order>()) {
+        : order_(make_order()) {
         order_->order_id = order_id;
         order_->client_id = client_id;
         order_->symbol = symbol;
@@ -250,6 +251,60 @@ private:
     std::unique_ptr<PerformanceMonitor> monitor_;
 };
 
+// Python wrapper for ShmBookReader; reads books another process publishes
+class PyBookReader {
+public:
+    bool open(const std::string& name) { return reader_.open(name); }
+    void close() { reader_.close(); }
+    bool is_open() const { return reader_.is_open(); }
+    bool engine_running() const { return reader_.engine_running(); }
+    
+    py::list get_symbols() const {
+        py::list result;
+        for (const auto& symbol : reader_.get_symbols()) {
+            result.append(symbol);
+        }
+        return result;
+    }
+    
+    uint64_t get_update_sequence(const std::string& symbol) const {
+        return reader_.get_update_sequence(symbol);
+    }
+    
+    // Book as a dict, None if the symbol has not been published
+    py::object read(const std::string& symbol) {
+        if (!reader_.read(symbol, view_)) {
+            return py::none();
+        }
+        
+        auto levels = [](const std::vector<std::pair<double, uint64_t>>& side) {
+            py::list result;
+            for (const auto& [price, quantity] : side) {
+                py::dict level;
+                level["price"] = price;
+                level["quantity"] = quantity;
+                result.append(level);
+            }
+            return result;
+        };
+        
+        py::dict result;
+        result["symbol"] = view_.symbol;
+        result["update_sequence"] = view_.update_sequence;
+        result["timestamp_ns"] = view_.timestamp_ns;
+        result["trade_count"] = view_.trade_count;
+        result["last_trade_price"] = view_.last_trade_price;
+        result["last_trade_quantity"] = view_.last_trade_quantity;
+        result["bids"] = levels(view_.bids);
+        result["asks"] = levels(view_.asks);
+        return result;
+    }
+    
+private:
+    ShmBookReader reader_;
+    ShmBookView view_;
+};
+
 PYBIND11_MODULE(order_engine_python, m) {
     m.doc() = "Ultra-Fast Analysis Order Matching Engine Python Bindings";
     
@@ -318,6 +373,17 @@ PYBIND11_MODULE(order_engine_python, m) {
         .def("generate_report", &PyPerformanceMonitor::generate_report)
         .def("print_summary", &PyPerformanceMonitor::print_summary);
     
+    // BookReader class
+    py::class_<PyBookReader>(m, "BookReader")
+        .def(py::init<>())
+        .def("open", &PyBookReader::open, py::arg("name") = ShmBookConfig{}.name)
+        .def("close", &PyBookReader::close)
+        .def("is_open", &PyBookReader::is_open)
+        .def("engine_running", &PyBookReader::engine_running)
+        .def("get_symbols", &PyBookReader::get_symbols)
+        .def("get_update_sequence", &PyBookReader::get_update_sequence)
+        .def("read", &PyBookReader::read);
+    
     // Constants
     m.attr("ORDER_SIDE_BUY") = "BUY";
     m.attr("ORDER_SIDE_SELL") = "SELL";
@@ -0,0 +1,197 @@
+#include "replay_market_data_source.h"
+#include "thread_name.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+namespace UltraFastAnalysis {
+
+ReplayMarketDataSource::ReplayMarketDataSource(const MarketDataConfig& config)
+    : config_(config) {
+}
+
+ReplayMarketDataSource::~ReplayMarketDataSource() {
+    disconnect();
+}
+
+bool ReplayMarketDataSource::connect() {
+    if (connected_.load()) {
+        return true;
+    }
+
+    file_ = std::fopen(config_.data_source_url.c_str(), "rb");
+    if (!file_) {
+        report_error("Failed to open recording " + config_.data_source_url + ": " + std::strerror(errno));
+        return false;
+    }
+
+    RecordingFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file_) != 1 ||
+        std::memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0) {
+        report_error("Not a market data recording: " + config_.data_source_url);
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    if (header.version != RECORDING_VERSION || header.record_size != sizeof(MarketDataRecord)) {
+        report_error("Unsupported recording version " + std::to_string(header.version) +
+                     ", record size " + std::to_string(header.record_size));
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    records_.resize(std::max<size_t>(config_.batch_size, 1));
+    replay_complete_.store(false);
+    connected_.store(true);
+    return true;
+}
+
+void ReplayMarketDataSource::disconnect() {
+    stop_streaming();
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    connected_.store(false);
+}
+
+bool ReplayMarketDataSource::is_connected() const {
+    return connected_.load();
+}
+
+bool ReplayMarketDataSource::start_streaming() {
+    if (!connected_.load() || streaming_.load()) {
+        return false;
+    }
+
+    streaming_.store(true);
+    shutdown_requested_.store(false);
+
+    replay_thread_ = std::thread(&ReplayMarketDataSource::replay_thread_worker, this);
+    return true;
+}
+
+void ReplayMarketDataSource::stop_streaming() {
+    if (!streaming_.load()) {
+        return;
+    }
+
+    shutdown_requested_.store(true);
+    streaming_.store(false);
+
+    if (replay_thread_.joinable()) {
+        replay_thread_.join();
+    }
+}
+
+void ReplayMarketDataSource::set_data_callback(std::function<void(const MarketData&)> callback) {
+    data_callback_ = callback;
+}
+
+void ReplayMarketDataSource::set_error_callback(std::function<void(const std::string&)> callback) {
+    error_callback_ = callback;
+}
+
+const MarketDataStats& ReplayMarketDataSource::get_stats() const {
+    return stats_;
+}
+
+void ReplayMarketDataSource::reset_stats() {
+    stats_.reset();
+}
+
+bool ReplayMarketDataSource::is_replay_complete() const {
+    return replay_complete_.load();
+}
+
+void ReplayMarketDataSource::replay_thread_worker() {
+    set_current_thread_name("replay_feed");
+    std::cout << "Market data replay started: " << config_.data_source_url << std::endl;
+
+    const bool paced = config_.replay_speed > 0.0;
+    const uint64_t max_gap_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(config_.replay_max_gap).count());
+
+    // Replay clock: recorded offset from the first record, minus collapsed gaps
+    bool first = true;
+    uint64_t previous_receive_ns = 0;
+    uint64_t recorded_offset_ns = 0;
+    auto replay_start = std::chrono::steady_clock::now();
+
+    while (!shutdown_requested_.load(std::memory_order_relaxed)) {
+        size_t count = std::fread(records_.data(), sizeof(MarketDataRecord), records_.size(), file_);
+        if (count == 0) {
+            if (std::ferror(file_)) {
+                report_error("Error reading recording " + config_.data_source_url);
+            }
+            break;
+        }
+
+        for (size_t i = 0; i < count && !shutdown_requested_.load(std::memory_order_relaxed); ++i) {
+            const MarketDataRecord& record = records_[i];
+
+            if (paced) {
+                if (first) {
+                    first = false;
+                    replay_start = std::chrono::steady_clock::now();
+                } else if (record.receive_timestamp_ns > previous_receive_ns) {
+                    uint64_t gap_ns = record.receive_timestamp_ns - previous_receive_ns;
+                    if (max_gap_ns > 0 && gap_ns > max_gap_ns) {
+                        gap_ns = max_gap_ns;
+                    }
+                    recorded_offset_ns += gap_ns;
+                }
+                previous_receive_ns = record.receive_timestamp_ns;
+
+                auto offset = std::chrono::nanoseconds(
+                    static_cast<int64_t>(static_cast<double>(recorded_offset_ns) / config_.replay_speed));
+                wait_until(replay_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+            }
+
+            decode_market_data_record(record, decoded_);
+
+            // Stamp with replay time so downstream latency measurements stay meaningful
+            decoded_.timestamp = std::chrono::high_resolution_clock::now();
+
+            stats_.messages_received.fetch_add(1, std::memory_order_relaxed);
+            if (data_callback_) {
+                data_callback_(decoded_);
+            }
+        }
+    }
+
+    if (!shutdown_requested_.load()) {
+        replay_complete_.store(true);
+    }
+
+    std::cout << "Market data replay finished: " << stats_.messages_received.load() << " events" << std::endl;
+}
+
+void ReplayMarketDataSource::wait_until(std::chrono::steady_clock::time_point deadline) {
+    // Sleep through long gaps, then spin the last stretch for accurate spacing
+    constexpr auto spin_window = std::chrono::microseconds(200);
+
+    auto now = std::chrono::steady_clock::now();
+    while (now < deadline && !shutdown_requested_.load(std::memory_order_relaxed)) {
+        auto remaining = deadline - now;
+        if (remaining > spin_window) {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                remaining - spin_window, std::chrono::milliseconds(100)));
+        }
+        now = std::chrono::steady_clock::now();
+    }
+}
+
+void ReplayMarketDataSource::report_error(const std::string& error) {
+    stats_.processing_errors.fetch_add(1, std::memory_order_relaxed);
+    if (error_callback_) {
+        error_callback_(error);
+    } else {
+        std::cerr << error << std::endl;
+    }
+}
+
+} // namespace UltraFastAnalysis
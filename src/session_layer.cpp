@@ -0,0 +1,302 @@
+#include "session_layer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace UltraFastAnalysis {
+
+// TimerWheel implementation
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, size_t slot_count)
+    : origin_(Clock::now()),
+      tick_(std::max<Clock::duration>(tick, std::chrono::milliseconds(1))),
+      slots_(std::max<size_t>(slot_count, 1)) {
+}
+
+void TimerWheel::schedule(uint64_t id, Clock::time_point deadline) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Round up so a timer never fires early; overdue timers fire on the next advance
+    uint64_t expiry_tick = 0;
+    if (deadline > origin_) {
+        expiry_tick = static_cast<uint64_t>((deadline - origin_ + tick_ - Clock::duration(1)) / tick_);
+    }
+    expiry_tick = std::max(expiry_tick, current_tick_);
+
+    slots_[expiry_tick % slots_.size()].push_back(Timer{id, expiry_tick});
+    ++size_;
+}
+
+void TimerWheel::advance(Clock::time_point now, std::vector<uint64_t>& expired) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (now < origin_) {
+        return;
+    }
+
+    uint64_t now_tick = static_cast<uint64_t>((now - origin_) / tick_);
+    if (now_tick < current_tick_) {
+        return;
+    }
+
+    // After a long stall every slot is visited once rather than once per missed tick
+    uint64_t ticks = std::min<uint64_t>(now_tick - current_tick_ + 1, slots_.size());
+    for (uint64_t i = 0; i < ticks; ++i) {
+        auto& slot = slots_[(current_tick_ + i) % slots_.size()];
+        for (size_t j = 0; j < slot.size();) {
+            if (slot[j].expiry_tick <= now_tick) {
+                expired.push_back(slot[j].id);
+                slot[j] = slot.back();
+                slot.pop_back();
+                --size_;
+            } else {
+                ++j;
+            }
+        }
+    }
+    current_tick_ = now_tick + 1;
+}
+
+size_t TimerWheel::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+// SessionJournal implementation
+SessionJournal::~SessionJournal() {
+    close();
+}
+
+bool SessionJournal::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    file_ = std::fopen(path.c_str(), "r+b");
+    bool created = false;
+    if (!file_) {
+        file_ = std::fopen(path.c_str(), "w+b");
+        created = true;
+    }
+    if (!file_) {
+        std::cerr << "Failed to open session journal " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, 1 << 16);
+
+    JournalFileHeader header{};
+    if (created) {
+        std::memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+        header.version = JOURNAL_VERSION;
+        header.created_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        if (std::fwrite(&header, sizeof(header), 1, file_) != 1 || std::fflush(file_) != 0) {
+            std::cerr << "Failed to write session journal header " << path << ": " << std::strerror(errno) << std::endl;
+            std::fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+        write_offset_ = sizeof(header);
+        return true;
+    }
+
+    if (std::fread(&header, sizeof(header), 1, file_) != 1 ||
+        std::memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != JOURNAL_VERSION) {
+        std::cerr << "Not a session journal: " << path << std::endl;
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    // Index every complete record; a record cut short by a crash ends the journal
+    uint64_t file_size = std::filesystem::file_size(path);
+    uint64_t offset = sizeof(header);
+    JournalRecordHeader record;
+    while (offset + sizeof(record) <= file_size && std::fread(&record, sizeof(record), 1, file_) == 1) {
+        if (record.sequence != offsets_.size() + 1 || offset + sizeof(record) + record.length > file_size) {
+            break;
+        }
+        if (record.length > 0 && std::fseek(file_, static_cast<long>(record.length), SEEK_CUR) != 0) {
+            break;
+        }
+        offsets_.push_back(offset);
+        offset += sizeof(record) + record.length;
+    }
+    last_sequence_ = offsets_.size();
+
+    if (offset < file_size) {
+        std::cerr << "Session journal " << path << ": dropping " << (file_size - offset)
+                  << " bytes after sequence " << last_sequence_ << std::endl;
+        std::error_code ec;
+        std::filesystem::resize_file(path, offset, ec);
+    }
+
+    write_offset_ = offset;
+    std::fseek(file_, static_cast<long>(write_offset_), SEEK_SET);
+    return true;
+}
+
+void SessionJournal::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool SessionJournal::append(uint64_t sequence, uint32_t message_type, uint64_t timestamp, bool recoverable,
+                            const void* payload, size_t length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence != last_sequence_ + 1) {
+        return false;
+    }
+    if (!file_) {
+        last_sequence_ = sequence;
+        return true;
+    }
+
+    // A read leaves the stream positioned inside the journal
+    if (reading_) {
+        std::fseek(file_, static_cast<long>(write_offset_), SEEK_SET);
+        reading_ = false;
+    }
+
+    JournalRecordHeader record{};
+    record.sequence = sequence;
+    record.timestamp = timestamp;
+    record.message_type = message_type;
+    record.length = recoverable ? static_cast<uint32_t>(length) : 0;
+    record.flags = recoverable ? JOURNAL_RECOVERABLE : 0;
+
+    if (std::fwrite(&record, sizeof(record), 1, file_) != 1 ||
+        (record.length > 0 && std::fwrite(payload, record.length, 1, file_) != 1)) {
+        std::cerr << "Session journal write failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Only a written record advances the journal, so last_sequence() always has an offset
+    last_sequence_ = sequence;
+    offsets_.push_back(write_offset_);
+    write_offset_ += sizeof(record) + record.length;
+    dirty_ = true;
+    return true;
+}
+
+bool SessionJournal::read(uint64_t sequence, JournalEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_ || sequence == 0 || sequence > offsets_.size()) {
+        return false;
+    }
+
+    // Switching from writing to reading needs a flush
+    if (!reading_) {
+        std::fflush(file_);
+        dirty_ = false;
+        reading_ = true;
+    }
+
+    JournalRecordHeader record;
+    if (std::fseek(file_, static_cast<long>(offsets_[sequence - 1]), SEEK_SET) != 0 ||
+        std::fread(&record, sizeof(record), 1, file_) != 1 || record.sequence != sequence) {
+        return false;
+    }
+
+    entry.sequence = record.sequence;
+    entry.timestamp = record.timestamp;
+    entry.message_type = record.message_type;
+    entry.recoverable = (record.flags & JOURNAL_RECOVERABLE) != 0;
+    entry.payload.resize(record.length);
+    return record.length == 0 || std::fread(entry.payload.data(), record.length, 1, file_) == 1;
+}
+
+void SessionJournal::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ && dirty_) {
+        std::fflush(file_);
+        dirty_ = false;
+    }
+}
+
+uint64_t SessionJournal::last_sequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_sequence_;
+}
+
+// SessionStore implementation
+SessionStore::SessionStore(const SessionConfig& config) : config_(config) {
+    if (!config_.journal_directory.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(config_.journal_directory, ec);
+        if (ec) {
+            std::cerr << "Failed to create session journal directory " << config_.journal_directory
+                      << ": " << ec.message() << std::endl;
+        }
+    }
+}
+
+std::shared_ptr<SessionJournal> SessionStore::claim(const std::string& session_name, uint64_t client_id) {
+    if (!is_valid_session_name(session_name)) {
+        std::cerr << "Invalid session name: " << session_name << std::endl;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& journal = journals_[session_name];
+    if (!journal) {
+        auto opened = std::make_shared<SessionJournal>();
+        if (!config_.journal_directory.empty()) {
+            auto path = std::filesystem::path(config_.journal_directory) / (session_name + ".journal");
+            if (!opened->open(path.string())) {
+                journals_.erase(session_name);
+                return nullptr;
+            }
+        }
+        journal = std::move(opened);
+    }
+
+    if (journal->in_use_) {
+        std::cerr << "Session " << session_name << " is already logged in" << std::endl;
+        return nullptr;
+    }
+    journal->in_use_ = true;
+    if (journal->client_id_ == 0) {
+        journal->client_id_ = client_id;
+    }
+    return journal;
+}
+
+void SessionStore::release(const std::shared_ptr<SessionJournal>& journal, uint64_t next_inbound_sequence,
+                           uint64_t next_order_sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    journal->in_use_ = false;
+    journal->next_inbound_sequence_ = next_inbound_sequence;
+    journal->next_order_sequence_ = next_order_sequence;
+    journal->flush();
+}
+
+void SessionStore::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [name, journal] : journals_) {
+        journal->flush();
+    }
+}
+
+ThrottleStats SessionStore::get_throttle_stats() const {
+    ThrottleStats stats;
+    stats.admitted = throttle_counters_.admitted.load(std::memory_order_relaxed);
+    stats.rejected = throttle_counters_.rejected.load(std::memory_order_relaxed);
+    stats.delayed = throttle_counters_.delayed.load(std::memory_order_relaxed);
+    stats.delay_ns = throttle_counters_.delay_ns.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool SessionStore::is_valid_session_name(const std::string& name) {
+    if (name.empty() || name.size() > 64 || name[0] == '.') {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+               c == '_' || c == '-' || c == '.';
+    });
+}
+
+} // namespace UltraFastAnalysis
@@ -0,0 +1,355 @@
+#include "shm_book_publisher.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+// The header is padded to a cache line so slot 0 starts on its own line
+constexpr size_t BOOK_HEADER_BYTES = 64;
+static_assert(sizeof(ShmBookHeader) <= BOOK_HEADER_BYTES, "ShmBookHeader outgrew its cache line");
+
+size_t segment_bytes(uint32_t max_symbols) {
+    return BOOK_HEADER_BYTES + static_cast<size_t>(max_symbols) * sizeof(ShmBookSlot);
+}
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+// ShmBookPublisher implementation
+ShmBookPublisher::ShmBookPublisher(const ShmBookConfig& config) : config_(config) {
+    config_.max_symbols = std::max<uint32_t>(config_.max_symbols, 1);
+}
+
+ShmBookPublisher::~ShmBookPublisher() {
+    stop();
+}
+
+bool ShmBookPublisher::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    // A segment left behind by a crashed engine is replaced; readers still mapping
+    // it keep the old books
+    shm_unlink(config_.name.c_str());
+    int fd = shm_open(config_.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared-memory books " << config_.name << ": "
+                  << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    segment_size_ = segment_bytes(config_.max_symbols);
+    void* segment = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(segment_size_)) == 0) {
+        segment = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (segment == MAP_FAILED) {
+        std::cerr << "Failed to map shared-memory books " << config_.name << ": "
+                  << std::strerror(errno) << std::endl;
+        shm_unlink(config_.name.c_str());
+        return false;
+    }
+    segment_ = segment;
+
+    // The object is zero-filled, so every slot starts empty with an even sequence
+    header()->version = SHM_BOOK_VERSION;
+    header()->max_symbols = config_.max_symbols;
+    header()->depth = static_cast<uint32_t>(SHM_BOOK_DEPTH);
+    header()->engine_pid = static_cast<uint32_t>(getpid());
+    header()->engine_running.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header()->magic = SHM_BOOK_MAGIC;
+
+    {
+        std::unique_lock<std::shared_mutex> lock(slots_mutex_);
+        slots_by_symbol_.clear();
+        overflow_reported_ = false;
+    }
+
+    running_.store(true);
+    std::cout << "Publishing order books to shared memory " << config_.name << " ("
+              << config_.max_symbols << " symbols, " << SHM_BOOK_DEPTH << " levels)" << std::endl;
+    return true;
+}
+
+void ShmBookPublisher::stop() {
+    if (!running_.load()) {
+        return;
+    }
+
+    // Matching threads may be inside publish(); the exclusive lock waits them out
+    std::unique_lock<std::shared_mutex> lock(slots_mutex_);
+    running_.store(false);
+    header()->engine_running.store(0, std::memory_order_release);
+
+    munmap(segment_, segment_size_);
+    segment_ = nullptr;
+    slots_by_symbol_.clear();
+    shm_unlink(config_.name.c_str());
+}
+
+bool ShmBookPublisher::is_running() const {
+    return running_.load();
+}
+
+size_t ShmBookPublisher::get_symbol_count() const {
+    std::shared_lock<std::shared_mutex> lock(slots_mutex_);
+    return slots_by_symbol_.size();
+}
+
+void ShmBookPublisher::publish(const std::string& symbol, const BookDepth& depth) {
+    std::shared_lock<std::shared_mutex> lock(slots_mutex_);
+    if (!running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    ShmBookSlot* target = nullptr;
+    auto it = slots_by_symbol_.find(symbol);
+    if (it != slots_by_symbol_.end()) {
+        target = it->second;
+    } else {
+        lock.unlock();
+        target = find_or_add_slot(symbol);
+        lock.lock();
+        if (!target || !running_.load(std::memory_order_relaxed)) {
+            return;
+        }
+    }
+
+    // The shared lock keeps stop() from unmapping the slot, and the book calling
+    // this is the slot's only writer
+    ShmBookSlot& slot = *target;
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t bid_count = std::min(depth.bid_count, SHM_BOOK_DEPTH);
+    size_t ask_count = std::min(depth.ask_count, SHM_BOOK_DEPTH);
+    for (size_t i = 0; i < bid_count; ++i) {
+        slot.bids[i].price.store(depth.bids[i].first, std::memory_order_relaxed);
+        slot.bids[i].quantity.store(depth.bids[i].second, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < ask_count; ++i) {
+        slot.asks[i].price.store(depth.asks[i].first, std::memory_order_relaxed);
+        slot.asks[i].quantity.store(depth.asks[i].second, std::memory_order_relaxed);
+    }
+    slot.bid_count.store(static_cast<uint32_t>(bid_count), std::memory_order_relaxed);
+    slot.ask_count.store(static_cast<uint32_t>(ask_count), std::memory_order_relaxed);
+    slot.update_sequence.store(depth.update_sequence, std::memory_order_relaxed);
+    slot.timestamp_ns.store(now_ns(), std::memory_order_relaxed);
+    slot.trade_count.store(depth.trade_count, std::memory_order_relaxed);
+    slot.last_trade_price.store(depth.last_trade_price, std::memory_order_relaxed);
+    slot.last_trade_quantity.store(depth.last_trade_quantity, std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+ShmBookSlot* ShmBookPublisher::slot(size_t index) const {
+    return reinterpret_cast<ShmBookSlot*>(static_cast<uint8_t*>(segment_) + BOOK_HEADER_BYTES) + index;
+}
+
+ShmBookSlot* ShmBookPublisher::find_or_add_slot(const std::string& symbol) {
+    std::unique_lock<std::shared_mutex> lock(slots_mutex_);
+    if (!running_.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    auto it = slots_by_symbol_.find(symbol);
+    if (it != slots_by_symbol_.end()) {
+        return it->second;
+    }
+
+    if (symbol.size() >= SHM_BOOK_SYMBOL_LENGTH || slots_by_symbol_.size() >= config_.max_symbols) {
+        if (!overflow_reported_) {
+            std::cerr << "Cannot publish " << symbol << " to shared memory: symbol too long or "
+                      << config_.max_symbols << " symbols already published" << std::endl;
+            overflow_reported_ = true;
+        }
+        return nullptr;
+    }
+
+    // The symbol is written before the slot is counted, so readers see it complete
+    uint32_t index = static_cast<uint32_t>(slots_by_symbol_.size());
+    ShmBookSlot* added = slot(index);
+    std::memcpy(added->symbol, symbol.data(), symbol.size());
+    header()->symbol_count.store(index + 1, std::memory_order_release);
+
+    slots_by_symbol_.emplace(symbol, added);
+    return added;
+}
+
+// ShmBookReader implementation
+ShmBookReader::~ShmBookReader() {
+    close();
+}
+
+bool ShmBookReader::open(const std::string& name) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "No shared-memory books at " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < BOOK_HEADER_BYTES) {
+        std::cerr << "Shared-memory books " << name << " are not initialised" << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    segment_size_ = static_cast<size_t>(info.st_size);
+    void* segment = mmap(nullptr, segment_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (segment == MAP_FAILED) {
+        std::cerr << "Failed to map shared-memory books " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    segment_ = segment;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header()->magic != SHM_BOOK_MAGIC || header()->version != SHM_BOOK_VERSION ||
+        header()->depth != SHM_BOOK_DEPTH || segment_size_ < segment_bytes(header()->max_symbols)) {
+        std::cerr << "Shared-memory books " << name << " have an incompatible layout" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ShmBookReader::close() {
+    if (segment_) {
+        munmap(segment_, segment_size_);
+        segment_ = nullptr;
+        segment_size_ = 0;
+    }
+    slots_by_symbol_.clear();
+    known_symbols_ = 0;
+}
+
+bool ShmBookReader::engine_running() const {
+    return segment_ && header()->engine_running.load(std::memory_order_acquire) != 0;
+}
+
+bool ShmBookReader::engine_alive() const {
+    // A crashed engine never clears engine_running, so check its process too
+    uint32_t pid = header()->engine_pid;
+    return engine_running() && pid != 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH);
+}
+
+std::vector<std::string> ShmBookReader::get_symbols() const {
+    std::vector<std::string> symbols;
+    if (!segment_) {
+        return symbols;
+    }
+
+    find_slot({});  // Picks up symbols published since the last call
+    symbols.reserve(slots_by_symbol_.size());
+    for (const auto& [symbol, slot] : slots_by_symbol_) {
+        symbols.push_back(symbol);
+    }
+    std::sort(symbols.begin(), symbols.end());
+    return symbols;
+}
+
+bool ShmBookReader::read(const std::string& symbol, ShmBookView& view) const {
+    const ShmBookSlot* slot = find_slot(symbol);
+    if (!slot) {
+        return false;
+    }
+    if (!read_slot(*slot, view)) {
+        return false;
+    }
+    view.symbol = symbol;
+    return true;
+}
+
+uint64_t ShmBookReader::get_update_sequence(const std::string& symbol) const {
+    const ShmBookSlot* slot = find_slot(symbol);
+    return slot ? slot->update_sequence.load(std::memory_order_acquire) : 0;
+}
+
+const ShmBookSlot* ShmBookReader::find_slot(const std::string& symbol) const {
+    if (!segment_) {
+        return nullptr;
+    }
+
+    auto it = slots_by_symbol_.find(symbol);
+    if (it != slots_by_symbol_.end()) {
+        return it->second;
+    }
+
+    uint32_t count = std::min(header()->symbol_count.load(std::memory_order_acquire), header()->max_symbols);
+    const auto* slots = reinterpret_cast<const ShmBookSlot*>(static_cast<const uint8_t*>(segment_) + BOOK_HEADER_BYTES);
+    for (; known_symbols_ < count; ++known_symbols_) {
+        const ShmBookSlot& slot = slots[known_symbols_];
+        std::string name(slot.symbol, strnlen(slot.symbol, SHM_BOOK_SYMBOL_LENGTH));
+        slots_by_symbol_.emplace(std::move(name), &slot);
+    }
+
+    it = slots_by_symbol_.find(symbol);
+    return it != slots_by_symbol_.end() ? it->second : nullptr;
+}
+
+bool ShmBookReader::read_slot(const ShmBookSlot& slot, ShmBookView& view) const {
+    // Retry until a read saw no write in progress and no write in between. An
+    // engine that died mid-write leaves the sequence odd for good, so the retries
+    // are bounded and check now and then that the engine is still there.
+    for (uint32_t attempt = 1; attempt <= READ_ATTEMPTS; ++attempt) {
+        if (attempt % LIVENESS_CHECK_INTERVAL == 0 && !engine_alive()) {
+            return false;
+        }
+
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            // The writer may have been preempted mid-write; let it finish
+            std::this_thread::yield();
+            continue;
+        }
+
+        size_t bid_count = std::min<size_t>(slot.bid_count.load(std::memory_order_relaxed), SHM_BOOK_DEPTH);
+        size_t ask_count = std::min<size_t>(slot.ask_count.load(std::memory_order_relaxed), SHM_BOOK_DEPTH);
+        view.bids.resize(bid_count);
+        view.asks.resize(ask_count);
+        for (size_t i = 0; i < bid_count; ++i) {
+            view.bids[i] = {slot.bids[i].price.load(std::memory_order_relaxed),
+                            slot.bids[i].quantity.load(std::memory_order_relaxed)};
+        }
+        for (size_t i = 0; i < ask_count; ++i) {
+            view.asks[i] = {slot.asks[i].price.load(std::memory_order_relaxed),
+                            slot.asks[i].quantity.load(std::memory_order_relaxed)};
+        }
+        view.update_sequence = slot.update_sequence.load(std::memory_order_relaxed);
+        view.timestamp_ns = slot.timestamp_ns.load(std::memory_order_relaxed);
+        view.trade_count = slot.trade_count.load(std::memory_order_relaxed);
+        view.last_trade_price = slot.last_trade_price.load(std::memory_order_relaxed);
+        view.last_trade_quantity = slot.last_trade_quantity.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace UltraFastAnalysis
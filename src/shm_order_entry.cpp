@@ -0,0 +1,768 @@
+#include "shm_order_entry.h"
+#include "thread_name.h"
+#include "tcp_server.h"
+#include <iostream>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+// Headers are padded to a cache line so the first ring starts on its own line
+constexpr size_t REGISTRY_HEADER_BYTES = 64;
+constexpr size_t CLIENT_HEADER_BYTES = 64;
+static_assert(sizeof(ShmRegistryHeader) <= REGISTRY_HEADER_BYTES, "ShmRegistryHeader outgrew its cache line");
+static_assert(sizeof(ShmClientHeader) <= CLIENT_HEADER_BYTES, "ShmClientHeader outgrew its cache line");
+
+// Client ids are BASE | generation << 16 | slot and must stay below 2^32 so that
+// order ids (client_id << 32 | sequence) do not overflow
+constexpr uint64_t SLOT_BITS = 16;
+constexpr uint64_t SLOT_MASK = (1ull << SLOT_BITS) - 1;
+constexpr uint64_t GENERATION_MASK = (1ull << (31 - SLOT_BITS)) - 1;
+constexpr uint32_t MAX_CLIENTS = 1u << SLOT_BITS;
+
+constexpr size_t POLL_BATCH = 64;   // Requests taken from one client before moving to the next
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+size_t registry_bytes(uint32_t max_clients) {
+    return REGISTRY_HEADER_BYTES + static_cast<size_t>(max_clients) * sizeof(ShmRegistrySlot);
+}
+
+size_t client_segment_bytes(uint32_t ring_capacity) {
+    return CLIENT_HEADER_BYTES + 2 * ShmRing::bytes(ring_capacity);
+}
+
+// Map a shared-memory object; nullptr on failure
+void* map_segment(int fd, size_t size) {
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return base == MAP_FAILED ? nullptr : base;
+}
+
+bool process_alive(uint32_t pid) {
+    return pid != 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH);
+}
+
+} // namespace
+
+// ShmRing implementation
+ShmRing::ShmRing(void* base, uint32_t capacity)
+    : indices_(static_cast<ShmRingIndices*>(base)),
+      slots_(reinterpret_cast<ShmMessage*>(static_cast<uint8_t*>(base) + sizeof(ShmRingIndices))),
+      mask_(capacity - 1) {
+    write_index_ = indices_->write_index.load(std::memory_order_acquire);
+    read_index_ = indices_->read_index.load(std::memory_order_acquire);
+}
+
+size_t ShmRing::bytes(uint32_t capacity) {
+    return sizeof(ShmRingIndices) + static_cast<size_t>(capacity) * sizeof(ShmMessage);
+}
+
+bool ShmRing::try_push(const ShmMessage& message) {
+    if (write_index_ - read_index_ > mask_) {
+        read_index_ = indices_->read_index.load(std::memory_order_acquire);
+        if (write_index_ - read_index_ > mask_) {
+            return false;
+        }
+    }
+
+    slots_[write_index_ & mask_] = message;
+    ++write_index_;
+    indices_->write_index.store(write_index_, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::try_pop(ShmMessage& message) {
+    if (read_index_ == write_index_) {
+        write_index_ = indices_->write_index.load(std::memory_order_acquire);
+        if (read_index_ == write_index_) {
+            return false;
+        }
+    }
+
+    message = slots_[read_index_ & mask_];
+    ++read_index_;
+    indices_->read_index.store(read_index_, std::memory_order_release);
+    return true;
+}
+
+// ShmOrderEntryGateway implementation
+ShmOrderEntryGateway::ShmOrderEntryGateway(const ShmOrderEntryConfig& config, const InstrumentRegistry& instruments)
+    : config_(config), instruments_(instruments) {
+    config_.max_clients = std::clamp<uint32_t>(config_.max_clients, 1, MAX_CLIENTS);
+    config_.ring_capacity = std::bit_ceil(std::max<uint32_t>(config_.ring_capacity, 2));
+}
+
+ShmOrderEntryGateway::~ShmOrderEntryGateway() {
+    stop();
+}
+
+bool ShmOrderEntryGateway::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    // Instruments are fixed once the engine starts; execution reports look them up by symbol
+    instruments_by_symbol_.clear();
+    for (const InstrumentInfo* instrument : instruments_.get_instruments()) {
+        instruments_by_symbol_[instrument->symbol] = instrument;
+    }
+
+    // A registry left behind by a crashed engine is replaced
+    shm_unlink(config_.name.c_str());
+    int fd = shm_open(config_.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared-memory registry " << config_.name << ": "
+                  << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    registry_size_ = registry_bytes(config_.max_clients);
+    if (ftruncate(fd, static_cast<off_t>(registry_size_)) != 0) {
+        std::cerr << "Failed to size shared-memory registry: " << std::strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(config_.name.c_str());
+        return false;
+    }
+    registry_ = map_segment(fd, registry_size_);
+    close(fd);
+    if (!registry_) {
+        std::cerr << "Failed to map shared-memory registry: " << std::strerror(errno) << std::endl;
+        shm_unlink(config_.name.c_str());
+        return false;
+    }
+
+    // The object is zero-filled, so every slot starts FREE
+    auto* header = static_cast<ShmRegistryHeader*>(registry_);
+    header->version = SHM_ORDER_ENTRY_VERSION;
+    header->max_clients = config_.max_clients;
+    header->ring_capacity = config_.ring_capacity;
+    header->engine_pid = static_cast<uint32_t>(getpid());
+    header->engine_running.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SHM_ORDER_ENTRY_MAGIC;
+
+    clients_ = std::make_unique<Client[]>(config_.max_clients);
+    client_count_.store(0);
+
+    running_.store(true);
+    poll_thread_ = std::thread(&ShmOrderEntryGateway::poll_thread_function, this);
+
+    std::cout << "Shared-memory order entry started on " << config_.name << " ("
+              << config_.max_clients << " clients, " << config_.ring_capacity << " messages per ring)" << std::endl;
+    return true;
+}
+
+void ShmOrderEntryGateway::stop() {
+    if (!running_.load()) {
+        return;
+    }
+
+    running_.store(false);
+    if (poll_thread_.joinable()) {
+        poll_thread_.join();
+    }
+
+    auto* header = static_cast<ShmRegistryHeader*>(registry_);
+    header->engine_running.store(0, std::memory_order_release);
+
+    for (size_t slot = 0; slot < config_.max_clients; ++slot) {
+        close_client(slot);
+    }
+
+    munmap(registry_, registry_size_);
+    registry_ = nullptr;
+    shm_unlink(config_.name.c_str());
+
+    std::cout << "Shared-memory order entry stopped" << std::endl;
+}
+
+bool ShmOrderEntryGateway::is_running() const {
+    return running_.load();
+}
+
+size_t ShmOrderEntryGateway::get_client_count() const {
+    return client_count_.load();
+}
+
+void ShmOrderEntryGateway::set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback) {
+    order_submit_callback_ = callback;
+}
+
+void ShmOrderEntryGateway::set_order_cancel_callback(std::function<bool(uint64_t, const std::string&)> callback) {
+    order_cancel_callback_ = callback;
+}
+
+void ShmOrderEntryGateway::set_order_modify_callback(std::function<bool(uint64_t, const std::string&, uint64_t, double)> callback) {
+    order_modify_callback_ = callback;
+}
+
+void ShmOrderEntryGateway::set_order_mass_cancel_callback(std::function<size_t(uint64_t, const std::string&, MassCancelSide)> callback) {
+    order_mass_cancel_callback_ = callback;
+}
+
+void ShmOrderEntryGateway::set_order_status_callback(std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> callback) {
+    order_status_callback_ = callback;
+}
+
+void ShmOrderEntryGateway::on_execution(const Order& order, uint64_t fill_quantity, double fill_price) {
+    uint64_t client_id = order.client_id;
+    if (!running_.load(std::memory_order_relaxed) || (client_id & SHM_CLIENT_ID_BASE) == 0 ||
+        client_id >= (1ull << 32)) {
+        return;
+    }
+
+    size_t slot = client_id & SLOT_MASK;
+    if (slot >= config_.max_clients) {
+        return;
+    }
+
+    auto instrument = instruments_by_symbol_.find(order.symbol);
+    if (instrument == instruments_by_symbol_.end()) {
+        return;
+    }
+
+    ExecutionReportMessage report{};
+    report.order_id = order.order_id;
+    report.last_quantity = fill_quantity;
+    report.last_price = fill_quantity ? InstrumentRegistry::price_to_ticks(*instrument->second, fill_price) : 0;
+    report.filled_quantity = order.filled_quantity;
+    report.leaves_quantity = order.status == OrderStatus::CANCELLED ? 0 : order.remaining_quantity();
+    report.instrument_id = instrument->second->instrument_id;
+    report.status = static_cast<uint8_t>(order.status);
+
+    // The id check under the lock drops reports for a client that has since left the slot
+    Client& client = clients_[slot];
+    std::lock_guard<std::mutex> lock(client.response_mutex);
+    if (client.client_id == client_id) {
+        send_response(client, MessageType::EXECUTION_REPORT, &report, sizeof(report));
+    }
+}
+
+ShmRegistrySlot* ShmOrderEntryGateway::registry_slot(size_t slot) const {
+    return reinterpret_cast<ShmRegistrySlot*>(static_cast<uint8_t*>(registry_) + REGISTRY_HEADER_BYTES) + slot;
+}
+
+std::string ShmOrderEntryGateway::segment_name(size_t slot) const {
+    return config_.name + "." + std::to_string(slot);
+}
+
+void ShmOrderEntryGateway::poll_thread_function() {
+    set_current_thread_name("shm_entry");
+    size_t idle_polls = 0;
+    auto next_liveness_check = std::chrono::steady_clock::now() + LIVENESS_CHECK_INTERVAL;
+
+    while (running_.load(std::memory_order_relaxed)) {
+        size_t processed = 0;
+        for (size_t slot = 0; slot < config_.max_clients; ++slot) {
+            if (clients_[slot].client_id != 0) {
+                processed += poll_client(clients_[slot]);
+            }
+        }
+
+        if (processed > 0) {
+            idle_polls = 0;
+            continue;
+        }
+
+        // Registrations are picked up between bursts of requests
+        auto now = std::chrono::steady_clock::now();
+        bool check_liveness = now >= next_liveness_check;
+        if (check_liveness) {
+            next_liveness_check = now + LIVENESS_CHECK_INTERVAL;
+        }
+        scan_registry(check_liveness);
+
+        if (++idle_polls >= IDLE_SPINS && config_.idle_sleep.count() > 0) {
+            std::this_thread::sleep_for(config_.idle_sleep);
+        }
+    }
+}
+
+void ShmOrderEntryGateway::scan_registry(bool check_liveness) {
+    for (size_t slot = 0; slot < config_.max_clients; ++slot) {
+        ShmRegistrySlot* entry = registry_slot(slot);
+        auto state = static_cast<ShmSlotState>(entry->state.load(std::memory_order_acquire));
+
+        switch (state) {
+            case ShmSlotState::REQUESTED: {
+                // A client that timed out meanwhile has moved the slot to CLOSING; the
+                // next scan then removes whatever was opened
+                auto answer = open_client(slot) ? ShmSlotState::ACTIVE : ShmSlotState::REJECTED;
+                uint32_t expected = static_cast<uint32_t>(ShmSlotState::REQUESTED);
+                entry->state.compare_exchange_strong(expected, static_cast<uint32_t>(answer),
+                                                     std::memory_order_acq_rel, std::memory_order_acquire);
+                break;
+            }
+
+            case ShmSlotState::CLOSING:
+                close_client(slot);
+                entry->client_pid = 0;
+                entry->state.store(static_cast<uint32_t>(ShmSlotState::FREE), std::memory_order_release);
+                break;
+
+            case ShmSlotState::CLAIMED:
+            case ShmSlotState::ACTIVE:
+                // A client that died without closing would otherwise hold its slot forever
+                if (check_liveness && entry->client_pid != 0 && !process_alive(entry->client_pid)) {
+                    std::cerr << "Shared-memory client " << clients_[slot].name << " (pid "
+                              << entry->client_pid << ") exited without closing" << std::endl;
+                    close_client(slot);
+                    entry->client_pid = 0;
+                    entry->state.store(static_cast<uint32_t>(ShmSlotState::FREE), std::memory_order_release);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+bool ShmOrderEntryGateway::open_client(size_t slot) {
+    ShmRegistrySlot* entry = registry_slot(slot);
+    std::string name = segment_name(slot);
+
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared-memory segment " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    size_t size = client_segment_bytes(config_.ring_capacity);
+    void* segment = nullptr;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        segment = map_segment(fd, size);
+    }
+    close(fd);
+    if (!segment) {
+        std::cerr << "Failed to map shared-memory segment " << name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    Client& client = clients_[slot];
+    uint64_t client_id = SHM_CLIENT_ID_BASE | ((client.generation & GENERATION_MASK) << SLOT_BITS) | slot;
+
+    auto* header = static_cast<ShmClientHeader*>(segment);
+    header->magic = SHM_ORDER_ENTRY_MAGIC;
+    header->client_id = client_id;
+    header->ring_capacity = config_.ring_capacity;
+
+    uint8_t* rings = static_cast<uint8_t*>(segment) + CLIENT_HEADER_BYTES;
+    {
+        std::lock_guard<std::mutex> lock(client.response_mutex);
+        client.segment = segment;
+        client.segment_size = size;
+        client.requests = ShmRing(rings, config_.ring_capacity);
+        client.responses = ShmRing(rings + ShmRing::bytes(config_.ring_capacity), config_.ring_capacity);
+        client.client_id = client_id;
+        client.pid = entry->client_pid;
+        client.next_order_sequence = 0;
+        client.dropped_responses = 0;
+        client.name.assign(entry->client_name, strnlen(entry->client_name, sizeof(entry->client_name)));
+        ++client.generation;
+    }
+
+    entry->client_id = client_id;
+    client_count_.fetch_add(1);
+
+    std::cout << "Shared-memory client " << client.name << " (pid " << client.pid << ") registered as "
+              << client_id << std::endl;
+    return true;
+}
+
+void ShmOrderEntryGateway::close_client(size_t slot) {
+    Client& client = clients_[slot];
+    std::lock_guard<std::mutex> lock(client.response_mutex);
+    if (!client.segment) {
+        return;
+    }
+
+    if (client.dropped_responses > 0) {
+        std::cerr << "Shared-memory client " << client.name << " dropped " << client.dropped_responses
+                  << " responses on a full ring" << std::endl;
+    }
+
+    munmap(client.segment, client.segment_size);
+    shm_unlink(segment_name(slot).c_str());
+    client.segment = nullptr;
+    client.segment_size = 0;
+    client.requests = ShmRing();
+    client.responses = ShmRing();
+    client.client_id = 0;
+    registry_slot(slot)->client_id = 0;
+    client_count_.fetch_sub(1);
+}
+
+size_t ShmOrderEntryGateway::poll_client(Client& client) {
+    ShmMessage message;
+    size_t processed = 0;
+    while (processed < POLL_BATCH && client.requests.try_pop(message)) {
+        handle_request(client, message);
+        ++processed;
+    }
+    return processed;
+}
+
+void ShmOrderEntryGateway::handle_request(Client& client, const ShmMessage& message) {
+    size_t length = std::min<size_t>(message.length, sizeof(message.body));
+
+    switch (static_cast<MessageType>(message.message_type)) {
+        case MessageType::BINARY_NEW_ORDER:
+            if (auto* body = decode_message<NewOrderMessage>(message.body, length)) {
+                handle_new_order(client, *body);
+                return;
+            }
+            break;
+        case MessageType::BINARY_CANCEL_ORDER:
+            if (auto* body = decode_message<CancelOrderMessage>(message.body, length)) {
+                handle_cancel_order(client, *body);
+                return;
+            }
+            break;
+        case MessageType::BINARY_AMEND_ORDER:
+            if (auto* body = decode_message<AmendOrderMessage>(message.body, length)) {
+                handle_amend_order(client, *body);
+                return;
+            }
+            break;
+        case MessageType::MASS_CANCEL:
+            if (auto* body = decode_message<MassCancelMessage>(message.body, length)) {
+                handle_mass_cancel(client, *body);
+                return;
+            }
+            break;
+        case MessageType::ORDER_STATUS_REQUEST:
+            if (auto* body = decode_message<OrderStatusRequestMessage>(message.body, length)) {
+                handle_order_status_request(client, *body);
+                return;
+            }
+            break;
+        default:
+            std::cerr << "Unsupported shared-memory message type " << message.message_type
+                      << " from " << client.name << std::endl;
+            return;
+    }
+
+    std::cerr << "Invalid shared-memory message length " << message.length << " for type "
+              << message.message_type << " from " << client.name << std::endl;
+}
+
+void ShmOrderEntryGateway::handle_new_order(Client& client, const NewOrderMessage& message) {
+    OrderAckMessage ack{};
+    ack.client_order_id = message.client_order_id;
+    ack.instrument_id = message.instrument_id;
+
+    const InstrumentInfo* instrument = instruments_.find(message.instrument_id);
+    OrderRejectReason reason = validate_new_order(message, instrument);
+
+    // Held across the submit so that the ack is ahead of any fill the matching threads report
+    std::lock_guard<std::mutex> lock(client.response_mutex);
+    if (reason == OrderRejectReason::NONE) {
+        auto order = make_order();
+        order->order_id = (client.client_id << 32) | ++client.next_order_sequence;
+        order->client_id = client.client_id;
+        order->symbol = instrument->symbol;
+        order->side = static_cast<OrderSide>(message.side);
+        order->type = static_cast<OrderType>(message.order_type);
+        order->quantity = message.quantity;
+        order->price = InstrumentRegistry::ticks_to_price(*instrument, message.price);
+        order->stop_price = InstrumentRegistry::ticks_to_price(*instrument, message.stop_price);
+        order->timestamp = std::chrono::high_resolution_clock::now();
+
+        if (order_submit_callback_ && order_submit_callback_(order)) {
+            ack.order_id = order->order_id;
+        } else {
+            reason = OrderRejectReason::UNAVAILABLE;
+        }
+    }
+
+    ack.status = static_cast<uint8_t>(reason == OrderRejectReason::NONE ? OrderAckStatus::ACCEPTED
+                                                                          : OrderAckStatus::REJECTED);
+    ack.reject_reason = static_cast<uint8_t>(reason);
+    send_response(client, MessageType::ORDER_ACK, &ack, sizeof(ack));
+}
+
+void ShmOrderEntryGateway::handle_cancel_order(Client& client, const CancelOrderMessage& message) {
+    const InstrumentInfo* instrument = instruments_.find(message.instrument_id);
+    if (!instrument) {
+        std::cerr << "Cancel for unknown instrument " << message.instrument_id << " from " << client.name << std::endl;
+        return;
+    }
+
+    // Clients only touch their own orders; the result arrives as an execution report
+    if ((message.order_id >> 32) == client.client_id && order_cancel_callback_) {
+        order_cancel_callback_(message.order_id, instrument->symbol);
+    }
+}
+
+void ShmOrderEntryGateway::handle_amend_order(Client& client, const AmendOrderMessage& message) {
+    const InstrumentInfo* instrument = instruments_.find(message.instrument_id);
+    if (!instrument) {
+        std::cerr << "Amend for unknown instrument " << message.instrument_id << " from " << client.name << std::endl;
+        return;
+    }
+
+    if (message.new_quantity == 0 || message.new_price <= 0) {
+        std::cerr << "Invalid amend for order " << message.order_id << " from " << client.name << std::endl;
+        return;
+    }
+
+    if ((message.order_id >> 32) == client.client_id && order_modify_callback_) {
+        order_modify_callback_(message.order_id, instrument->symbol, message.new_quantity,
+                               InstrumentRegistry::ticks_to_price(*instrument, message.new_price));
+    }
+}
+
+void ShmOrderEntryGateway::handle_mass_cancel(Client& client, const MassCancelMessage& message) {
+    if (message.side > static_cast<uint8_t>(MassCancelSide::BOTH)) {
+        std::cerr << "Invalid mass cancel message from " << client.name << std::endl;
+        return;
+    }
+
+    // Instrument id 0 cancels across every instrument
+    static const std::string all_instruments;
+    const std::string* symbol = &all_instruments;
+    if (message.instrument_id != 0) {
+        const InstrumentInfo* instrument = instruments_.find(message.instrument_id);
+        if (!instrument) {
+            std::cerr << "Mass cancel for unknown instrument " << message.instrument_id
+                      << " from " << client.name << std::endl;
+            return;
+        }
+        symbol = &instrument->symbol;
+    }
+
+    if (order_mass_cancel_callback_) {
+        order_mass_cancel_callback_(client.client_id, *symbol, static_cast<MassCancelSide>(message.side));
+    }
+}
+
+void ShmOrderEntryGateway::handle_order_status_request(Client& client, const OrderStatusRequestMessage& message) {
+    OrderStatusMessage reply{};
+    reply.order_id = message.order_id;
+    reply.instrument_id = message.instrument_id;
+    reply.result = static_cast<uint8_t>(OrderStatusResult::UNKNOWN_ORDER);
+
+    // Clients only see their own orders
+    const InstrumentInfo* instrument = instruments_.find(message.instrument_id);
+    OrderStatusEntry entry;
+    if (!instrument) {
+        reply.result = static_cast<uint8_t>(OrderStatusResult::UNKNOWN_INSTRUMENT);
+    } else if (order_status_callback_ && order_status_callback_(message.order_id, instrument->symbol, entry) &&
+               entry.client_id == client.client_id) {
+        reply.result = static_cast<uint8_t>(OrderStatusResult::FOUND);
+        reply.status = static_cast<uint8_t>(entry.status);
+        reply.quantity = entry.quantity;
+        reply.filled_quantity = entry.filled_quantity;
+        reply.average_price = entry.average_price;
+        reply.update_sequence = entry.update_sequence;
+    }
+
+    std::lock_guard<std::mutex> lock(client.response_mutex);
+    send_response(client, MessageType::ORDER_STATUS_REQUEST, &reply, sizeof(reply));
+}
+
+bool ShmOrderEntryGateway::send_response(Client& client, MessageType type, const void* body, size_t length) {
+    ShmMessage message{};
+    message.message_type = static_cast<uint16_t>(type);
+    message.length = static_cast<uint16_t>(length);
+    message.timestamp = now_ns();
+    std::memcpy(message.body, body, length);
+
+    // Never wait on a client that is not draining its responses
+    if (!client.responses.try_push(message)) {
+        ++client.dropped_responses;
+        return false;
+    }
+    return true;
+}
+
+// ShmOrderEntryClient implementation
+ShmOrderEntryClient::~ShmOrderEntryClient() {
+    disconnect();
+}
+
+bool ShmOrderEntryClient::connect(const std::string& name, const std::string& client_name,
+                                  std::chrono::milliseconds timeout) {
+    if (is_connected()) {
+        return true;
+    }
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        std::cerr << "No shared-memory order entry at " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < REGISTRY_HEADER_BYTES) {
+        std::cerr << "Shared-memory registry " << name << " is not initialised" << std::endl;
+        close(fd);
+        return false;
+    }
+    registry_size_ = static_cast<size_t>(info.st_size);
+    registry_ = map_segment(fd, registry_size_);
+    close(fd);
+    if (!registry_) {
+        std::cerr << "Failed to map shared-memory registry " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    auto* header = static_cast<ShmRegistryHeader*>(registry_);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->magic != SHM_ORDER_ENTRY_MAGIC || header->version != SHM_ORDER_ENTRY_VERSION ||
+        registry_size_ < registry_bytes(header->max_clients) || !engine_running()) {
+        std::cerr << "Shared-memory registry " << name << " is incompatible or its engine has stopped" << std::endl;
+        unmap();
+        return false;
+    }
+
+    // Claim a free slot
+    ShmRegistrySlot* entry = nullptr;
+    auto* slots = reinterpret_cast<ShmRegistrySlot*>(static_cast<uint8_t*>(registry_) + REGISTRY_HEADER_BYTES);
+    for (size_t slot = 0; slot < header->max_clients; ++slot) {
+        uint32_t expected = static_cast<uint32_t>(ShmSlotState::FREE);
+        if (slots[slot].state.compare_exchange_strong(expected, static_cast<uint32_t>(ShmSlotState::CLAIMED),
+                                                      std::memory_order_acq_rel)) {
+            entry = &slots[slot];
+            slot_ = slot;
+            break;
+        }
+    }
+    if (!entry) {
+        std::cerr << "No free shared-memory order entry slot at " << name << std::endl;
+        unmap();
+        return false;
+    }
+
+    entry->client_pid = static_cast<uint32_t>(getpid());
+    std::memset(entry->client_name, 0, sizeof(entry->client_name));
+    std::memcpy(entry->client_name, client_name.data(), std::min(client_name.size(), sizeof(entry->client_name) - 1));
+    entry->state.store(static_cast<uint32_t>(ShmSlotState::REQUESTED), std::memory_order_release);
+
+    // The engine answers from its poll thread
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    ShmSlotState state = ShmSlotState::REQUESTED;
+    while ((state = static_cast<ShmSlotState>(entry->state.load(std::memory_order_acquire))) ==
+           ShmSlotState::REQUESTED) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+    }
+
+    // Giving up races the engine's answer; whichever side moves the slot out of
+    // REQUESTED first decides, and a late answer is taken as if it came in time
+    if (state == ShmSlotState::REQUESTED) {
+        uint32_t expected = static_cast<uint32_t>(ShmSlotState::REQUESTED);
+        if (entry->state.compare_exchange_strong(expected, static_cast<uint32_t>(ShmSlotState::CLOSING),
+                                                 std::memory_order_acq_rel, std::memory_order_acquire)) {
+            std::cerr << "Timed out registering with shared-memory order entry at " << name << std::endl;
+            unmap();
+            return false;
+        }
+        state = static_cast<ShmSlotState>(expected);
+    }
+
+    if (state != ShmSlotState::ACTIVE) {
+        std::cerr << "Engine rejected shared-memory registration" << std::endl;
+        entry->state.store(static_cast<uint32_t>(ShmSlotState::FREE), std::memory_order_release);
+        unmap();
+        return false;
+    }
+
+    std::string segment = name + "." + std::to_string(slot_);
+    fd = shm_open(segment.c_str(), O_RDWR, 0);
+    uint32_t capacity = header->ring_capacity;
+    size_t size = client_segment_bytes(capacity);
+    void* base = fd >= 0 ? map_segment(fd, size) : nullptr;
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    auto* client_header = static_cast<ShmClientHeader*>(base);
+    if (!base || client_header->magic != SHM_ORDER_ENTRY_MAGIC || client_header->client_id != entry->client_id ||
+        client_header->ring_capacity != capacity) {
+        std::cerr << "Failed to map shared-memory segment " << segment << std::endl;
+        if (base) {
+            munmap(base, size);
+        }
+        entry->state.store(static_cast<uint32_t>(ShmSlotState::CLOSING), std::memory_order_release);
+        unmap();
+        return false;
+    }
+
+    segment_ = base;
+    segment_size_ = size;
+    client_id_ = client_header->client_id;
+    uint8_t* rings = static_cast<uint8_t*>(base) + CLIENT_HEADER_BYTES;
+    requests_ = ShmRing(rings, capacity);
+    responses_ = ShmRing(rings + ShmRing::bytes(capacity), capacity);
+    return true;
+}
+
+void ShmOrderEntryClient::disconnect() {
+    if (!registry_) {
+        return;
+    }
+
+    if (segment_) {
+        auto* slots = reinterpret_cast<ShmRegistrySlot*>(static_cast<uint8_t*>(registry_) + REGISTRY_HEADER_BYTES);
+        slots[slot_].state.store(static_cast<uint32_t>(ShmSlotState::CLOSING), std::memory_order_release);
+    }
+    unmap();
+}
+
+bool ShmOrderEntryClient::send(MessageType type, const void* body, size_t length) {
+    if (!segment_ || length > sizeof(ShmMessage::body)) {
+        return false;
+    }
+
+    ShmMessage message{};
+    message.message_type = static_cast<uint16_t>(type);
+    message.length = static_cast<uint16_t>(length);
+    message.timestamp = now_ns();
+    std::memcpy(message.body, body, length);
+    return requests_.try_push(message);
+}
+
+bool ShmOrderEntryClient::poll(ShmMessage& message) {
+    return segment_ && responses_.try_pop(message);
+}
+
+bool ShmOrderEntryClient::engine_running() const {
+    return registry_ &&
+           static_cast<const ShmRegistryHeader*>(registry_)->engine_running.load(std::memory_order_acquire) != 0;
+}
+
+void ShmOrderEntryClient::unmap() {
+    if (segment_) {
+        munmap(segment_, segment_size_);
+        segment_ = nullptr;
+        segment_size_ = 0;
+    }
+    if (registry_) {
+        munmap(registry_, registry_size_);
+        registry_ = nullptr;
+        registry_size_ = 0;
+    }
+    requests_ = ShmRing();
+    responses_ = ShmRing();
+    client_id_ = 0;
+}
+
+} // namespace UltraFastAnalysis
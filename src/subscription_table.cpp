@@ -0,0 +1,108 @@
+#include "subscription_table.h"
+#include <mutex>
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+void set_channels(std::array<SessionBitset, SUBSCRIPTION_CHANNEL_COUNT>& bitsets, uint32_t slot, uint8_t channels) {
+    for (size_t i = 0; i < SUBSCRIPTION_CHANNEL_COUNT; ++i) {
+        if (channels & (1u << i)) {
+            bitsets[i].set(slot);
+        }
+    }
+}
+
+void clear_channels(std::array<SessionBitset, SUBSCRIPTION_CHANNEL_COUNT>& bitsets, uint32_t slot, uint8_t channels) {
+    for (size_t i = 0; i < SUBSCRIPTION_CHANNEL_COUNT; ++i) {
+        if (channels & (1u << i)) {
+            bitsets[i].clear(slot);
+        }
+    }
+}
+
+} // namespace
+
+bool SubscriptionTable::subscribe(uint32_t slot, const std::string& symbol, uint8_t channels) {
+    if (slot >= MAX_SUBSCRIBER_SESSIONS) {
+        return false;
+    }
+
+    if (symbol == WILDCARD) {
+        set_channels(wildcard_.channels, slot, channels);
+        return true;
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = instruments_.find(symbol);
+        if (it != instruments_.end()) {
+            set_channels(it->second->channels, slot, channels);
+            return true;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = instruments_.find(symbol);
+    if (it == instruments_.end()) {
+        if (instruments_.size() >= MAX_INSTRUMENTS) {
+            return false;
+        }
+        it = instruments_.emplace(symbol, std::make_unique<InstrumentSubscribers>()).first;
+    }
+    set_channels(it->second->channels, slot, channels);
+    return true;
+}
+
+void SubscriptionTable::unsubscribe(uint32_t slot, const std::string& symbol, uint8_t channels) {
+    if (slot >= MAX_SUBSCRIBER_SESSIONS) {
+        return;
+    }
+
+    if (symbol == WILDCARD) {
+        clear_channels(wildcard_.channels, slot, channels);
+        return;
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = instruments_.find(symbol);
+        if (it == instruments_.end()) {
+            return;
+        }
+        clear_channels(it->second->channels, slot, channels);
+        if (!it->second->empty()) {
+            return;
+        }
+    }
+    erase_if_empty(symbol);
+}
+
+void SubscriptionTable::remove_session(uint32_t slot) {
+    if (slot >= MAX_SUBSCRIBER_SESSIONS) {
+        return;
+    }
+
+    clear_channels(wildcard_.channels, slot, CHANNEL_ALL);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto it = instruments_.begin(); it != instruments_.end();) {
+        clear_channels(it->second->channels, slot, CHANNEL_ALL);
+        if (it->second->empty()) {
+            it = instruments_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SubscriptionTable::erase_if_empty(const std::string& symbol) {
+    // Another session may have subscribed since the shared lock was released
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = instruments_.find(symbol);
+    if (it != instruments_.end() && it->second->empty()) {
+        instruments_.erase(it);
+    }
+}
+
+} // namespace UltraFastAnalysis
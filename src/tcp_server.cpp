@@ -1,17 +1,101 @@
 #include "tcp_server.h"
+#include "thread_name.h"
+#include <algorithm>
 #include <iostream>
 #include <cstring>
+#include <stdexcept>
 #include <sstream>
+#include <charconv>
+#include <string_view>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace UltraFastAnalysis {
 
+namespace {
+
+int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Messages that would be wrong to replay are gap-filled on resend instead:
+// market data is stale, and session messages belong to the original connection
+bool is_recoverable(MessageType type) {
+    switch (type) {
+        case MessageType::MARKET_DATA:
+        case MessageType::ORDER_BOOK_REQUEST:
+        case MessageType::ORDER_STATUS_REQUEST:
+        case MessageType::HEARTBEAT:
+        case MessageType::LOGIN:
+        case MessageType::LOGOUT:
+        case MessageType::RESEND_REQUEST:
+        case MessageType::SEQUENCE_RESET:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Session messages are processed even while the inbound stream has a gap
+bool is_session_message(MessageType type) {
+    return type == MessageType::HEARTBEAT || type == MessageType::LOGOUT ||
+           type == MessageType::RESEND_REQUEST || type == MessageType::SEQUENCE_RESET;
+}
+
+const SessionConfig default_session_config{};
+
+// Field `index` of a colon-separated text message, empty if it has fewer fields
+std::string_view text_field(const uint8_t* data, size_t length, size_t index) {
+    const char* begin = reinterpret_cast<const char*>(data);
+    const char* end = begin + length;
+    for (; index > 0 && begin != end; --index) {
+        begin = std::find(begin, end, ':');
+        if (begin != end) {
+            ++begin;
+        }
+    }
+    return index == 0 ? std::string_view(begin, std::find(begin, end, ':') - begin) : std::string_view();
+}
+
+// The string's buffer is charged by hand; the allocator covers the object and control block
+struct ChargedPayload {
+    std::string data;
+    MemoryCharge memory;
+
+    explicit ChargedPayload(std::string payload)
+        : data(std::move(payload)), memory(MemorySubsystem::CONNECTION_BUFFERS, data.capacity()) {}
+};
+
+} // namespace
+
+std::shared_ptr<const std::string> make_outbound_payload(std::string data) {
+    auto payload = std::allocate_shared<ChargedPayload>(
+        TrackingAllocator<ChargedPayload, MemorySubsystem::CONNECTION_BUFFERS>(), std::move(data));
+    return std::shared_ptr<const std::string>(payload, &payload->data);
+}
+
+// ProtocolSession implementation
+ProtocolSession::ProtocolSession(uint64_t connection_id, std::shared_ptr<const InstrumentRegistry> instruments)
+    : connection_id_(connection_id), client_id_(connection_id), client_name_("Unknown"), instruments_(std::move(instruments)) {
+}
+
 // ClientConnection implementation
-ClientConnection::ClientConnection(boost::asio::ip::tcp::socket socket)
-    : socket_(std::move(socket)), client_id_(0), client_name_("Unknown") {
+ClientConnection::ClientConnection(boost::asio::ip::tcp::socket socket, uint64_t connection_id,
+                                   std::shared_ptr<const InstrumentRegistry> instruments)
+    : ProtocolSession(connection_id, std::move(instruments)),
+      socket_(std::move(socket)), strand_(boost::asio::make_strand(socket_.get_executor())),
+      throttle_timer_(strand_) {
+    pending_.reserve(MAX_WRITE_BATCH);
+    writing_.reserve(MAX_WRITE_BATCH);
+    write_buffers_.reserve(MAX_WRITE_BATCH * 2);
 }
 
 ClientConnection::~ClientConnection() {
-    stop();
+    boost::system::error_code ec;
+    socket_.close(ec);
 }
 
 void ClientConnection::start() {
@@ -20,90 +104,175 @@ void ClientConnection::start() {
     }
     
     connected_.store(true);
-    start_read();
+    boost::asio::dispatch(strand_, [this, self = shared_from_this()]() {
+        start_read();
+    });
 }
 
 void ClientConnection::stop() {
-    if (!connected_.load()) {
+    if (!connected_.exchange(false)) {
         return;
     }
     
-    connected_.store(false);
-    
-    boost::system::error_code ec;
-    socket_.close(ec);
+    // Close on the strand so the socket is never closed under an in-flight read or
+    // write, and notify the owner from there since stop() may run under its locks
+    boost::asio::post(strand_, [this, self = shared_from_this()]() {
+        boost::system::error_code ec;
+        socket_.close(ec);
+        end_session();
+        
+        if (disconnect_callback_) {
+            disconnect_callback_(connection_id_);
+        }
+    });
 }
 
 bool ClientConnection::is_connected() const {
     return connected_.load();
 }
 
-void ClientConnection::send_order_confirmation(const Order& order) {
+void ClientConnection::disconnect(bool flush) {
+    if (!flush) {
+        stop();
+        return;
+    }
+    
+    // The writer closes the connection once the queue drains; if it is idle now, close here
+    close_after_flush_.store(true);
+    boost::asio::post(strand_, [this, self = shared_from_this()]() {
+        bool idle = false;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            idle = !write_in_progress_;
+        }
+        if (idle) {
+            stop();
+        }
+    });
+}
+
+void ProtocolSession::send_order_confirmation(const Order& order) {
     // Create confirmation message
     std::stringstream ss;
     ss << "ORDER_CONFIRMED:" << order.order_id << ":" << order.symbol << ":" 
        << (order.side == OrderSide::BUY ? "BUY" : "SELL") << ":" 
        << order.quantity << ":" << order.price;
     
-    std::string message = ss.str();
-    serialize_message(MessageType::ORDER_SUBMIT, message);
+    enqueue_message(MessageType::ORDER_SUBMIT, make_outbound_payload(ss.str()));
 }
 
-void ClientConnection::send_trade_confirmation(const Order& order, uint64_t fill_quantity, double fill_price) {
+void ProtocolSession::send_trade_confirmation(const Order& order, uint64_t fill_quantity, double fill_price) {
     // Create trade confirmation message
     std::stringstream ss;
     ss << "TRADE_EXECUTED:" << order.order_id << ":" << order.symbol << ":" 
        << (order.side == OrderSide::BUY ? "BUY" : "SELL") << ":" 
        << fill_quantity << ":" << fill_price;
     
-    std::string message = ss.str();
-    serialize_message(MessageType::ORDER_SUBMIT, message);
+    enqueue_message(MessageType::ORDER_SUBMIT, make_outbound_payload(ss.str()));
 }
 
-void ClientConnection::send_order_book_snapshot(const OrderBookSnapshot& snapshot) {
-    // Create order book snapshot message
-    std::stringstream ss;
-    ss << "ORDER_BOOK:" << snapshot.symbol << ":";
+void ProtocolSession::send_order_book_snapshot(const OrderBookSnapshot& snapshot) {
+    auto payload = encode_order_book_snapshot(snapshot);
+    send_encoded(make_header(MessageType::ORDER_BOOK_REQUEST, payload->size()), payload);
+}
+
+void ProtocolSession::send_market_data(const MarketData& data) {
+    auto payload = encode_market_data(data);
+    send_encoded(make_header(MessageType::MARKET_DATA, payload->size()), payload);
+}
+
+void ProtocolSession::send_encoded(const MessageHeader& header, const std::shared_ptr<const std::string>& payload) {
+    OutboundMessage message;
+    message.header = header;
+    message.payload = payload;
+    send_message(std::move(message));
+}
+
+// Text encoders; numbers are formatted like the default ostream (%g) without a stringstream
+namespace {
+
+void append_number(std::string& out, uint64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void append_number(std::string& out, double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+    out.append(buffer, result.ptr);
+}
+
+} // namespace
+
+std::shared_ptr<const std::string> ProtocolSession::encode_order_book_snapshot(const OrderBookSnapshot& snapshot) {
+    std::string message;
+    message.reserve(32 + snapshot.symbol.size() + (snapshot.bids.size() + snapshot.asks.size()) * 24);
+    
+    message.append("ORDER_BOOK:").append(snapshot.symbol).append(":");
     
     // Add bids
-    ss << "BIDS:";
+    message.append("BIDS:");
     for (const auto& [price, quantity] : snapshot.bids) {
-        ss << price << "," << quantity << ";";
+        append_number(message, price);
+        message.push_back(',');
+        append_number(message, quantity);
+        message.push_back(';');
     }
     
     // Add asks
-    ss << "ASKS:";
+    message.append("ASKS:");
     for (const auto& [price, quantity] : snapshot.asks) {
-        ss << price << "," << quantity << ";";
+        append_number(message, price);
+        message.push_back(',');
+        append_number(message, quantity);
+        message.push_back(';');
     }
     
-    std::string message = ss.str();
-    serialize_message(MessageType::ORDER_BOOK_REQUEST, message);
+    return make_outbound_payload(std::move(message));
 }
 
-void ClientConnection::send_market_data(const MarketData& data) {
-    // Create market data message
-    std::stringstream ss;
-    ss << "MARKET_DATA:" << data.symbol << ":" << static_cast<int>(data.type) << ":";
+std::shared_ptr<const std::string> ProtocolSession::encode_market_data(const MarketData& data) {
+    std::string message;
+    message.reserve(96);
+    
+    message.append("MARKET_DATA:").append(data.symbol).push_back(':');
+    append_number(message, static_cast<uint64_t>(data.type));
+    message.push_back(':');
     
     switch (data.type) {
         case MarketDataType::TRADE:
-            ss << data.trade_price << ":" << data.trade_quantity << ":" << data.trade_id;
+            append_number(message, data.trade_price);
+            message.push_back(':');
+            append_number(message, data.trade_quantity);
+            message.push_back(':');
+            append_number(message, data.trade_id);
             break;
         case MarketDataType::QUOTE:
-            ss << data.bid_price << ":" << data.bid_quantity << ":" 
-               << data.ask_price << ":" << data.ask_quantity;
+            append_number(message, data.bid_price);
+            message.push_back(':');
+            append_number(message, data.bid_quantity);
+            message.push_back(':');
+            append_number(message, data.ask_price);
+            message.push_back(':');
+            append_number(message, data.ask_quantity);
             break;
         case MarketDataType::ORDER_BOOK_UPDATE:
-            ss << data.price << ":" << data.quantity << ":" << (data.is_bid ? "BID" : "ASK");
+            append_number(message, data.price);
+            message.push_back(':');
+            append_number(message, data.quantity);
+            message.append(data.is_bid ? ":BID" : ":ASK");
             break;
         default:
-            ss << "UNKNOWN";
+            message.append("UNKNOWN");
             break;
     }
     
-    std::string message = ss.str();
-    serialize_message(MessageType::MARKET_DATA, message);
+    return make_outbound_payload(std::move(message));
+}
+
+void ProtocolSession::send_order_ack(const OrderAckMessage& ack) {
+    serialize_message(MessageType::ORDER_ACK, ack);
 }
 
 void ClientConnection::start_read() {
@@ -111,17 +280,21 @@ void ClientConnection::start_read() {
         return;
     }
     
-    // Read message header first
-    boost::asio::async_read(socket_,
-        boost::asio::buffer(&read_buffer_[0], sizeof(MessageHeader)),
-        [this](const boost::system::error_code& error, size_t bytes_transferred) {
-            if (!error) {
+    // Move a trailing partial message to the front once less than a maximum-size
+    // message fits behind it
+    if (READ_BUFFER_SIZE - read_end_ < MAX_MESSAGE_SIZE) {
+        size_t pending = read_end_ - read_start_;
+        std::memmove(read_buffer_.data(), read_buffer_.data() + read_start_, pending);
+        read_start_ = 0;
+        read_end_ = pending;
+    }
+    
+    socket_.async_read_some(
+        boost::asio::buffer(read_buffer_.data() + read_end_, READ_BUFFER_SIZE - read_end_),
+        boost::asio::bind_executor(strand_,
+            [this, self = shared_from_this()](const boost::system::error_code& error, size_t bytes_transferred) {
                 handle_read(error, bytes_transferred);
-            } else {
-                // Handle error
-                stop();
-            }
-        });
+            }));
 }
 
 void ClientConnection::handle_read(const boost::system::error_code& error, size_t bytes_transferred) {
@@ -130,41 +303,179 @@ void ClientConnection::handle_read(const boost::system::error_code& error, size_
         return;
     }
     
-    if (bytes_transferred == sizeof(MessageHeader)) {
-        // Parse header
+    read_end_ += bytes_transferred;
+    dispatch_received();
+}
+
+void ClientConnection::dispatch_received() {
+    bool ok = true;
+    read_start_ += dispatch_messages(read_buffer_.data() + read_start_, read_end_ - read_start_, ok);
+    if (!ok) {
+        stop();
+        return;
+    }
+    if (read_start_ == read_end_) {
+        read_start_ = 0;
+        read_end_ = 0;
+    }
+    
+    // A throttled message is still buffered; read nothing more until it is admitted
+    std::chrono::nanoseconds delay = get_throttle_delay();
+    if (delay.count() > 0) {
+        throttle_timer_.expires_after(delay);
+        throttle_timer_.async_wait(
+            [this, self = shared_from_this()](const boost::system::error_code& error) {
+                if (error || !connected_.load()) {
+                    return;
+                }
+                dispatch_received();
+            });
+        return;
+    }
+    
+    start_read(); // Continue reading
+}
+
+size_t ProtocolSession::dispatch_messages(const uint8_t* data, size_t length, bool& ok) {
+    size_t offset = 0;
+    while (length - offset >= sizeof(MessageHeader)) {
         MessageHeader header;
-        std::memcpy(&header, &read_buffer_[0], sizeof(MessageHeader));
+        std::memcpy(&header, data + offset, sizeof(MessageHeader));
+        
+        // A resent message is handled like the original; its sequence number
+        // already tells whether it is a duplicate
+        header.message_type &= ~MESSAGE_FLAG_POSS_DUP;
         
         // Validate message size
         if (header.message_length > MAX_MESSAGE_SIZE - sizeof(MessageHeader)) {
             std::cerr << "Message too large: " << header.message_length << std::endl;
-            stop();
-            return;
+            ok = false;
+            return offset;
+        }
+        
+        size_t total = sizeof(MessageHeader) + header.message_length;
+        if (length - offset < total) {
+            break;
         }
         
-        // Read message body if present
-        if (header.message_length > 0) {
-            boost::asio::async_read(socket_,
-                boost::asio::buffer(&read_buffer_[sizeof(MessageHeader)], header.message_length),
-                [this, header](const boost::system::error_code& error, size_t bytes_transferred) {
-                    if (!error) {
-                        handle_message(header, &read_buffer_[sizeof(MessageHeader)], bytes_transferred);
-                        start_read(); // Continue reading
-                    } else {
-                        stop();
-                    }
-                });
+        const uint8_t* body = header.message_length > 0 ? data + offset + sizeof(MessageHeader) : nullptr;
+        if (throttle_.enabled() && !admit_message(header, body, header.message_length)) {
+            if (throttle_delay_.count() > 0) {
+                break;  // Held back; the transport dispatches it again after the delay
+            }
         } else {
-            handle_message(header, nullptr, 0);
-            start_read(); // Continue reading
+            handle_message(header, body, header.message_length);
         }
-    } else {
-        start_read(); // Continue reading
+        ++messages_dispatched_;
+        offset += total;
+    }
+    
+    // Any inbound traffic counts as a sign of life
+    if (offset > 0 && heartbeat_interval_ms_.load(std::memory_order_relaxed) != 0) {
+        last_received_ns_.store(steady_now_ns(), std::memory_order_relaxed);
     }
+    return offset;
 }
 
-void ClientConnection::handle_message(const MessageHeader& header, const uint8_t* data, size_t length) {
+bool ProtocolSession::admit_message(const MessageHeader& header, const uint8_t* data, size_t length) {
+    throttle_delay_ = std::chrono::nanoseconds{0};
+    
+    // Only order entry is limited; the instrument id sits at a fixed offset in each
+    // binary body, so it is read without decoding the message. Text messages name
+    // a symbol instead, which is looked up in the registry.
+    uint32_t instrument_id = 0;
     switch (static_cast<MessageType>(header.message_type)) {
+        case MessageType::ORDER_SUBMIT:
+        case MessageType::ORDER_CANCEL:
+        case MessageType::ORDER_MODIFY: {
+            // SYMBOL leads a submit; cancel and modify start with ORDER_ID:SYMBOL
+            size_t field = static_cast<MessageType>(header.message_type) == MessageType::ORDER_SUBMIT ? 0 : 1;
+            const InstrumentInfo* instrument =
+                instruments_ ? instruments_->find_by_symbol(text_field(data, length, field)) : nullptr;
+            instrument_id = instrument ? instrument->instrument_id : 0;
+            break;
+        }
+        case MessageType::BINARY_NEW_ORDER:
+        case MessageType::BINARY_CANCEL_ORDER:
+        case MessageType::BINARY_AMEND_ORDER:
+            if (length >= sizeof(uint64_t) + sizeof(uint32_t)) {
+                std::memcpy(&instrument_id, data + sizeof(uint64_t), sizeof(uint32_t));
+            }
+            break;
+        case MessageType::MASS_CANCEL:
+            if (length >= sizeof(uint32_t)) {
+                std::memcpy(&instrument_id, data, sizeof(uint32_t));
+            }
+            break;
+        default:
+            return true;
+    }
+    
+    // Ids outside the registry share the bucket of instrument 0, so a client
+    // cannot grow the session's bucket table by inventing instruments
+    if (instrument_id != 0 && (!instruments_ || !instruments_->find(instrument_id))) {
+        instrument_id = 0;
+    }
+    
+    uint64_t now = TscClock::now();
+    uint64_t wait = throttle_.acquire(instrument_id, now);
+    if (wait == 0) {
+        if (throttle_paused_at_ != 0) {
+            throttle_.record_delayed(now - throttle_paused_at_);
+            throttle_paused_at_ = 0;
+        }
+        return true;
+    }
+    
+    // Delay while the total hold stays within max_delay, otherwise reject
+    if (throttle_.action() == ThrottleAction::DELAY && supports_read_pause()) {
+        uint64_t paused_at = throttle_paused_at_ != 0 ? throttle_paused_at_ : now;
+        if (now - paused_at + wait <= throttle_.max_delay_ticks()) {
+            throttle_paused_at_ = paused_at;
+            throttle_delay_ = std::max(TscClock::to_duration(wait), std::chrono::nanoseconds{1});
+            return false;
+        }
+    }
+    throttle_paused_at_ = 0;
+    reject_throttled(header, data, length);
+    return false;
+}
+
+void ProtocolSession::reject_throttled(const MessageHeader& header, const uint8_t* data, size_t length) {
+    throttle_.record_rejected();
+    
+    // The message still takes its inbound sequence number so the session stays in step
+    MessageType type = static_cast<MessageType>(header.message_type);
+    if (!accept_inbound_sequence(type, header.sequence_number)) {
+        return;
+    }
+    if (type == MessageType::BINARY_NEW_ORDER && data && length >= sizeof(NewOrderMessage)) {
+        NewOrderMessage message;
+        std::memcpy(&message, data, sizeof(NewOrderMessage));
+        reject_order(message, OrderRejectReason::THROTTLED);
+    }
+}
+
+void ProtocolSession::handle_message(const MessageHeader& header, const uint8_t* data, size_t length) {
+    MessageType type = static_cast<MessageType>(header.message_type);
+    
+    // Text order messages are only honoured in compatibility mode
+    if (!text_protocol_enabled_ &&
+        (type == MessageType::ORDER_SUBMIT || type == MessageType::ORDER_CANCEL || type == MessageType::ORDER_MODIFY)) {
+        std::cerr << "Text order message rejected, text protocol disabled" << std::endl;
+        return;
+    }
+    
+    // Duplicates, and everything after a gap until the client resends, are dropped
+    if (type == MessageType::LOGIN) {
+        handle_login(data, length, header.sequence_number);
+        return;
+    }
+    if (!accept_inbound_sequence(type, header.sequence_number) && !is_session_message(type)) {
+        return;
+    }
+    
+    switch (type) {
         case MessageType::ORDER_SUBMIT:
             handle_order_submit(data, length);
             break;
@@ -177,11 +488,38 @@ void ClientConnection::handle_message(const MessageHeader& header, const uint8_t
         case MessageType::MARKET_DATA:
             handle_market_data_request(data, length);
             break;
-        case MessageType::LOGIN:
-            handle_login(data, length);
+        case MessageType::BINARY_NEW_ORDER:
+            handle_binary_new_order(data, length);
+            break;
+        case MessageType::BINARY_CANCEL_ORDER:
+            handle_binary_cancel_order(data, length);
+            break;
+        case MessageType::BINARY_AMEND_ORDER:
+            handle_binary_amend_order(data, length);
+            break;
+        case MessageType::MASS_CANCEL:
+            handle_mass_cancel(data, length);
+            break;
+        case MessageType::ORDER_STATUS_REQUEST:
+            handle_order_status_request(data, length);
+            break;
+        case MessageType::SUBSCRIBE:
+            handle_subscription(data, length, true);
+            break;
+        case MessageType::UNSUBSCRIBE:
+            handle_subscription(data, length, false);
             break;
         case MessageType::HEARTBEAT:
-            // Send heartbeat response
+            // Only refreshes last_received_ns_; answering would ping-pong with the client
+            break;
+        case MessageType::LOGOUT:
+            handle_logout();
+            break;
+        case MessageType::RESEND_REQUEST:
+            handle_resend_request(data, length);
+            break;
+        case MessageType::SEQUENCE_RESET:
+            handle_sequence_reset(data, length);
             break;
         default:
             std::cerr << "Unknown message type: " << header.message_type << std::endl;
@@ -189,7 +527,7 @@ void ClientConnection::handle_message(const MessageHeader& header, const uint8_t
     }
 }
 
-void ClientConnection::handle_order_submit(const uint8_t* data, size_t length) {
+void ProtocolSession::handle_order_submit(const uint8_t* data, size_t length) {
     if (!data || length == 0) return;
     
     std::string message(reinterpret_cast<const char*>(data), length);
@@ -208,13 +546,13 @@ void ClientConnection::handle_order_submit(const uint8_t* data, size_t length) {
     }
     
     try {
-        auto order = std::make_shared<Order>();
+        auto order = make_order();
         order->symbol = tokens[0];
         order->side = (tokens[1] == "BUY") ? OrderSide::BUY : OrderSide::SELL;
         order->quantity = std::stoull(tokens[2]);
         order->price = std::stod(tokens[3]);
         order->type = static_cast<OrderType>(std::stoi(tokens[4]));
-        order->order_id = ++client_id_; // Simple ID generation
+        order->order_id = next_order_id();
         order->client_id = client_id_;
         order->timestamp = std::chrono::high_resolution_clock::now();
         
@@ -227,7 +565,7 @@ void ClientConnection::handle_order_submit(const uint8_t* data, size_t length) {
     }
 }
 
-void ClientConnection::handle_order_cancel(const uint8_t* data, size_t length) {
+void ProtocolSession::handle_order_cancel(const uint8_t* data, size_t length) {
     if (!data || length == 0) return;
     
     std::string message(reinterpret_cast<const char*>(data), length);
@@ -249,6 +587,11 @@ void ClientConnection::handle_order_cancel(const uint8_t* data, size_t length) {
         uint64_t order_id = std::stoull(tokens[0]);
         std::string symbol = tokens[1];
         
+        if ((order_id >> 32) != client_id_) {
+            std::cerr << "Cancel of order " << order_id << " not owned by client " << client_id_ << std::endl;
+            return;
+        }
+        
         if (order_cancel_callback_) {
             order_cancel_callback_(order_id, symbol);
         }
@@ -258,7 +601,7 @@ void ClientConnection::handle_order_cancel(const uint8_t* data, size_t length) {
     }
 }
 
-void ClientConnection::handle_order_modify(const uint8_t* data, size_t length) {
+void ProtocolSession::handle_order_modify(const uint8_t* data, size_t length) {
     if (!data || length == 0) return;
     
     std::string message(reinterpret_cast<const char*>(data), length);
@@ -282,6 +625,11 @@ void ClientConnection::handle_order_modify(const uint8_t* data, size_t length) {
         uint64_t new_quantity = std::stoull(tokens[2]);
         double new_price = std::stod(tokens[3]);
         
+        if ((order_id >> 32) != client_id_) {
+            std::cerr << "Modify of order " << order_id << " not owned by client " << client_id_ << std::endl;
+            return;
+        }
+        
         if (order_modify_callback_) {
             order_modify_callback_(order_id, symbol, new_quantity, new_price);
         }
@@ -291,76 +639,697 @@ void ClientConnection::handle_order_modify(const uint8_t* data, size_t length) {
     }
 }
 
-void ClientConnection::handle_market_data_request(const uint8_t* data, size_t length) {
-    // Handle market data subscription request
-    // This could be used to control which symbols the client receives
+void ProtocolSession::handle_market_data_request(const uint8_t* data, size_t length) {
+    if (!data || length == 0) return;
+    
+    // Parse subscription request: SUBSCRIBE|UNSUBSCRIBE:SYMBOL[:CHANNEL,CHANNEL...]
+    std::string_view message(reinterpret_cast<const char*>(data), length);
+    size_t first = message.find(':');
+    if (first == std::string_view::npos) {
+        std::cerr << "Invalid market data request format" << std::endl;
+        return;
+    }
+    
+    std::string_view action = message.substr(0, first);
+    std::string_view rest = message.substr(first + 1);
+    size_t second = rest.find(':');
+    std::string_view symbol = rest.substr(0, second);
+    
+    if (symbol.empty() || (action != "SUBSCRIBE" && action != "UNSUBSCRIBE")) {
+        std::cerr << "Invalid market data request format" << std::endl;
+        return;
+    }
+    
+    uint8_t channels = CHANNEL_ALL;
+    if (second != std::string_view::npos) {
+        channels = 0;
+        std::string_view list = rest.substr(second + 1);
+        while (!list.empty()) {
+            size_t comma = list.find(',');
+            std::string_view name = list.substr(0, comma);
+            
+            if (name == "TRADE") channels |= CHANNEL_TRADE;
+            else if (name == "QUOTE") channels |= CHANNEL_QUOTE;
+            else if (name == "BOOK") channels |= CHANNEL_BOOK_UPDATE;
+            else if (name == "TICK") channels |= CHANNEL_TICK;
+            else if (name == "SNAPSHOT") channels |= CHANNEL_BOOK_SNAPSHOT;
+            else if (name == "ALL") channels |= CHANNEL_ALL;
+            else std::cerr << "Unknown subscription channel: " << name << std::endl;
+            
+            list = (comma == std::string_view::npos) ? std::string_view{} : list.substr(comma + 1);
+        }
+    }
+    
+    update_subscription(std::string(symbol), channels, action == "SUBSCRIBE");
+}
+
+void ProtocolSession::handle_subscription(const uint8_t* data, size_t length, bool subscribe) {
+    const SubscriptionMessage* message = decode_message<SubscriptionMessage>(data, length);
+    if (!message) {
+        std::cerr << "Invalid subscription message length: " << length << std::endl;
+        return;
+    }
+    
+    // Instrument id 0 subscribes to every instrument
+    if (message->instrument_id == 0) {
+        update_subscription(SubscriptionTable::WILDCARD, message->channels, subscribe);
+        return;
+    }
+    
+    const InstrumentInfo* instrument = instruments_ ? instruments_->find(message->instrument_id) : nullptr;
+    if (!instrument) {
+        std::cerr << "Subscription for unknown instrument " << message->instrument_id << std::endl;
+        return;
+    }
+    
+    update_subscription(instrument->symbol, message->channels, subscribe);
+}
+
+void ProtocolSession::update_subscription(const std::string& symbol, uint8_t channels, bool subscribe) {
+    // A stopped connection's slot may already have been released for reuse
+    if (!subscriptions_ || !is_connected()) {
+        return;
+    }
+    
+    if (subscribe) {
+        if (!subscriptions_->subscribe(session_slot_, symbol, channels)) {
+            std::cerr << "Subscription to " << symbol << " refused, too many subscribed instruments" << std::endl;
+        }
+    } else {
+        subscriptions_->unsubscribe(session_slot_, symbol, channels);
+    }
 }
 
-void ClientConnection::handle_login(const uint8_t* data, size_t length) {
+void ProtocolSession::handle_login(const uint8_t* data, size_t length, uint64_t sequence) {
     if (!data || length == 0) return;
     
     std::string message(reinterpret_cast<const char*>(data), length);
     std::istringstream ss(message);
     std::string token;
     
-    // Parse login message: CLIENT_NAME
+    // Parse login message: CLIENT_NAME[:HEARTBEAT_SECONDS]
     std::vector<std::string> tokens;
     while (std::getline(ss, token, ':')) {
         tokens.push_back(token);
     }
     
-    if (!tokens.empty()) {
-        client_name_ = tokens[0];
-        std::cout << "Client connected: " << client_name_ << " (ID: " << client_id_ << ")" << std::endl;
+    if (tokens.empty()) {
+        return;
     }
+    
+    const SessionConfig& config = session_store_ ? session_store_->config() : default_session_config;
+    LoginAckMessage ack{};
+    {
+        std::lock_guard<std::mutex> lock(sequence_mutex_);
+        if (journal_) {
+            std::cerr << "Client " << client_id_ << " is already logged in" << std::endl;
+            return;
+        }
+    
+        std::shared_ptr<SessionJournal> journal = session_store_ ? session_store_->claim(tokens[0], client_id_) : nullptr;
+        if (session_store_ && !journal) {
+            ack.status = static_cast<uint8_t>(LoginStatus::REJECTED);
+        } else {
+            // A resumed session takes back the client id that owns its orders, so it can
+            // still cancel, amend and query them and order ids never repeat
+            if (journal && journal->client_id() != client_id_) {
+                client_id_ = journal->client_id();
+                next_order_sequence_ = journal->next_order_sequence();
+            }
+    
+            // Outbound numbering continues from the journal so the client can ask for what it missed
+            journal_ = journal ? journal : std::make_shared<SessionJournal>();
+            next_outbound_sequence_ = journal_->last_sequence() + 1;
+            next_inbound_sequence_ = journal_->next_inbound_sequence();
+            awaiting_resend_ = false;
+    
+            auto interval = config.heartbeat_interval;
+            if (tokens.size() > 1) {
+                try {
+                    interval = std::chrono::seconds(std::stoul(tokens[1]));
+                } catch (const std::exception&) {
+                    std::cerr << "Invalid heartbeat interval in login: " << tokens[1] << std::endl;
+                }
+            }
+            interval = std::clamp(interval, config.min_heartbeat_interval, config.max_heartbeat_interval);
+    
+            // The session timer reads the name under sequence_mutex_
+            client_name_ = tokens[0];
+    
+            int64_t now = steady_now_ns();
+            last_sent_ns_.store(now, std::memory_order_relaxed);
+            last_received_ns_.store(now, std::memory_order_relaxed);
+            heartbeat_interval_ms_.store(static_cast<uint32_t>(interval.count()), std::memory_order_relaxed);
+    
+            ack.status = static_cast<uint8_t>(LoginStatus::ACCEPTED);
+            ack.next_inbound_sequence = next_inbound_sequence_;
+            ack.last_outbound_sequence = next_outbound_sequence_ - 1;
+            ack.heartbeat_interval_ms = static_cast<uint32_t>(interval.count());
+        }
+    }
+    
+    if (ack.status == static_cast<uint8_t>(LoginStatus::REJECTED)) {
+        std::cerr << "Login rejected for " << tokens[0] << " (ID: " << client_id_ << ")" << std::endl;
+        serialize_message(MessageType::LOGIN, ack);
+        disconnect(true);
+        return;
+    }
+    
+    std::cout << "Client connected: " << client_name_ << " (ID: " << client_id_ << ")" << std::endl;
+    serialize_message(MessageType::LOGIN, ack);
+    
+    // A client that restarted its numbering starts a fresh inbound stream
+    if (sequence != 0 && sequence < next_inbound_sequence_) {
+        std::cerr << "Client " << client_name_ << " reset its sequence to " << sequence
+                  << ", expected " << next_inbound_sequence_ << std::endl;
+        next_inbound_sequence_ = 0;
+    }
+    accept_inbound_sequence(MessageType::LOGIN, sequence);
+}
+
+void ProtocolSession::handle_logout() {
+    std::cout << "Client logged out: " << client_name_ << " (ID: " << client_id_ << ")" << std::endl;
+    send_empty(MessageType::LOGOUT);
+    end_session();
+    disconnect(true);
+}
+
+bool ProtocolSession::accept_inbound_sequence(MessageType type, uint64_t sequence) {
+    if (sequence == 0) {
+        return true;
+    }
+    
+    if (next_inbound_sequence_ == 0 || sequence == next_inbound_sequence_) {
+        next_inbound_sequence_ = sequence + 1;
+        awaiting_resend_ = false;
+        return true;
+    }
+    
+    if (sequence < next_inbound_sequence_) {
+        return false;
+    }
+    
+    // Gap: ask once for everything from the first missing message; the client
+    // resends it in order and the stream resumes when the expected number arrives
+    if (!awaiting_resend_) {
+        std::cerr << "Client " << client_id_ << " sequence gap: expected " << next_inbound_sequence_
+                  << ", received " << sequence << " (" << static_cast<uint32_t>(type) << ")" << std::endl;
+        awaiting_resend_ = true;
+        ResendRequestMessage request{};
+        request.begin_sequence = next_inbound_sequence_;
+        request.end_sequence = 0;
+        serialize_message(MessageType::RESEND_REQUEST, request);
+    }
+    return false;
+}
+
+void ProtocolSession::handle_resend_request(const uint8_t* data, size_t length) {
+    ResendRequestMessage request;
+    if (!data || length < sizeof(request)) {
+        return;
+    }
+    std::memcpy(&request, data, sizeof(request));
+    
+    // Resent messages keep their original numbers, so they bypass send_message and
+    // are queued under sequence_mutex_ to stay ahead of newer messages
+    std::lock_guard<std::mutex> lock(sequence_mutex_);
+    uint64_t last = next_outbound_sequence_ - 1;
+    uint64_t begin = std::max<uint64_t>(request.begin_sequence, 1);
+    uint64_t end = request.end_sequence == 0 ? last : std::min(request.end_sequence, last);
+    if (begin > end) {
+        return;
+    }
+    end = std::min(end, begin + MAX_RESEND_BATCH - 1);
+    
+    JournalEntry entry;
+    uint64_t gap_begin = 0;
+    for (uint64_t sequence = begin; sequence <= end; ++sequence) {
+        if (!journal_ || !journal_->read(sequence, entry) || !entry.recoverable) {
+            if (gap_begin == 0) {
+                gap_begin = sequence;
+            }
+            continue;
+        }
+    
+        if (gap_begin != 0) {
+            send_gap_fill(gap_begin, sequence);
+            gap_begin = 0;
+        }
+    
+        OutboundMessage message;
+        message.header.message_type = entry.message_type | MESSAGE_FLAG_POSS_DUP;
+        message.header.message_length = static_cast<uint32_t>(entry.payload.size());
+        message.header.sequence_number = sequence;
+        message.header.timestamp = entry.timestamp;
+        message.payload = make_outbound_payload(std::move(entry.payload));
+        if (!enqueue(std::move(message))) {
+            return;
+        }
+    }
+    if (gap_begin != 0) {
+        send_gap_fill(gap_begin, end + 1);
+    }
+}
+
+void ProtocolSession::handle_sequence_reset(const uint8_t* data, size_t length) {
+    SequenceResetMessage reset;
+    if (!data || length < sizeof(reset)) {
+        return;
+    }
+    std::memcpy(&reset, data, sizeof(reset));
+    
+    // Only moves forward; a reset can never make the session accept a duplicate
+    if (reset.new_sequence > next_inbound_sequence_) {
+        next_inbound_sequence_ = reset.new_sequence;
+        awaiting_resend_ = false;
+    }
+}
+
+void ProtocolSession::send_gap_fill(uint64_t begin_sequence, uint64_t new_sequence) {
+    SequenceResetMessage reset{};
+    reset.new_sequence = new_sequence;
+    reset.gap_fill = 1;
+    
+    OutboundMessage message;
+    message.header = make_header(MessageType::SEQUENCE_RESET, sizeof(reset));
+    message.header.message_type |= MESSAGE_FLAG_POSS_DUP;
+    message.header.sequence_number = begin_sequence;
+    std::memcpy(message.inline_payload.data(), &reset, sizeof(reset));
+    enqueue(std::move(message));
+}
+
+void ProtocolSession::send_empty(MessageType type) {
+    OutboundMessage message;
+    message.header = make_header(type, 0);
+    send_message(std::move(message));
+}
+
+bool ProtocolSession::send_message(OutboundMessage&& message) {
+    std::lock_guard<std::mutex> lock(sequence_mutex_);
+    
+    // The number is used even if the transport refuses the message, so a reconnecting
+    // client can still recover it from the journal
+    uint64_t sequence = next_outbound_sequence_++;
+    message.header.sequence_number = sequence;
+    if (journal_) {
+        MessageType type = static_cast<MessageType>(message.header.message_type);
+        const void* payload = message.payload
+            ? static_cast<const void*>(message.payload->data())
+            : static_cast<const void*>(message.inline_payload.data());
+        journal_->append(sequence, message.header.message_type, message.header.timestamp,
+                         is_recoverable(type), payload, message.header.message_length);
+    }
+    
+    if (heartbeat_interval_ms_.load(std::memory_order_relaxed) != 0) {
+        last_sent_ns_.store(steady_now_ns(), std::memory_order_relaxed);
+    }
+    return enqueue(std::move(message));
+}
+
+std::optional<std::chrono::steady_clock::time_point> ProtocolSession::on_session_timer(
+    std::chrono::steady_clock::time_point now) {
+    if (!is_connected()) {
+        return std::nullopt;
+    }
+    
+    const SessionConfig& config = session_store_ ? session_store_->config() : default_session_config;
+    uint32_t interval_ms = heartbeat_interval_ms_.load(std::memory_order_relaxed);
+    if (interval_ms == 0) {
+        // Not logged in; check again for a login
+        return now + config.min_heartbeat_interval;
+    }
+    
+    auto interval = std::chrono::milliseconds(interval_ms);
+    auto timeout = interval * std::max<uint32_t>(config.missed_heartbeats, 1);
+    std::chrono::steady_clock::time_point last_received{std::chrono::nanoseconds(last_received_ns_.load())};
+    if (now - last_received >= timeout) {
+        // The timer runs off the session's read path, which may be in handle_login
+        std::string client_name;
+        uint64_t client_id;
+        {
+            std::lock_guard<std::mutex> lock(sequence_mutex_);
+            client_name = client_name_;
+            client_id = client_id_;
+        }
+        std::cerr << "Client " << client_name << " (ID: " << client_id << ") silent for "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - last_received).count()
+                  << " ms, disconnecting" << std::endl;
+        disconnect(false);
+        return std::nullopt;
+    }
+    
+    std::chrono::steady_clock::time_point last_sent{std::chrono::nanoseconds(last_sent_ns_.load())};
+    if (now - last_sent >= interval) {
+        send_empty(MessageType::HEARTBEAT);
+        last_sent = now;
+    }
+    return std::min(last_sent + interval, last_received + timeout);
+}
+
+void ProtocolSession::set_session_store(std::shared_ptr<SessionStore> store) {
+    session_store_ = std::move(store);
+    if (session_store_) {
+        throttle_.configure(session_store_->config().throttle, &session_store_->get_throttle_counters());
+    }
+}
+
+void ProtocolSession::end_session() {
+    std::lock_guard<std::mutex> lock(sequence_mutex_);
+    heartbeat_interval_ms_.store(0, std::memory_order_relaxed);
+    if (!journal_) {
+        return;
+    }
+    if (session_store_) {
+        session_store_->release(journal_, next_inbound_sequence_, next_order_sequence_);
+    }
+    journal_.reset();
+}
+
+void ProtocolSession::handle_binary_new_order(const uint8_t* data, size_t length) {
+    const NewOrderMessage* message = decode_message<NewOrderMessage>(data, length);
+    if (!message) {
+        std::cerr << "Invalid binary new order length: " << length << std::endl;
+        return;
+    }
+    
+    const InstrumentInfo* instrument = instruments_ ? instruments_->find(message->instrument_id) : nullptr;
+    OrderRejectReason reason = validate_new_order(*message, instrument);
+    if (reason != OrderRejectReason::NONE) {
+        reject_order(*message, reason);
+        return;
+    }
+    
+    auto order = make_order();
+    order->order_id = next_order_id();
+    order->client_id = client_id_;
+    order->symbol = instrument->symbol;
+    order->side = static_cast<OrderSide>(message->side);
+    order->type = static_cast<OrderType>(message->order_type);
+    order->quantity = message->quantity;
+    order->price = InstrumentRegistry::ticks_to_price(*instrument, message->price);
+    order->stop_price = InstrumentRegistry::ticks_to_price(*instrument, message->stop_price);
+    order->timestamp = std::chrono::high_resolution_clock::now();
+    
+    // Not queued means the order never reaches a book
+    if (!order_submit_callback_ || !order_submit_callback_(order)) {
+        reject_order(*message, OrderRejectReason::UNAVAILABLE);
+        return;
+    }
+    
+    OrderAckMessage ack{};
+    ack.client_order_id = message->client_order_id;
+    ack.order_id = order->order_id;
+    ack.instrument_id = message->instrument_id;
+    ack.status = static_cast<uint8_t>(OrderAckStatus::ACCEPTED);
+    ack.reject_reason = static_cast<uint8_t>(OrderRejectReason::NONE);
+    send_order_ack(ack);
+}
+
+void ProtocolSession::handle_binary_cancel_order(const uint8_t* data, size_t length) {
+    const CancelOrderMessage* message = decode_message<CancelOrderMessage>(data, length);
+    if (!message) {
+        std::cerr << "Invalid binary cancel length: " << length << std::endl;
+        return;
+    }
+    
+    const InstrumentInfo* instrument = instruments_ ? instruments_->find(message->instrument_id) : nullptr;
+    if (!instrument) {
+        std::cerr << "Cancel for unknown instrument " << message->instrument_id << std::endl;
+        return;
+    }
+    
+    // Sessions only touch their own orders
+    if ((message->order_id >> 32) != client_id_) {
+        std::cerr << "Cancel of order " << message->order_id << " not owned by client " << client_id_ << std::endl;
+        return;
+    }
+    
+    if (order_cancel_callback_) {
+        order_cancel_callback_(message->order_id, instrument->symbol);
+    }
+}
+
+void ProtocolSession::handle_binary_amend_order(const uint8_t* data, size_t length) {
+    const AmendOrderMessage* message = decode_message<AmendOrderMessage>(data, length);
+    if (!message) {
+        std::cerr << "Invalid binary amend length: " << length << std::endl;
+        return;
+    }
+    
+    const InstrumentInfo* instrument = instruments_ ? instruments_->find(message->instrument_id) : nullptr;
+    if (!instrument) {
+        std::cerr << "Amend for unknown instrument " << message->instrument_id << std::endl;
+        return;
+    }
+    
+    if (message->new_quantity == 0 || message->new_price <= 0) {
+        std::cerr << "Invalid amend for order " << message->order_id << std::endl;
+        return;
+    }
+    
+    if ((message->order_id >> 32) != client_id_) {
+        std::cerr << "Amend of order " << message->order_id << " not owned by client " << client_id_ << std::endl;
+        return;
+    }
+    
+    if (order_modify_callback_) {
+        order_modify_callback_(message->order_id, instrument->symbol, message->new_quantity,
+                               InstrumentRegistry::ticks_to_price(*instrument, message->new_price));
+    }
+}
+
+void ProtocolSession::handle_mass_cancel(const uint8_t* data, size_t length) {
+    const MassCancelMessage* message = decode_message<MassCancelMessage>(data, length);
+    if (!message || message->side > static_cast<uint8_t>(MassCancelSide::BOTH)) {
+        std::cerr << "Invalid mass cancel message" << std::endl;
+        return;
+    }
+    
+    // Instrument id 0 cancels across every instrument
+    static const std::string all_instruments;
+    const std::string* symbol = &all_instruments;
+    if (message->instrument_id != 0) {
+        const InstrumentInfo* instrument = instruments_ ? instruments_->find(message->instrument_id) : nullptr;
+        if (!instrument) {
+            std::cerr << "Mass cancel for unknown instrument " << message->instrument_id << std::endl;
+            return;
+        }
+        symbol = &instrument->symbol;
+    }
+    
+    if (order_mass_cancel_callback_) {
+        order_mass_cancel_callback_(client_id_, *symbol, static_cast<MassCancelSide>(message->side));
+    }
+}
+
+void ProtocolSession::handle_order_status_request(const uint8_t* data, size_t length) {
+    const OrderStatusRequestMessage* message = decode_message<OrderStatusRequestMessage>(data, length);
+    if (!message) {
+        std::cerr << "Invalid order status request length: " << length << std::endl;
+        return;
+    }
+    
+    OrderStatusMessage reply{};
+    reply.order_id = message->order_id;
+    reply.instrument_id = message->instrument_id;
+    reply.result = static_cast<uint8_t>(OrderStatusResult::UNKNOWN_ORDER);
+    
+    // Sessions only see their own orders
+    const InstrumentInfo* instrument = instruments_ ? instruments_->find(message->instrument_id) : nullptr;
+    OrderStatusEntry entry;
+    if (!instrument) {
+        reply.result = static_cast<uint8_t>(OrderStatusResult::UNKNOWN_INSTRUMENT);
+    } else if (order_status_callback_ && order_status_callback_(message->order_id, instrument->symbol, entry) &&
+               entry.client_id == client_id_) {
+        reply.result = static_cast<uint8_t>(OrderStatusResult::FOUND);
+        reply.status = static_cast<uint8_t>(entry.status);
+        reply.quantity = entry.quantity;
+        reply.filled_quantity = entry.filled_quantity;
+        reply.average_price = entry.average_price;
+        reply.update_sequence = entry.update_sequence;
+    }
+    
+    serialize_message(MessageType::ORDER_STATUS_REQUEST, reply);
+}
+
+void ProtocolSession::reject_order(const NewOrderMessage& message, OrderRejectReason reason) {
+    OrderAckMessage ack{};
+    ack.client_order_id = message.client_order_id;
+    ack.order_id = 0;
+    ack.instrument_id = message.instrument_id;
+    ack.status = static_cast<uint8_t>(OrderAckStatus::REJECTED);
+    ack.reject_reason = static_cast<uint8_t>(reason);
+    send_order_ack(ack);
+}
+
+size_t ClientConnection::get_outbound_queue_bytes() const {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    return queued_bytes_;
 }
 
 void ClientConnection::start_write() {
-    // This would be implemented for async writes
-    // For simplicity, we're using synchronous writes in this implementation
+    // Runs on the strand; write_in_progress_ guarantees a single writer
+    bool idle = false;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (pending_.empty() || !connected_.load()) {
+            write_in_progress_ = false;
+            idle = true;
+        } else if (pending_.size() <= MAX_WRITE_BATCH) {
+            writing_.swap(pending_);
+        } else {
+            auto batch_end = pending_.begin() + MAX_WRITE_BATCH;
+            std::move(pending_.begin(), batch_end, std::back_inserter(writing_));
+            pending_.erase(pending_.begin(), batch_end);
+        }
+    }
+    
+    // A flushing disconnect closes once everything queued has been written
+    if (idle) {
+        if (close_after_flush_.load()) {
+            stop();
+        }
+        return;
+    }
+    
+    // Gather every queued header and payload into a single write
+    write_buffers_.clear();
+    for (const auto& message : writing_) {
+        write_buffers_.push_back(boost::asio::buffer(&message.header, sizeof(MessageHeader)));
+        if (message.header.message_length == 0) {
+            continue;
+        }
+        if (message.payload) {
+            write_buffers_.push_back(boost::asio::buffer(*message.payload));
+        } else {
+            write_buffers_.push_back(boost::asio::buffer(message.inline_payload.data(), message.header.message_length));
+        }
+    }
+    
+    boost::asio::async_write(socket_, write_buffers_,
+        boost::asio::bind_executor(strand_,
+            [this, self = shared_from_this()](const boost::system::error_code& error, size_t bytes_transferred) {
+                handle_write(error, bytes_transferred);
+            }));
 }
 
 void ClientConnection::handle_write(const boost::system::error_code& error, size_t bytes_transferred) {
     if (error) {
+        if (error != boost::asio::error::operation_aborted) {
+            std::cerr << "Write error: " << error.message() << std::endl;
+        }
         stop();
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        queued_bytes_ -= bytes_transferred;
     }
+    
+    writing_.clear();
+    start_write();
 }
 
-template<typename T>
-void ClientConnection::serialize_message(MessageType type, const T& data) {
+MessageHeader ProtocolSession::make_header(MessageType type, size_t length) {
     MessageHeader header;
     header.message_type = static_cast<uint32_t>(type);
-    header.message_length = sizeof(T);
-    header.sequence_number = 0; // Could implement sequence numbering
+    header.message_length = static_cast<uint32_t>(length);
+    header.sequence_number = 0; // Assigned by send_message
     header.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
         std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    return header;
+}
+
+bool ClientConnection::enqueue(OutboundMessage&& message) {
+    if (!connected_.load(std::memory_order_relaxed)) {
+        return false;
+    }
     
-    // For string data, we need to handle it specially
+    bool start_writer = false;
+    bool slow_consumer = false;
+    size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (queued_bytes_ + message.wire_size() > max_outbound_bytes_) {
+            slow_consumer = true;
+            queued = queued_bytes_;
+        } else {
+            queued_bytes_ += message.wire_size();
+            pending_.push_back(std::move(message));
+            if (!write_in_progress_) {
+                write_in_progress_ = true;
+                start_writer = true;
+            }
+        }
+    }
+    
+    // Never block the producing thread on a client that cannot keep up
+    if (slow_consumer) {
+        std::cerr << "Connection " << connection_id_ << " is not draining its socket (" << queued
+                  << " bytes queued), disconnecting slow consumer" << std::endl;
+        stop();
+        return false;
+    }
+    
+    if (start_writer) {
+        boost::asio::post(strand_, [this, self = shared_from_this()]() {
+            start_write();
+        });
+    }
+    return true;
+}
+
+void ProtocolSession::enqueue_message(MessageType type, std::shared_ptr<const std::string> payload) {
+    OutboundMessage message;
+    message.header = make_header(type, payload->size());
+    message.payload = std::move(payload);
+    send_message(std::move(message));
+}
+
+template<typename T>
+void ProtocolSession::serialize_message(MessageType type, const T& data) {
     if constexpr (std::is_same_v<T, std::string>) {
-        header.message_length = data.length();
-        
-        // Copy header
-        std::memcpy(&write_buffer_[0], &header, sizeof(MessageHeader));
-        
-        // Copy data
-        std::memcpy(&write_buffer_[sizeof(MessageHeader)], data.data(), data.length());
-        
-        // Send synchronously for simplicity
-        boost::system::error_code ec;
-        boost::asio::write(socket_, 
-            boost::asio::buffer(&write_buffer_[0], sizeof(MessageHeader) + data.length()), ec);
+        enqueue_message(type, make_outbound_payload(data));
+    } else {
+        static_assert(std::is_trivially_copyable_v<T>, "Binary messages must be trivially copyable");
+        static_assert(sizeof(T) <= OutboundMessage::INLINE_PAYLOAD_SIZE, "Binary message too large to queue inline");
         
-        if (ec) {
-            std::cerr << "Write error: " << ec.message() << std::endl;
-            stop();
-        }
+        // Fixed-layout messages are copied inline, no allocation
+        OutboundMessage message;
+        message.header = make_header(type, sizeof(T));
+        std::memcpy(message.inline_payload.data(), &data, sizeof(T));
+        send_message(std::move(message));
     }
 }
 
 // TCPServer implementation
 TCPServer::TCPServer(uint16_t port, size_t num_threads)
-    : acceptor_(io_context_, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)),
-      num_threads_(num_threads) {
+    : TCPServer(NetworkServerConfig{port, num_threads}) {
+}
+
+TCPServer::TCPServer(const NetworkServerConfig& config)
+    : config_(config),
+      instruments_(std::make_shared<InstrumentRegistry>()),
+      session_store_(std::make_shared<SessionStore>()),
+      subscriptions_(std::make_shared<SubscriptionTable>()),
+      sessions_by_slot_(MAX_SUBSCRIBER_SESSIONS) {
+    
+    config_.num_threads = std::max<size_t>(1, config_.num_threads);
+    if (config_.threading == IoThreadingModel::PER_THREAD) {
+        // A context run by a single thread can skip the scheduler's locking
+        for (size_t i = 0; i < config_.num_threads; ++i) {
+            io_contexts_.push_back(std::make_unique<boost::asio::io_context>(1));
+        }
+    } else {
+        io_contexts_.push_back(std::make_unique<boost::asio::io_context>(static_cast<int>(config_.num_threads)));
+    }
+    
+    // Hand out low slots first so the publisher scans as few words as possible
+    free_session_slots_.reserve(MAX_SUBSCRIBER_SESSIONS);
+    for (size_t slot = MAX_SUBSCRIBER_SESSIONS; slot > 0; --slot) {
+        free_session_slots_.push_back(static_cast<uint32_t>(slot - 1));
+    }
 }
 
 TCPServer::~TCPServer() {
@@ -373,20 +1342,40 @@ bool TCPServer::start() {
     }
     
     try {
-        start_accept();
+        for (auto& context : io_contexts_) {
+            context->restart();
+            work_guards_.emplace_back(context->get_executor());
+        }
+        
+        open_acceptors();
+        running_.store(true);
+        
+        // Heartbeats for every connection run off one timer on the first context
+        session_timers_ = std::make_unique<TimerWheel>(session_store_->config().timer_tick);
+        session_tick_ = std::make_unique<boost::asio::steady_timer>(*io_contexts_.front());
+        schedule_session_tick();
+        
+        for (size_t i = 0; i < acceptors_.size(); ++i) {
+            start_accept(i);
+        }
         
         // Start worker threads
-        for (size_t i = 0; i < num_threads_; ++i) {
-            worker_threads_.emplace_back(&TCPServer::worker_thread_function, this);
+        for (size_t i = 0; i < config_.num_threads; ++i) {
+            worker_threads_.emplace_back(&TCPServer::worker_thread_function, this, i);
         }
         
-        running_.store(true);
-        std::cout << "TCP server started on port " << acceptor_.local_endpoint().port() << std::endl;
+        std::cout << "TCP server started on port " << acceptors_.front()->local_endpoint().port()
+                  << " (" << config_.num_threads << " threads, " << io_threading_model_name(config_.threading)
+                  << (acceptors_.size() > 1 ? ", SO_REUSEPORT" : "") << ")" << std::endl;
         
         return true;
         
     } catch (const std::exception& e) {
         std::cerr << "Failed to start TCP server: " << e.what() << std::endl;
+        running_.store(false);
+        acceptors_.clear();
+        session_tick_.reset();
+        work_guards_.clear();
         return false;
     }
 }
@@ -400,21 +1389,36 @@ void TCPServer::stop() {
     
     running_.store(false);
     
-    // Close acceptor
+    // Close acceptors
     boost::system::error_code ec;
-    acceptor_.close(ec);
+    for (auto& acceptor : acceptors_) {
+        acceptor->close(ec);
+    }
+    if (session_tick_) {
+        session_tick_->cancel();
+    }
     
     // Close all client connections
+    std::unordered_map<uint64_t, std::shared_ptr<ClientConnection>> clients;
     {
         std::unique_lock<std::shared_mutex> lock(clients_mutex_);
-        for (auto& [id, client] : clients_) {
-            client->stop();
+        clients.swap(clients_);
+        for (auto& [id, client] : clients) {
+            uint32_t slot = client->get_session_slot();
+            subscriptions_->remove_session(slot);
+            sessions_by_slot_[slot].reset();
+            free_session_slots_.push_back(slot);
         }
-        clients_.clear();
+    }
+    for (auto& [id, client] : clients) {
+        client->stop();
     }
     
-    // Stop io_context
-    io_context_.stop();
+    // Stop the io_contexts
+    work_guards_.clear();
+    for (auto& context : io_contexts_) {
+        context->stop();
+    }
     
     // Wait for worker threads
     for (auto& thread : worker_threads_) {
@@ -423,6 +1427,10 @@ void TCPServer::stop() {
         }
     }
     worker_threads_.clear();
+    acceptors_.clear();
+    session_tick_.reset();
+    session_timers_.reset();
+    session_store_->flush();
     
     std::cout << "TCP server stopped" << std::endl;
 }
@@ -436,6 +1444,10 @@ size_t TCPServer::get_client_count() const {
     return clients_.size();
 }
 
+void TCPServer::set_max_outbound_bytes(size_t bytes) {
+    max_outbound_bytes_ = bytes;
+}
+
 std::vector<uint64_t> TCPServer::get_client_ids() const {
     std::shared_lock<std::shared_mutex> lock(clients_mutex_);
     
@@ -452,24 +1464,45 @@ std::vector<uint64_t> TCPServer::get_client_ids() const {
 void TCPServer::broadcast_market_data(const MarketData& data) {
     std::shared_lock<std::shared_mutex> lock(clients_mutex_);
     
-    for (auto& [id, client] : clients_) {
-        if (client->is_connected()) {
-            client->send_market_data(data);
+    // Encode once, on the first subscriber; every subscriber then queues a
+    // reference to the same buffer
+    std::shared_ptr<const std::string> payload;
+    MessageHeader header;
+    
+    uint8_t channel = static_cast<uint8_t>(1u << static_cast<uint8_t>(data.type));
+    subscriptions_->for_each_subscriber(data.symbol, channel, [&](uint32_t slot) {
+        const auto& client = sessions_by_slot_[slot];
+        if (!client || !client->is_connected()) {
+            return;
         }
-    }
+        if (!payload) {
+            payload = ProtocolSession::encode_market_data(data);
+            header = ProtocolSession::make_header(MessageType::MARKET_DATA, payload->size());
+        }
+        client->send_encoded(header, payload);
+    });
 }
 
 void TCPServer::broadcast_order_book_update(const OrderBookSnapshot& snapshot) {
     std::shared_lock<std::shared_mutex> lock(clients_mutex_);
     
-    for (auto& [id, client] : clients_) {
-        if (client->is_connected()) {
-            client->send_order_book_snapshot(snapshot);
+    std::shared_ptr<const std::string> payload;
+    MessageHeader header;
+    
+    subscriptions_->for_each_subscriber(snapshot.symbol, CHANNEL_BOOK_SNAPSHOT, [&](uint32_t slot) {
+        const auto& client = sessions_by_slot_[slot];
+        if (!client || !client->is_connected()) {
+            return;
         }
-    }
+        if (!payload) {
+            payload = ProtocolSession::encode_order_book_snapshot(snapshot);
+            header = ProtocolSession::make_header(MessageType::ORDER_BOOK_REQUEST, payload->size());
+        }
+        client->send_encoded(header, payload);
+    });
 }
 
-void TCPServer::set_order_submit_callback(std::function<void(std::shared_ptr<Order>)> callback) {
+void TCPServer::set_order_submit_callback(std::function<bool(std::shared_ptr<Order>)> callback) {
     order_submit_callback_ = callback;
 }
 
@@ -481,17 +1514,64 @@ void TCPServer::set_order_modify_callback(std::function<void(uint64_t, const std
     order_modify_callback_ = callback;
 }
 
-void TCPServer::start_accept() {
-    acceptor_.async_accept(
-        [this](const boost::system::error_code& error, boost::asio::ip::tcp::socket socket) {
+void TCPServer::set_order_mass_cancel_callback(std::function<void(uint64_t, const std::string&, MassCancelSide)> callback) {
+    order_mass_cancel_callback_ = callback;
+}
+
+void TCPServer::set_order_status_callback(std::function<bool(uint64_t, const std::string&, OrderStatusEntry&)> callback) {
+    order_status_callback_ = callback;
+}
+
+void TCPServer::set_text_protocol_enabled(bool enabled) {
+    text_protocol_enabled_ = enabled;
+}
+
+void TCPServer::set_session_config(const SessionConfig& config) {
+    session_store_ = std::make_shared<SessionStore>(config);
+}
+
+ThrottleStats TCPServer::get_throttle_stats() const {
+    return session_store_->get_throttle_stats();
+}
+
+void TCPServer::open_acceptors() {
+    // With reuse_port every worker listens on the same port and the kernel spreads
+    // incoming connections across them
+    bool per_worker = config_.threading == IoThreadingModel::PER_THREAD && config_.reuse_port;
+    size_t count = per_worker ? io_contexts_.size() : 1;
+    
+    boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::tcp::v4(), config_.port);
+    for (size_t i = 0; i < count; ++i) {
+        auto acceptor = std::make_unique<boost::asio::ip::tcp::acceptor>(*io_contexts_[i]);
+        acceptor->open(endpoint.protocol());
+        acceptor->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+        if (per_worker) {
+#ifdef SO_REUSEPORT
+            acceptor->set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#else
+            throw std::runtime_error("SO_REUSEPORT is not supported on this platform");
+#endif
+        }
+        acceptor->bind(endpoint);
+        acceptor->listen();
+        
+        // Port 0 picks an ephemeral port once; the other acceptors join it
+        endpoint = acceptor->local_endpoint();
+        acceptors_.push_back(std::move(acceptor));
+    }
+}
+
+void TCPServer::start_accept(size_t acceptor_index) {
+    acceptors_[acceptor_index]->async_accept(
+        [this, acceptor_index](const boost::system::error_code& error, boost::asio::ip::tcp::socket socket) {
             if (!error) {
                 handle_accept(error, std::move(socket));
-            } else {
+            } else if (running_.load()) {
                 std::cerr << "Accept error: " << error.message() << std::endl;
             }
             
             if (running_.load()) {
-                start_accept();
+                start_accept(acceptor_index);
             }
         });
 }
@@ -500,39 +1580,166 @@ void TCPServer::handle_accept(const boost::system::error_code& error, boost::asi
     if (error) {
         return;
     }
+
+    // Replies are small and latency sensitive; don't let Nagle hold them back
+    boost::system::error_code option_error;
+    socket.set_option(boost::asio::ip::tcp::no_delay(true), option_error);
+    
+    // A single shared acceptor hands the socket to its worker's io_context, so every
+    // handler for the connection runs on that worker's thread
+    if (io_contexts_.size() > 1 && acceptors_.size() == 1) {
+        auto& target = *io_contexts_[select_worker(socket)];
+        if (&socket.get_executor().context() != &target) {
+            boost::system::error_code move_error;
+            auto protocol = socket.local_endpoint(move_error).protocol();
+            boost::asio::ip::tcp::socket moved(target);
+            if (!move_error) {
+                auto handle = socket.release(move_error);
+                if (!move_error) {
+                    moved.assign(protocol, handle, move_error);
+                }
+            }
+            if (move_error) {
+                std::cerr << "Failed to hand connection to worker: " << move_error.message() << std::endl;
+                return;
+            }
+            socket = std::move(moved);
+        }
+    }
+    
+    // Assign connection ID; logged-in sessions carry their own client id
+    uint64_t connection_id = next_connection_id_++;
     
     // Create new client connection
-    auto client = std::make_shared<ClientConnection>(std::move(socket));
+    auto client = std::make_shared<ClientConnection>(std::move(socket), connection_id, instruments_);
+    client->set_text_protocol_enabled(text_protocol_enabled_);
+    client->set_session_store(session_store_);
     
     // Set callbacks
     client->set_order_submit_callback(order_submit_callback_);
     client->set_order_cancel_callback(order_cancel_callback_);
     client->set_order_modify_callback(order_modify_callback_);
+    client->set_order_mass_cancel_callback(order_mass_cancel_callback_);
+    client->set_order_status_callback(order_status_callback_);
+    client->set_disconnect_callback([this](uint64_t id) {
+        remove_client(id);
+    });
+    if (max_outbound_bytes_ > 0) {
+        client->set_max_outbound_bytes(max_outbound_bytes_);
+    }
     
-    // Assign client ID
-    uint64_t client_id = next_client_id_++;
-    
-    // Store client
+    // Store client and give it a subscription slot
     {
         std::unique_lock<std::shared_mutex> lock(clients_mutex_);
-        clients_[client_id] = client;
+        if (free_session_slots_.empty()) {
+            std::cerr << "Session limit reached, rejecting client " << connection_id << std::endl;
+            return;
+        }
+        
+        uint32_t slot = free_session_slots_.back();
+        free_session_slots_.pop_back();
+        
+        client->set_subscriptions(subscriptions_, slot);
+        sessions_by_slot_[slot] = client;
+        clients_[connection_id] = client;
     }
     
-    // Start client
+    // Start client; its first timer only waits for a login
     client->start();
+    session_timers_->schedule(connection_id, std::chrono::steady_clock::now() + session_store_->config().min_heartbeat_interval);
     
     std::cout << "New client connected, total clients: " << get_client_count() << std::endl;
 }
 
-void TCPServer::remove_client(uint64_t client_id) {
-    std::unique_lock<std::shared_mutex> lock(clients_mutex_);
-    clients_.erase(client_id);
-    std::cout << "Client disconnected, total clients: " << get_client_count() << std::endl;
+size_t TCPServer::select_worker(const boost::asio::ip::tcp::socket& socket) {
+    size_t workers = io_contexts_.size();
+    if (config_.affinity == ConnectionAffinity::CLIENT_ADDRESS) {
+        boost::system::error_code ec;
+        auto address = socket.remote_endpoint(ec).address();
+        if (!ec) {
+            uint64_t key = address.is_v4() ? address.to_v4().to_uint()
+                                           : std::hash<std::string>{}(address.to_string());
+            return static_cast<size_t>(((key * 0x9E3779B97F4A7C15ULL) >> 32) % workers);
+        }
+    }
+    return next_worker_.fetch_add(1, std::memory_order_relaxed) % workers;
+}
+
+void TCPServer::remove_client(uint64_t connection_id) {
+    size_t remaining = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(clients_mutex_);
+        auto it = clients_.find(connection_id);
+        if (it == clients_.end()) {
+            return;
+        }
+        
+        // Clear the session's subscriptions before its slot can be reused
+        uint32_t slot = it->second->get_session_slot();
+        subscriptions_->remove_session(slot);
+        sessions_by_slot_[slot].reset();
+        free_session_slots_.push_back(slot);
+        
+        clients_.erase(it);
+        remaining = clients_.size();
+    }
+    std::cout << "Client disconnected, total clients: " << remaining << std::endl;
+}
+
+void TCPServer::schedule_session_tick() {
+    session_tick_->expires_after(session_store_->config().timer_tick);
+    session_tick_->async_wait([this](const boost::system::error_code& error) {
+        if (error || !running_.load()) {
+            return;
+        }
+        handle_session_tick();
+    });
+}
+
+void TCPServer::handle_session_tick() {
+    auto now = std::chrono::steady_clock::now();
+    expired_timers_.clear();
+    session_timers_->advance(now, expired_timers_);
+    
+    // Timers of clients that have gone are simply dropped
+    for (uint64_t connection_id : expired_timers_) {
+        std::shared_ptr<ClientConnection> client;
+        {
+            std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+            auto it = clients_.find(connection_id);
+            if (it != clients_.end()) {
+                client = it->second;
+            }
+        }
+        if (!client) {
+            continue;
+        }
+        if (auto next = client->on_session_timer(now)) {
+            session_timers_->schedule(connection_id, *next);
+        }
+    }
+    
+    session_store_->flush();
+    schedule_session_tick();
 }
 
-void TCPServer::worker_thread_function() {
+void TCPServer::worker_thread_function(size_t worker_index) {
+    set_current_thread_name("tcp_worker" + std::to_string(worker_index));
+#ifdef __linux__
+    if (config_.pin_threads) {
+        unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(worker_index % cpus, &cpu_set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+            std::cerr << "Failed to pin network worker " << worker_index << std::endl;
+        }
+    }
+#endif
+    
+    auto& context = *io_contexts_[io_contexts_.size() == 1 ? 0 : worker_index];
     try {
-        io_context_.run();
+        context.run();
     } catch (const std::exception& e) {
         std::cerr << "Worker thread error: " << e.what() << std::endl;
     }
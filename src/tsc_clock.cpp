@@ -0,0 +1,54 @@
+#include "tsc_clock.h"
+#include <thread>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#define UFA_TSC 1
+#endif
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+uint64_t steady_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t calibrate_ticks_per_second() {
+#ifdef UFA_TSC
+    // 10 ms against steady_clock is within a fraction of a percent, plenty for rate limits
+    uint64_t start_ns = steady_now_ns();
+    uint64_t start_ticks = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    uint64_t elapsed_ns = steady_now_ns() - start_ns;
+    uint64_t elapsed_ticks = __rdtsc() - start_ticks;
+    if (elapsed_ns == 0 || elapsed_ticks == 0) {
+        return 1000000000ULL;
+    }
+    return static_cast<uint64_t>(static_cast<unsigned __int128>(elapsed_ticks) * 1000000000ULL / elapsed_ns);
+#else
+    return 1000000000ULL;
+#endif
+}
+
+} // namespace
+
+uint64_t TscClock::now() {
+#ifdef UFA_TSC
+    return __rdtsc();
+#else
+    return steady_now_ns();
+#endif
+}
+
+uint64_t TscClock::ticks_per_second() {
+    static const uint64_t ticks = calibrate_ticks_per_second();
+    return ticks;
+}
+
+std::chrono::nanoseconds TscClock::to_duration(uint64_t ticks) {
+    return std::chrono::nanoseconds(static_cast<int64_t>(
+        static_cast<unsigned __int128>(ticks) * 1000000000ULL / ticks_per_second()));
+}
+
+} // namespace UltraFastAnalysis
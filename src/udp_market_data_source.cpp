@@ -0,0 +1,513 @@
+#include "udp_market_data_source.h"
+#include "thread_name.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace UltraFastAnalysis {
+
+namespace {
+
+uint64_t steady_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+UdpMulticastDataSource::UdpMulticastDataSource(const MarketDataConfig& config)
+    : config_(config), batch_size_(config.recv_batch_size > 0 ? config.recv_batch_size : 1),
+      hold_ns_(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          config.arbitration_hold).count())) {
+}
+
+UdpMulticastDataSource::~UdpMulticastDataSource() {
+    stop_streaming();
+    close_sockets();
+}
+
+bool UdpMulticastDataSource::connect() {
+    if (connected_.load()) {
+        return true;
+    }
+
+    // Pre-allocate one packet slot per recvmmsg entry, per line
+    packet_storage_.assign(NUM_LINES * batch_size_ * MAX_FEED_PACKET_SIZE, 0);
+    iovecs_.resize(NUM_LINES * batch_size_);
+    messages_.resize(NUM_LINES * batch_size_);
+    pending_.reserve(NUM_LINES * batch_size_);
+
+    for (size_t i = 0; i < iovecs_.size(); ++i) {
+        iovecs_[i].iov_base = &packet_storage_[i * MAX_FEED_PACKET_SIZE];
+        iovecs_[i].iov_len = MAX_FEED_PACKET_SIZE;
+
+        std::memset(&messages_[i], 0, sizeof(mmsghdr));
+        messages_[i].msg_hdr.msg_iov = &iovecs_[i];
+        messages_[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // Slots for packets held back while the other line catches up
+    size_t hold_slots = hold_ns_ != 0 ? config_.arbitration_hold_packets : 0;
+    held_.clear();
+    held_.reserve(hold_slots);
+    held_storage_.assign(hold_slots * MAX_FEED_PACKET_SIZE, 0);
+    free_held_slots_.clear();
+    for (size_t slot = hold_slots; slot > 0; --slot) {
+        free_held_slots_.push_back(static_cast<uint32_t>(slot - 1));
+    }
+
+    sockets_[0] = open_line_socket(config_.multicast_group_a, config_.multicast_port_a);
+    if (sockets_[0] < 0) {
+        close_sockets();
+        return false;
+    }
+
+    // Line B is optional; an empty group runs the feed on a single line
+    if (!config_.multicast_group_b.empty()) {
+        sockets_[1] = open_line_socket(config_.multicast_group_b, config_.multicast_port_b);
+        if (sockets_[1] < 0) {
+            close_sockets();
+            return false;
+        }
+    }
+
+    sequence_initialized_ = false;
+    connected_.store(true);
+    return true;
+}
+
+void UdpMulticastDataSource::disconnect() {
+    stop_streaming();
+    close_sockets();
+    connected_.store(false);
+}
+
+bool UdpMulticastDataSource::is_connected() const {
+    return connected_.load();
+}
+
+bool UdpMulticastDataSource::start_streaming() {
+    if (!connected_.load() || streaming_.load()) {
+        return false;
+    }
+
+    streaming_.store(true);
+    shutdown_requested_.store(false);
+
+    receive_thread_ = std::thread(&UdpMulticastDataSource::receive_thread_worker, this);
+    return true;
+}
+
+void UdpMulticastDataSource::stop_streaming() {
+    if (!streaming_.load()) {
+        return;
+    }
+
+    shutdown_requested_.store(true);
+    streaming_.store(false);
+
+    if (receive_thread_.joinable()) {
+        receive_thread_.join();
+    }
+}
+
+void UdpMulticastDataSource::set_data_callback(std::function<void(const MarketData&)> callback) {
+    data_callback_ = callback;
+}
+
+void UdpMulticastDataSource::set_error_callback(std::function<void(const std::string&)> callback) {
+    error_callback_ = callback;
+}
+
+const MarketDataStats& UdpMulticastDataSource::get_stats() const {
+    return stats_;
+}
+
+void UdpMulticastDataSource::reset_stats() {
+    stats_.reset();
+    arbitration_stats_.reset();
+}
+
+void UdpMulticastDataSource::set_packet_decoder(PacketDecoder decoder) {
+    packet_decoder_ = decoder;
+}
+
+const FeedArbitrationStats& UdpMulticastDataSource::get_arbitration_stats() const {
+    return arbitration_stats_;
+}
+
+uint64_t UdpMulticastDataSource::get_next_expected_sequence() const {
+    return next_expected_sequence_.load(std::memory_order_relaxed);
+}
+
+int UdpMulticastDataSource::open_line_socket(const std::string& group, uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        report_error("Failed to create UDP socket: " + std::string(std::strerror(errno)));
+        return -1;
+    }
+
+    int enable = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+#ifdef SO_REUSEPORT
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+#endif
+
+    // Large receive buffers absorb bursts while the receive thread is busy decoding.
+    // SO_RCVBUFFORCE bypasses rmem_max when running with CAP_NET_ADMIN.
+    int buffer_size = config_.socket_receive_buffer_size;
+    if (::setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &buffer_size, sizeof(buffer_size)) != 0) {
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    }
+
+    in_addr group_address{};
+    if (::inet_pton(AF_INET, group.c_str(), &group_address) != 1) {
+        report_error("Invalid feed address: " + group);
+        ::close(fd);
+        return -1;
+    }
+
+    bool is_multicast = IN_MULTICAST(ntohl(group_address.s_addr));
+
+    // Bind to the group address so only this group's traffic is delivered on the port
+    sockaddr_in bind_address{};
+    bind_address.sin_family = AF_INET;
+    bind_address.sin_port = htons(port);
+    bind_address.sin_addr = is_multicast ? group_address : in_addr{htonl(INADDR_ANY)};
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&bind_address), sizeof(bind_address)) != 0) {
+        report_error("Failed to bind feed socket to " + group + ":" + std::to_string(port) +
+                     ": " + std::strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+
+    // Unicast addresses (e.g. 127.0.0.1) are accepted so the feed can be exercised on loopback
+    if (is_multicast) {
+        ip_mreq membership{};
+        membership.imr_multiaddr = group_address;
+        if (::inet_pton(AF_INET, config_.multicast_interface.c_str(), &membership.imr_interface) != 1) {
+            membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        }
+
+        if (::setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+            report_error("Failed to join multicast group " + group + ": " + std::strerror(errno));
+            ::close(fd);
+            return -1;
+        }
+    }
+
+    return fd;
+}
+
+void UdpMulticastDataSource::close_sockets() {
+    for (auto& fd : sockets_) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void UdpMulticastDataSource::receive_thread_worker() {
+    set_current_thread_name("udp_feed");
+
+    std::array<pollfd, NUM_LINES> poll_fds{};
+    nfds_t num_fds = 0;
+    for (size_t line = 0; line < NUM_LINES; ++line) {
+        if (sockets_[line] >= 0) {
+            poll_fds[num_fds].fd = sockets_[line];
+            poll_fds[num_fds].events = POLLIN;
+            ++num_fds;
+        }
+    }
+
+    while (!shutdown_requested_.load(std::memory_order_relaxed)) {
+        // Drain both lines without blocking; only sleep in poll() once both are empty
+        pending_.clear();
+        drain_line(0);
+        drain_line(1);
+
+        if (pending_.empty()) {
+            // Held packets whose window ran out while both lines were idle
+            if (!held_.empty()) {
+                release_held_packets(steady_now_ns(), false);
+            }
+
+            int ready = ::poll(poll_fds.data(), num_fds, 1);
+            if (ready < 0 && errno != EINTR) {
+                report_error("Feed poll failed: " + std::string(std::strerror(errno)));
+                break;
+            }
+            continue;
+        }
+
+        // Arbitrate the combined batch in sequence order, so a packet lost on one line
+        // is filled from the other line's batch instead of being reported as a gap
+        std::sort(pending_.begin(), pending_.end(),
+                         [](const PendingPacket& a, const PendingPacket& b) {
+                             return a.sequence_number < b.sequence_number;
+                         });
+
+        uint64_t now_ns = steady_now_ns();
+        for (const auto& packet : pending_) {
+            arbitrate_packet(packet.data, packet.length, now_ns);
+        }
+    }
+}
+
+void UdpMulticastDataSource::drain_line(size_t line) {
+    int fd = sockets_[line];
+    if (fd < 0) {
+        return;
+    }
+
+    mmsghdr* batch = &messages_[line * batch_size_];
+    for (size_t i = 0; i < batch_size_; ++i) {
+        batch[i].msg_len = 0;
+    }
+
+    int count = ::recvmmsg(fd, batch, static_cast<unsigned int>(batch_size_), MSG_DONTWAIT, nullptr);
+    if (count <= 0) {
+        if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            report_error("recvmmsg failed: " + std::string(std::strerror(errno)));
+        }
+        return;
+    }
+
+    arbitration_stats_.recv_batches.fetch_add(1, std::memory_order_relaxed);
+    (line == 0 ? arbitration_stats_.packets_line_a : arbitration_stats_.packets_line_b)
+        .fetch_add(static_cast<uint64_t>(count), std::memory_order_relaxed);
+
+    for (int i = 0; i < count; ++i) {
+        auto* data = static_cast<uint8_t*>(batch[i].msg_hdr.msg_iov->iov_base);
+        size_t length = batch[i].msg_len;
+
+        if (length < sizeof(FeedPacketHeader)) {
+            arbitration_stats_.packets_malformed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        uint64_t sequence_number;
+        std::memcpy(&sequence_number, data, sizeof(sequence_number));
+        pending_.push_back(PendingPacket{data, length, sequence_number});
+    }
+}
+
+void UdpMulticastDataSource::arbitrate_packet(uint8_t* data, size_t length, uint64_t now_ns) {
+    FeedPacketHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.packet_length != length ||
+        length != sizeof(FeedPacketHeader) + header.message_count * sizeof(FeedMessage)) {
+        arbitration_stats_.packets_malformed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t first = header.sequence_number;
+    uint64_t end = first + header.message_count;
+
+    if (!sequence_initialized_) {
+        // Join the feed wherever it currently is
+        next_expected_sequence_.store(first, std::memory_order_relaxed);
+        sequence_initialized_ = true;
+    }
+
+    // Past a missing range, which the other line may still deliver
+    if (first > next_expected_sequence_.load(std::memory_order_relaxed) &&
+        hold_packet(data, length, first, now_ns)) {
+        return;
+    }
+
+    // Already delivered by the other line
+    if (end <= next_expected_sequence_.load(std::memory_order_relaxed)) {
+        arbitration_stats_.packets_duplicate.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    deliver_packet(data, length);
+    if (!held_.empty()) {
+        release_held_packets(now_ns, false);
+    }
+}
+
+bool UdpMulticastDataSource::hold_packet(const uint8_t* data, size_t length, uint64_t sequence_number,
+                                         uint64_t now_ns) {
+    if (hold_ns_ == 0) {
+        return false;
+    }
+
+    auto find_position = [this](uint64_t sequence) {
+        return std::lower_bound(held_.begin(), held_.end(), sequence,
+                                [](const HeldPacket& held, uint64_t value) {
+                                    return held.sequence_number < value;
+                                });
+    };
+    auto position = find_position(sequence_number);
+    if (position != held_.end() && position->sequence_number == sequence_number) {
+        arbitration_stats_.packets_duplicate.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Out of slots: give up on the oldest missing range rather than wait longer. A
+    // packet older than every held one is delivered now instead, reporting the gap
+    // before it.
+    if (free_held_slots_.empty()) {
+        if (position == held_.begin()) {
+            return false;
+        }
+        release_held_packets(now_ns, true);
+        if (sequence_number <= next_expected_sequence_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        position = find_position(sequence_number);
+    }
+
+    // The window runs from when the missing range was first seen, so a packet
+    // slotting in ahead of others inherits the earliest hold time
+    uint64_t held_at_ns = position != held_.end() ? std::min(now_ns, position->held_at_ns) : now_ns;
+    uint32_t slot = free_held_slots_.back();
+    free_held_slots_.pop_back();
+    std::memcpy(&held_storage_[static_cast<size_t>(slot) * MAX_FEED_PACKET_SIZE], data, length);
+    held_.insert(position, HeldPacket{sequence_number, length, held_at_ns, slot});
+    arbitration_stats_.packets_held.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void UdpMulticastDataSource::release_held_packets(uint64_t now_ns, bool force) {
+    // Deliver packets the feed has caught up to; past the hold window, also those
+    // still ahead of a missing range, reporting the gap. Forcing gives up on the
+    // oldest missing range only: the oldest held packet goes out regardless, then
+    // whatever it makes contiguous.
+    size_t released = 0;
+    for (; released < held_.size(); ++released) {
+        HeldPacket& held = held_[released];
+        uint64_t expected = next_expected_sequence_.load(std::memory_order_relaxed);
+        bool give_up = force && released == 0;
+        if (held.sequence_number > expected && !give_up && now_ns - held.held_at_ns < hold_ns_) {
+            break;
+        }
+
+        uint8_t* data = &held_storage_[static_cast<size_t>(held.slot) * MAX_FEED_PACKET_SIZE];
+        FeedPacketHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (held.sequence_number + header.message_count <= expected) {
+            arbitration_stats_.packets_duplicate.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            deliver_packet(data, held.length);
+        }
+        free_held_slots_.push_back(held.slot);
+    }
+    held_.erase(held_.begin(), held_.begin() + static_cast<std::ptrdiff_t>(released));
+}
+
+void UdpMulticastDataSource::deliver_packet(uint8_t* data, size_t length) {
+    FeedPacketHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    uint64_t first = header.sequence_number;
+    uint64_t end = first + header.message_count;
+    uint64_t expected = next_expected_sequence_.load(std::memory_order_relaxed);
+
+    // Neither line delivered the missing range; report it and move on
+    if (first > expected) {
+        arbitration_stats_.sequence_gaps.fetch_add(1, std::memory_order_relaxed);
+        arbitration_stats_.messages_lost.fetch_add(first - expected, std::memory_order_relaxed);
+        report_error("Feed sequence gap: expected " + std::to_string(expected) +
+                     ", received " + std::to_string(first));
+        expected = first;
+    }
+
+    // Skip messages of a partially overlapping packet that were already delivered
+    size_t skip = static_cast<size_t>(expected - first);
+    next_expected_sequence_.store(end, std::memory_order_relaxed);
+    arbitration_stats_.packets_accepted.fetch_add(1, std::memory_order_relaxed);
+
+    if (skip > 0) {
+        // Present the remaining messages as a packet of their own, still in place
+        FeedPacketHeader trimmed = header;
+        trimmed.sequence_number = expected;
+        trimmed.message_count = static_cast<uint16_t>(header.message_count - skip);
+        trimmed.packet_length = static_cast<uint16_t>(sizeof(FeedPacketHeader) +
+                                                      trimmed.message_count * sizeof(FeedMessage));
+
+        data += skip * sizeof(FeedMessage);
+        std::memcpy(data, &trimmed, sizeof(trimmed));
+        length = trimmed.packet_length;
+    }
+
+    if (packet_decoder_) {
+        packet_decoder_(data, length);
+    } else {
+        decode_packet(data, length);
+    }
+}
+
+void UdpMulticastDataSource::decode_packet(const uint8_t* data, size_t length) {
+    FeedPacketHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    const uint8_t* cursor = data + sizeof(FeedPacketHeader);
+    auto receive_time = std::chrono::high_resolution_clock::now();
+
+    // Never trust the count past the bytes actually received
+    size_t count = std::min<size_t>(header.message_count, (length - sizeof(FeedPacketHeader)) / sizeof(FeedMessage));
+    for (size_t i = 0; i < count; ++i, cursor += sizeof(FeedMessage)) {
+        FeedMessage message;
+        std::memcpy(&message, cursor, sizeof(message));
+
+        decoded_.reset();
+        decoded_.sequence_number = header.sequence_number + i;
+        decoded_.symbol.assign(message.symbol, strnlen(message.symbol, sizeof(message.symbol)));
+        decoded_.type = static_cast<MarketDataType>(message.type);
+        decoded_.timestamp = receive_time;
+
+        double price = static_cast<double>(message.price) / FEED_PRICE_MULTIPLIER;
+
+        switch (decoded_.type) {
+            case MarketDataType::TRADE:
+            case MarketDataType::TICK:
+                decoded_.trade_price = price;
+                decoded_.trade_quantity = message.quantity;
+                decoded_.trade_id = message.trade_id;
+                break;
+            case MarketDataType::QUOTE:
+                decoded_.bid_price = price;
+                decoded_.bid_quantity = message.quantity;
+                decoded_.ask_price = static_cast<double>(message.ask_price) / FEED_PRICE_MULTIPLIER;
+                decoded_.ask_quantity = message.ask_quantity;
+                break;
+            case MarketDataType::ORDER_BOOK_UPDATE:
+                decoded_.price = price;
+                decoded_.quantity = message.quantity;
+                decoded_.is_bid = message.is_bid != 0;
+                break;
+            default:
+                stats_.validation_errors.fetch_add(1, std::memory_order_relaxed);
+                continue;
+        }
+
+        stats_.messages_received.fetch_add(1, std::memory_order_relaxed);
+        if (data_callback_) {
+            data_callback_(decoded_);
+        }
+    }
+}
+
+void UdpMulticastDataSource::report_error(const std::string& error) {
+    if (error_callback_) {
+        error_callback_(error);
+    } else {
+        std::cerr << error << std::endl;
+    }
+}
+
+} // namespace UltraFastAnalysis
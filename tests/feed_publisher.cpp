@@ -0,0 +1,137 @@
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <utility>     // Boost 1.74 asio uses std::exchange without including it
+#include <boost/asio.hpp>
+#include "udp_market_data_source.h"
+
+using boost::asio::ip::udp;
+using namespace UltraFastAnalysis;
+
+// Publishes synthetic FeedMessage packets on the A and B lines so that
+// UdpMulticastDataSource can be exercised locally (multicast or loopback unicast).
+class FeedPublisher {
+public:
+    FeedPublisher(const std::string& group_a, uint16_t port_a,
+                  const std::string& group_b, uint16_t port_b)
+        : io_context_(), socket_(io_context_, udp::v4()),
+          line_a_(boost::asio::ip::make_address(group_a), port_a),
+          line_b_(boost::asio::ip::make_address(group_b), port_b),
+          rng_(std::random_device{}()) {
+        socket_.set_option(boost::asio::ip::multicast::enable_loopback(true));
+        socket_.set_option(boost::asio::ip::multicast::hops(1));
+    }
+
+    // Independent per-line loss, to exercise arbitration and gap detection
+    void set_loss_rates(double loss_a, double loss_b) {
+        loss_a_ = loss_a;
+        loss_b_ = loss_b;
+    }
+
+    void publish(size_t total_messages, size_t messages_per_second, size_t messages_per_packet) {
+        const std::vector<std::string> symbols = {"AAPL", "GOOGL", "MSFT", "TSLA", "AMZN"};
+        std::vector<int64_t> prices(symbols.size(), 100 * FEED_PRICE_MULTIPLIER);
+        std::uniform_int_distribution<int> tick(-5, 5);
+        std::uniform_real_distribution<double> loss(0.0, 1.0);
+
+        std::vector<uint8_t> packet(MAX_FEED_PACKET_SIZE);
+        auto packet_interval = std::chrono::nanoseconds(
+            1000000000ULL * messages_per_packet / std::max<size_t>(messages_per_second, 1));
+        auto next_send = std::chrono::steady_clock::now();
+
+        size_t sent = 0;
+        while (sent < total_messages) {
+            size_t count = std::min(messages_per_packet, total_messages - sent);
+
+            FeedPacketHeader header{};
+            header.sequence_number = next_sequence_;
+            header.message_count = static_cast<uint16_t>(count);
+            header.packet_length = static_cast<uint16_t>(sizeof(FeedPacketHeader) + count * sizeof(FeedMessage));
+            std::memcpy(packet.data(), &header, sizeof(header));
+
+            for (size_t i = 0; i < count; ++i) {
+                size_t s = (sent + i) % symbols.size();
+                prices[s] = std::max<int64_t>(prices[s] + tick(rng_), FEED_PRICE_MULTIPLIER);
+
+                FeedMessage message{};
+                message.type = static_cast<uint8_t>((sent + i) % 2 == 0 ? MarketDataType::TRADE
+                                                                        : MarketDataType::QUOTE);
+                // NUL-padded, not necessarily NUL-terminated
+                std::memcpy(message.symbol, symbols[s].data(), std::min(symbols[s].size(), sizeof(message.symbol)));
+                message.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                message.trade_id = next_sequence_ + i;
+                message.price = prices[s];
+                message.quantity = 100;
+                message.ask_price = prices[s] + 1;
+                message.ask_quantity = 100;
+
+                std::memcpy(packet.data() + sizeof(FeedPacketHeader) + i * sizeof(FeedMessage),
+                            &message, sizeof(message));
+            }
+
+            auto buffer = boost::asio::buffer(packet.data(), header.packet_length);
+            if (loss(rng_) >= loss_a_) {
+                socket_.send_to(buffer, line_a_);
+            }
+            if (loss(rng_) >= loss_b_) {
+                socket_.send_to(buffer, line_b_);
+            }
+
+            next_sequence_ += count;
+            sent += count;
+
+            next_send += packet_interval;
+            std::this_thread::sleep_until(next_send);
+        }
+
+        std::cout << "Published " << sent << " messages, last sequence " << next_sequence_ - 1 << std::endl;
+    }
+
+private:
+    boost::asio::io_context io_context_;
+    udp::socket socket_;
+    udp::endpoint line_a_;
+    udp::endpoint line_b_;
+    std::mt19937 rng_;
+    uint64_t next_sequence_ = 1;
+    double loss_a_ = 0.0;
+    double loss_b_ = 0.0;
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 5) {
+        std::cout << "Usage: " << argv[0]
+                  << " <group_a> <port_a> <group_b> <port_b> [messages] [rate] [per_packet] [loss_a] [loss_b]\n";
+        std::cout << "Example: " << argv[0] << " 239.1.1.1 30001 239.1.1.2 30002 100000 50000 8 0.01 0.01\n";
+        std::cout << "Loopback: " << argv[0] << " 127.0.0.1 30001 127.0.0.1 30002\n";
+        return 1;
+    }
+
+    try {
+        size_t messages = argc > 5 ? std::stoul(argv[5]) : 10000;
+        size_t rate = argc > 6 ? std::stoul(argv[6]) : 10000;
+        size_t per_packet = argc > 7 ? std::stoul(argv[7]) : 8;
+        double loss_a = argc > 8 ? std::stod(argv[8]) : 0.0;
+        double loss_b = argc > 9 ? std::stod(argv[9]) : 0.0;
+
+        size_t max_per_packet = (MAX_FEED_PACKET_SIZE - sizeof(FeedPacketHeader)) / sizeof(FeedMessage);
+        per_packet = std::clamp<size_t>(per_packet, 1, max_per_packet);
+
+        FeedPublisher publisher(argv[1], static_cast<uint16_t>(std::stoi(argv[2])),
+                                argv[3], static_cast<uint16_t>(std::stoi(argv[4])));
+        publisher.set_loss_rates(loss_a, loss_b);
+        publisher.publish(messages, rate, per_packet);
+
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
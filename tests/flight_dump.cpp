@@ -0,0 +1,57 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "flight_recorder.h"
+
+using namespace UltraFastAnalysis;
+
+// Prints a flight recorder dump (see FlightDumpHeader) with event times relative
+// to the trigger, in microseconds.
+static bool print_dump(const char* path) {
+    FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        std::cerr << "Cannot open " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    FlightDumpHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "UFR1", 4) != 0) {
+        std::cerr << path << " is not a flight recorder dump" << std::endl;
+        std::fclose(file);
+        return false;
+    }
+    std::vector<FlightEvent> events(header.event_count);
+    size_t read = std::fread(events.data(), sizeof(FlightEvent), events.size(), file);
+    std::fclose(file);
+    events.resize(read);
+
+    header.thread_name[sizeof(header.thread_name) - 1] = '\0';
+    std::cout << path << ": thread " << header.thread_name << ", latency " << header.trigger_latency_ns / 1000.0
+              << " us over " << header.threshold_ns / 1000.0 << " us, wall clock " << header.wall_clock_ns
+              << " ns, " << events.size() << " events" << std::endl;
+
+    double ticks_per_us = static_cast<double>(header.ticks_per_second) / 1e6;
+    for (const FlightEvent& event : events) {
+        double offset_us = (static_cast<double>(event.tsc) - static_cast<double>(header.trigger_tsc)) / ticks_per_us;
+        std::cout << std::fixed << std::setprecision(3) << std::setw(14) << offset_us << "  "
+                  << std::left << std::setw(11) << flight_event_type_name(event.type) << std::right
+                  << " order " << event.order_id << " value " << event.value << " aux " << event.aux << std::endl;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " <dump.bin> [more dumps...]\n";
+        return 1;
+    }
+
+    bool ok = true;
+    for (int i = 1; i < argc; ++i) {
+        ok = print_dump(argv[i]) && ok;
+    }
+    return ok ? 0 : 1;
+}
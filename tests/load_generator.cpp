@@ -0,0 +1,432 @@
+// Open-loop order entry load generator
+//
+// Opens many connections to a running engine and sends binary NewOrder messages
+// on each at a fixed rate. Orders follow a schedule fixed before the run: order k
+// of a connection is due at start + k / rate, whether or not earlier orders
+// have been acknowledged. Each ORDER_ACK is matched to its order by
+// client_order_id.
+//
+// Two latencies are recorded per order:
+//   - corrected:   ack receipt minus the order's scheduled send time. When the
+//                  engine stalls, the orders that should have gone out during
+//                  the stall are charged for it (no coordinated omission).
+//   - uncorrected: ack receipt minus the time the generator wrote the order,
+//                  which is what a closed-loop client would report.
+//
+// Usage: load_generator [--host H] [--port P] [--connections N] [--rate R]
+//                       [--duration S] [--warmup S] [--threads T] [--instrument ID]
+
+#include "order_entry_protocol.h"
+#include "tcp_server.h"
+#include "performance_monitor.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace UltraFastAnalysis;
+
+namespace {
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8080;
+    size_t connections = 16;
+    double rate = 1000.0;           // Orders per second per connection
+    double duration = 10.0;         // Seconds of measured load
+    double warmup = 2.0;            // Seconds sent before measuring
+    size_t threads = 2;
+    uint32_t instrument_id = 1;
+};
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Each worker records into its own histograms, merged once the run ends
+struct Stats {
+    LatencyHistogram corrected;
+    LatencyHistogram uncorrected;
+    uint64_t sent = 0;
+    uint64_t acked = 0;
+    uint64_t rejected = 0;
+    uint64_t window_stalls = 0;     // Sends held back because too many orders were outstanding
+    uint64_t disconnects = 0;
+    int64_t last_ack_ns = 0;
+};
+
+// Outstanding orders are kept in a ring indexed by client_order_id
+constexpr size_t WINDOW = 1 << 16;
+
+struct Pending {
+    int64_t scheduled_ns = 0;
+    int64_t written_ns = 0;
+    bool outstanding = false;
+};
+
+struct Connection {
+    int fd = -1;
+    int64_t first_due_ns = 0;
+    uint64_t next_order = 0;
+    std::vector<uint8_t> output;
+    size_t output_offset = 0;
+    std::vector<uint8_t> input;
+    size_t input_end = 0;
+    std::vector<Pending> pending;
+    size_t outstanding = 0;
+    std::mt19937 rng;
+};
+
+int connect_to(const Options& options) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(options.host.c_str(), std::to_string(options.port).c_str(), &hints, &addresses) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+        fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// Limit orders alternating sides around a fixed mid, so about half of them trade
+void append_new_order(Connection& connection, uint32_t instrument_id, uint64_t client_order_id) {
+    std::uniform_int_distribution<int64_t> offset(-10, 10);
+    NewOrderMessage order{};
+    order.client_order_id = client_order_id;
+    order.instrument_id = instrument_id;
+    order.side = static_cast<uint8_t>(client_order_id % 2 ? OrderSide::BUY : OrderSide::SELL);
+    order.order_type = static_cast<uint8_t>(OrderType::LIMIT);
+    order.price = 15000 + offset(connection.rng);
+    order.quantity = 100;
+
+    MessageHeader header = ProtocolSession::make_header(MessageType::BINARY_NEW_ORDER, sizeof(order));
+    size_t at = connection.output.size();
+    connection.output.resize(at + sizeof(header) + sizeof(order));
+    std::memcpy(connection.output.data() + at, &header, sizeof(header));
+    std::memcpy(connection.output.data() + at + sizeof(header), &order, sizeof(order));
+}
+
+bool flush_output(Connection& connection) {
+    while (connection.output_offset < connection.output.size()) {
+        ssize_t n = ::send(connection.fd, connection.output.data() + connection.output_offset,
+                           connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection.output_offset += static_cast<size_t>(n);
+    }
+    connection.output.clear();
+    connection.output_offset = 0;
+    return true;
+}
+
+// Read what has arrived and match every ORDER_ACK; other messages are skipped
+bool read_acks(Connection& connection, int64_t measure_from_ns, Stats& stats) {
+    for (;;) {
+        ssize_t n = ::recv(connection.fd, connection.input.data() + connection.input_end,
+                           connection.input.size() - connection.input_end, 0);
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection.input_end += static_cast<size_t>(n);
+        int64_t received_ns = now_ns();
+
+        size_t offset = 0;
+        while (connection.input_end - offset >= sizeof(MessageHeader)) {
+            MessageHeader header;
+            std::memcpy(&header, connection.input.data() + offset, sizeof(header));
+            size_t total = sizeof(header) + header.message_length;
+            if (total > connection.input.size()) {
+                std::cerr << "Oversized message from engine: " << header.message_length << std::endl;
+                return false;
+            }
+            if (connection.input_end - offset < total) {
+                break;
+            }
+
+            if (static_cast<MessageType>(header.message_type) == MessageType::ORDER_ACK &&
+                header.message_length >= sizeof(OrderAckMessage)) {
+                OrderAckMessage ack;
+                std::memcpy(&ack, connection.input.data() + offset + sizeof(header), sizeof(ack));
+                Pending& order = connection.pending[ack.client_order_id & (WINDOW - 1)];
+                if (order.outstanding) {
+                    order.outstanding = false;
+                    --connection.outstanding;
+                    if (order.scheduled_ns >= measure_from_ns) {
+                        ++stats.acked;
+                        stats.last_ack_ns = received_ns;
+                        if (ack.status == static_cast<uint8_t>(OrderAckStatus::REJECTED)) {
+                            ++stats.rejected;
+                        }
+                        stats.corrected.record_single_writer(static_cast<uint64_t>(received_ns - order.scheduled_ns));
+                        stats.uncorrected.record_single_writer(static_cast<uint64_t>(received_ns - order.written_ns));
+                    }
+                }
+            }
+            offset += total;
+        }
+
+        std::memmove(connection.input.data(), connection.input.data() + offset, connection.input_end - offset);
+        connection.input_end -= offset;
+    }
+}
+
+// Drive a share of the connections until the schedule ends, then drain acks
+void run_worker(const Options& options, std::vector<Connection>& connections,
+                int64_t start_ns, int64_t end_ns, Stats& stats) {
+    const double interval_ns = 1e9 / options.rate;
+    const int64_t measure_from_ns = start_ns + static_cast<int64_t>(options.warmup * 1e9);
+    const int64_t drain_until_ns = end_ns + 2000000000LL;
+
+    std::vector<pollfd> fds(connections.size());
+    for (size_t i = 0; i < connections.size(); ++i) {
+        fds[i].fd = connections[i].fd;
+    }
+
+    size_t open = connections.size();
+    while (open > 0) {
+        int64_t now = now_ns();
+        if (now >= drain_until_ns) {
+            break;
+        }
+
+        // Queue every order that is due; the schedule never waits for acks
+        int64_t next_due = drain_until_ns;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            Connection& connection = connections[i];
+            if (connection.fd < 0) {
+                continue;
+            }
+            for (;;) {
+                int64_t due = connection.first_due_ns + static_cast<int64_t>(connection.next_order * interval_ns);
+                if (due >= end_ns) {
+                    break;
+                }
+                if (due > now) {
+                    next_due = std::min(next_due, due);
+                    break;
+                }
+                Pending& slot = connection.pending[connection.next_order & (WINDOW - 1)];
+                if (slot.outstanding) {
+                    ++stats.window_stalls;
+                    break;
+                }
+                slot.scheduled_ns = due;
+                slot.written_ns = now;
+                slot.outstanding = true;
+                ++connection.outstanding;
+                append_new_order(connection, options.instrument_id, connection.next_order);
+                ++connection.next_order;
+                if (due >= measure_from_ns) {
+                    ++stats.sent;
+                }
+            }
+            if (!flush_output(connection)) {
+                ::close(connection.fd);
+                connection.fd = -1;
+                fds[i].fd = -1;
+                ++stats.disconnects;
+                --open;
+                continue;
+            }
+            fds[i].events = POLLIN | (connection.output.empty() ? 0 : POLLOUT);
+        }
+
+        // Sleep at most until the next order is due
+        int64_t wait_ns = std::max<int64_t>(0, next_due - now_ns());
+        timespec timeout{static_cast<time_t>(wait_ns / 1000000000), static_cast<long>(wait_ns % 1000000000)};
+        if (ppoll(fds.data(), fds.size(), &timeout, nullptr) <= 0) {
+            continue;
+        }
+        for (size_t i = 0; i < connections.size(); ++i) {
+            Connection& connection = connections[i];
+            if (connection.fd < 0 || !(fds[i].revents & (POLLIN | POLLERR | POLLHUP))) {
+                continue;
+            }
+            if (!read_acks(connection, measure_from_ns, stats)) {
+                ::close(connection.fd);
+                connection.fd = -1;
+                fds[i].fd = -1;
+                ++stats.disconnects;
+                --open;
+            }
+        }
+
+        // Done once the schedule has ended and nothing is outstanding
+        if (now_ns() >= end_ns) {
+            bool outstanding = std::any_of(connections.begin(), connections.end(), [](const Connection& connection) {
+                return connection.fd >= 0 && connection.outstanding > 0;
+            });
+            if (!outstanding) {
+                break;
+            }
+        }
+    }
+
+    for (Connection& connection : connections) {
+        if (connection.fd >= 0) {
+            ::close(connection.fd);
+            connection.fd = -1;
+        }
+    }
+}
+
+void print_latencies(const char* title, const LatencyHistogram& histogram) {
+    std::cout << title << " (" << histogram.get_count() << " orders)\n";
+    const std::pair<const char*, double> points[] = {
+        {"p50:    ", 50.0}, {"p90:    ", 90.0}, {"p99:    ", 99.0},
+        {"p99.9:  ", 99.9}, {"p99.99: ", 99.99}};
+    for (const auto& [label, p] : points) {
+        std::cout << "  " << label << histogram.get_percentile(p) / 1000.0 << " us\n";
+    }
+    std::cout << "  max:    " << histogram.get_max() / 1000.0 << " us\n";
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]\n"
+              << "  --host <host>          Engine host (default: 127.0.0.1)\n"
+              << "  --port <port>          Engine order entry port (default: 8080)\n"
+              << "  --connections <n>      Connections to open (default: 16)\n"
+              << "  --rate <n>             Orders per second per connection (default: 1000)\n"
+              << "  --duration <seconds>   Measured load (default: 10)\n"
+              << "  --warmup <seconds>     Load sent before measuring (default: 2)\n"
+              << "  --threads <n>          Client threads sharing the connections (default: 2)\n"
+              << "  --instrument <id>      Instrument id to trade (default: 1)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--host" && i + 1 < argc) {
+            options.host = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            options.port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--connections" && i + 1 < argc) {
+            options.connections = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--rate" && i + 1 < argc) {
+            options.rate = std::max(1.0, std::stod(argv[++i]));
+        } else if (arg == "--duration" && i + 1 < argc) {
+            options.duration = std::max(0.1, std::stod(argv[++i]));
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            options.warmup = std::max(0.0, std::stod(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--instrument" && i + 1 < argc) {
+            options.instrument_id = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else {
+            print_usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+    options.threads = std::min(options.threads, options.connections);
+
+    // Connections are dealt to threads round-robin
+    std::vector<std::vector<Connection>> shares(options.threads);
+    for (size_t i = 0; i < options.connections; ++i) {
+        Connection connection;
+        connection.fd = connect_to(options);
+        if (connection.fd < 0) {
+            std::cerr << "Failed to connect to " << options.host << ":" << options.port << std::endl;
+            return 1;
+        }
+        connection.input.resize(ProtocolSession::MAX_MESSAGE_SIZE * 8);
+        connection.pending.resize(WINDOW);
+        connection.rng.seed(static_cast<uint32_t>(i + 1));
+        shares[i % options.threads].push_back(std::move(connection));
+    }
+
+    // Stagger connections across one interval so their orders do not arrive in lockstep
+    int64_t start_ns = now_ns() + 100000000;
+    int64_t end_ns = start_ns + static_cast<int64_t>((options.warmup + options.duration) * 1e9);
+    double interval_ns = 1e9 / options.rate;
+    size_t index = 0;
+    for (auto& share : shares) {
+        for (Connection& connection : share) {
+            connection.first_due_ns = start_ns + static_cast<int64_t>(
+                interval_ns * static_cast<double>(index++) / static_cast<double>(options.connections));
+        }
+    }
+
+    std::cout << "Sending " << options.rate << " orders/s on each of " << options.connections
+              << " connections for " << options.duration << " s (+" << options.warmup << " s warmup)" << std::endl;
+
+    std::vector<Stats> stats(options.threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < options.threads; ++t) {
+        workers.emplace_back([&, t]() { run_worker(options, shares[t], start_ns, end_ns, stats[t]); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    Stats total;
+    for (const Stats& s : stats) {
+        total.corrected.merge(s.corrected);
+        total.uncorrected.merge(s.uncorrected);
+        total.sent += s.sent;
+        total.acked += s.acked;
+        total.rejected += s.rejected;
+        total.window_stalls += s.window_stalls;
+        total.disconnects += s.disconnects;
+        total.last_ack_ns = std::max(total.last_ack_ns, s.last_ack_ns);
+    }
+
+    // Acks over the time it took to receive them; below target when the engine falls behind
+    int64_t measure_from_ns = start_ns + static_cast<int64_t>(options.warmup * 1e9);
+    double ack_seconds = std::max(options.duration, static_cast<double>(total.last_ack_ns - measure_from_ns) / 1e9);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "\n=== Load Generator ===\n"
+              << "Target rate:   " << options.rate * static_cast<double>(options.connections) << " orders/s\n"
+              << "Achieved rate: " << static_cast<double>(total.acked) / ack_seconds << " orders/s\n"
+              << "Acked:         " << total.acked << " of " << total.sent << " (" << total.rejected << " rejected)\n"
+              << "Window stalls: " << total.window_stalls << ", disconnects: " << total.disconnects << "\n";
+    print_latencies("Latency from scheduled send (corrected)", total.corrected);
+    print_latencies("Latency from actual send (uncorrected)", total.uncorrected);
+    std::cout << std::flush;
+
+    return total.disconnects == 0 && total.acked == total.sent ? 0 : 1;
+}
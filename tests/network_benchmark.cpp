@@ -0,0 +1,404 @@
+// Network backend benchmark: Asio (epoll) vs io_uring
+//
+// Runs the order entry server in-process with the selected backend and drives it
+// from a client thread with binary NewOrder messages, measuring
+//   - round-trip latency (one order in flight, send -> OrderAck)
+//   - pipelined throughput (bursts of orders written together)
+//   - server-side syscalls per message
+//
+// Syscalls are counted by interposing the libc wrappers the backends use (read,
+// write, sendmsg, recvmsg, epoll_wait, syscall, ...). Calls made by the client
+// thread are excluded.
+//
+// Usage: network_benchmark [--backend asio|io_uring|both] [--messages N] [--burst N] [--port P]
+
+#include "network_server.h"
+#include "tcp_server.h"
+#include "io_uring_server.h"
+#include <arpa/inet.h>
+#include <dlfcn.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace UltraFastAnalysis;
+
+namespace {
+
+std::atomic<uint64_t> syscall_count{0};
+thread_local bool exclude_thread = false;
+
+inline void count_syscall() {
+    if (!exclude_thread) {
+        syscall_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+template<typename F>
+F real_function(const char* name) {
+    return reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+}
+
+} // namespace
+
+// libc wrapper interposition; each forwards to the real symbol
+extern "C" {
+
+ssize_t read(int fd, void* buffer, size_t count) {
+    static auto real = real_function<ssize_t (*)(int, void*, size_t)>("read");
+    count_syscall();
+    return real(fd, buffer, count);
+}
+
+ssize_t write(int fd, const void* buffer, size_t count) {
+    static auto real = real_function<ssize_t (*)(int, const void*, size_t)>("write");
+    count_syscall();
+    return real(fd, buffer, count);
+}
+
+ssize_t readv(int fd, const struct iovec* iov, int count) {
+    static auto real = real_function<ssize_t (*)(int, const struct iovec*, int)>("readv");
+    count_syscall();
+    return real(fd, iov, count);
+}
+
+ssize_t writev(int fd, const struct iovec* iov, int count) {
+    static auto real = real_function<ssize_t (*)(int, const struct iovec*, int)>("writev");
+    count_syscall();
+    return real(fd, iov, count);
+}
+
+ssize_t recvmsg(int fd, struct msghdr* message, int flags) {
+    static auto real = real_function<ssize_t (*)(int, struct msghdr*, int)>("recvmsg");
+    count_syscall();
+    return real(fd, message, flags);
+}
+
+ssize_t sendmsg(int fd, const struct msghdr* message, int flags) {
+    static auto real = real_function<ssize_t (*)(int, const struct msghdr*, int)>("sendmsg");
+    count_syscall();
+    return real(fd, message, flags);
+}
+
+ssize_t recv(int fd, void* buffer, size_t length, int flags) {
+    static auto real = real_function<ssize_t (*)(int, void*, size_t, int)>("recv");
+    count_syscall();
+    return real(fd, buffer, length, flags);
+}
+
+ssize_t send(int fd, const void* buffer, size_t length, int flags) {
+    static auto real = real_function<ssize_t (*)(int, const void*, size_t, int)>("send");
+    count_syscall();
+    return real(fd, buffer, length, flags);
+}
+
+int epoll_wait(int epfd, struct epoll_event* events, int max_events, int timeout) {
+    static auto real = real_function<int (*)(int, struct epoll_event*, int, int)>("epoll_wait");
+    count_syscall();
+    return real(epfd, events, max_events, timeout);
+}
+
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) noexcept {
+    static auto real = real_function<int (*)(int, int, int, struct epoll_event*)>("epoll_ctl");
+    count_syscall();
+    return real(epfd, op, fd, event);
+}
+
+int poll(struct pollfd* fds, nfds_t count, int timeout) {
+    static auto real = real_function<int (*)(struct pollfd*, nfds_t, int)>("poll");
+    count_syscall();
+    return real(fds, count, timeout);
+}
+
+// io_uring_setup/enter/register go through syscall(); six register-sized
+// arguments cover every call the server makes
+long syscall(long number, ...) noexcept {
+    static auto real = real_function<long (*)(long, ...)>("syscall");
+    va_list args;
+    va_start(args, number);
+    long a1 = va_arg(args, long), a2 = va_arg(args, long), a3 = va_arg(args, long);
+    long a4 = va_arg(args, long), a5 = va_arg(args, long), a6 = va_arg(args, long);
+    va_end(args);
+    count_syscall();
+    return real(number, a1, a2, a3, a4, a5, a6);
+}
+
+} // extern "C"
+
+namespace {
+
+struct Options {
+    std::string backend = "both";
+    size_t messages = 20000;
+    size_t burst = 64;
+    uint16_t port = 9100;
+};
+
+struct Result {
+    std::vector<uint64_t> latencies_ns;
+    double pingpong_syscalls_per_message = 0.0;
+    double pipelined_messages_per_second = 0.0;
+    double pipelined_syscalls_per_message = 0.0;
+};
+
+constexpr uint32_t INSTRUMENT_ID = 1;
+
+std::vector<uint8_t> encode_new_order(uint64_t client_order_id) {
+    NewOrderMessage order{};
+    order.client_order_id = client_order_id;
+    order.instrument_id = INSTRUMENT_ID;
+    order.side = static_cast<uint8_t>(client_order_id % 2 ? OrderSide::BUY : OrderSide::SELL);
+    order.order_type = static_cast<uint8_t>(OrderType::LIMIT);
+    order.price = 15000 + static_cast<int64_t>(client_order_id % 100);
+    order.quantity = 100;
+
+    MessageHeader header = ProtocolSession::make_header(MessageType::BINARY_NEW_ORDER, sizeof(order));
+    std::vector<uint8_t> bytes(sizeof(header) + sizeof(order));
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    std::memcpy(bytes.data() + sizeof(header), &order, sizeof(order));
+    return bytes;
+}
+
+bool read_exact(int fd, uint8_t* out, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::recv(fd, out + done, length - done, 0);
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_all(int fd, const uint8_t* data, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::send(fd, data + done, length - done, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Read one OrderAck (header + body)
+bool read_ack(int fd) {
+    uint8_t buffer[sizeof(MessageHeader) + sizeof(OrderAckMessage)];
+    if (!read_exact(fd, buffer, sizeof(MessageHeader))) {
+        return false;
+    }
+    MessageHeader header;
+    std::memcpy(&header, buffer, sizeof(header));
+    if (header.message_length > sizeof(OrderAckMessage)) {
+        return false;
+    }
+    return read_exact(fd, buffer + sizeof(MessageHeader), header.message_length);
+}
+
+int connect_client(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int attempt = 0; attempt < 50; ++attempt) {
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            return fd;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    ::close(fd);
+    return -1;
+}
+
+bool run_client(const Options& options, Result& result) {
+    exclude_thread = true;
+
+    int fd = connect_client(options.port);
+    if (fd < 0) {
+        std::cerr << "Failed to connect to benchmark server" << std::endl;
+        return false;
+    }
+
+    // Warm up both sides before measuring
+    for (uint64_t i = 0; i < 1000; ++i) {
+        auto order = encode_new_order(i);
+        if (!write_all(fd, order.data(), order.size()) || !read_ack(fd)) {
+            ::close(fd);
+            return false;
+        }
+    }
+
+    // Round trip: one order in flight
+    result.latencies_ns.reserve(options.messages);
+    uint64_t start_syscalls = syscall_count.load();
+    for (uint64_t i = 0; i < options.messages; ++i) {
+        auto order = encode_new_order(i);
+        auto start = std::chrono::steady_clock::now();
+        if (!write_all(fd, order.data(), order.size()) || !read_ack(fd)) {
+            ::close(fd);
+            return false;
+        }
+        auto end = std::chrono::steady_clock::now();
+        result.latencies_ns.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+    result.pingpong_syscalls_per_message =
+        static_cast<double>(syscall_count.load() - start_syscalls) / static_cast<double>(options.messages);
+
+    // Pipelined: bursts written with one send, then every ack read back
+    std::vector<uint8_t> burst;
+    for (uint64_t i = 0; i < options.burst; ++i) {
+        auto order = encode_new_order(i);
+        burst.insert(burst.end(), order.begin(), order.end());
+    }
+
+    size_t bursts = std::max<size_t>(1, options.messages / options.burst);
+    start_syscalls = syscall_count.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < bursts; ++b) {
+        if (!write_all(fd, burst.data(), burst.size())) {
+            ::close(fd);
+            return false;
+        }
+        for (size_t i = 0; i < options.burst; ++i) {
+            if (!read_ack(fd)) {
+                ::close(fd);
+                return false;
+            }
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double pipelined = static_cast<double>(bursts * options.burst);
+    result.pipelined_messages_per_second =
+        pipelined / std::chrono::duration<double>(elapsed).count();
+    result.pipelined_syscalls_per_message =
+        static_cast<double>(syscall_count.load() - start_syscalls) / pipelined;
+
+    ::close(fd);
+    return true;
+}
+
+uint64_t percentile(std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+bool run_backend(NetworkBackend backend, const Options& options) {
+    std::unique_ptr<NetworkServer> server;
+    if (backend == NetworkBackend::IO_URING) {
+        if (!IoUringServer::is_supported()) {
+            std::cout << "io_uring: not supported on this kernel, skipped" << std::endl;
+            return true;
+        }
+        server = std::make_unique<IoUringServer>(options.port);
+    } else {
+        // One worker thread, matching the io_uring backend's single event loop
+        server = std::make_unique<TCPServer>(options.port, 1);
+    }
+
+    // Orders are acknowledged by the session; no matching engine behind it
+    server->get_instrument_registry().register_instrument(INSTRUMENT_ID, "AAPL", 0.01);
+    server->set_order_submit_callback([](std::shared_ptr<Order>) { return true; });
+
+    if (!server->start()) {
+        return false;
+    }
+
+    Result result;
+    bool ok = false;
+    std::thread client([&]() { ok = run_client(options, result); });
+    client.join();
+    server->stop();
+
+    if (!ok) {
+        std::cerr << network_backend_name(backend) << ": benchmark client failed" << std::endl;
+        return false;
+    }
+
+    std::sort(result.latencies_ns.begin(), result.latencies_ns.end());
+    std::cout << std::fixed << std::setprecision(2)
+              << "\n=== " << network_backend_name(backend) << " ===\n"
+              << "Round trip (" << options.messages << " orders, one in flight)\n"
+              << "  p50:   " << percentile(result.latencies_ns, 0.50) / 1000.0 << " us\n"
+              << "  p99:   " << percentile(result.latencies_ns, 0.99) / 1000.0 << " us\n"
+              << "  p99.9: " << percentile(result.latencies_ns, 0.999) / 1000.0 << " us\n"
+              << "  max:   " << result.latencies_ns.back() / 1000.0 << " us\n"
+              << "  server syscalls/message: " << result.pingpong_syscalls_per_message << "\n"
+              << "Pipelined (bursts of " << options.burst << ")\n"
+              << "  throughput: " << std::setprecision(0) << result.pipelined_messages_per_second << " msg/s\n"
+              << std::setprecision(3)
+              << "  server syscalls/message: " << result.pipelined_syscalls_per_message << std::endl;
+
+    if (backend == NetworkBackend::IO_URING) {
+        IoUringStats stats = static_cast<IoUringServer*>(server.get())->get_stats();
+        std::cout << "  io_uring_enter calls: " << stats.enter_calls
+                  << ", SQEs: " << stats.sqes_submitted
+                  << ", CQEs: " << stats.completions << std::endl;
+    }
+    return true;
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]\n"
+              << "  --backend <asio|io_uring|both>  Backends to measure (default: both)\n"
+              << "  --messages <n>                  Orders per phase (default: 20000)\n"
+              << "  --burst <n>                     Orders per pipelined burst (default: 64)\n"
+              << "  --port <port>                   Server port (default: 9100)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--backend" && i + 1 < argc) {
+            options.backend = argv[++i];
+        } else if (arg == "--messages" && i + 1 < argc) {
+            options.messages = std::stoul(argv[++i]);
+        } else if (arg == "--burst" && i + 1 < argc) {
+            options.burst = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--port" && i + 1 < argc) {
+            options.port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else {
+            print_usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    bool ok = true;
+    if (options.backend == "asio" || options.backend == "both") {
+        ok = run_backend(NetworkBackend::ASIO, options) && ok;
+    }
+    if (options.backend == "io_uring" || options.backend == "both") {
+        ok = run_backend(NetworkBackend::IO_URING, options) && ok;
+    }
+    return ok ? 0 : 1;
+}
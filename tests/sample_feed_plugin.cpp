@@ -0,0 +1,114 @@
+// Sample CUSTOM_FEED plugin generating synthetic trades and quotes.
+// Load with MarketDataConfig::plugin_path = ".../libsample_feed_plugin.so" and
+// plugin_config = "<messages per second>" (default 100000).
+
+#include "feed_plugin.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+struct SampleFeed {
+    uint64_t messages_per_second = 100000;
+    uint64_t next_sequence = 1;
+    int64_t price = 1500000; // 150.0000
+    bool running = false;
+    std::chrono::steady_clock::time_point start_time;
+};
+
+const char* const SYMBOLS[] = {"AAPL", "GOOGL", "MSFT", "TSLA", "AMZN"};
+
+void* sample_create(const char* config) {
+    auto* feed = new SampleFeed();
+    if (config && *config) {
+        uint64_t rate = std::strtoull(config, nullptr, 10);
+        if (rate > 0) {
+            feed->messages_per_second = rate;
+        }
+    }
+    return feed;
+}
+
+void sample_destroy(void* instance) {
+    delete static_cast<SampleFeed*>(instance);
+}
+
+int sample_start(void* instance) {
+    auto* feed = static_cast<SampleFeed*>(instance);
+    feed->running = true;
+    feed->start_time = std::chrono::steady_clock::now();
+    return 0;
+}
+
+void sample_stop(void* instance) {
+    static_cast<SampleFeed*>(instance)->running = false;
+}
+
+int64_t sample_poll(void* instance, ufa_feed_event* events, size_t capacity, uint32_t timeout_us) {
+    auto* feed = static_cast<SampleFeed*>(instance);
+    if (!feed->running) {
+        return -1;
+    }
+
+    // Emit as many events as the configured rate allows since start
+    auto elapsed = std::chrono::steady_clock::now() - feed->start_time;
+    uint64_t due = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()) *
+        feed->messages_per_second / 1000000 + 1;
+
+    if (due < feed->next_sequence) {
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min<uint32_t>(timeout_us, 100)));
+        return 0;
+    }
+
+    size_t count = static_cast<size_t>(std::min<uint64_t>(due - feed->next_sequence + 1, capacity));
+    for (size_t i = 0; i < count; ++i) {
+        ufa_feed_event& event = events[i];
+        std::memset(&event, 0, sizeof(event));
+
+        uint64_t sequence = feed->next_sequence++;
+        feed->price += (sequence % 3 == 0) ? 1 : -1;
+
+        event.sequence_number = sequence;
+        std::strncpy(event.symbol, SYMBOLS[sequence % 5], UFA_FEED_SYMBOL_LENGTH);
+        if (sequence % 2 == 0) {
+            event.type = UFA_FEED_EVENT_TRADE;
+            event.price = feed->price;
+            event.quantity = 100;
+            event.trade_id = sequence;
+        } else {
+            event.type = UFA_FEED_EVENT_QUOTE;
+            event.price = feed->price - 5;
+            event.quantity = 500;
+            event.ask_price = feed->price + 5;
+            event.ask_quantity = 500;
+        }
+    }
+
+    return static_cast<int64_t>(count);
+}
+
+const char* sample_last_error(void*) {
+    return "sample feed is not running";
+}
+
+const ufa_feed_plugin SAMPLE_PLUGIN = {
+    UFA_FEED_PLUGIN_ABI_VERSION,
+    sizeof(ufa_feed_event),
+    "sample_feed",
+    4,
+    sample_create,
+    sample_destroy,
+    sample_start,
+    sample_stop,
+    sample_poll,
+    sample_last_error
+};
+
+} // namespace
+
+extern "C" UFA_FEED_PLUGIN_EXPORT const ufa_feed_plugin* ufa_feed_plugin_entry(void) {
+    return &SAMPLE_PLUGIN;
+}
@@ -2,6 +2,8 @@
 #include <string>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <utility>     // Boost 1.74 asio uses std::exchange without including it
 #include <boost/asio.hpp>
 #include <boost/array.hpp>
 
@@ -89,14 +91,16 @@ public:
                         uint32_t message_length = *reinterpret_cast<uint32_t*>(&header_buffer[4]);
                         
                         // Read message body if present
+                        std::vector<uint8_t> body_buffer(message_length);
                         if (message_length > 0) {
-                            std::vector<uint8_t> body_buffer(message_length);
                             len = boost::asio::read(socket_, boost::asio::buffer(body_buffer));
-                            
-                            if (len == message_length) {
-                                std::string body(reinterpret_cast<char*>(body_buffer.data()), message_length);
-                                handle_response(message_type, body);
-                            }
+                        } else {
+                            len = 0;
+                        }
+                        
+                        if (len == message_length) {
+                            std::string body(reinterpret_cast<char*>(body_buffer.data()), message_length);
+                            handle_response(message_type, body);
                         }
                     }
                 } catch (std::exception& e) {
@@ -111,6 +115,8 @@ public:
     
 private:
     void send_message(uint32_t message_type, const std::string& data) {
+        // The listener thread answers heartbeats while the main thread sends orders
+        std::lock_guard<std::mutex> lock(send_mutex_);
         try {
             // Create message header
             struct {
@@ -150,6 +156,9 @@ private:
             case 5: // ORDER_BOOK response
                 std::cout << "Order book: " << data << std::endl;
                 break;
+            case 7: // HEARTBEAT; answer so the server does not time the session out
+                send_message(7, "");
+                break;
             default:
                 std::cout << "Response (type " << message_type << "): " << data << std::endl;
                 break;
@@ -159,6 +168,7 @@ private:
     boost::asio::io_context io_context_;
     tcp::socket socket_;
     uint64_t sequence_number_ = 0;
+    std::mutex send_mutex_;
 };
 
 int main(int argc, char* argv[]) {